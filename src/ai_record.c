@@ -0,0 +1,128 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - ai_record.c                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ai_record.h"
+#include "main.h"
+
+#include "m64p_types.h"
+
+/* large stdio buffer, to keep writes off the emulation thread most of the time */
+enum { AI_RECORD_BUFFER_SIZE = 1 << 20 };
+
+struct ai_recorder
+{
+    FILE* file;
+    uint64_t last_event;
+    uint64_t perf_frequency;
+    uint32_t events;
+};
+
+
+static void write_le32(FILE* f, uint32_t v)
+{
+    unsigned char bytes[4];
+
+    bytes[0] = (unsigned char)(v);
+    bytes[1] = (unsigned char)(v >> 8);
+    bytes[2] = (unsigned char)(v >> 16);
+    bytes[3] = (unsigned char)(v >> 24);
+
+    fwrite(bytes, 1, 4, f);
+}
+
+static void write_event_header(struct ai_recorder* recorder, enum ai_record_type type)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t delta = (now - recorder->last_event) * 1000000 / recorder->perf_frequency;
+
+    recorder->last_event = now;
+    ++recorder->events;
+
+    fputc(type, recorder->file);
+    write_le32(recorder->file, (delta > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta);
+}
+
+
+struct ai_recorder* start_ai_recorder(const char* filename)
+{
+    struct ai_recorder* recorder = malloc(sizeof(*recorder));
+    if (recorder == NULL) {
+        DebugMessage(M64MSG_ERROR, "AI recorder: failed to allocate memory");
+        return NULL;
+    }
+
+    recorder->file = fopen(filename, "wb");
+    if (recorder->file == NULL) {
+        DebugMessage(M64MSG_ERROR, "AI recorder: couldn't open %s for writing", filename);
+        free(recorder);
+        return NULL;
+    }
+
+    setvbuf(recorder->file, NULL, _IOFBF, AI_RECORD_BUFFER_SIZE);
+
+    fwrite(AI_RECORD_MAGIC, 1, 8, recorder->file);
+    write_le32(recorder->file, AI_RECORD_VERSION);
+
+    recorder->perf_frequency = SDL_GetPerformanceFrequency();
+    recorder->last_event = SDL_GetPerformanceCounter();
+    recorder->events = 0;
+
+    DebugMessage(M64MSG_INFO, "AI recorder: recording to %s", filename);
+
+    return recorder;
+}
+
+void stop_ai_recorder(struct ai_recorder* recorder)
+{
+    if (recorder == NULL) {
+        return;
+    }
+
+    DebugMessage(M64MSG_INFO, "AI recorder: %u events recorded", recorder->events);
+
+    fclose(recorder->file);
+    free(recorder);
+}
+
+void ai_record_dacrate(struct ai_recorder* recorder, int system_type, uint32_t dacrate)
+{
+    write_event_header(recorder, AI_RECORD_DACRATE);
+    write_le32(recorder->file, (uint32_t)system_type);
+    write_le32(recorder->file, dacrate);
+}
+
+void ai_record_len(struct ai_recorder* recorder, const void* samples, uint32_t length)
+{
+    write_event_header(recorder, AI_RECORD_LEN);
+    write_le32(recorder->file, length);
+    fwrite(samples, 1, length, recorder->file);
+}
+
+void ai_record_speed(struct ai_recorder* recorder, int percentage)
+{
+    write_event_header(recorder, AI_RECORD_SPEED);
+    write_le32(recorder->file, (uint32_t)percentage);
+}
@@ -0,0 +1,60 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - ai_record.h                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AI_RECORD_H
+#define M64P_AI_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Recording of the audio interface input stream, for offline replay (see tools/ai_replay.c).
+ *
+ * File layout (all integers are little endian):
+ *   header: "M64AIREC" magic, u32 version
+ *   events: u8 type, u32 time elapsed since previous event (in us), then
+ *     AI_RECORD_DACRATE: u32 system type, u32 AI_DACRATE register
+ *     AI_RECORD_LEN:     u32 length, followed by length bytes of samples as found in RDRAM
+ *     AI_RECORD_SPEED:   u32 speed factor (percent)
+ */
+
+#define AI_RECORD_MAGIC "M64AIREC"
+enum { AI_RECORD_VERSION = 1 };
+
+enum ai_record_type
+{
+    AI_RECORD_DACRATE = 'R',
+    AI_RECORD_LEN     = 'L',
+    AI_RECORD_SPEED   = 'S'
+};
+
+struct ai_recorder;
+
+struct ai_recorder* start_ai_recorder(const char* filename);
+
+void stop_ai_recorder(struct ai_recorder* recorder);
+
+void ai_record_dacrate(struct ai_recorder* recorder, int system_type, uint32_t dacrate);
+
+void ai_record_len(struct ai_recorder* recorder, const void* samples, uint32_t length);
+
+void ai_record_speed(struct ai_recorder* recorder, int percentage);
+
+#endif
@@ -0,0 +1,174 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "alist/alist.h"
+#include "alist/alist_kernels.h"
+
+#include "hot_log.h"
+#include "main.h"
+
+#include "m64p_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* OSTask header, at the end of DMEM */
+enum
+{
+    TASK_TYPE      = 0xfc0,
+    TASK_UCODE_DATA = 0xfd8,
+    TASK_DATA_PTR  = 0xff0,
+    TASK_DATA_SIZE = 0xff4
+};
+
+enum { M_AUDTASK = 2 };
+
+struct alist_hle* init_alist_hle(void)
+{
+    struct alist_hle* hle = calloc(1, sizeof(*hle));
+
+    if (hle == NULL) {
+        return NULL;
+    }
+
+    hle->buffer = calloc(1, ALIST_BUFFER_SIZE + ALIST_BUFFER_SLACK);
+    if (hle->buffer == NULL) {
+        free(hle);
+        return NULL;
+    }
+
+    return hle;
+}
+
+void release_alist_hle(struct alist_hle* hle)
+{
+    if (hle == NULL) {
+        return;
+    }
+
+    free(hle->buffer);
+    free(hle);
+}
+
+/* Identify the microcode from its data, the same way RSP HLE plugins do.
+ * Return its command set, or NULL if it isn't supported. */
+static void (*identify_ucode(struct alist_hle* hle, uint32_t* signature))(struct alist_hle*)
+{
+    uint32_t ucode_data = alist_dmem_u32(hle, TASK_UCODE_DATA);
+
+    *signature = *alist_dram_u32(hle, ucode_data);
+
+    if (*signature != 0x00000001) {
+        /* ABI3 and MusyX family: not supported */
+        return NULL;
+    }
+
+    if (*alist_dram_u32(hle, ucode_data + 0x30) != 0xf0000f00) {
+        /* ABI2 (Nead) family: not supported */
+        *signature = *alist_dram_u32(hle, ucode_data + 0x10);
+        return NULL;
+    }
+
+    *signature = *alist_dram_u32(hle, ucode_data + 0x28);
+
+    switch (*signature)
+    {
+    case 0x1e24138c: /* most common */
+        return alist_process_audio;
+    case 0x1dc8138c: /* GoldenEye */
+        return alist_process_audio_ge;
+    case 0x1e3c1390: /* Blast Corps, Diddy Kong Racing */
+        return alist_process_audio_bc;
+    default:
+        return NULL;
+    }
+}
+
+int alist_hle_process_task(struct alist_hle* hle, unsigned char* rdram, const unsigned char* dmem)
+{
+    void (*process)(struct alist_hle*);
+    uint32_t signature;
+
+    hle->rdram = rdram;
+    hle->dmem = dmem;
+
+    if (alist_dmem_u32(hle, TASK_TYPE) != M_AUDTASK) {
+        DebugMessage(M64MSG_WARNING, "ProcessAList: not an audio task (type %u)", alist_dmem_u32(hle, TASK_TYPE));
+        return -1;
+    }
+
+    process = identify_ucode(hle, &signature);
+    if (process == NULL) {
+        if (signature != hle->unsupported_ucode) {
+            DebugMessage(M64MSG_WARNING, "ProcessAList: unsupported audio microcode (%08x)", signature);
+            hle->unsupported_ucode = signature;
+        }
+        return -1;
+    }
+
+    process(hle);
+    return 0;
+}
+
+void alist_process(struct alist_hle* hle, const alist_command_t* commands, size_t command_count)
+{
+    uint32_t address = alist_dmem_u32(hle, TASK_DATA_PTR);
+    uint32_t end = address + (alist_dmem_u32(hle, TASK_DATA_SIZE) & ~7u);
+
+    for (; address != end; address += 8) {
+        uint32_t w1 = *alist_dram_u32(hle, address);
+        uint32_t w2 = *alist_dram_u32(hle, address + 4);
+        unsigned int command = (w1 >> 24) & 0x7f;
+
+        if (command < command_count) {
+            commands[command](hle, w1, w2);
+        }
+        else {
+            HOT_LOG(M64MSG_WARNING, "ProcessAList: invalid command %zu", command, 0);
+        }
+    }
+}
+
+uint32_t alist_get_address(struct alist_hle* hle, uint32_t so, const uint32_t* segments, size_t n)
+{
+    uint8_t segment = (so >> 24) & 0x3f;
+    uint32_t offset = so & 0xffffff;
+
+    if (segment >= n) {
+        HOT_LOG(M64MSG_WARNING, "ProcessAList: invalid segment %zu", segment, 0);
+        return offset;
+    }
+
+    return segments[segment] + offset;
+}
+
+void alist_set_address(struct alist_hle* hle, uint32_t so, uint32_t* segments, size_t n)
+{
+    uint8_t segment = (so >> 24) & 0x3f;
+    uint32_t offset = so & 0xffffff;
+
+    if (segment >= n) {
+        HOT_LOG(M64MSG_WARNING, "ProcessAList: invalid segment %zu", segment, 0);
+        return;
+    }
+
+    segments[segment] = offset;
+}
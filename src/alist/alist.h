@@ -0,0 +1,48 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_ALIST_ALIST_H
+#define M64P_ALIST_ALIST_H
+
+/* High level emulation of the RSP audio microcode, for ProcessAList.
+ *
+ * RSP plugins can forward audio tasks to the audio plugin instead of running
+ * them (e.g. mupen64plus-rsp-hle with AudioListToAudioPlugin). The task header
+ * is then read from the RSP data memory, and its command list is run against
+ * RDRAM and a private copy of the microcode's data buffer.
+ *
+ * Supported microcodes: the ABI1 family (SM64, Mario Kart 64 and most early
+ * games), including the GoldenEye and Blast Corps / Diddy Kong Racing variants.
+ * The ABI2 (Nead), ABI3 and MusyX families are not supported yet: they are reported
+ * once and left to the ALIST_FALLBACK RSP plugin (see rsp_fallback.h), if any.
+ */
+
+struct alist_hle;
+
+struct alist_hle* init_alist_hle(void);
+
+void release_alist_hle(struct alist_hle* hle);
+
+/* Run the audio task described by the task header in dmem.
+ * Return 0 if the task was processed, -1 if its microcode isn't supported. */
+int alist_hle_process_task(struct alist_hle* hle, unsigned char* rdram, const unsigned char* dmem);
+
+#endif
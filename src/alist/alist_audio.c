@@ -0,0 +1,308 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist_audio.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "alist/alist_kernels.h"
+
+#include <string.h>
+
+/* ABI1: the standard audio microcode command set, and the variants of GoldenEye and
+ * Blast Corps / Diddy Kong Racing which only differ by their envelope mixer */
+
+/* offset of the data buffer in DMEM */
+enum { DMEM_BASE = 0x5c0 };
+
+/* flags */
+enum
+{
+    A_INIT  = 0x01,
+    A_LOOP  = 0x02,
+    A_LEFT  = 0x02,
+    A_VOL   = 0x04,
+    A_AUX   = 0x08
+};
+
+static uint32_t get_address(struct alist_hle* hle, uint32_t so)
+{
+    return alist_get_address(hle, so, hle->audio.segments, ALIST_SEGMENTS);
+}
+
+static void SPNOOP(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+}
+
+static void CLEARBUFF(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint16_t dmem  = (uint16_t)(w1 + DMEM_BASE);
+    uint16_t count = w2 & 0xfff;
+
+    if (count == 0) {
+        return;
+    }
+
+    alist_clear(hle, dmem, alist_align(count, 16));
+}
+
+static void ENVMIXER(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t  flags   = (uint8_t)(w1 >> 16);
+    uint32_t address = get_address(hle, w2);
+    struct alist_audio* audio = &hle->audio;
+
+    alist_envmix_exp(hle,
+            flags & A_INIT,
+            flags & A_AUX,
+            audio->out, audio->dry_right,
+            audio->wet_left, audio->wet_right,
+            audio->in, audio->count,
+            audio->dry, audio->wet,
+            audio->vol, audio->target, audio->rate,
+            address);
+}
+
+static void ENVMIXER_GE(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t  flags   = (uint8_t)(w1 >> 16);
+    uint32_t address = get_address(hle, w2);
+    struct alist_audio* audio = &hle->audio;
+
+    alist_envmix_ge(hle,
+            flags & A_INIT,
+            flags & A_AUX,
+            audio->out, audio->dry_right,
+            audio->wet_left, audio->wet_right,
+            audio->in, audio->count,
+            audio->dry, audio->wet,
+            audio->vol, audio->target, audio->rate,
+            address);
+}
+
+static void RESAMPLE(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t  flags   = (uint8_t)(w1 >> 16);
+    uint16_t pitch   = (uint16_t)w1;
+    uint32_t address = get_address(hle, w2);
+
+    alist_resample(hle,
+            flags & A_INIT,
+            hle->audio.out,
+            hle->audio.in,
+            alist_align(hle->audio.count, 16),
+            (uint32_t)pitch << 1,
+            address);
+}
+
+static void SETVOL(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t flags = (uint8_t)(w1 >> 16);
+
+    if (flags & A_AUX) {
+        hle->audio.dry = (int16_t)w1;
+        hle->audio.wet = (int16_t)w2;
+    }
+    else {
+        unsigned int lr = (flags & A_LEFT) ? 0 : 1;
+
+        if (flags & A_VOL) {
+            hle->audio.vol[lr] = (int16_t)w1;
+        }
+        else {
+            hle->audio.target[lr] = (int16_t)w1;
+            hle->audio.rate[lr] = (int32_t)w2;
+        }
+    }
+}
+
+static void SETLOOP(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    hle->audio.loop = get_address(hle, w2);
+}
+
+static void ADPCM(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t  flags   = (uint8_t)(w1 >> 16);
+    uint32_t address = get_address(hle, w2);
+
+    alist_adpcm(hle,
+            flags & A_INIT,
+            flags & A_LOOP,
+            hle->audio.out,
+            hle->audio.in,
+            alist_align(hle->audio.count, 32),
+            hle->audio.table,
+            hle->audio.loop,
+            address);
+}
+
+static void LOADBUFF(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint32_t address = get_address(hle, w2);
+
+    if (hle->audio.count == 0) {
+        return;
+    }
+
+    alist_load(hle, hle->audio.in, address, hle->audio.count);
+}
+
+static void SAVEBUFF(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint32_t address = get_address(hle, w2);
+
+    if (hle->audio.count == 0) {
+        return;
+    }
+
+    alist_save(hle, hle->audio.out, address, hle->audio.count);
+}
+
+static void SETBUFF(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t flags = (uint8_t)(w1 >> 16);
+
+    if (flags & A_AUX) {
+        hle->audio.dry_right = (uint16_t)(w1 + DMEM_BASE);
+        hle->audio.wet_left  = (uint16_t)((w2 >> 16) + DMEM_BASE);
+        hle->audio.wet_right = (uint16_t)(w2 + DMEM_BASE);
+    }
+    else {
+        hle->audio.in    = (uint16_t)(w1 + DMEM_BASE);
+        hle->audio.out   = (uint16_t)((w2 >> 16) + DMEM_BASE);
+        hle->audio.count = (uint16_t)w2;
+    }
+}
+
+static void DMEMMOVE(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint16_t dmemi = (uint16_t)(w1 + DMEM_BASE);
+    uint16_t dmemo = (uint16_t)((w2 >> 16) + DMEM_BASE);
+    uint16_t count = (uint16_t)w2;
+
+    if (count == 0) {
+        return;
+    }
+
+    alist_move(hle, dmemo, dmemi, alist_align(count, 16));
+}
+
+static void LOADADPCM(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint16_t count   = (uint16_t)w1;
+    uint32_t address = get_address(hle, w2);
+    size_t words = alist_align(count, 8) >> 1;
+
+    if (words > sizeof(hle->audio.table) / sizeof(hle->audio.table[0])) {
+        words = sizeof(hle->audio.table) / sizeof(hle->audio.table[0]);
+    }
+
+    alist_load_table(hle, hle->audio.table, address, words);
+}
+
+static void INTERLEAVE(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint16_t left  = (uint16_t)((w2 >> 16) + DMEM_BASE);
+    uint16_t right = (uint16_t)(w2 + DMEM_BASE);
+
+    if (hle->audio.count == 0) {
+        return;
+    }
+
+    alist_interleave(hle, hle->audio.out, left, right, alist_align(hle->audio.count, 16));
+}
+
+static void MIXER(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    int16_t  gain  = (int16_t)w1;
+    uint16_t dmemi = (uint16_t)((w2 >> 16) + DMEM_BASE);
+    uint16_t dmemo = (uint16_t)(w2 + DMEM_BASE);
+
+    if (hle->audio.count == 0) {
+        return;
+    }
+
+    alist_mix(hle, dmemo, dmemi, alist_align(hle->audio.count, 32), gain);
+}
+
+static void SEGMENT(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    alist_set_address(hle, w2, hle->audio.segments, ALIST_SEGMENTS);
+}
+
+static void POLEF(struct alist_hle* hle, uint32_t w1, uint32_t w2)
+{
+    uint8_t  flags   = (uint8_t)(w1 >> 16);
+    uint16_t gain    = (uint16_t)w1;
+    uint32_t address = get_address(hle, w2);
+
+    if (hle->audio.count == 0) {
+        return;
+    }
+
+    alist_polef(hle,
+            flags & A_INIT,
+            hle->audio.out,
+            hle->audio.in,
+            alist_align(hle->audio.count, 16),
+            gain,
+            hle->audio.table,
+            address);
+}
+
+void alist_process_audio(struct alist_hle* hle)
+{
+    static const alist_command_t commands[0x10] = {
+        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER,
+        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+    };
+
+    memset(hle->audio.segments, 0, sizeof(hle->audio.segments));
+
+    alist_process(hle, commands, 0x10);
+}
+
+void alist_process_audio_ge(struct alist_hle* hle)
+{
+    static const alist_command_t commands[0x10] = {
+        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER_GE,
+        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+    };
+
+    memset(hle->audio.segments, 0, sizeof(hle->audio.segments));
+
+    alist_process(hle, commands, 0x10);
+}
+
+void alist_process_audio_bc(struct alist_hle* hle)
+{
+    static const alist_command_t commands[0x10] = {
+        SPNOOP,         ADPCM,          CLEARBUFF,      ENVMIXER_GE,
+        LOADBUFF,       RESAMPLE,       SAVEBUFF,       SEGMENT,
+        SETBUFF,        SETVOL,         DMEMMOVE,       LOADADPCM,
+        MIXER,          INTERLEAVE,     POLEF,          SETLOOP
+    };
+
+    memset(hle->audio.segments, 0, sizeof(hle->audio.segments));
+
+    alist_process(hle, commands, 0x10);
+}
@@ -0,0 +1,833 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist_kernels.c                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "alist/alist_kernels.h"
+#include "dsp/dsp_simd.h"
+
+#include <string.h>
+
+/* Kernels of the audio microcode commands.
+ *
+ * The mixing, envelope, ADPCM, resampling and pole filter kernels have SSE2 inner loops
+ * which give the same results as their scalar versions, bit for bit. Blocks of 8 samples
+ * keep the swizzled layout of the data buffer, which doesn't matter to element-wise
+ * operations as long as per-sample parameters are swizzled the same way.
+ * Commands working on overlapping buffers depend on the order samples are processed in,
+ * they take the scalar path. */
+
+static inline int16_t clamp_s16(int32_t x)
+{
+    return (int16_t)((x < -32768) ? -32768 : (x > 32767) ? 32767 : x);
+}
+
+/* RSP VMULF: signed fractional multiply, rounded and saturated */
+static inline int16_t vmulf(int16_t x, int16_t y)
+{
+    return clamp_s16(((int32_t)x * y + 0x4000) >> 15);
+}
+
+#if !defined(DSP_SSE2)
+static int32_t rdot(size_t n, const int16_t* x, const int16_t* y)
+{
+    int32_t accu = 0;
+
+    y += n;
+
+    while (n != 0) {
+        accu += *(x++) * *(--y);
+        --n;
+    }
+
+    return accu;
+}
+#endif
+
+/* bounds checked RDRAM span */
+static unsigned char* dram_span(struct alist_hle* hle, uint32_t address, size_t* size)
+{
+    address &= ALIST_RDRAM_SIZE - 1;
+
+    if (address + *size > ALIST_RDRAM_SIZE) {
+        *size = ALIST_RDRAM_SIZE - address;
+    }
+
+    return hle->rdram + address;
+}
+
+#if defined(DSP_SSE2)
+/* a*b as 8 32-bit products, in two halves */
+static inline void mul_epi16_epi32(__m128i a, __m128i b, __m128i* lo, __m128i* hi)
+{
+    __m128i l = _mm_mullo_epi16(a, b);
+    __m128i h = _mm_mulhi_epi16(a, b);
+
+    *lo = _mm_unpacklo_epi16(l, h);
+    *hi = _mm_unpackhi_epi16(l, h);
+}
+
+/* vmulf on 8 lanes */
+static inline __m128i mulf_epi16(__m128i a, __m128i b)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i lo, hi;
+
+    mul_epi16_epi32(a, b, &lo, &hi);
+
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 15);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 15);
+
+    return _mm_packs_epi32(lo, hi);
+}
+#endif
+
+/* true if sample blocks of [a, a + n) and [b, b + n) overlap, other than exactly */
+static int blocks_overlap(const int16_t* a, const int16_t* b, size_t n)
+{
+    return (a != b) && (a < b + n) && (b < a + n);
+}
+
+/* dst[i] = clamp(dst[i] + vmulf(src[i], gains[i])) on a block of 8 samples */
+static void mix8(int16_t* dst, const int16_t* src, const int16_t* gains)
+{
+#if defined(DSP_SSE2)
+    __m128i x = _mm_loadu_si128((const __m128i*)src);
+    __m128i g = _mm_loadu_si128((const __m128i*)gains);
+    __m128i y = _mm_loadu_si128((const __m128i*)dst);
+
+    _mm_storeu_si128((__m128i*)dst, _mm_adds_epi16(y, mulf_epi16(x, g)));
+#else
+    size_t i;
+
+    for (i = 0; i < 8; ++i) {
+        dst[i] = clamp_s16(dst[i] + vmulf(src[i], gains[i]));
+    }
+#endif
+}
+
+/* Order 2 prediction of 8 samples, shared by ADPCM and POLEF:
+ * dst[i] = clamp((base[i] + c1[i]*l1 + c2[i]*l2 + sum(h[i-1-k]*x[k], k < i)) >> shift) */
+static void predict8(int16_t* dst, const int32_t* base,
+        const int16_t* c1, int16_t l1, const int16_t* c2, int16_t l2,
+        const int16_t* h, const int16_t* x, unsigned int shift)
+{
+#if defined(DSP_SSE2)
+    __m128i acc_lo = _mm_loadu_si128((const __m128i*)base);
+    __m128i acc_hi = _mm_loadu_si128((const __m128i*)(base + 4));
+    __m128i taps = _mm_loadu_si128((const __m128i*)h);
+    __m128i lo, hi;
+
+#define PREDICT8_TERM(coefs, sample) \
+    mul_epi16_epi32((coefs), _mm_set1_epi16(sample), &lo, &hi); \
+    acc_lo = _mm_add_epi32(acc_lo, lo); \
+    acc_hi = _mm_add_epi32(acc_hi, hi)
+
+    PREDICT8_TERM(_mm_loadu_si128((const __m128i*)c1), l1);
+    PREDICT8_TERM(_mm_loadu_si128((const __m128i*)c2), l2);
+
+    /* x[k] contributes to the samples after it, through the taps shifted by k+1 lanes */
+    PREDICT8_TERM(_mm_slli_si128(taps, 2), x[0]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 4), x[1]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 6), x[2]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 8), x[3]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 10), x[4]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 12), x[5]);
+    PREDICT8_TERM(_mm_slli_si128(taps, 14), x[6]);
+
+#undef PREDICT8_TERM
+
+    acc_lo = _mm_sra_epi32(acc_lo, _mm_cvtsi32_si128((int)shift));
+    acc_hi = _mm_sra_epi32(acc_hi, _mm_cvtsi32_si128((int)shift));
+
+    _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(acc_lo, acc_hi));
+#else
+    size_t i;
+
+    for (i = 0; i < 8; ++i) {
+        int32_t accu = base[i] + c1[i] * l1 + c2[i] * l2 + rdot(i, h, x);
+        dst[i] = clamp_s16(accu >> shift);
+    }
+#endif
+}
+
+
+void alist_clear(struct alist_hle* hle, uint16_t dmem, uint16_t count)
+{
+    while (count != 0) {
+        *alist_u8(hle, dmem++) = 0;
+        --count;
+    }
+}
+
+void alist_load(struct alist_hle* hle, uint16_t dmem, uint32_t address, uint16_t count)
+{
+    size_t size;
+
+    /* enforce DMA alignment constraints */
+    dmem &= ~3;
+    address &= ~7;
+    size = alist_align(count, 8);
+
+    memcpy(hle->buffer + (dmem & 0xfff), dram_span(hle, address, &size), size);
+}
+
+void alist_save(struct alist_hle* hle, uint16_t dmem, uint32_t address, uint16_t count)
+{
+    size_t size;
+
+    /* enforce DMA alignment constraints */
+    dmem &= ~3;
+    address &= ~7;
+    size = alist_align(count, 8);
+
+    memcpy(dram_span(hle, address, &size), hle->buffer + (dmem & 0xfff), size);
+}
+
+void alist_move(struct alist_hle* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count)
+{
+    while (count != 0) {
+        *alist_u8(hle, dmemo++) = *alist_u8(hle, dmemi++);
+        --count;
+    }
+}
+
+void alist_load_table(struct alist_hle* hle, int16_t* table, uint32_t address, size_t count)
+{
+    while (count != 0) {
+        *(table++) = (int16_t)*alist_dram_u16(hle, address);
+        address += 2;
+        --count;
+    }
+}
+
+void alist_interleave(struct alist_hle* hle, uint16_t dmemo, uint16_t left, uint16_t right, uint16_t count)
+{
+    uint16_t* dst = (uint16_t*)alist_block(hle, dmemo);
+    const uint16_t* src_left = (const uint16_t*)alist_block(hle, left);
+    const uint16_t* src_right = (const uint16_t*)alist_block(hle, right);
+
+    count >>= 2;
+
+    while (count != 0) {
+        uint16_t l1 = *(src_left++);
+        uint16_t l2 = *(src_left++);
+        uint16_t r1 = *(src_right++);
+        uint16_t r2 = *(src_right++);
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        *(dst++) = l1;
+        *(dst++) = r1;
+        *(dst++) = l2;
+        *(dst++) = r2;
+#else
+        *(dst++) = r2;
+        *(dst++) = l2;
+        *(dst++) = r1;
+        *(dst++) = l1;
+#endif
+        --count;
+    }
+}
+
+void alist_mix(struct alist_hle* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count, int16_t gain)
+{
+    int16_t* dst = alist_block(hle, dmemo);
+    const int16_t* src = alist_block(hle, dmemi);
+    int16_t gains[8];
+    size_t n = count >> 1;
+    size_t i;
+
+    for (i = 0; i < 8; ++i) {
+        gains[i] = gain;
+    }
+
+    if (!blocks_overlap(dst, src, n)) {
+        for (i = 0; i + 8 <= n; i += 8) {
+            mix8(dst + i, src + i, gains);
+        }
+    }
+    else {
+        i = 0;
+    }
+
+    for (; i < n; ++i) {
+        dst[i] = clamp_s16(dst[i] + vmulf(src[i], gain));
+    }
+}
+
+
+/* ----------- envelope mixer ------------- */
+
+struct ramp
+{
+    int64_t value;
+    int64_t step;
+    int64_t target;
+};
+
+static int16_t ramp_step(struct ramp* ramp)
+{
+    int target_reached;
+
+    ramp->value += ramp->step;
+
+    target_reached = (ramp->step <= 0)
+        ? (ramp->value <= ramp->target)
+        : (ramp->value >= ramp->target);
+
+    if (target_reached) {
+        ramp->value = ramp->target;
+        ramp->step = 0;
+    }
+
+    return (int16_t)(ramp->value >> 16);
+}
+
+/* the state saved in RDRAM between calls, as 16-bit words */
+enum { ENVMIX_STATE_WORDS = 40 };
+
+static int32_t get_state32(const int16_t* state, size_t index)
+{
+    int32_t value;
+    memcpy(&value, state + index, sizeof(value));
+    return value;
+}
+
+static void set_state32(int16_t* state, size_t index, int32_t value)
+{
+    memcpy(state + index, &value, sizeof(value));
+}
+
+/* gains of the next sample from the envelopes, stored at index x */
+static void envmix_gains(struct ramp* ramps, int16_t dry, int16_t wet, int16_t gains[4][8], unsigned int x)
+{
+    int16_t l_vol = ramp_step(&ramps[0]);
+    int16_t r_vol = ramp_step(&ramps[1]);
+
+    gains[0][x] = clamp_s16((l_vol * dry + 0x4000) >> 15);
+    gains[1][x] = clamp_s16((r_vol * dry + 0x4000) >> 15);
+    gains[2][x] = clamp_s16((l_vol * wet + 0x4000) >> 15);
+    gains[3][x] = clamp_s16((r_vol * wet + 0x4000) >> 15);
+}
+
+/* true if the n output buffers may be mixed by blocks: none of them overlaps the input
+ * or another one over size samples */
+static int envmix_blocks(int16_t* const* buffers, size_t n, const int16_t* in, size_t size)
+{
+    size_t k, l;
+
+    for (k = 0; k < n; ++k) {
+        if (blocks_overlap(buffers[k], in, size)) {
+            return 0;
+        }
+        for (l = 0; l < k; ++l) {
+            if (blocks_overlap(buffers[k], buffers[l], size)) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void alist_envmix_exp(struct alist_hle* hle, int init, int aux,
+        uint16_t dmem_dl, uint16_t dmem_dr, uint16_t dmem_wl, uint16_t dmem_wr,
+        uint16_t dmemi, uint16_t count,
+        int16_t dry, int16_t wet,
+        const int16_t* vol, const int16_t* target, const int32_t* rate,
+        uint32_t address)
+{
+    size_t n = (aux) ? 4 : 2;
+
+    const int16_t* const in = alist_block(hle, dmemi);
+    int16_t* const buffers[4] = {
+        alist_block(hle, dmem_dl),
+        alist_block(hle, dmem_dr),
+        alist_block(hle, dmem_wl),
+        alist_block(hle, dmem_wr)
+    };
+
+    struct ramp ramps[2];
+    int32_t exp_seq[2];
+    int32_t exp_rates[2];
+    int16_t state[ENVMIX_STATE_WORDS];
+    size_t state_size = sizeof(state);
+    uint32_t ptr = 0;
+    unsigned int y;
+    size_t k;
+    int blocks = envmix_blocks(buffers, n, in, count / 2 + 8);
+
+    if (init) {
+        memset(state, 0, sizeof(state));
+        ramps[0].value  = (int64_t)vol[0] << 16;
+        ramps[1].value  = (int64_t)vol[1] << 16;
+        ramps[0].target = (int64_t)target[0] << 16;
+        ramps[1].target = (int64_t)target[1] << 16;
+        exp_rates[0]    = rate[0];
+        exp_rates[1]    = rate[1];
+        exp_seq[0]      = vol[0] * rate[0];
+        exp_seq[1]      = vol[1] * rate[1];
+    }
+    else {
+        memcpy(state, dram_span(hle, address, &state_size), state_size);
+        wet             = state[0];
+        dry             = state[2];
+        ramps[0].target = get_state32(state, 4);
+        ramps[1].target = get_state32(state, 6);
+        exp_rates[0]    = get_state32(state, 8);
+        exp_rates[1]    = get_state32(state, 10);
+        exp_seq[0]      = get_state32(state, 12);
+        exp_seq[1]      = get_state32(state, 14);
+        ramps[0].value  = get_state32(state, 16);
+        ramps[1].value  = get_state32(state, 18);
+    }
+
+    /* step != 0 iff value != target */
+    ramps[0].step = ramps[0].target - ramps[0].value;
+    ramps[1].step = ramps[1].target - ramps[1].value;
+
+    for (y = 0; y < count; y += 16) {
+        int16_t gains[4][8];
+        unsigned int x;
+
+        if (ramps[0].step != 0) {
+            exp_seq[0] = (int32_t)(((int64_t)exp_seq[0] * exp_rates[0]) >> 16);
+            ramps[0].step = (exp_seq[0] - ramps[0].value) >> 3;
+        }
+
+        if (ramps[1].step != 0) {
+            exp_seq[1] = (int32_t)(((int64_t)exp_seq[1] * exp_rates[1]) >> 16);
+            ramps[1].step = (exp_seq[1] - ramps[1].value) >> 3;
+        }
+
+        /* per sample gains, swizzled like the samples */
+        for (x = 0; x < 8; ++x) {
+            envmix_gains(ramps, dry, wet, gains, x ^ ALIST_S);
+        }
+
+        if (blocks) {
+            for (k = 0; k < n; ++k) {
+                mix8(buffers[k] + ptr, in + ptr, gains[k]);
+            }
+        }
+        else {
+            /* in sample order, as the outputs may feed the next samples */
+            for (x = 0; x < 8; ++x) {
+                uint32_t i = ptr + (x ^ ALIST_S);
+
+                for (k = 0; k < n; ++k) {
+                    buffers[k][i] = clamp_s16(buffers[k][i] + vmulf(in[i], gains[k][x ^ ALIST_S]));
+                }
+            }
+        }
+
+        ptr += 8;
+    }
+
+    /* the other words of a loaded state are written back unchanged */
+    state[0] = wet;
+    state[2] = dry;
+    set_state32(state, 4, (int32_t)ramps[0].target);
+    set_state32(state, 6, (int32_t)ramps[1].target);
+    set_state32(state, 8, exp_rates[0]);
+    set_state32(state, 10, exp_rates[1]);
+    set_state32(state, 12, exp_seq[0]);
+    set_state32(state, 14, exp_seq[1]);
+    set_state32(state, 16, (int32_t)ramps[0].value);
+    set_state32(state, 18, (int32_t)ramps[1].value);
+
+    state_size = sizeof(state);
+    memcpy(dram_span(hle, address, &state_size), state, state_size);
+}
+
+
+/* Linear envelopes, by steps of rate / 8 per sample, of GoldenEye and Blast Corps */
+void alist_envmix_ge(struct alist_hle* hle, int init, int aux,
+        uint16_t dmem_dl, uint16_t dmem_dr, uint16_t dmem_wl, uint16_t dmem_wr,
+        uint16_t dmemi, uint16_t count,
+        int16_t dry, int16_t wet,
+        const int16_t* vol, const int16_t* target, const int32_t* rate,
+        uint32_t address)
+{
+    size_t n = (aux) ? 4 : 2;
+
+    const int16_t* const in = alist_block(hle, dmemi);
+    int16_t* const buffers[4] = {
+        alist_block(hle, dmem_dl),
+        alist_block(hle, dmem_dr),
+        alist_block(hle, dmem_wl),
+        alist_block(hle, dmem_wr)
+    };
+
+    struct ramp ramps[2];
+    int16_t gains[4][8];
+    int16_t state[ENVMIX_STATE_WORDS];
+    size_t state_size = sizeof(state);
+    size_t samples = count >> 1;
+    size_t ptr = 0;
+    unsigned int x;
+    size_t k;
+
+    if (init) {
+        memset(state, 0, sizeof(state));
+        ramps[0].value  = (int64_t)vol[0] << 16;
+        ramps[1].value  = (int64_t)vol[1] << 16;
+        ramps[0].target = (int64_t)target[0] << 16;
+        ramps[1].target = (int64_t)target[1] << 16;
+        ramps[0].step   = rate[0] / 8;
+        ramps[1].step   = rate[1] / 8;
+    }
+    else {
+        memcpy(state, dram_span(hle, address, &state_size), state_size);
+        wet             = state[0];
+        dry             = state[2];
+        ramps[0].target = get_state32(state, 4);
+        ramps[1].target = get_state32(state, 6);
+        ramps[0].step   = get_state32(state, 8);
+        ramps[1].step   = get_state32(state, 10);
+        ramps[0].value  = get_state32(state, 16);
+        ramps[1].value  = get_state32(state, 18);
+    }
+
+    if (envmix_blocks(buffers, n, in, samples + 8)) {
+        for (; ptr + 8 <= samples; ptr += 8) {
+            /* per sample gains, swizzled like the samples */
+            for (x = 0; x < 8; ++x) {
+                envmix_gains(ramps, dry, wet, gains, x ^ ALIST_S);
+            }
+
+            for (k = 0; k < n; ++k) {
+                mix8(buffers[k] + ptr, in + ptr, gains[k]);
+            }
+        }
+    }
+
+    /* in sample order, as overlapping outputs may feed the next samples */
+    for (; ptr < samples; ++ptr) {
+        size_t i = ptr ^ ALIST_S;
+
+        envmix_gains(ramps, dry, wet, gains, 0);
+
+        for (k = 0; k < n; ++k) {
+            buffers[k][i] = clamp_s16(buffers[k][i] + vmulf(in[i], gains[k][0]));
+        }
+    }
+
+    /* the other words of a loaded state are written back unchanged */
+    state[0] = wet;
+    state[2] = dry;
+    set_state32(state, 4, (int32_t)ramps[0].target);
+    set_state32(state, 6, (int32_t)ramps[1].target);
+    set_state32(state, 8, (int32_t)ramps[0].step);
+    set_state32(state, 10, (int32_t)ramps[1].step);
+    set_state32(state, 16, (int32_t)ramps[0].value);
+    set_state32(state, 18, (int32_t)ramps[1].value);
+
+    state_size = sizeof(state);
+    memcpy(dram_span(hle, address, &state_size), state, state_size);
+}
+
+/* ----------- ADPCM ------------- */
+
+static int16_t adpcm_predict_sample(uint8_t byte, uint8_t mask, unsigned int lshift, unsigned int rshift)
+{
+    int16_t sample = (int16_t)((uint16_t)(byte & mask) << lshift);
+    sample >>= rshift; /* signed */
+    return sample;
+}
+
+void alist_adpcm(struct alist_hle* hle, int init, int loop,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        const int16_t* codebook, uint32_t loop_address, uint32_t last_frame_address)
+{
+    int16_t last_frame[16];
+    size_t i;
+
+    if (init) {
+        memset(last_frame, 0, sizeof(last_frame));
+    }
+    else {
+        alist_load_table(hle, last_frame, (loop) ? loop_address : last_frame_address, 16);
+    }
+
+    for (i = 0; i < 16; ++i, dmemo += 2) {
+        *alist_s16(hle, dmemo) = last_frame[i];
+    }
+
+    while (count >= 32) {
+        int16_t frame[16];
+        int32_t base[16];
+        uint8_t code = *alist_u8(hle, dmemi++);
+        unsigned int scale = (code & 0xf0) >> 4;
+        unsigned int rshift = (scale < 12) ? 12 - scale : 0;
+        const int16_t* const book1 = codebook + ((code & 0xf) << 4);
+        const int16_t* const book2 = book1 + 8;
+
+        for (i = 0; i < 8; ++i) {
+            uint8_t byte = *alist_u8(hle, dmemi++);
+
+            frame[2 * i]     = adpcm_predict_sample(byte, 0xf0,  8, rshift);
+            frame[2 * i + 1] = adpcm_predict_sample(byte, 0x0f, 12, rshift);
+        }
+
+        for (i = 0; i < 16; ++i) {
+            base[i] = (int32_t)frame[i] << 11;
+        }
+
+        /* each half is predicted from the last two samples before it */
+        predict8(last_frame, base, book1, last_frame[14], book2, last_frame[15], book2, frame, 11);
+        predict8(last_frame + 8, base + 8, book1, last_frame[6], book2, last_frame[7], book2, frame + 8, 11);
+
+        for (i = 0; i < 16; ++i, dmemo += 2) {
+            *alist_s16(hle, dmemo) = last_frame[i];
+        }
+
+        count -= 32;
+    }
+
+    for (i = 0; i < 16; ++i) {
+        *alist_dram_u16(hle, last_frame_address + 2 * i) = (uint16_t)last_frame[i];
+    }
+}
+
+
+/* ----------- resampler ------------- */
+
+/* 4 taps interpolation filter of the microcode, for 64 phases */
+static const int16_t RESAMPLE_LUT[64 * 4] =
+{
+    (int16_t)0x0c39, (int16_t)0x66ad, (int16_t)0x0d46, (int16_t)0xffdf,
+    (int16_t)0x0b39, (int16_t)0x6696, (int16_t)0x0e5f, (int16_t)0xffd8,
+    (int16_t)0x0a44, (int16_t)0x6669, (int16_t)0x0f83, (int16_t)0xffd0,
+    (int16_t)0x095a, (int16_t)0x6626, (int16_t)0x10b4, (int16_t)0xffc8,
+    (int16_t)0x087d, (int16_t)0x65cd, (int16_t)0x11f0, (int16_t)0xffbf,
+    (int16_t)0x07ab, (int16_t)0x655e, (int16_t)0x1338, (int16_t)0xffb6,
+    (int16_t)0x06e4, (int16_t)0x64d9, (int16_t)0x148c, (int16_t)0xffac,
+    (int16_t)0x0628, (int16_t)0x643f, (int16_t)0x15eb, (int16_t)0xffa1,
+    (int16_t)0x0577, (int16_t)0x638f, (int16_t)0x1756, (int16_t)0xff96,
+    (int16_t)0x04d1, (int16_t)0x62cb, (int16_t)0x18cb, (int16_t)0xff8a,
+    (int16_t)0x0435, (int16_t)0x61f3, (int16_t)0x1a4c, (int16_t)0xff7e,
+    (int16_t)0x03a4, (int16_t)0x6106, (int16_t)0x1bd7, (int16_t)0xff71,
+    (int16_t)0x031c, (int16_t)0x6007, (int16_t)0x1d6c, (int16_t)0xff64,
+    (int16_t)0x029f, (int16_t)0x5ef5, (int16_t)0x1f0b, (int16_t)0xff56,
+    (int16_t)0x022a, (int16_t)0x5dd0, (int16_t)0x20b3, (int16_t)0xff48,
+    (int16_t)0x01be, (int16_t)0x5c9a, (int16_t)0x2264, (int16_t)0xff3a,
+    (int16_t)0x015b, (int16_t)0x5b53, (int16_t)0x241e, (int16_t)0xff2c,
+    (int16_t)0x0101, (int16_t)0x59fc, (int16_t)0x25e0, (int16_t)0xff1e,
+    (int16_t)0x00ae, (int16_t)0x5896, (int16_t)0x27a9, (int16_t)0xff10,
+    (int16_t)0x0063, (int16_t)0x5720, (int16_t)0x297a, (int16_t)0xff02,
+    (int16_t)0x001f, (int16_t)0x559d, (int16_t)0x2b50, (int16_t)0xfef4,
+    (int16_t)0xffe2, (int16_t)0x540d, (int16_t)0x2d2c, (int16_t)0xfee8,
+    (int16_t)0xffac, (int16_t)0x5270, (int16_t)0x2f0d, (int16_t)0xfedb,
+    (int16_t)0xff7c, (int16_t)0x50c7, (int16_t)0x30f3, (int16_t)0xfed0,
+    (int16_t)0xff53, (int16_t)0x4f14, (int16_t)0x32dc, (int16_t)0xfec6,
+    (int16_t)0xff2e, (int16_t)0x4d57, (int16_t)0x34c8, (int16_t)0xfebd,
+    (int16_t)0xff0f, (int16_t)0x4b91, (int16_t)0x36b6, (int16_t)0xfeb6,
+    (int16_t)0xfef5, (int16_t)0x49c2, (int16_t)0x38a5, (int16_t)0xfeb0,
+    (int16_t)0xfedf, (int16_t)0x47ed, (int16_t)0x3a95, (int16_t)0xfeac,
+    (int16_t)0xfece, (int16_t)0x4611, (int16_t)0x3c85, (int16_t)0xfeab,
+    (int16_t)0xfec0, (int16_t)0x4430, (int16_t)0x3e74, (int16_t)0xfeac,
+    (int16_t)0xfeb6, (int16_t)0x424a, (int16_t)0x4060, (int16_t)0xfeaf,
+    (int16_t)0xfeaf, (int16_t)0x4060, (int16_t)0x424a, (int16_t)0xfeb6,
+    (int16_t)0xfeac, (int16_t)0x3e74, (int16_t)0x4430, (int16_t)0xfec0,
+    (int16_t)0xfeab, (int16_t)0x3c85, (int16_t)0x4611, (int16_t)0xfece,
+    (int16_t)0xfeac, (int16_t)0x3a95, (int16_t)0x47ed, (int16_t)0xfedf,
+    (int16_t)0xfeb0, (int16_t)0x38a5, (int16_t)0x49c2, (int16_t)0xfef5,
+    (int16_t)0xfeb6, (int16_t)0x36b6, (int16_t)0x4b91, (int16_t)0xff0f,
+    (int16_t)0xfebd, (int16_t)0x34c8, (int16_t)0x4d57, (int16_t)0xff2e,
+    (int16_t)0xfec6, (int16_t)0x32dc, (int16_t)0x4f14, (int16_t)0xff53,
+    (int16_t)0xfed0, (int16_t)0x30f3, (int16_t)0x50c7, (int16_t)0xff7c,
+    (int16_t)0xfedb, (int16_t)0x2f0d, (int16_t)0x5270, (int16_t)0xffac,
+    (int16_t)0xfee8, (int16_t)0x2d2c, (int16_t)0x540d, (int16_t)0xffe2,
+    (int16_t)0xfef4, (int16_t)0x2b50, (int16_t)0x559d, (int16_t)0x001f,
+    (int16_t)0xff02, (int16_t)0x297a, (int16_t)0x5720, (int16_t)0x0063,
+    (int16_t)0xff10, (int16_t)0x27a9, (int16_t)0x5896, (int16_t)0x00ae,
+    (int16_t)0xff1e, (int16_t)0x25e0, (int16_t)0x59fc, (int16_t)0x0101,
+    (int16_t)0xff2c, (int16_t)0x241e, (int16_t)0x5b53, (int16_t)0x015b,
+    (int16_t)0xff3a, (int16_t)0x2264, (int16_t)0x5c9a, (int16_t)0x01be,
+    (int16_t)0xff48, (int16_t)0x20b3, (int16_t)0x5dd0, (int16_t)0x022a,
+    (int16_t)0xff56, (int16_t)0x1f0b, (int16_t)0x5ef5, (int16_t)0x029f,
+    (int16_t)0xff64, (int16_t)0x1d6c, (int16_t)0x6007, (int16_t)0x031c,
+    (int16_t)0xff71, (int16_t)0x1bd7, (int16_t)0x6106, (int16_t)0x03a4,
+    (int16_t)0xff7e, (int16_t)0x1a4c, (int16_t)0x61f3, (int16_t)0x0435,
+    (int16_t)0xff8a, (int16_t)0x18cb, (int16_t)0x62cb, (int16_t)0x04d1,
+    (int16_t)0xff96, (int16_t)0x1756, (int16_t)0x638f, (int16_t)0x0577,
+    (int16_t)0xffa1, (int16_t)0x15eb, (int16_t)0x643f, (int16_t)0x0628,
+    (int16_t)0xffac, (int16_t)0x148c, (int16_t)0x64d9, (int16_t)0x06e4,
+    (int16_t)0xffb6, (int16_t)0x1338, (int16_t)0x655e, (int16_t)0x07ab,
+    (int16_t)0xffbf, (int16_t)0x11f0, (int16_t)0x65cd, (int16_t)0x087d,
+    (int16_t)0xffc8, (int16_t)0x10b4, (int16_t)0x6626, (int16_t)0x095a,
+    (int16_t)0xffd0, (int16_t)0x0f83, (int16_t)0x6669, (int16_t)0x0a44,
+    (int16_t)0xffd8, (int16_t)0x0e5f, (int16_t)0x6696, (int16_t)0x0b39,
+    (int16_t)0xffdf, (int16_t)0x0d46, (int16_t)0x66ad, (int16_t)0x0c39
+};
+
+static inline int16_t* sample(struct alist_hle* hle, unsigned int pos)
+{
+    return (int16_t*)hle->buffer + ((pos ^ ALIST_S) & 0x7ff);
+}
+
+void alist_resample(struct alist_hle* hle, int init,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        uint32_t pitch, uint32_t address)
+{
+    uint32_t pitch_accu;
+    uint16_t ipos = dmemi >> 1;
+    uint16_t opos = dmemo >> 1;
+    unsigned int k;
+
+    count >>= 1;
+    ipos -= 4;
+
+    if (init) {
+        for (k = 0; k < 4; ++k) {
+            *sample(hle, ipos + k) = 0;
+        }
+        pitch_accu = 0;
+    }
+    else {
+        for (k = 0; k < 4; ++k) {
+            *sample(hle, ipos + k) = (int16_t)*alist_dram_u16(hle, address + 2 * k);
+        }
+        pitch_accu = *alist_dram_u16(hle, address + 8);
+    }
+
+#if defined(DSP_SSE2)
+    /* the positions only depend on the pitch: gather 4 outputs worth of samples and taps.
+     * With a pitch below 2, the inputs of a block lie within 12 samples of the first one,
+     * none of which may be written by the block itself */
+    while (count >= 4 && pitch < 0x20000
+            && ((opos - ipos) & 0x7ff) >= 12 && ((opos - ipos) & 0x7ff) <= 0x7fc) {
+        int16_t samples[16];
+        int16_t taps[16];
+        int16_t out[8];
+        __m128i p0, p1, even, odd, sum;
+        unsigned int o;
+
+        for (o = 0; o < 4; ++o) {
+            const int16_t* lut = RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8);
+
+            for (k = 0; k < 4; ++k) {
+                samples[4 * o + k] = *sample(hle, ipos + k);
+                taps[4 * o + k] = lut[k];
+            }
+
+            pitch_accu += pitch;
+            ipos += (pitch_accu >> 16);
+            pitch_accu &= 0xffff;
+        }
+
+        p0 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)samples), _mm_loadu_si128((const __m128i*)taps));
+        p1 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(samples + 8)), _mm_loadu_si128((const __m128i*)(taps + 8)));
+
+        /* sum the pairs of each output */
+        even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(p0), _mm_castsi128_ps(p1), _MM_SHUFFLE(2, 0, 2, 0)));
+        odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(p0), _mm_castsi128_ps(p1), _MM_SHUFFLE(3, 1, 3, 1)));
+        sum = _mm_srai_epi32(_mm_add_epi32(even, odd), 15);
+
+        _mm_storeu_si128((__m128i*)out, _mm_packs_epi32(sum, sum));
+
+        for (o = 0; o < 4; ++o) {
+            *sample(hle, opos++) = out[o];
+        }
+
+        count -= 4;
+    }
+#endif
+
+    while (count != 0) {
+        const int16_t* lut = RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8);
+
+        *sample(hle, opos++) = clamp_s16((
+            (*sample(hle, ipos    ) * lut[0]) +
+            (*sample(hle, ipos + 1) * lut[1]) +
+            (*sample(hle, ipos + 2) * lut[2]) +
+            (*sample(hle, ipos + 3) * lut[3])) >> 15);
+
+        pitch_accu += pitch;
+        ipos += (pitch_accu >> 16);
+        pitch_accu &= 0xffff;
+        --count;
+    }
+
+    for (k = 0; k < 4; ++k) {
+        *alist_dram_u16(hle, address + 2 * k) = (uint16_t)*sample(hle, ipos + k);
+    }
+    *alist_dram_u16(hle, address + 8) = (uint16_t)pitch_accu;
+}
+
+
+/* ----------- pole filter ------------- */
+
+void alist_polef(struct alist_hle* hle, int init,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        uint16_t gain, int16_t* table, uint32_t address)
+{
+    const int16_t* const h1 = table;
+    int16_t* const h2 = table + 8;
+    int16_t h2_before[8];
+    int16_t l1, l2;
+    unsigned int i;
+
+    count = alist_align(count, 16);
+
+    if (init) {
+        l1 = 0;
+        l2 = 0;
+    }
+    else {
+        l1 = (int16_t)*alist_dram_u16(hle, address + 4);
+        l2 = (int16_t)*alist_dram_u16(hle, address + 6);
+    }
+
+    /* like the microcode, scale the coefficients in place */
+    for (i = 0; i < 8; ++i) {
+        h2_before[i] = h2[i];
+        h2[i] = (int16_t)(((int32_t)h2[i] * gain) >> 14);
+    }
+
+    while (count != 0) {
+        int16_t frame[8];
+        int16_t out[8];
+        int32_t base[8];
+
+        for (i = 0; i < 8; ++i, dmemi += 2) {
+            frame[i] = *alist_s16(hle, dmemi);
+            base[i] = frame[i] * gain;
+        }
+
+        predict8(out, base, h1, l1, h2_before, l2, h2, frame, 14);
+
+        for (i = 0; i < 8; ++i) {
+            *alist_s16(hle, dmemo + 2 * i) = out[i];
+        }
+
+        l1 = out[6];
+        l2 = out[7];
+
+        dmemo += 16;
+        count -= 16;
+    }
+
+    /* last 4 samples */
+    for (i = 0; i < 4; ++i) {
+        *alist_dram_u16(hle, address + 2 * i) = (uint16_t)*alist_s16(hle, dmemo - 8 + 2 * i);
+    }
+}
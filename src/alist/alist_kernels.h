@@ -0,0 +1,190 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist_kernels.h                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_ALIST_ALIST_KERNELS_H
+#define M64P_ALIST_ALIST_KERNELS_H
+
+#include <SDL.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Internals of the audio microcode HLE: state, memory accessors and the
+ * processing kernels shared by the command sets. */
+
+/* RDRAM as allocated by the core */
+enum { ALIST_RDRAM_SIZE = 0x800000 };
+
+/* data buffer of the microcode, addressed by 12 bits offsets */
+enum { ALIST_BUFFER_SIZE = 0x1000 };
+
+/* room after the buffer, so that kernels working on raw pointers stay in bounds
+ * with the largest offsets and counts the command encoding allows */
+enum { ALIST_BUFFER_SLACK = 0x20000 };
+
+enum { ALIST_SEGMENTS = 16 };
+
+/* RDRAM and DMEM hold big endian 32-bit words in host byte order:
+ * 16 and 8 bits accesses are swizzled within each word */
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#define ALIST_S   0
+#define ALIST_S16 0
+#define ALIST_S8  0
+#else
+#define ALIST_S   1
+#define ALIST_S16 2
+#define ALIST_S8  3
+#endif
+
+/* state of the ABI1 command set */
+struct alist_audio
+{
+    uint32_t segments[ALIST_SEGMENTS];
+
+    /* main buffers */
+    uint16_t in;
+    uint16_t out;
+    uint16_t count;
+
+    /* auxiliary buffers */
+    uint16_t dry_right;
+    uint16_t wet_left;
+    uint16_t wet_right;
+
+    /* gains */
+    int16_t dry;
+    int16_t wet;
+
+    /* envelopes (0: left, 1: right) */
+    int16_t vol[2];
+    int16_t target[2];
+    int32_t rate[2];
+
+    /* ADPCM loop point address */
+    uint32_t loop;
+
+    /* ADPCM codebook (up to 16 entries) and POLEF coefficients */
+    int16_t table[16 * 16];
+};
+
+struct alist_hle
+{
+    /* memories of the task being processed */
+    unsigned char* rdram;
+    const unsigned char* dmem;
+
+    /* ALIST_BUFFER_SIZE + ALIST_BUFFER_SLACK bytes, same layout as RDRAM */
+    unsigned char* buffer;
+
+    struct alist_audio audio;
+
+    /* last unsupported microcode reported */
+    uint32_t unsupported_ucode;
+};
+
+typedef void (*alist_command_t)(struct alist_hle* hle, uint32_t w1, uint32_t w2);
+
+
+static inline uint16_t alist_align(uint16_t x, uint16_t n)
+{
+    return (uint16_t)((x + (n - 1)) & ~(n - 1));
+}
+
+static inline uint32_t* alist_dram_u32(struct alist_hle* hle, uint32_t address)
+{
+    return (uint32_t*)(hle->rdram + (address & (ALIST_RDRAM_SIZE - 4)));
+}
+
+static inline uint16_t* alist_dram_u16(struct alist_hle* hle, uint32_t address)
+{
+    return (uint16_t*)(hle->rdram + ((address & (ALIST_RDRAM_SIZE - 2)) ^ ALIST_S16));
+}
+
+static inline uint32_t alist_dmem_u32(const struct alist_hle* hle, uint16_t address)
+{
+    return *(const uint32_t*)(hle->dmem + (address & 0xffc));
+}
+
+static inline uint8_t* alist_u8(struct alist_hle* hle, uint16_t dmem)
+{
+    return hle->buffer + ((dmem & 0xfff) ^ ALIST_S8);
+}
+
+static inline int16_t* alist_s16(struct alist_hle* hle, uint16_t dmem)
+{
+    return (int16_t*)(hle->buffer + ((dmem & 0xffe) ^ ALIST_S16));
+}
+
+/* first byte of a block of samples, which keeps the swizzled layout */
+static inline int16_t* alist_block(struct alist_hle* hle, uint16_t dmem)
+{
+    return (int16_t*)(hle->buffer + (dmem & 0xffe));
+}
+
+/* run the command list of the current task */
+void alist_process(struct alist_hle* hle, const alist_command_t* commands, size_t command_count);
+
+uint32_t alist_get_address(struct alist_hle* hle, uint32_t so, const uint32_t* segments, size_t n);
+void alist_set_address(struct alist_hle* hle, uint32_t so, uint32_t* segments, size_t n);
+
+/* kernels (dmem: offsets in the data buffer, address: RDRAM addresses, count: in bytes) */
+void alist_clear(struct alist_hle* hle, uint16_t dmem, uint16_t count);
+void alist_load(struct alist_hle* hle, uint16_t dmem, uint32_t address, uint16_t count);
+void alist_save(struct alist_hle* hle, uint16_t dmem, uint32_t address, uint16_t count);
+void alist_move(struct alist_hle* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count);
+void alist_load_table(struct alist_hle* hle, int16_t* table, uint32_t address, size_t count);
+
+void alist_interleave(struct alist_hle* hle, uint16_t dmemo, uint16_t left, uint16_t right, uint16_t count);
+
+void alist_mix(struct alist_hle* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count, int16_t gain);
+
+void alist_envmix_exp(struct alist_hle* hle, int init, int aux,
+        uint16_t dmem_dl, uint16_t dmem_dr, uint16_t dmem_wl, uint16_t dmem_wr,
+        uint16_t dmemi, uint16_t count,
+        int16_t dry, int16_t wet,
+        const int16_t* vol, const int16_t* target, const int32_t* rate,
+        uint32_t address);
+
+void alist_envmix_ge(struct alist_hle* hle, int init, int aux,
+        uint16_t dmem_dl, uint16_t dmem_dr, uint16_t dmem_wl, uint16_t dmem_wr,
+        uint16_t dmemi, uint16_t count,
+        int16_t dry, int16_t wet,
+        const int16_t* vol, const int16_t* target, const int32_t* rate,
+        uint32_t address);
+
+void alist_adpcm(struct alist_hle* hle, int init, int loop,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        const int16_t* codebook, uint32_t loop_address, uint32_t last_frame_address);
+
+void alist_resample(struct alist_hle* hle, int init,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        uint32_t pitch, uint32_t address);
+
+void alist_polef(struct alist_hle* hle, int init,
+        uint16_t dmemo, uint16_t dmemi, uint16_t count,
+        uint16_t gain, int16_t* table, uint32_t address);
+
+/* command sets */
+void alist_process_audio(struct alist_hle* hle);
+void alist_process_audio_ge(struct alist_hle* hle);
+void alist_process_audio_bc(struct alist_hle* hle);
+
+#endif
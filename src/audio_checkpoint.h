@@ -0,0 +1,72 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_checkpoint.h                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AUDIO_CHECKPOINT_H
+#define M64P_AUDIO_CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "m64p_types.h"
+
+/* Checkpoints and speculation, for run-ahead and rollback netplay
+ *
+ * Frames executed speculatively push samples which may have to be taken back.
+ *
+ * AudioSpeculationBegin makes further AiLenChanged stage their samples instead of
+ * queuing them for playback, and skip audio synchronization so that the frames run
+ * at full speed. AudioSpeculationCommit queues the staged samples, and
+ * AudioSpeculationDiscard drops them. Samples are staged in place in the primary
+ * buffer, so neither copies anything.
+ *
+ * AudioCheckpointSave records the position of the input stream (and its rate),
+ * AudioCheckpointRestore takes back the samples pushed since, as far as they
+ * haven't been played yet, and ends speculation. Both are O(1): samples are never
+ * copied, and neither is the resampler state, since the resampler only sees samples
+ * once they are being played.
+ *
+ * The raw capture, the latency probe and the AI recorder see samples as they are pushed. */
+
+/* Saved by AudioCheckpointSave, to be treated as opaque */
+struct audio_checkpoint
+{
+    /* bytes queued in the primary buffer since RomOpen */
+    uint64_t pushed;
+    /* input rate and speed factor */
+    unsigned int input_rate_num;
+    unsigned int input_rate_den;
+    unsigned int speed_factor;
+};
+
+typedef m64p_error (*ptr_AudioCheckpointSave)(struct audio_checkpoint* checkpoint);
+typedef m64p_error (*ptr_AudioCheckpointRestore)(const struct audio_checkpoint* checkpoint);
+typedef m64p_error (*ptr_AudioSpeculationBegin)(void);
+typedef m64p_error (*ptr_AudioSpeculationCommit)(void);
+typedef m64p_error (*ptr_AudioSpeculationDiscard)(void);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioCheckpointSave(struct audio_checkpoint* checkpoint);
+EXPORT m64p_error CALL AudioCheckpointRestore(const struct audio_checkpoint* checkpoint);
+EXPORT m64p_error CALL AudioSpeculationBegin(void);
+EXPORT m64p_error CALL AudioSpeculationCommit(void);
+EXPORT m64p_error CALL AudioSpeculationDiscard(void);
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_instance.h                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AUDIO_INSTANCE_H
+#define M64P_AUDIO_INSTANCE_H
+
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+/* Instance API
+ *
+ * The legacy plugin API drives a single audio pipeline. The functions below
+ * create independent pipelines, so that several emulators can share one
+ * process: each instance has its own SDL audio device, buffers, resampler,
+ * volume, capture and recorder, and different instances can be used
+ * concurrently from different threads.
+ * A given instance must only be used from one thread at a time.
+ *
+ * Debug messages, the event trace and the real-time checks are process-wide.
+ *
+ * All functions require PluginStartup to have been called first. */
+
+struct audio_checkpoint;
+struct audio_instance;
+struct audio_stats;
+struct audio_timing;
+
+/* AudioInstanceCreate
+ *
+ * Creates an instance reading its parameters from config_section
+ * (NULL for the plugin's 'Audio-SDL' section). Missing parameters of
+ * config_section are set to their defaults.
+ * audio_info is copied, and plays the role of InitiateAudio. */
+typedef m64p_error (*ptr_AudioInstanceCreate)(m64p_handle config_section, const AUDIO_INFO* audio_info, struct audio_instance** instance);
+/* AudioInstanceDestroy
+ *
+ * Closes the instance if needed and frees it. */
+typedef m64p_error (*ptr_AudioInstanceDestroy)(struct audio_instance* instance);
+
+/* Counterparts of RomOpen, RomClosed, AiDacrateChanged, AiLenChanged, ProcessAList and SetSpeedFactor */
+typedef m64p_error (*ptr_AudioInstanceRomOpen)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceRomClosed)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceAiDacrateChanged)(struct audio_instance* instance, int SystemType);
+typedef m64p_error (*ptr_AudioInstanceAiLenChanged)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceProcessAList)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceSetSpeedFactor)(struct audio_instance* instance, int percentage);
+
+/* Counterparts of VolumeMute, VolumeSetLevel and VolumeGetLevel */
+typedef m64p_error (*ptr_AudioInstanceVolumeMute)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceVolumeSetLevel)(struct audio_instance* instance, int level);
+typedef m64p_error (*ptr_AudioInstanceVolumeGetLevel)(struct audio_instance* instance, int* level);
+
+/* Counterparts of AudioGetStats, AudioGetTiming, AudioCaptureStart, AudioCaptureStop and AudioReloadConfig.
+ * Like AudioGetTiming, AudioInstanceGetTiming may be called from any thread. */
+typedef m64p_error (*ptr_AudioInstanceGetStats)(struct audio_instance* instance, struct audio_stats* stats);
+typedef m64p_error (*ptr_AudioInstanceGetTiming)(struct audio_instance* instance, struct audio_timing* timing);
+typedef m64p_error (*ptr_AudioInstanceCaptureStart)(struct audio_instance* instance, const char* output_file, const char* raw_file);
+typedef m64p_error (*ptr_AudioInstanceCaptureStop)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceReloadConfig)(struct audio_instance* instance);
+
+/* Counterparts of AudioCheckpointSave, AudioCheckpointRestore, AudioSpeculationBegin,
+ * AudioSpeculationCommit and AudioSpeculationDiscard */
+typedef m64p_error (*ptr_AudioInstanceCheckpointSave)(struct audio_instance* instance, struct audio_checkpoint* checkpoint);
+typedef m64p_error (*ptr_AudioInstanceCheckpointRestore)(struct audio_instance* instance, const struct audio_checkpoint* checkpoint);
+typedef m64p_error (*ptr_AudioInstanceSpeculationBegin)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceSpeculationCommit)(struct audio_instance* instance);
+typedef m64p_error (*ptr_AudioInstanceSpeculationDiscard)(struct audio_instance* instance);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioInstanceCreate(m64p_handle config_section, const AUDIO_INFO* audio_info, struct audio_instance** instance);
+EXPORT m64p_error CALL AudioInstanceDestroy(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceRomOpen(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceRomClosed(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceAiDacrateChanged(struct audio_instance* instance, int SystemType);
+EXPORT m64p_error CALL AudioInstanceAiLenChanged(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceProcessAList(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceSetSpeedFactor(struct audio_instance* instance, int percentage);
+EXPORT m64p_error CALL AudioInstanceVolumeMute(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceVolumeSetLevel(struct audio_instance* instance, int level);
+EXPORT m64p_error CALL AudioInstanceVolumeGetLevel(struct audio_instance* instance, int* level);
+EXPORT m64p_error CALL AudioInstanceGetStats(struct audio_instance* instance, struct audio_stats* stats);
+EXPORT m64p_error CALL AudioInstanceGetTiming(struct audio_instance* instance, struct audio_timing* timing);
+EXPORT m64p_error CALL AudioInstanceCaptureStart(struct audio_instance* instance, const char* output_file, const char* raw_file);
+EXPORT m64p_error CALL AudioInstanceCaptureStop(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceReloadConfig(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceCheckpointSave(struct audio_instance* instance, struct audio_checkpoint* checkpoint);
+EXPORT m64p_error CALL AudioInstanceCheckpointRestore(struct audio_instance* instance, const struct audio_checkpoint* checkpoint);
+EXPORT m64p_error CALL AudioInstanceSpeculationBegin(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceSpeculationCommit(struct audio_instance* instance);
+EXPORT m64p_error CALL AudioInstanceSpeculationDiscard(struct audio_instance* instance);
+#endif
+
+#endif
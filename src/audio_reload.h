@@ -0,0 +1,48 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_reload.h                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef M64P_AUDIO_RELOAD_H
+#define M64P_AUDIO_RELOAD_H
+
+#include "m64p_types.h"
+
+/* AudioReloadConfig
+ *
+ * Applies the changes of the 'Audio-SDL' config section to the running pipeline,
+ * without closing the ROM.
+ *
+ * AUDIO_SYNC, SYNC_TOLERANCE_MS, SYNC_RESUME_MS, SWAP_CHANNELS and VOLUME_ADJUST
+ * take effect at once, as do PRIMARY_BUFFER_SIZE, PRIMARY_BUFFER_TARGET, CONCEAL_MS,
+ * DSP_CHAIN and RESAMPLE_BUDGET. A new SECONDARY_BUFFER_SIZE reopens the device.
+ * A new RESAMPLE is prepared on the calling thread, then crossfaded in by the audio
+ * callback. PRIMARY_BUFFER_LAYOUT and the low-latency parameters wait for the next RomOpen.
+ *
+ * Returns M64ERR_NOT_INIT before PluginStartup, and M64ERR_INVALID_STATE if no audio
+ * device is open (outside RomOpen/RomClosed). A RESAMPLE which can't be created is
+ * reported with a warning, and the current resampler is kept. */
+typedef m64p_error (*ptr_AudioReloadConfig)(void);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioReloadConfig(void);
+#endif
+
+#endif
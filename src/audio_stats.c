@@ -0,0 +1,212 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_stats.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_stats.h"
+#include "main.h"
+
+#include "m64p_types.h"
+
+static uint64_t ticks_to_us(const struct audio_stats_collector* collector, uint64_t ticks)
+{
+    return (collector->perf_frequency == 0)
+        ? 0
+        : ticks * 1000000 / collector->perf_frequency;
+}
+
+/* Map a duration to its histogram bin.
+ * First 4 bins are 1us wide, then each octave is split in 4 bins. */
+static size_t duration_bin(uint64_t us)
+{
+    size_t msb = 0;
+    size_t bin;
+
+    if (us < 4) {
+        return (size_t)us;
+    }
+
+    while ((us >> (msb + 1)) != 0) {
+        ++msb;
+    }
+
+    bin = 4 * (msb - 1) + (size_t)((us >> (msb - 2)) & 3);
+
+    return (bin < AUDIO_STATS_DURATION_BINS) ? bin : AUDIO_STATS_DURATION_BINS - 1;
+}
+
+/* Exclusive upper bound (in us) of a duration histogram bin */
+static uint64_t duration_bin_upper(size_t bin)
+{
+    if (bin < 4) {
+        return bin + 1;
+    }
+
+    return (uint64_t)(5 + (bin & 3)) << (bin / 4 - 1);
+}
+
+static uint32_t duration_percentile(const struct audio_stats_collector* collector, unsigned int percent, uint32_t max_us)
+{
+    size_t i;
+    uint64_t count = 0;
+    uint64_t threshold = (collector->callbacks * percent + 99) / 100;
+
+    if (collector->callbacks == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < AUDIO_STATS_DURATION_BINS; ++i) {
+        count += collector->duration_histogram[i];
+        if (count >= threshold) {
+            uint64_t upper = duration_bin_upper(i);
+            return (upper < max_us) ? (uint32_t)upper : max_us;
+        }
+    }
+
+    return max_us;
+}
+
+
+void init_audio_stats_collector(struct audio_stats_collector* collector)
+{
+    memset(collector, 0, sizeof(*collector));
+    collector->perf_frequency = SDL_GetPerformanceFrequency();
+}
+
+void stats_add_callback_duration(struct audio_stats_collector* collector, uint64_t ticks)
+{
+    ++collector->callbacks;
+    ++collector->duration_histogram[duration_bin(ticks_to_us(collector, ticks))];
+
+    if (ticks > collector->callback_max_ticks) {
+        collector->callback_max_ticks = ticks;
+    }
+}
+
+void stats_add_level(struct audio_stats_collector* collector, size_t level, size_t target, uint32_t latency_ms)
+{
+    size_t bin = (target == 0)
+        ? AUDIO_STATS_LEVEL_BINS - 1
+        : level * (AUDIO_STATS_LEVEL_BINS / 2) / target;
+
+    if (bin >= AUDIO_STATS_LEVEL_BINS) {
+        bin = AUDIO_STATS_LEVEL_BINS - 1;
+    }
+
+    ++collector->level_histogram[bin];
+
+    collector->latency_ms = latency_ms;
+    collector->latency_ms_sum += latency_ms;
+    ++collector->latency_samples;
+}
+
+void get_audio_stats(const struct audio_stats_collector* collector, struct audio_stats* stats)
+{
+    uint32_t max_us = (uint32_t)ticks_to_us(collector, collector->callback_max_ticks);
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->callbacks = collector->callbacks;
+    stats->underruns = collector->underruns;
+    stats->overflows = collector->overflows;
+    stats->dropped_bytes = collector->dropped_bytes;
+
+    stats->sync_sleeps = collector->sync_sleeps;
+    stats->sync_sleep_ms = collector->sync_sleep_ms;
+    stats->sync_pauses = collector->sync_pauses;
+
+    stats->callback_us_p50 = duration_percentile(collector, 50, max_us);
+    stats->callback_us_p90 = duration_percentile(collector, 90, max_us);
+    stats->callback_us_p99 = duration_percentile(collector, 99, max_us);
+    stats->callback_us_max = max_us;
+
+    stats->resample_us = ticks_to_us(collector, collector->resample_ticks);
+
+    stats->steady_callbacks = collector->steady_callbacks;
+    stats->steady_saved_us = (collector->resampled_callbacks == 0)
+        ? 0
+        : stats->resample_us * collector->steady_callbacks / collector->resampled_callbacks;
+
+    stats->device_losses = collector->device_losses;
+    stats->device_recoveries = collector->device_recoveries;
+    stats->virtual_callbacks = collector->virtual_callbacks;
+    stats->rollback_dropped_bytes = collector->rollback_dropped_bytes;
+    stats->rollback_played_bytes = collector->rollback_played_bytes;
+
+    memcpy(stats->level_histogram, collector->level_histogram, sizeof(stats->level_histogram));
+
+    stats->latency_ms = collector->latency_ms;
+    stats->latency_ms_avg = (collector->latency_samples == 0)
+        ? 0
+        : (uint32_t)(collector->latency_ms_sum / collector->latency_samples);
+}
+
+void log_audio_stats(const struct audio_stats* stats)
+{
+    size_t i;
+    uint64_t total = 0;
+    char histogram[AUDIO_STATS_LEVEL_BINS * 5 + 1];
+    char* p = histogram;
+
+    DebugMessage(M64MSG_INFO, "Audio statistics: %llu callbacks, %llu underruns, %llu overflows, %llu bytes dropped",
+            (unsigned long long)stats->callbacks,
+            (unsigned long long)stats->underruns,
+            (unsigned long long)stats->overflows,
+            (unsigned long long)stats->dropped_bytes);
+    DebugMessage(M64MSG_INFO, "Audio sync: %llu sleeps (%llu ms total), %llu pauses",
+            (unsigned long long)stats->sync_sleeps,
+            (unsigned long long)stats->sync_sleep_ms,
+            (unsigned long long)stats->sync_pauses);
+    DebugMessage(M64MSG_INFO, "Audio callback duration: p50 %u us, p90 %u us, p99 %u us, max %u us; resampling %llu us total",
+            stats->callback_us_p50, stats->callback_us_p90, stats->callback_us_p99, stats->callback_us_max,
+            (unsigned long long)stats->resample_us);
+    DebugMessage(M64MSG_INFO, "Audio output latency: %u ms (average %u ms)",
+            stats->latency_ms, stats->latency_ms_avg);
+    DebugMessage(M64MSG_INFO, "Audio steady state: %llu callbacks skipped resampling, saving about %llu us",
+            (unsigned long long)stats->steady_callbacks,
+            (unsigned long long)stats->steady_saved_us);
+    if (stats->device_losses != 0) {
+        DebugMessage(M64MSG_INFO, "Audio device: lost %llu times, reopened %llu times, %llu callbacks on the virtual clock",
+                (unsigned long long)stats->device_losses,
+                (unsigned long long)stats->device_recoveries,
+                (unsigned long long)stats->virtual_callbacks);
+    }
+    if (stats->rollback_dropped_bytes != 0 || stats->rollback_played_bytes != 0) {
+        DebugMessage(M64MSG_INFO, "Audio rollback: %llu bytes taken back, %llu bytes already played",
+                (unsigned long long)stats->rollback_dropped_bytes,
+                (unsigned long long)stats->rollback_played_bytes);
+    }
+
+    /* display level histogram as percentages, in 1/8th of target */
+    for (i = 0; i < AUDIO_STATS_LEVEL_BINS; ++i) {
+        total += stats->level_histogram[i];
+    }
+    if (total == 0) {
+        return;
+    }
+
+    for (i = 0; i < AUDIO_STATS_LEVEL_BINS; ++i) {
+        p += sprintf(p, " %3u", (unsigned int)(stats->level_histogram[i] * 100 / total));
+    }
+    DebugMessage(M64MSG_INFO, "Audio buffer level histogram (%% per 1/8th of target):%s", histogram);
+}
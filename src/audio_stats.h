@@ -0,0 +1,143 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_stats.h                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AUDIO_STATS_H
+#define M64P_AUDIO_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "m64p_types.h"
+
+/* Number of bins of the primary buffer level histogram.
+ * Each bin spans 1/8th of the fullness target, so bin 8 starts at the target level,
+ * and the last bin also collects every level above 2x the target. */
+enum { AUDIO_STATS_LEVEL_BINS = 16 };
+
+/* Number of bins of the callback duration histogram (4 bins per octave of microseconds) */
+enum { AUDIO_STATS_DURATION_BINS = 96 };
+
+/* Runtime statistics of the audio pipeline, as returned by AudioGetStats.
+ * Counters are cumulated since RomOpen. */
+struct audio_stats
+{
+    /* number of SDL audio callbacks */
+    uint64_t callbacks;
+    /* callbacks which had not enough data and played silence */
+    uint64_t underruns;
+    /* pushes which did not fit in the primary buffer */
+    uint64_t overflows;
+    /* bytes discarded because of overflows or incomplete samples */
+    uint64_t dropped_bytes;
+
+    /* delays inserted by audio synchronization, and their total duration (in ms) */
+    uint64_t sync_sleeps;
+    uint64_t sync_sleep_ms;
+    /* number of times audio playback was paused to let the core catch up */
+    uint64_t sync_pauses;
+
+    /* callback duration percentiles (in us) */
+    uint32_t callback_us_p50;
+    uint32_t callback_us_p90;
+    uint32_t callback_us_p99;
+    uint32_t callback_us_max;
+
+    /* cumulated time spent resampling and mixing in the callback (in us) */
+    uint64_t resample_us;
+
+    /* histogram of the expected primary buffer level at each synchronization point */
+    uint64_t level_histogram[AUDIO_STATS_LEVEL_BINS];
+
+    /* estimated output latency (in ms), at last synchronization point and averaged */
+    uint32_t latency_ms;
+    uint32_t latency_ms_avg;
+
+    /* callbacks which skipped resampling because the input was silent or DC,
+     * and the resampling time this saved (in us, estimated from the other callbacks) */
+    uint64_t steady_callbacks;
+    uint64_t steady_saved_us;
+
+    /* times the output device was lost (removed, or stopped calling back), and reopened */
+    uint64_t device_losses;
+    uint64_t device_recoveries;
+    /* callbacks played on the virtual clock while no device was open */
+    uint64_t virtual_callbacks;
+
+    /* bytes taken back by speculation discards and checkpoint restores,
+     * and bytes restores couldn't take back because they were already played */
+    uint64_t rollback_dropped_bytes;
+    uint64_t rollback_played_bytes;
+};
+
+/* Raw counters collected by the backend, turned into audio_stats on request */
+struct audio_stats_collector
+{
+    uint64_t perf_frequency;
+
+    uint64_t callbacks;
+    uint64_t underruns;
+    uint64_t overflows;
+    uint64_t dropped_bytes;
+
+    uint64_t sync_sleeps;
+    uint64_t sync_sleep_ms;
+    uint64_t sync_pauses;
+
+    uint64_t resample_ticks;
+    uint64_t resampled_callbacks;
+    uint64_t steady_callbacks;
+    uint64_t device_losses;
+    uint64_t device_recoveries;
+    uint64_t virtual_callbacks;
+    uint64_t rollback_dropped_bytes;
+    uint64_t rollback_played_bytes;
+    uint64_t callback_max_ticks;
+    uint64_t duration_histogram[AUDIO_STATS_DURATION_BINS];
+
+    uint64_t level_histogram[AUDIO_STATS_LEVEL_BINS];
+
+    uint32_t latency_ms;
+    uint64_t latency_ms_sum;
+    uint64_t latency_samples;
+};
+
+void init_audio_stats_collector(struct audio_stats_collector* collector);
+
+void stats_add_callback_duration(struct audio_stats_collector* collector, uint64_t ticks);
+
+void stats_add_level(struct audio_stats_collector* collector, size_t level, size_t target, uint32_t latency_ms);
+
+void get_audio_stats(const struct audio_stats_collector* collector, struct audio_stats* stats);
+
+void log_audio_stats(const struct audio_stats* stats);
+
+/* AudioGetStats
+ *
+ * Fills stats with the statistics of the pipeline since RomOpen.
+ * Returns M64ERR_NOT_INIT before PluginStartup, M64ERR_INPUT_ASSERT if stats is NULL,
+ * and M64ERR_INVALID_STATE if no audio device is open (outside RomOpen/RomClosed). */
+typedef m64p_error (*ptr_AudioGetStats)(struct audio_stats* stats);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioGetStats(struct audio_stats* stats);
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_sync.c                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdint.h>
+
+#include "audio_sync.h"
+
+/* number of bytes per sample */
+#define N64_SAMPLE_BYTES 4
+
+size_t estimate_audio_level(size_t available,
+        unsigned int input_rate_num, unsigned int input_rate_den,
+        unsigned int output_frequency, unsigned int speed_factor,
+        size_t secondary_buffer_size, unsigned int last_cb_time, unsigned int now)
+{
+    /* Start by calculating the current Primary buffer fullness in terms of output samples */
+    size_t expected_level = (size_t)(((uint64_t)(available/N64_SAMPLE_BYTES) * output_frequency * 100 * input_rate_den)
+            / ((uint64_t)input_rate_num * speed_factor));
+
+    /* Next, extrapolate to the buffer level at the expected time of the next audio callback, assuming that the
+       buffer is filled at the same rate as the output frequency */
+    unsigned int expected_next_cb_time = last_cb_time + ((1000 * secondary_buffer_size) / output_frequency);
+
+    if (now < expected_next_cb_time) {
+        expected_level += (expected_next_cb_time - now) * output_frequency / 1000;
+    }
+
+    return expected_level;
+}
+
+enum audio_sync_action audio_sync_decide(const struct audio_sync_policy* policy,
+        size_t expected_level, size_t target, size_t secondary_buffer_size,
+        unsigned int output_frequency, int paused, unsigned int* wait_time)
+{
+    size_t resume_level = secondary_buffer_size;
+
+    if (paused) {
+        resume_level += output_frequency * policy->resume_ms / 1000;
+    }
+
+    /* If the expected value of the Primary Buffer Fullness at the time of the next audio callback is more than
+       tolerance milliseconds ahead of our target buffer fullness level, then insert a delay now */
+    if (policy->audio_sync && expected_level >= target + output_frequency * policy->tolerance_ms / 1000)
+    {
+        /* Core is ahead of SDL audio thread,
+         * delay emulation to allow the SDL audio thread to catch up */
+        *wait_time = (expected_level - target) * 1000 / output_frequency;
+        return AUDIO_SYNC_DELAY;
+    }
+    else if (expected_level < resume_level)
+    {
+        /* Core is behind SDL audio thread (predicting an underflow),
+         * pause the audio to let the Core catch up */
+        return AUDIO_SYNC_PAUSE;
+    }
+
+    /* Expected fullness is within tolerance,
+     * audio thread is running */
+    return AUDIO_SYNC_RUN;
+}
@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_sync.h                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AUDIO_SYNC_H
+#define M64P_AUDIO_SYNC_H
+
+#include <stddef.h>
+
+/* Parameters of the emulation/audio synchronization done at each AI DMA */
+struct audio_sync_policy
+{
+    /* delay emulation when it gets ahead of audio (AUDIO_SYNC) */
+    int audio_sync;
+
+    /* delay emulation only when the expected level exceeds the target by more than this (in ms) */
+    unsigned int tolerance_ms;
+
+    /* once paused for an expected underflow, resume audio only when the expected level
+     * exceeds the secondary buffer size by this much (in ms). 0 resumes as soon as it is refilled */
+    unsigned int resume_ms;
+};
+
+enum audio_sync_action
+{
+    /* expected level is within tolerance, audio runs */
+    AUDIO_SYNC_RUN,
+    /* core is ahead of audio, delay emulation (audio runs) */
+    AUDIO_SYNC_DELAY,
+    /* core is behind audio, pause audio to let the core catch up */
+    AUDIO_SYNC_PAUSE
+};
+
+/* Estimate the primary buffer level (in output samples) at the time of the next audio callback,
+ * from the available bytes in the primary buffer and the time of the last callback (in ms).
+ * The input rate is input_rate_num/input_rate_den Hz.
+ * Assumes that the buffer is filled at the same rate as the output frequency. */
+size_t estimate_audio_level(size_t available,
+        unsigned int input_rate_num, unsigned int input_rate_den,
+        unsigned int output_frequency, unsigned int speed_factor,
+        size_t secondary_buffer_size, unsigned int last_cb_time, unsigned int now);
+
+
+/* Decide what to do given the expected primary buffer level (in output samples).
+ * paused tells if audio is currently paused for synchronization.
+ * For AUDIO_SYNC_DELAY, wait_time is set to the delay to insert (in ms). */
+enum audio_sync_action audio_sync_decide(const struct audio_sync_policy* policy,
+        size_t expected_level, size_t target, size_t secondary_buffer_size,
+        unsigned int output_frequency, int paused, unsigned int* wait_time);
+
+#endif
@@ -0,0 +1,60 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - audio_timing.h                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_AUDIO_TIMING_H
+#define M64P_AUDIO_TIMING_H
+
+#include <stdint.h>
+
+#include "m64p_types.h"
+
+/* Timing of the audio output, for frontends pacing frames or picking a run-ahead depth.
+ *
+ * AudioGetTiming doesn't lock anything and doesn't wait for the audio callback,
+ * so it may be called from any thread between RomOpen and RomClosed. */
+struct audio_timing
+{
+    /* SDL performance counter when the timing was taken, and its frequency */
+    uint64_t timestamp;
+    uint64_t timestamp_frequency;
+
+    /* duration of the input buffered ahead of the audio callback (in us) */
+    uint64_t buffered_us;
+    /* predicted time until the next audio callback (in us), 0 if it is due or late */
+    uint64_t next_callback_us;
+    /* duration of the device buffer, filled at each callback (in us) */
+    uint64_t device_latency_us;
+    /* predicted delay before a sample pushed now is played (in us):
+     * next callback, then the device buffer, then the buffered input */
+    uint64_t latency_us;
+
+    /* input frames per output frame, speed factor included */
+    double resample_ratio;
+    unsigned int output_frequency;
+};
+
+typedef m64p_error (*ptr_AudioGetTiming)(struct audio_timing* timing);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioGetTiming(struct audio_timing* timing);
+#endif
+
+#endif
@@ -0,0 +1,276 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - capture.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "main.h"
+
+#include "m64p_types.h"
+
+enum { CAPTURE_BLOCK_SIZE = 4096 };
+/* must be a power of two */
+enum { CAPTURE_BLOCK_COUNT = 256 };
+/* 16-bit stereo */
+enum { CAPTURE_FRAME_BYTES = 4 };
+
+struct capture_block
+{
+    size_t size;
+    unsigned int frequency;
+    unsigned char data[CAPTURE_BLOCK_SIZE];
+};
+
+struct audio_capture
+{
+    /* blocks [read, write) are waiting to be written */
+    SDL_atomic_t read;
+    SDL_atomic_t write;
+    SDL_atomic_t dropped;
+    SDL_atomic_t stop;
+
+    SDL_Thread* thread;
+
+    char filename[1024];
+    unsigned int file_count;
+    FILE* file;
+    unsigned int file_frequency;
+    uint32_t data_size;
+    uint64_t total_size;
+
+    struct capture_block blocks[CAPTURE_BLOCK_COUNT];
+};
+
+
+static void put_le16(unsigned char* p, uint16_t v)
+{
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_le32(unsigned char* p, uint32_t v)
+{
+    put_le16(p + 0, (uint16_t)(v));
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void write_wav_header(FILE* f, unsigned int frequency, uint32_t data_size)
+{
+    unsigned char header[44];
+
+    memcpy(header + 0, "RIFF", 4);
+    put_le32(header + 4, 36 + data_size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1);  /* PCM */
+    put_le16(header + 22, 2);  /* channels */
+    put_le32(header + 24, frequency);
+    put_le32(header + 28, frequency * CAPTURE_FRAME_BYTES);
+    put_le16(header + 32, CAPTURE_FRAME_BYTES);
+    put_le16(header + 34, 16); /* bits per sample */
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_size);
+
+    fwrite(header, 1, sizeof(header), f);
+}
+
+static void close_capture_file(struct audio_capture* capture)
+{
+    if (capture->file == NULL) {
+        return;
+    }
+
+    /* now that sizes are known, rewrite the header */
+    fseek(capture->file, 0, SEEK_SET);
+    write_wav_header(capture->file, capture->file_frequency, capture->data_size);
+    fclose(capture->file);
+    capture->file = NULL;
+}
+
+static void open_capture_file(struct audio_capture* capture, unsigned int frequency)
+{
+    char filename[1024 + 16];
+
+    /* first file uses the requested name, following ones get a sequence number before the extension */
+    if (capture->file_count == 0) {
+        strcpy(filename, capture->filename);
+    }
+    else {
+        const char* ext = strrchr(capture->filename, '.');
+        int base_len = (ext != NULL && strpbrk(ext, "/\\") == NULL)
+            ? (int)(ext - capture->filename)
+            : (int)strlen(capture->filename);
+
+        sprintf(filename, "%.*s-%u%s", base_len, capture->filename, capture->file_count, capture->filename + base_len);
+    }
+    ++capture->file_count;
+
+    capture->file = fopen(filename, "wb");
+    if (capture->file == NULL) {
+        DebugMessage(M64MSG_ERROR, "Audio capture: couldn't open %s for writing", filename);
+        return;
+    }
+
+    capture->file_frequency = frequency;
+    capture->data_size = 0;
+    write_wav_header(capture->file, frequency, 0);
+
+    DebugMessage(M64MSG_INFO, "Audio capture: writing %s at %uHz", filename, frequency);
+}
+
+static void write_capture_block(struct audio_capture* capture, struct capture_block* block)
+{
+    if (capture->file == NULL || capture->file_frequency != block->frequency) {
+        close_capture_file(capture);
+        open_capture_file(capture, block->frequency);
+    }
+
+    if (capture->file == NULL) {
+        return;
+    }
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    {
+        /* WAV samples are little endian */
+        size_t i;
+        for (i = 0; i < block->size; i += 2) {
+            unsigned char tmp = block->data[i];
+            block->data[i] = block->data[i + 1];
+            block->data[i + 1] = tmp;
+        }
+    }
+#endif
+
+    fwrite(block->data, 1, block->size, capture->file);
+    capture->data_size += (uint32_t)block->size;
+    capture->total_size += block->size;
+}
+
+static int capture_writer_thread(void* data)
+{
+    struct audio_capture* capture = (struct audio_capture*)data;
+
+    for (;;) {
+        int read = SDL_AtomicGet(&capture->read);
+        int write = SDL_AtomicGet(&capture->write);
+
+        if (read == write) {
+            if (SDL_AtomicGet(&capture->stop)) {
+                break;
+            }
+            SDL_Delay(10);
+            continue;
+        }
+
+        SDL_MemoryBarrierAcquire();
+
+        while (read != write) {
+            write_capture_block(capture, &capture->blocks[read & (CAPTURE_BLOCK_COUNT - 1)]);
+            ++read;
+        }
+
+        SDL_AtomicSet(&capture->read, read);
+    }
+
+    close_capture_file(capture);
+
+    return 0;
+}
+
+
+struct audio_capture* start_audio_capture(const char* filename)
+{
+    struct audio_capture* capture = malloc(sizeof(*capture));
+    if (capture == NULL) {
+        DebugMessage(M64MSG_ERROR, "Audio capture: failed to allocate memory");
+        return NULL;
+    }
+
+    memset(capture, 0, sizeof(*capture));
+    strncpy(capture->filename, filename, sizeof(capture->filename) - 1);
+
+    capture->thread = SDL_CreateThread(capture_writer_thread, "AudioCapture", capture);
+    if (capture->thread == NULL) {
+        DebugMessage(M64MSG_ERROR, "Audio capture: couldn't create writer thread: %s", SDL_GetError());
+        free(capture);
+        return NULL;
+    }
+
+    return capture;
+}
+
+void stop_audio_capture(struct audio_capture* capture)
+{
+    int dropped;
+
+    if (capture == NULL) {
+        return;
+    }
+
+    /* writer thread drains the queue before exiting */
+    SDL_AtomicSet(&capture->stop, 1);
+    SDL_WaitThread(capture->thread, NULL);
+
+    DebugMessage(M64MSG_INFO, "Audio capture: %llu bytes written to %s",
+            (unsigned long long)capture->total_size, capture->filename);
+
+    dropped = SDL_AtomicGet(&capture->dropped);
+    if (dropped != 0) {
+        DebugMessage(M64MSG_WARNING, "Audio capture: %d blocks dropped, writer couldn't keep up", dropped);
+    }
+
+    free(capture);
+}
+
+void audio_capture_push(struct audio_capture* capture, const void* data, size_t size, unsigned int frequency)
+{
+    const unsigned char* src = (const unsigned char*)data;
+    int write = SDL_AtomicGet(&capture->write);
+    int read = SDL_AtomicGet(&capture->read);
+
+    while (size > 0) {
+        struct capture_block* block;
+        size_t chunk = (size < CAPTURE_BLOCK_SIZE) ? size : CAPTURE_BLOCK_SIZE;
+
+        if (write - read >= CAPTURE_BLOCK_COUNT) {
+            /* writer is late, drop everything that doesn't fit */
+            SDL_AtomicAdd(&capture->dropped, (int)((size + CAPTURE_BLOCK_SIZE - 1) / CAPTURE_BLOCK_SIZE));
+            break;
+        }
+
+        block = &capture->blocks[write & (CAPTURE_BLOCK_COUNT - 1)];
+        memcpy(block->data, src, chunk);
+        block->size = chunk;
+        block->frequency = frequency;
+
+        src += chunk;
+        size -= chunk;
+        ++write;
+    }
+
+    /* publish blocks */
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&capture->write, write);
+}
@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - capture.h                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_CAPTURE_H
+#define M64P_CAPTURE_H
+
+#include <stddef.h>
+
+#include "m64p_types.h"
+
+/* Lossless audio capture to WAV files.
+ *
+ * Samples (16-bit stereo, host byte order) are copied into a lock-free
+ * single-producer/single-consumer queue of fixed-size blocks, and a background
+ * thread writes them to disk. When the writer falls behind, blocks are dropped
+ * (never waited for) and reported when the capture stops.
+ * A change of sample rate starts a new file, suffixed with a sequence number.
+ */
+
+struct audio_capture;
+
+struct audio_capture* start_audio_capture(const char* filename);
+
+void stop_audio_capture(struct audio_capture* capture);
+
+/* Can be called from the audio callback: no lock, no allocation, no I/O */
+void audio_capture_push(struct audio_capture* capture, const void* data, size_t size, unsigned int frequency);
+
+/* AudioCaptureStart
+ *
+ * Stops the current captures, then captures the output (as played, after
+ * resampling and volume) to output_file and the N64 input to raw_file.
+ * Either may be NULL or empty to skip it.
+ * Returns M64ERR_NOT_INIT before PluginStartup, M64ERR_INVALID_STATE if no audio
+ * device is open (outside RomOpen/RomClosed), and M64ERR_FILES if a file couldn't
+ * be created; the other capture is still started then. */
+typedef m64p_error (*ptr_AudioCaptureStart)(const char* output_file, const char* raw_file);
+/* AudioCaptureStop
+ *
+ * Stops the captures and finishes their files.
+ * Returns M64ERR_NOT_INIT before PluginStartup, and M64ERR_INVALID_STATE if no
+ * audio device is open. */
+typedef m64p_error (*ptr_AudioCaptureStop)(void);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioCaptureStart(const char* output_file, const char* raw_file);
+EXPORT m64p_error CALL AudioCaptureStop(void);
+#endif
+
+#endif
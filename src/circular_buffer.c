@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "circular_buffer.h"
+#include "rt_check.h"
 
 
 int init_cbuff(struct circular_buffer* cbuff, size_t capacity)
@@ -38,6 +39,7 @@ int init_cbuff(struct circular_buffer* cbuff, size_t capacity)
     cbuff->data = data;
     cbuff->size = capacity;
     cbuff->head = 0;
+    cbuff->staged = 0;
 
     return 0;
 }
@@ -51,10 +53,10 @@ void release_cbuff(struct circular_buffer* cbuff)
 
 void* cbuff_head(const struct circular_buffer* cbuff, size_t* available)
 {
-    assert(cbuff->head <= cbuff->size);
+    assert(cbuff->head + cbuff->staged <= cbuff->size);
 
-    *available = cbuff->size - cbuff->head;
-    return (unsigned char*)cbuff->data + cbuff->head;
+    *available = cbuff->size - cbuff->head - cbuff->staged;
+    return (unsigned char*)cbuff->data + cbuff->head + cbuff->staged;
 }
 
 
@@ -67,6 +69,7 @@ void* cbuff_tail(const struct circular_buffer* cbuff, size_t* available)
 
 void produce_cbuff_data(struct circular_buffer* cbuff, size_t amount)
 {
+    assert(cbuff->staged == 0);
     assert(cbuff->head + amount <= cbuff->size);
 
     cbuff->head += amount;
@@ -77,7 +80,56 @@ void consume_cbuff_data(struct circular_buffer* cbuff, size_t amount)
 {
     assert(cbuff->head >= amount);
 
-    memmove(cbuff->data, (unsigned char*)cbuff->data + amount, cbuff->head - amount);
+    memmove(cbuff->data, (unsigned char*)cbuff->data + amount, cbuff->head + cbuff->staged - amount);
     cbuff->head -= amount;
 }
 
+
+void unproduce_cbuff_data(struct circular_buffer* cbuff, size_t amount)
+{
+    assert(cbuff->staged == 0);
+    assert(cbuff->head >= amount);
+
+    cbuff->head -= amount;
+}
+
+
+void stage_cbuff_data(struct circular_buffer* cbuff, size_t amount)
+{
+    assert(cbuff->head + cbuff->staged + amount <= cbuff->size);
+
+    cbuff->staged += amount;
+}
+
+
+void commit_cbuff_data(struct circular_buffer* cbuff)
+{
+    cbuff->head += cbuff->staged;
+    cbuff->staged = 0;
+}
+
+
+void discard_cbuff_data(struct circular_buffer* cbuff)
+{
+    cbuff->staged = 0;
+}
+
+
+void* cbuff_plane(const struct circular_buffer* cbuff, size_t plane, size_t planes)
+{
+    return (unsigned char*)cbuff->data + plane * (cbuff->size / planes);
+}
+
+
+void consume_cbuff_planes(struct circular_buffer* cbuff, size_t amount, size_t planes)
+{
+    size_t plane;
+
+    assert(cbuff->head >= amount);
+
+    for (plane = 0; plane < planes; ++plane) {
+        unsigned char* data = (unsigned char*)cbuff_plane(cbuff, plane, planes);
+        memmove(data, data + amount / planes, (cbuff->head + cbuff->staged - amount) / planes);
+    }
+    cbuff->head -= amount;
+}
@@ -29,6 +29,8 @@ struct circular_buffer
     void* data;
     size_t size;
     size_t head;
+    /* bytes written after head but not produced yet, kept in place by consumption */
+    size_t staged;
 };
 
 int init_cbuff(struct circular_buffer* cbuff, size_t capacity);
@@ -43,4 +45,20 @@ void produce_cbuff_data(struct circular_buffer* cbuff, size_t amount);
 
 void consume_cbuff_data(struct circular_buffer* cbuff, size_t amount);
 
+/* Take back the last amount bytes produced */
+void unproduce_cbuff_data(struct circular_buffer* cbuff, size_t amount);
+
+/* Staged data is written at cbuff_head like produced data, but stays out of cbuff_tail
+ * until committed, or is dropped */
+void stage_cbuff_data(struct circular_buffer* cbuff, size_t amount);
+
+void commit_cbuff_data(struct circular_buffer* cbuff);
+
+void discard_cbuff_data(struct circular_buffer* cbuff);
+
+/* Planar buffers split data in equally sized planes, each holding head/planes bytes */
+void* cbuff_plane(const struct circular_buffer* cbuff, size_t plane, size_t planes);
+
+void consume_cbuff_planes(struct circular_buffer* cbuff, size_t amount, size_t planes);
+
 #endif
@@ -0,0 +1,107 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - concealment.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "concealment.h"
+
+void init_concealment(struct concealment* concealment, size_t window_frames)
+{
+    if (window_frames != concealment->frames) {
+        free(concealment->history);
+        concealment->history = (window_frames != 0)
+            ? malloc(window_frames * 2 * sizeof(int16_t))
+            : NULL;
+        concealment->frames = (concealment->history != NULL) ? window_frames : 0;
+    }
+
+    /* prefault */
+    if (concealment->history != NULL) {
+        memset(concealment->history, 0, concealment->frames * 2 * sizeof(int16_t));
+    }
+
+    concealment->fill = 0;
+    concealment->conceal_pos = 0;
+    concealment->fade_in_pos = concealment->frames;
+}
+
+void release_concealment(struct concealment* concealment)
+{
+    free(concealment->history);
+    memset(concealment, 0, sizeof(*concealment));
+}
+
+void concealment_render(struct concealment* concealment, int16_t* samples, size_t frames)
+{
+    size_t n = concealment->frames;
+    size_t i;
+
+    if (n == 0 || frames == 0) {
+        return;
+    }
+
+    for (i = 0; concealment->fade_in_pos < n && i < frames; ++i, ++concealment->fade_in_pos) {
+        int32_t w = (int32_t)((concealment->fade_in_pos << 15) / n);
+
+        samples[2 * i] = (int16_t)((samples[2 * i] * w) >> 15);
+        samples[2 * i + 1] = (int16_t)((samples[2 * i + 1] * w) >> 15);
+    }
+
+    /* keep the last n frames */
+    if (frames >= n) {
+        memcpy(concealment->history, samples + 2 * (frames - n), n * 2 * sizeof(int16_t));
+        concealment->fill = n;
+    }
+    else {
+        size_t keep = (concealment->fill + frames > n) ? n - frames : concealment->fill;
+
+        memmove(concealment->history, concealment->history + 2 * (concealment->fill - keep), keep * 2 * sizeof(int16_t));
+        memcpy(concealment->history + 2 * keep, samples, frames * 2 * sizeof(int16_t));
+        concealment->fill = keep + frames;
+    }
+
+    concealment->conceal_pos = 0;
+}
+
+void concealment_conceal(struct concealment* concealment, int16_t* samples, size_t frames)
+{
+    size_t n = concealment->frames;
+    size_t i;
+
+    if (frames == 0) {
+        return;
+    }
+
+    /* mirror the history around the last rendered frame, fading out */
+    for (i = 0; i < frames && concealment->conceal_pos < concealment->fill; ++i, ++concealment->conceal_pos) {
+        const int16_t* frame = concealment->history + 2 * (concealment->fill - 1 - concealment->conceal_pos);
+        int32_t w = (int32_t)(((n - concealment->conceal_pos) << 15) / n);
+
+        samples[2 * i] = (int16_t)((frame[0] * w) >> 15);
+        samples[2 * i + 1] = (int16_t)((frame[1] * w) >> 15);
+    }
+
+    memset(samples + 2 * i, 0, (frames - i) * 2 * sizeof(int16_t));
+
+    /* fade in whatever comes next */
+    concealment->fade_in_pos = 0;
+}
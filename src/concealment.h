@@ -0,0 +1,63 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - concealment.h                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_CONCEALMENT_H
+#define M64P_CONCEALMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Underrun concealment (CONCEAL_MS config parameter).
+ *
+ * When the audio callback runs out of input, the missing tail of the output is
+ * filled with the last rendered frames played backwards, which continues the waveform
+ * without a discontinuity, faded out over the concealment window. Once input comes
+ * back, it is faded in over the same window, so a late frame turns into a short dip
+ * instead of a click followed by a dropout.
+ *
+ * All functions but init/release are real-time safe.
+ */
+struct concealment
+{
+    /* last rendered stereo frames, oldest first */
+    int16_t* history;
+    /* length of the concealment window (in frames), 0 if disabled */
+    size_t frames;
+    /* number of valid frames in history */
+    size_t fill;
+    /* frames concealed since the last rendered one */
+    size_t conceal_pos;
+    /* frames faded in since recovery, frames once done */
+    size_t fade_in_pos;
+};
+
+/* (Re)allocate the history for a window of window_frames frames, 0 disables concealment */
+void init_concealment(struct concealment* concealment, size_t window_frames);
+
+void release_concealment(struct concealment* concealment);
+
+/* Fade in rendered frames after a concealment, and remember them for the next one */
+void concealment_render(struct concealment* concealment, int16_t* samples, size_t frames);
+
+/* Fill frames missing from the output */
+void concealment_conceal(struct concealment* concealment, int16_t* samples, size_t frames);
+
+#endif
@@ -0,0 +1,218 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - biquad.c                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "dsp/dsp.h"
+#include "dsp/dsp_simd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+#if !defined(M_SQRT1_2)
+#define M_SQRT1_2 0.70710678118654752440
+#endif
+
+/* Second order IIR filters (Robert Bristow-Johnson's audio EQ cookbook),
+ * in transposed direct form II, double precision.
+ * Both channels are filtered together, one per SSE2 lane. */
+
+enum biquad_type
+{
+    BIQUAD_LOWPASS,
+    BIQUAD_HIGHPASS,
+    BIQUAD_PEAK,
+    BIQUAD_LOWSHELF,
+    BIQUAD_HIGHSHELF
+};
+
+struct biquad
+{
+    enum biquad_type type;
+    double frequency;
+    double gain_db;
+    double q;
+
+    /* normalized coefficients (a0 = 1) */
+    double b0, b1, b2, a1, a2;
+
+    /* state, per channel */
+    double z1[2];
+    double z2[2];
+};
+
+static void* biquad_init(const char* stage_name, const double* params, size_t param_count, int* disabled)
+{
+    struct biquad* bq;
+    enum biquad_type type;
+    size_t min_params = 2;
+
+    if (strcmp(stage_name, "lowpass") == 0) { type = BIQUAD_LOWPASS; min_params = 1; }
+    else if (strcmp(stage_name, "highpass") == 0) { type = BIQUAD_HIGHPASS; min_params = 1; }
+    else if (strcmp(stage_name, "peak") == 0) { type = BIQUAD_PEAK; }
+    else if (strcmp(stage_name, "lowshelf") == 0) { type = BIQUAD_LOWSHELF; }
+    else if (strcmp(stage_name, "highshelf") == 0) { type = BIQUAD_HIGHSHELF; }
+    else { return NULL; }
+
+    /* FREQ[:Q] for pass filters, FREQ:GAIN_DB[:Q] for the others */
+    if (param_count < min_params || param_count > min_params + 1 || params[0] <= 0.0) {
+        return NULL;
+    }
+
+    if (min_params == 2 && params[1] == 0.0) {
+        *disabled = 1;
+        return NULL;
+    }
+
+    bq = malloc(sizeof(*bq));
+    if (bq == NULL) {
+        return NULL;
+    }
+    memset(bq, 0, sizeof(*bq));
+
+    bq->type = type;
+    bq->frequency = params[0];
+    bq->gain_db = (min_params == 2) ? params[1] : 0.0;
+    bq->q = (param_count > min_params && params[min_params] > 0.0) ? params[min_params] : M_SQRT1_2;
+
+    return bq;
+}
+
+static void biquad_release(void* stage)
+{
+    free(stage);
+}
+
+static void biquad_set_frequency(void* stage, unsigned int frequency)
+{
+    struct biquad* bq = (struct biquad*)stage;
+    /* keep the corner frequency below Nyquist */
+    double f = (bq->frequency < 0.45 * frequency) ? bq->frequency : 0.45 * frequency;
+    double w0 = 2.0 * M_PI * f / frequency;
+    double cosw = cos(w0);
+    double alpha = sin(w0) / (2.0 * bq->q);
+    double A = pow(10.0, bq->gain_db / 40.0);
+    double sqrtA2alpha = 2.0 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (bq->type)
+    {
+    default:
+    case BIQUAD_LOWPASS:
+        b0 = (1.0 - cosw) / 2.0; b1 = 1.0 - cosw; b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_HIGHPASS:
+        b0 = (1.0 + cosw) / 2.0; b1 = -(1.0 + cosw); b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_PEAK:
+        b0 = 1.0 + alpha * A; b1 = -2.0 * cosw; b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A; a1 = -2.0 * cosw; a2 = 1.0 - alpha / A;
+        break;
+    case BIQUAD_LOWSHELF:
+        b0 = A * ((A + 1.0) - (A - 1.0) * cosw + sqrtA2alpha);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cosw - sqrtA2alpha);
+        a0 = (A + 1.0) + (A - 1.0) * cosw + sqrtA2alpha;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+        a2 = (A + 1.0) + (A - 1.0) * cosw - sqrtA2alpha;
+        break;
+    case BIQUAD_HIGHSHELF:
+        b0 = A * ((A + 1.0) + (A - 1.0) * cosw + sqrtA2alpha);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cosw - sqrtA2alpha);
+        a0 = (A + 1.0) - (A - 1.0) * cosw + sqrtA2alpha;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+        a2 = (A + 1.0) - (A - 1.0) * cosw - sqrtA2alpha;
+        break;
+    }
+
+    bq->b0 = b0 / a0;
+    bq->b1 = b1 / a0;
+    bq->b2 = b2 / a0;
+    bq->a1 = a1 / a0;
+    bq->a2 = a2 / a0;
+}
+
+static void biquad_process(void* stage, float* samples, size_t frames)
+{
+    struct biquad* bq = (struct biquad*)stage;
+    size_t i;
+    int c;
+
+#if defined(DSP_SSE2)
+    const __m128d b0 = _mm_set1_pd(bq->b0);
+    const __m128d b1 = _mm_set1_pd(bq->b1);
+    const __m128d b2 = _mm_set1_pd(bq->b2);
+    const __m128d a1 = _mm_set1_pd(bq->a1);
+    const __m128d a2 = _mm_set1_pd(bq->a2);
+    __m128d z1 = _mm_loadu_pd(bq->z1);
+    __m128d z2 = _mm_loadu_pd(bq->z2);
+
+    for (i = 0; i < frames; ++i) {
+        /* left and right samples of the frame */
+        __m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(samples + 2 * i))));
+        __m128d y = _mm_add_pd(_mm_mul_pd(b0, x), z1);
+
+        z1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, x), _mm_mul_pd(a1, y)), z2);
+        z2 = _mm_sub_pd(_mm_mul_pd(b2, x), _mm_mul_pd(a2, y));
+
+        _mm_storel_epi64((__m128i*)(samples + 2 * i), _mm_castps_si128(_mm_cvtpd_ps(y)));
+    }
+
+    _mm_storeu_pd(bq->z1, z1);
+    _mm_storeu_pd(bq->z2, z2);
+#else
+    for (c = 0; c < 2; ++c) {
+        double z1 = bq->z1[c];
+        double z2 = bq->z2[c];
+
+        for (i = 0; i < frames; ++i) {
+            double x = samples[2 * i + c];
+            double y = bq->b0 * x + z1;
+
+            z1 = bq->b1 * x - bq->a1 * y + z2;
+            z2 = bq->b2 * x - bq->a2 * y;
+            samples[2 * i + c] = (float)y;
+        }
+
+        bq->z1[c] = z1;
+        bq->z2[c] = z2;
+    }
+#endif
+
+    /* flush decaying state before it becomes denormal and slow */
+    for (c = 0; c < 2; ++c) {
+        if (fabs(bq->z1[c]) < 1e-20) { bq->z1[c] = 0.0; }
+        if (fabs(bq->z2[c]) < 1e-20) { bq->z2[c] = 0.0; }
+    }
+}
+
+const struct dsp_interface g_biquad_idsp = {
+    "biquad",
+    biquad_init,
+    biquad_release,
+    biquad_set_frequency,
+    biquad_process
+};
@@ -0,0 +1,314 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - dsp.c                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "dsp/dsp.h"
+#include "dsp/dsp_simd.h"
+
+#include "main.h"
+
+#include "m64p_types.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+extern const struct dsp_interface g_biquad_idsp;
+extern const struct dsp_interface g_limiter_idsp;
+extern const struct dsp_interface g_stereo_width_idsp;
+
+
+#define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
+
+enum { DSP_MAX_STAGES = 16 };
+enum { DSP_MAX_PARAMS = 4 };
+
+static const struct {
+    const struct dsp_interface* idsp;
+    const char* stage_name;
+} stages[] = {
+    { &g_biquad_idsp, "lowpass" },
+    { &g_biquad_idsp, "highpass" },
+    { &g_biquad_idsp, "peak" },
+    { &g_biquad_idsp, "lowshelf" },
+    { &g_biquad_idsp, "highshelf" },
+    { &g_limiter_idsp, "limiter" },
+    { &g_stereo_width_idsp, "width" }
+};
+
+/* shorthands expanded before parsing */
+static const struct {
+    const char* name;
+    const char* expansion;
+} presets[] = {
+    /* approximation of the N64 analog output: AC coupling and a gentle roll-off of the highs */
+    { "n64dac", "highpass:20:0.7071,lowpass:12000:0.6" }
+};
+
+struct dsp_stage
+{
+    const struct dsp_interface* idsp;
+    void* stage;
+};
+
+struct dsp_chain
+{
+    /* only the enabled stages */
+    struct dsp_stage stages[DSP_MAX_STAGES];
+    size_t count;
+
+    float work[DSP_BLOCK_FRAMES * 2];
+};
+
+static void add_stage(struct dsp_chain* chain, const char* token)
+{
+    char name[32];
+    double params[DSP_MAX_PARAMS];
+    size_t param_count = 0;
+    size_t name_len = strcspn(token, ":");
+    const char* p = token + name_len;
+    int disabled = 0;
+    void* stage;
+    size_t i;
+
+    if (name_len == 0 || name_len >= sizeof(name)) {
+        DebugMessage(M64MSG_WARNING, "DSP_CHAIN: invalid stage '%s'", token);
+        return;
+    }
+    memcpy(name, token, name_len);
+    name[name_len] = '\0';
+
+    while (*p == ':') {
+        char* end;
+        double value = strtod(p + 1, &end);
+
+        if (end == p + 1 || param_count >= DSP_MAX_PARAMS) {
+            DebugMessage(M64MSG_WARNING, "DSP_CHAIN: invalid parameters for stage '%s'", token);
+            return;
+        }
+        params[param_count++] = value;
+        p = end;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(stages); ++i) {
+        if (strcmp(name, stages[i].stage_name) == 0) {
+            break;
+        }
+    }
+
+    if (i >= ARRAY_SIZE(stages)) {
+        DebugMessage(M64MSG_WARNING, "DSP_CHAIN: unknown stage '%s'", name);
+        return;
+    }
+
+    if (chain->count >= DSP_MAX_STAGES) {
+        DebugMessage(M64MSG_WARNING, "DSP_CHAIN: too many stages, ignoring '%s'", token);
+        return;
+    }
+
+    stage = stages[i].idsp->init(name, params, param_count, &disabled);
+    if (stage == NULL) {
+        if (disabled) {
+            DebugMessage(M64MSG_VERBOSE, "DSP_CHAIN: stage '%s' has no effect, skipped", token);
+        }
+        else {
+            DebugMessage(M64MSG_WARNING, "DSP_CHAIN: couldn't create stage '%s'", token);
+        }
+        return;
+    }
+
+    chain->stages[chain->count].idsp = stages[i].idsp;
+    chain->stages[chain->count].stage = stage;
+    ++chain->count;
+
+    DebugMessage(M64MSG_VERBOSE, "DSP_CHAIN: added stage '%s'", token);
+}
+
+static void parse_chain(struct dsp_chain* chain, const char* description, int allow_presets)
+{
+    while (*description != '\0') {
+        char token[128];
+        size_t len = strcspn(description, ",");
+        size_t i;
+
+        if (len >= sizeof(token)) {
+            DebugMessage(M64MSG_WARNING, "DSP_CHAIN: stage description too long");
+            len = sizeof(token) - 1;
+        }
+        memcpy(token, description, len);
+        token[len] = '\0';
+
+        description += strcspn(description, ",");
+        if (*description == ',') {
+            ++description;
+        }
+
+        if (token[0] == '\0') {
+            continue;
+        }
+
+        for (i = 0; allow_presets && i < ARRAY_SIZE(presets); ++i) {
+            if (strcmp(token, presets[i].name) == 0) {
+                break;
+            }
+        }
+
+        if (allow_presets && i < ARRAY_SIZE(presets)) {
+            parse_chain(chain, presets[i].expansion, 0);
+        }
+        else {
+            add_stage(chain, token);
+        }
+    }
+}
+
+struct dsp_chain* init_dsp_chain(const char* description)
+{
+    struct dsp_chain* chain;
+
+    if (description == NULL || description[0] == '\0') {
+        return NULL;
+    }
+
+    chain = malloc(sizeof(*chain));
+    if (chain == NULL) {
+        DebugMessage(M64MSG_ERROR, "DSP_CHAIN: failed to allocate memory");
+        return NULL;
+    }
+    memset(chain, 0, sizeof(*chain));
+
+    parse_chain(chain, description, 1);
+
+    if (chain->count == 0) {
+        DebugMessage(M64MSG_WARNING, "DSP_CHAIN: no enabled stage in '%s'", description);
+        free(chain);
+        return NULL;
+    }
+
+    DebugMessage(M64MSG_INFO, "Using DSP chain %s (%u stages)", description, (unsigned int)chain->count);
+
+    /* until the device frequency is known */
+    dsp_chain_set_frequency(chain, 44100);
+
+    return chain;
+}
+
+void release_dsp_chain(struct dsp_chain* chain)
+{
+    size_t i;
+
+    if (chain == NULL) {
+        return;
+    }
+
+    for (i = 0; i < chain->count; ++i) {
+        chain->stages[i].idsp->release(chain->stages[i].stage);
+    }
+
+    free(chain);
+}
+
+void dsp_chain_set_frequency(struct dsp_chain* chain, unsigned int frequency)
+{
+    size_t i;
+
+    for (i = 0; i < chain->count; ++i) {
+        chain->stages[i].idsp->set_frequency(chain->stages[i].stage, frequency);
+    }
+}
+
+static void s16_to_float(float* dst, const int16_t* src, size_t count)
+{
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        /* sign extend by shifting the duplicated 16-bit words down */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+static void float_to_s16(int16_t* dst, const float* src, size_t count)
+{
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    const __m128 vscale = _mm_set1_ps(32768.0f);
+    const __m128 vmax = _mm_set1_ps(32767.0f);
+    const __m128 vmin = _mm_set1_ps(-32768.0f);
+
+    for (; i + 8 <= count; i += 8) {
+        /* clamp before converting: out of range conversions give INT_MIN */
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vscale), vmin), vmax);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), vscale), vmin), vmax);
+
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float v = src[i] * 32768.0f;
+
+        if (v > 32767.0f) {
+            v = 32767.0f;
+        }
+        else if (v < -32768.0f) {
+            v = -32768.0f;
+        }
+        /* rounds to nearest even like _mm_cvtps_epi32, so both paths give the same samples */
+        dst[i] = (int16_t)lrintf(v);
+    }
+}
+
+void dsp_chain_process(struct dsp_chain* chain, void* samples, size_t frames)
+{
+    int16_t* s = (int16_t*)samples;
+
+    while (frames > 0) {
+        size_t n = (frames < DSP_BLOCK_FRAMES) ? frames : DSP_BLOCK_FRAMES;
+        size_t i;
+
+        s16_to_float(chain->work, s, n * 2);
+
+        for (i = 0; i < chain->count; ++i) {
+            chain->stages[i].idsp->process(chain->stages[i].stage, chain->work, n);
+        }
+
+        float_to_s16(s, chain->work, n * 2);
+
+        s += n * 2;
+        frames -= n;
+    }
+}
@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - dsp.h                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DSP_DSP_H
+#define M64P_DSP_DSP_H
+
+#include <stddef.h>
+
+/* Post-processing chain, run in place on the output buffer after resampling and volume.
+ *
+ * The chain is described by the DSP_CHAIN parameter: a comma separated list of
+ * stages, each one a name followed by colon separated numeric parameters,
+ * e.g. "n64dac,limiter:-1:50,width:1.2". Stages with neutral parameters are
+ * left out of the chain, so they cost nothing.
+ *
+ * Samples are converted once per block to interleaved stereo floats (-1..1),
+ * processed by every stage in place, and converted back with saturation.
+ */
+
+/* frames per processing block */
+enum { DSP_BLOCK_FRAMES = 256 };
+
+struct dsp_interface
+{
+    const char* name;
+
+    /* Create a stage from its name and parameters.
+     * Return NULL and set *disabled if the parameters make it a no-op. */
+    void* (*init)(const char* stage_name, const double* params, size_t param_count, int* disabled);
+
+    void (*release)(void* stage);
+
+    /* Called before any processing, and on output frequency changes (never concurrently with process) */
+    void (*set_frequency)(void* stage, unsigned int frequency);
+
+    /* Process frames interleaved stereo float frames in place. Must not allocate, lock or log. */
+    void (*process)(void* stage, float* samples, size_t frames);
+};
+
+struct dsp_chain;
+
+/* Return NULL if the description is empty or has no enabled stage */
+struct dsp_chain* init_dsp_chain(const char* description);
+
+void release_dsp_chain(struct dsp_chain* chain);
+
+void dsp_chain_set_frequency(struct dsp_chain* chain, unsigned int frequency);
+
+/* Process frames 16-bit stereo frames (host byte order) in place */
+void dsp_chain_process(struct dsp_chain* chain, void* samples, size_t frames);
+
+#endif
@@ -0,0 +1,148 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - limiter.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "dsp/dsp.h"
+#include "dsp/dsp_simd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Peak limiter: instant attack (no sample ever exceeds the threshold),
+ * exponential release. Both channels share the same gain, to keep the stereo image.
+ *
+ * The gain recursion is inherently sequential, so only the block peak detection
+ * and the unity gain fast path are vectorized. */
+
+struct limiter
+{
+    float threshold;
+    double release_ms;
+    float release;
+
+    float gain;
+};
+
+static void* limiter_init(const char* stage_name, const double* params, size_t param_count, int* disabled)
+{
+    struct limiter* limiter;
+
+    /* [THRESHOLD_DB[:RELEASE_MS]] */
+    if (param_count > 2 || (param_count > 0 && params[0] > 0.0) || (param_count > 1 && params[1] <= 0.0)) {
+        return NULL;
+    }
+
+    limiter = malloc(sizeof(*limiter));
+    if (limiter == NULL) {
+        return NULL;
+    }
+    memset(limiter, 0, sizeof(*limiter));
+
+    limiter->threshold = (float)pow(10.0, ((param_count > 0) ? params[0] : -1.0) / 20.0);
+    limiter->release_ms = (param_count > 1) ? params[1] : 50.0;
+    limiter->gain = 1.0f;
+
+    return limiter;
+}
+
+static void limiter_release(void* stage)
+{
+    free(stage);
+}
+
+static void limiter_set_frequency(void* stage, unsigned int frequency)
+{
+    struct limiter* limiter = (struct limiter*)stage;
+
+    limiter->release = (float)(1.0 - exp(-1000.0 / (limiter->release_ms * frequency)));
+}
+
+static float block_peak(const float* samples, size_t count)
+{
+    float peak = 0.0f;
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    /* clear the sign bits for the absolute value */
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vpeak = _mm_setzero_ps();
+    float lanes[4];
+
+    for (; i + 4 <= count; i += 4) {
+        vpeak = _mm_max_ps(vpeak, _mm_and_ps(_mm_loadu_ps(samples + i), abs_mask));
+    }
+
+    _mm_storeu_ps(lanes, vpeak);
+    peak = lanes[0];
+    if (lanes[1] > peak) { peak = lanes[1]; }
+    if (lanes[2] > peak) { peak = lanes[2]; }
+    if (lanes[3] > peak) { peak = lanes[3]; }
+#endif
+
+    for (; i < count; ++i) {
+        float a = fabsf(samples[i]);
+        if (a > peak) {
+            peak = a;
+        }
+    }
+
+    return peak;
+}
+
+static void limiter_process(void* stage, float* samples, size_t frames)
+{
+    struct limiter* limiter = (struct limiter*)stage;
+    float gain = limiter->gain;
+    size_t i;
+
+    /* nothing to limit nor to recover from */
+    if (gain == 1.0f && block_peak(samples, frames * 2) <= limiter->threshold) {
+        return;
+    }
+
+    for (i = 0; i < frames; ++i) {
+        float l = fabsf(samples[2 * i]);
+        float r = fabsf(samples[2 * i + 1]);
+        float peak = (l > r) ? l : r;
+        float target = (peak > limiter->threshold) ? limiter->threshold / peak : 1.0f;
+
+        if (target < gain) {
+            gain = target;
+        }
+        else {
+            gain += (target - gain) * limiter->release;
+        }
+
+        samples[2 * i] *= gain;
+        samples[2 * i + 1] *= gain;
+    }
+
+    /* snap back to unity to reenable the fast path */
+    limiter->gain = (gain > 0.9999f) ? 1.0f : gain;
+}
+
+const struct dsp_interface g_limiter_idsp = {
+    "limiter",
+    limiter_init,
+    limiter_release,
+    limiter_set_frequency,
+    limiter_process
+};
@@ -0,0 +1,106 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - stereo_width.c                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "dsp/dsp.h"
+#include "dsp/dsp_simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Stereo width control, in mid/side terms: L = M + w.S, R = M - w.S
+ * (0 is mono, 1 unchanged, above 1 wider), which is the 2x2 mix
+ * L' = a.L + b.R, R' = b.L + a.R with a = (1 + w) / 2, b = (1 - w) / 2. */
+
+struct stereo_width
+{
+    float a;
+    float b;
+};
+
+static void* stereo_width_init(const char* stage_name, const double* params, size_t param_count, int* disabled)
+{
+    struct stereo_width* sw;
+
+    /* WIDTH */
+    if (param_count != 1 || params[0] < 0.0) {
+        return NULL;
+    }
+
+    if (params[0] == 1.0) {
+        *disabled = 1;
+        return NULL;
+    }
+
+    sw = malloc(sizeof(*sw));
+    if (sw == NULL) {
+        return NULL;
+    }
+
+    sw->a = (float)((1.0 + params[0]) / 2.0);
+    sw->b = (float)((1.0 - params[0]) / 2.0);
+
+    return sw;
+}
+
+static void stereo_width_release(void* stage)
+{
+    free(stage);
+}
+
+static void stereo_width_set_frequency(void* stage, unsigned int frequency)
+{
+    /* frequency independent */
+}
+
+static void stereo_width_process(void* stage, float* samples, size_t frames)
+{
+    const struct stereo_width* sw = (const struct stereo_width*)stage;
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    const __m128 a = _mm_set1_ps(sw->a);
+    const __m128 b = _mm_set1_ps(sw->b);
+
+    /* 2 frames at a time, b is applied to the swapped channels */
+    for (; i + 2 <= frames; i += 2) {
+        __m128 x = _mm_loadu_ps(samples + 2 * i);
+        __m128 swapped = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+
+        _mm_storeu_ps(samples + 2 * i, _mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, swapped)));
+    }
+#endif
+
+    for (; i < frames; ++i) {
+        float l = samples[2 * i];
+        float r = samples[2 * i + 1];
+
+        samples[2 * i] = sw->a * l + sw->b * r;
+        samples[2 * i + 1] = sw->b * l + sw->a * r;
+    }
+}
+
+const struct dsp_interface g_stereo_width_idsp = {
+    "stereo width",
+    stereo_width_init,
+    stereo_width_release,
+    stereo_width_set_frequency,
+    stereo_width_process
+};
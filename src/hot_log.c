@@ -0,0 +1,95 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - hot_log.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdio.h>
+
+#include "hot_log.h"
+#include "main.h"
+
+/* minimum delay between two non-forced flushes */
+enum { HOT_LOG_FLUSH_PERIOD_MS = 1000 };
+
+/* stack of sites with pending messages */
+static void* l_pending = NULL;
+static unsigned int l_last_flush = 0;
+
+
+void hot_log(struct hot_log_site* site, size_t arg0, size_t arg1)
+{
+    void* head;
+
+    site->args[0] = arg0;
+    site->args[1] = arg1;
+
+    /* only the first occurrence since last flush queues the site */
+    if (SDL_AtomicAdd(&site->count, 1) != 0) {
+        return;
+    }
+
+    do {
+        head = SDL_AtomicGetPtr(&l_pending);
+        site->next = (struct hot_log_site*)head;
+    } while (!SDL_AtomicCASPtr(&l_pending, head, site));
+}
+
+void hot_log_flush(int force)
+{
+    struct hot_log_site* site;
+    struct hot_log_site* sites = NULL;
+    unsigned int now = SDL_GetTicks();
+
+    if (!force && (now - l_last_flush) < HOT_LOG_FLUSH_PERIOD_MS) {
+        return;
+    }
+    l_last_flush = now;
+
+    /* grab all pending sites at once and restore their logging order */
+    site = (struct hot_log_site*)SDL_AtomicSetPtr(&l_pending, NULL);
+    while (site != NULL) {
+        struct hot_log_site* next = site->next;
+        site->next = sites;
+        sites = site;
+        site = next;
+    }
+
+    while (sites != NULL) {
+        char msgbuf[256];
+        size_t args[HOT_LOG_MAX_ARGS];
+        int count;
+
+        site = sites;
+        /* read next before releasing the site, which can be queued again right after */
+        sites = site->next;
+        args[0] = site->args[0];
+        args[1] = site->args[1];
+        count = SDL_AtomicSet(&site->count, 0);
+
+        snprintf(msgbuf, sizeof(msgbuf), site->message, args[0], args[1]);
+
+        if (count > 1) {
+            DebugMessage(site->level, "%s (%d times)", msgbuf, count);
+        }
+        else {
+            DebugMessage(site->level, "%s", msgbuf);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - hot_log.h                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_HOT_LOG_H
+#define M64P_HOT_LOG_H
+
+#include <SDL.h>
+#include <stddef.h>
+
+/* Deferred logging for hot paths (audio callback, sample pushing).
+ *
+ * Each call site owns a fixed-size record. Logging a message only stores its arguments
+ * and bumps an occurrence counter; the first occurrence since the last flush also pushes
+ * the record into a lock-free queue. Formatting and calls into the core happen later,
+ * in hot_log_flush, from the emulation thread. Repeated messages are coalesced
+ * into a single line with their occurrence count.
+ *
+ * Messages may only use size_t arguments (%zu).
+ */
+
+enum { HOT_LOG_MAX_ARGS = 2 };
+
+struct hot_log_site
+{
+    int level;
+    const char* message;
+    SDL_atomic_t count;
+    size_t args[HOT_LOG_MAX_ARGS];
+    struct hot_log_site* next;
+};
+
+void hot_log(struct hot_log_site* site, size_t arg0, size_t arg1);
+
+/* Format pending messages. Must not be called from the audio callback.
+ * Unless force is set, flushes at most once per second. */
+void hot_log_flush(int force);
+
+#define HOT_LOG(level, message, arg0, arg1) \
+    do { \
+        static struct hot_log_site hot_log_site_ = { (level), (message) }; \
+        hot_log(&hot_log_site_, (size_t)(arg0), (size_t)(arg1)); \
+    } while(0)
+
+#endif
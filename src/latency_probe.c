@@ -0,0 +1,307 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - latency_probe.c                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_probe.h"
+#include "main.h"
+
+#include "m64p_types.h"
+
+/* burst written at the start of a push, in N64 samples */
+enum { PROBE_BURST_SAMPLES = 16 };
+enum { PROBE_BURST_LEVEL = 0x6000 };
+/* detection threshold on the output, low enough to survive resampling and volume */
+enum { PROBE_DETECT_LEVEL = 0x0800 };
+/* must be a power of two */
+enum { PROBE_MARKERS = 16 };
+/* measurements kept per series */
+enum { PROBE_SAMPLES = 4096 };
+/* 16-bit stereo */
+enum { PROBE_FRAME_BYTES = 4 };
+
+struct probe_marker
+{
+    uint64_t push_ticks;
+    double predicted_ms;
+};
+
+struct probe_series
+{
+    const char* name;
+    double values[PROBE_SAMPLES];
+    unsigned int count;
+};
+
+struct probe_detector
+{
+    /* output frames to skip before detecting the next burst */
+    size_t holdoff;
+    struct probe_series series;
+};
+
+struct latency_probe
+{
+    uint64_t perf_frequency;
+    uint64_t interval_ticks;
+    uint64_t next_burst_ticks;
+
+    /* markers are written by the emulation thread and read by the detectors,
+     * marker_count is published after the marker is written */
+    struct probe_marker markers[PROBE_MARKERS];
+    SDL_atomic_t marker_count;
+
+    struct probe_series model;
+    struct probe_detector output;
+    struct probe_detector capture;
+
+    SDL_AudioDeviceID capture_device;
+    unsigned int capture_frequency;
+};
+
+
+static void add_sample(struct probe_series* series, double value)
+{
+    series->values[series->count % PROBE_SAMPLES] = value;
+    ++series->count;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void log_series(const struct probe_series* series)
+{
+    unsigned int count = (series->count < PROBE_SAMPLES) ? series->count : PROBE_SAMPLES;
+    double sorted[PROBE_SAMPLES];
+    double sum = 0.0;
+    unsigned int i;
+
+    if (count == 0) {
+        DebugMessage(M64MSG_INFO, "Latency probe: %s: no measurement", series->name);
+        return;
+    }
+
+    memcpy(sorted, series->values, count * sizeof(sorted[0]));
+    qsort(sorted, count, sizeof(sorted[0]), compare_doubles);
+
+    for (i = 0; i < count; ++i) {
+        sum += sorted[i];
+    }
+
+    DebugMessage(M64MSG_INFO, "Latency probe: %s: %u bursts, avg %.1f ms, min %.1f / p50 %.1f / p90 %.1f / p99 %.1f / max %.1f ms",
+            series->name, count, sum / count,
+            sorted[0], sorted[count / 2], sorted[(count - 1) * 9 / 10], sorted[(count - 1) * 99 / 100], sorted[count - 1]);
+}
+
+/* Scan 16-bit stereo frames for a burst. Returns the frame index or -1 */
+static long detect_burst(struct probe_detector* detector, const int16_t* frames, size_t count)
+{
+    size_t i = 0;
+    long found = -1;
+
+    if (detector->holdoff >= count) {
+        detector->holdoff -= count;
+        return -1;
+    }
+
+    i = detector->holdoff;
+    detector->holdoff = 0;
+
+    for (; i < count; ++i) {
+        if (abs(frames[2 * i + 0]) >= PROBE_DETECT_LEVEL || abs(frames[2 * i + 1]) >= PROBE_DETECT_LEVEL) {
+            found = (long)i;
+            break;
+        }
+    }
+
+    return found;
+}
+
+/* Latency of a burst played at detect_ticks, found at now_ticks, against the most recent burst pushed before */
+static int match_marker(struct latency_probe* probe, uint64_t now_ticks, uint64_t detect_ticks, double* latency_ms)
+{
+    int count = SDL_AtomicGet(&probe->marker_count);
+    int i;
+
+    SDL_MemoryBarrierAcquire();
+
+    for (i = count - 1; i >= 0 && i >= count - PROBE_MARKERS; --i) {
+        const struct probe_marker* marker = &probe->markers[i % PROBE_MARKERS];
+        if (marker->push_ticks <= now_ticks) {
+            if (detect_ticks < marker->push_ticks) {
+                return 0;
+            }
+            *latency_ms = (double)(detect_ticks - marker->push_ticks) * 1000.0 / probe->perf_frequency;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void detect(struct latency_probe* probe, struct probe_detector* detector,
+                   const void* stream, size_t size, unsigned int frequency, uint64_t ticks, int captured)
+{
+    size_t count = size / PROBE_FRAME_BYTES;
+    long index = detect_burst(detector, (const int16_t*)stream, count);
+    double latency_ms;
+    uint64_t offset, detect_ticks;
+
+    if (index < 0) {
+        return;
+    }
+
+    /* A captured frame was recorded before its callback.
+     * An output frame is played once the buffer currently played by the device is done,
+     * assuming a double buffered device (same assumption as the synchronization model) */
+    offset = (uint64_t)(captured ? (count - index) : (count + index)) * probe->perf_frequency / frequency;
+    detect_ticks = captured ? ticks - offset : ticks + offset;
+
+    if (match_marker(probe, ticks, detect_ticks, &latency_ms)) {
+        add_sample(&detector->series, latency_ms);
+    }
+
+    /* skip the rest of the burst and its resampling ringing (the rest of this buffer is skipped anyway) */
+    detector->holdoff = frequency / 50;
+}
+
+static void capture_callback(void* userdata, Uint8* stream, int len)
+{
+    struct latency_probe* probe = (struct latency_probe*)userdata;
+
+    detect(probe, &probe->capture, stream, len, probe->capture_frequency, SDL_GetPerformanceCounter(), 1);
+}
+
+static void open_capture_device(struct latency_probe* probe, const char* capture_device)
+{
+    SDL_AudioSpec desired, obtained;
+
+    memset(&desired, 0, sizeof(desired));
+    desired.freq = 48000;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = 2;
+    desired.samples = 256;
+    desired.callback = capture_callback;
+    desired.userdata = probe;
+
+    probe->capture_device = SDL_OpenAudioDevice((strcmp(capture_device, "default") == 0) ? NULL : capture_device,
+            1, &desired, &obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+
+    if (probe->capture_device == 0) {
+        DebugMessage(M64MSG_WARNING, "Latency probe: couldn't open capture device %s: %s", capture_device, SDL_GetError());
+        return;
+    }
+
+    probe->capture_frequency = obtained.freq;
+    SDL_PauseAudioDevice(probe->capture_device, 0);
+
+    DebugMessage(M64MSG_INFO, "Latency probe: capturing from %s at %iHz", capture_device, obtained.freq);
+}
+
+
+struct latency_probe* start_latency_probe(unsigned int interval_ms, const char* capture_device)
+{
+    struct latency_probe* probe;
+
+    if (interval_ms == 0) {
+        return NULL;
+    }
+
+    probe = malloc(sizeof(*probe));
+    if (probe == NULL) {
+        DebugMessage(M64MSG_ERROR, "Failed to allocate memory for latency probe");
+        return NULL;
+    }
+
+    memset(probe, 0, sizeof(*probe));
+    probe->perf_frequency = SDL_GetPerformanceFrequency();
+    probe->interval_ticks = probe->perf_frequency * interval_ms / 1000;
+    probe->next_burst_ticks = SDL_GetPerformanceCounter();
+    probe->model.name = "model";
+    probe->output.series.name = "audio callback (+1 buffer)";
+    probe->capture.series.name = "capture";
+
+    if (capture_device != NULL && capture_device[0] != '\0') {
+        open_capture_device(probe, capture_device);
+    }
+
+    DebugMessage(M64MSG_WARNING, "Latency probe enabled: game audio is replaced by a burst every %u ms", interval_ms);
+
+    return probe;
+}
+
+void stop_latency_probe(struct latency_probe* probe)
+{
+    if (probe == NULL) {
+        return;
+    }
+
+    if (probe->capture_device != 0) {
+        SDL_CloseAudioDevice(probe->capture_device);
+    }
+
+    log_series(&probe->model);
+    log_series(&probe->output.series);
+    if (probe->capture_device != 0) {
+        log_series(&probe->capture.series);
+    }
+
+    free(probe);
+}
+
+void latency_probe_push(struct latency_probe* probe, void* samples, size_t size, double predicted_ms)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    int count;
+    size_t i;
+
+    memset(samples, 0, size);
+
+    if (now < probe->next_burst_ticks || size < PROBE_BURST_SAMPLES * PROBE_FRAME_BYTES) {
+        return;
+    }
+
+    probe->next_burst_ticks = now + probe->interval_ticks;
+
+    for (i = 0; i < PROBE_BURST_SAMPLES * 2; ++i) {
+        ((int16_t*)samples)[i] = PROBE_BURST_LEVEL;
+    }
+
+    count = SDL_AtomicGet(&probe->marker_count);
+    probe->markers[count % PROBE_MARKERS].push_ticks = now;
+    probe->markers[count % PROBE_MARKERS].predicted_ms = predicted_ms;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&probe->marker_count, count + 1);
+
+    add_sample(&probe->model, predicted_ms);
+}
+
+void latency_probe_output(struct latency_probe* probe, const void* stream, size_t size,
+        unsigned int frequency, unsigned long long cb_ticks)
+{
+    detect(probe, &probe->output, stream, size, frequency, cb_ticks, 0);
+}
@@ -0,0 +1,56 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - latency_probe.h                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_LATENCY_PROBE_H
+#define M64P_LATENCY_PROBE_H
+
+#include <stddef.h>
+
+/* End-to-end latency measurement mode (LATENCY_PROBE_MS config parameter).
+ *
+ * N64 audio is replaced by silence with a short full scale burst every interval.
+ * Each burst is timestamped when pushed, along with the latency predicted by the
+ * synchronization model, then detected in the output stream written by the audio
+ * callback and, optionally, in a capture device (e.g. an ALSA loopback or a monitor
+ * of the output). Latency distributions are logged when the probe is stopped.
+ *
+ * Bursts are matched to the most recent burst pushed before detection,
+ * so the interval must be longer than the latency being measured.
+ */
+
+struct latency_probe;
+
+/* capture_device: name of an SDL capture device, "default" for the default one, or NULL/empty for none */
+struct latency_probe* start_latency_probe(unsigned int interval_ms, const char* capture_device);
+
+/* close the capture device and log measurements */
+void stop_latency_probe(struct latency_probe* probe);
+
+/* Replace size bytes of pushed samples (already in the primary buffer) by the probe signal.
+ * predicted_ms is the latency predicted by the synchronization model for the first of these samples. */
+void latency_probe_push(struct latency_probe* probe, void* samples, size_t size, double predicted_ms);
+
+/* Look for bursts in the output stream written by the audio callback, which started at cb_ticks
+ * (SDL performance counter). Real-time safe. */
+void latency_probe_output(struct latency_probe* probe, const void* stream, size_t size,
+        unsigned int frequency, unsigned long long cb_ticks);
+
+#endif
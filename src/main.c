@@ -26,18 +26,31 @@
 #include <SDL_audio.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 
+#define M64P_PLUGIN_PROTOTYPES 1
+#include "ai_record.h"
+#include "audio_stats.h"
+#include "capture.h"
+#include "hot_log.h"
 #include "main.h"
 #include "osal_dynamiclib.h"
+#include "rsp_fallback.h"
+#include "rt_check.h"
 #include "sdl_backend.h"
+#include "trace.h"
+#include "alist/alist.h"
 #include "resamplers/resamplers.h"
 
-#define M64P_PLUGIN_PROTOTYPES 1
 #include "m64p_common.h"
 #include "m64p_config.h"
 #include "m64p_plugin.h"
 #include "m64p_types.h"
+#include "audio_checkpoint.h"
+#include "audio_instance.h"
+#include "audio_reload.h"
+#include "audio_timing.h"
 
 /* version info */
 #define SDL_AUDIO_PLUGIN_VERSION 0x020600
@@ -78,20 +91,59 @@ static void (*l_DebugCallback)(void *, int, const char *) = NULL;
 static void *l_DebugCallContext = NULL;
 static int l_PluginInit = 0;
 static m64p_handle l_ConfigAudio;
+/* for the PluginStartup of ALIST_FALLBACK */
+static m64p_dynlib_handle l_CoreHandle = NULL;
+
+/* State of an audio pipeline. The legacy plugin API drives l_DefaultInstance,
+ * the AudioInstance* API drives any number of them. */
+struct audio_instance
+{
+    m64p_handle config;
+
+    /* Read header for type definition */
+    AUDIO_INFO info;
+
+    struct sdl_backend* sdl_backend;
+
+    /* recorder of the AI input stream, if enabled */
+    struct ai_recorder* ai_recorder;
+
+    /* audio microcode HLE, for ProcessAList */
+    struct alist_hle* alist_hle;
+    /* RSP plugin running the audio lists alist_hle doesn't support, if any */
+    struct rsp_fallback* rsp_fallback;
+    /* whether the lack of rsp_fallback was reported */
+    int rsp_fallback_warned;
+
+    /* between RomOpen and RomClosed, counted in l_open_instances */
+    int rom_open;
+
+    // volume to scale the audio by, range of 0..100
+    // if muted, this holds the volume when not muted
+    int vol_percent;
+    // how much percent to increment/decrement volume by
+    int vol_delta;
+    // Muted or not
+    int vol_is_muted;
+
+    char volume_string[32];
+
+    /* next instance created by AudioInstanceCreate, in l_instances */
+    struct audio_instance* next;
+};
+
+static struct audio_instance l_DefaultInstance;
+/* instances created by AudioInstanceCreate and not destroyed yet, closed by PluginShutdown */
+static struct audio_instance* l_instances = NULL;
+
+/* The RT checks and the event trace are process-wide: they start with the first open
+ * instance, and only the last instance closed reports, stops and dumps them.
+ * A mutex rather than a spinlock, as the trace is dumped to a file while holding it. */
+static SDL_mutex* l_global_lock = NULL;
+static int l_open_instances = 0;
+/* file where the event trace is written when the last instance is closed */
+static char l_trace_file[1024];
 
-static struct sdl_backend* l_sdl_backend = NULL;
-
-/* Read header for type definition */
-static AUDIO_INFO AudioInfo;
-// volume to scale the audio by, range of 0..100
-// if muted, this holds the volume when not muted
-static int VolPercent = 80;
-// how much percent to increment/decrement volume by
-static int VolDelta = 5;
-// the actual volume passed into SDL, range of 0..SDL_MIX_MAXVOLUME
-static int VolSDL = SDL_MIX_MAXVOLUME;
-// Muted or not
-static int VolIsMuted = 0;
 /* definitions of pointers to Core config functions */
 ptr_ConfigOpenSection      ConfigOpenSection = NULL;
 ptr_ConfigDeleteSection    ConfigDeleteSection = NULL;
@@ -113,6 +165,8 @@ void DebugMessage(int level, const char *message, ...)
   char msgbuf[1024];
   va_list args;
 
+  RT_CHECK_POINT(RT_CHECK_LOG);
+
   if (l_DebugCallback == NULL)
       return;
 
@@ -125,6 +179,47 @@ void DebugMessage(int level, const char *message, ...)
 }
 
 
+static void set_config_defaults(m64p_handle config)
+{
+    ConfigSetDefaultFloat(config, "Version",             CONFIG_PARAM_VERSION,  "Mupen64Plus SDL Audio Plugin config parameter version number");
+    ConfigSetDefaultInt(config, "DEFAULT_FREQUENCY",     DEFAULT_FREQUENCY,     "Frequency which is used if rom doesn't want to change it");
+    ConfigSetDefaultBool(config, "SWAP_CHANNELS",        0,                     "Swaps left and right channels");
+    ConfigSetDefaultInt(config, "PRIMARY_BUFFER_SIZE",   PRIMARY_BUFFER_SIZE,   "Size of primary buffer in output samples. This is where audio is loaded after it's extracted from n64's memory.");
+    ConfigSetDefaultInt(config, "PRIMARY_BUFFER_TARGET", PRIMARY_BUFFER_TARGET, "Fullness level target for Primary audio buffer, in equivalent output samples. This value must be larger than the SECONDARY_BUFFER_SIZE. Decreasing this value will reduce audio latency but requires a faster PC to avoid choppiness. Increasing this will increase audio latency but reduce the chance of drop-outs.");
+    ConfigSetDefaultInt(config, "SECONDARY_BUFFER_SIZE", SECONDARY_BUFFER_SIZE, "Size of secondary buffer in output samples. This is SDL's hardware buffer. The SDL documentation states that this should be a power of two between 512 and 8192.");
+    ConfigSetDefaultString(config, "RESAMPLE",           DEFAULT_RESAMPLER,             "Audio resampling algorithm. src-sinc-best-quality, src-sinc-medium-quality, src-sinc-fastest, src-zero-order-hold, src-linear, speex-fixed-{10-0}, trivial, or auto[:ID,ID,...] to adapt quality to the available CPU time, stepping through the listed configurations from best to cheapest");
+    ConfigSetDefaultInt(config, "RESAMPLE_BUDGET",       30,                    "With RESAMPLE=auto, percentage of the audio callback period that resampling may use before quality is lowered");
+    ConfigSetDefaultString(config, "PRIMARY_BUFFER_LAYOUT", "interleaved",         "Layout of the samples waiting to be resampled: interleaved (int16 left/right frames), planar-s16, planar-f32 (separate left and right channels, as int16 or float), or planar (planar-f32 if the resampler accepts it, else planar-s16). Falls back to interleaved if the resampler doesn't accept the layout");
+    ConfigSetDefaultInt(config, "CONCEAL_MS",            5,                     "Length (in ms) of the fade out covering missing audio on underruns, and of the fade in on recovery. 0 plays silence as soon as data is missing");
+    ConfigSetDefaultString(config, "DSP_CHAIN",          "",                    "Post-processing of the output, comma separated stages: lowpass:FREQ[:Q], highpass:FREQ[:Q], peak|lowshelf|highshelf:FREQ:GAIN_DB[:Q], limiter[:THRESHOLD_DB[:RELEASE_MS]], width:FACTOR, n64dac (N64 analog output approximation)");
+    ConfigSetDefaultInt(config, "VOLUME_ADJUST",         5,                     "Percentage change each time the volume is increased or decreased");
+    ConfigSetDefaultInt(config, "VOLUME_DEFAULT",        80,                    "Default volume when a game is started");
+    ConfigSetDefaultBool(config, "AUDIO_SYNC",           1,                     "Synchronize Video/Audio");
+    ConfigSetDefaultInt(config, "SYNC_TOLERANCE_MS",     10,                    "With AUDIO_SYNC, delay emulation only when audio is buffered this many milliseconds above PRIMARY_BUFFER_TARGET");
+    ConfigSetDefaultInt(config, "SYNC_RESUME_MS",        0,                     "After pausing audio to avoid an underrun, resume only when this many milliseconds above SECONDARY_BUFFER_SIZE are buffered");
+    ConfigSetDefaultInt(config, "DEVICE_TIMEOUT_MS",     500,                   "If the audio device stops playing for this many milliseconds (removed headset, sound server restart), keep the game running on a virtual clock and reopen the default device once available. 0 only reacts to devices SDL reports as removed");
+    ConfigSetDefaultBool(config, "LOW_LATENCY",          0,                     "Lock audio buffers in memory and run the audio thread with real-time scheduling");
+    ConfigSetDefaultInt(config, "RT_PRIORITY",           10,                    "Real-time priority of the audio thread in low latency mode");
+    ConfigSetDefaultInt(config, "AUDIO_CPU",             -1,                    "CPU to pin the audio thread to in low latency mode (-1 to not pin it)");
+    ConfigSetDefaultString(config, "CAPTURE_FILE",       "",                    "If not empty, record the audio output (after resampling and volume) to this WAV file");
+    ConfigSetDefaultString(config, "CAPTURE_RAW_FILE",   "",                    "If not empty, record the audio produced by the N64 (before resampling) to this WAV file");
+    ConfigSetDefaultString(config, "AI_RECORD_FILE",     "",                    "If not empty, record the audio interface input (rate changes and samples) to this file, for replay with ai_replay");
+    ConfigSetDefaultInt(config, "LATENCY_PROBE_MS",      0,                     "Latency measurement mode: if not 0, replace game audio by a burst every this many milliseconds and log the measured input to output latency when the game is closed");
+    ConfigSetDefaultString(config, "LATENCY_PROBE_CAPTURE", "",                  "Latency measurement mode: SDL capture device receiving the output (e.g. a loopback or monitor device, 'default' for the default one), for measuring actual playback latency");
+    ConfigSetDefaultString(config, "SHM_TAP_NAME",       "",                    "If not empty, publish the audio output into a shared memory ring of this name, for external readers such as shm_reader");
+    ConfigSetDefaultInt(config, "SHM_TAP_FRAMES",        65536,                 "Size of the shared memory ring in output samples (rounded up to a power of two)");
+    ConfigSetDefaultString(config, "ALIST_FALLBACK",     "",                    "Path of an RSP plugin (e.g. mupen64plus-rsp-cxd4) running the audio lists forwarded to this plugin whose microcode it doesn't support (ABI2, ABI3, MusyX). It must not be the RSP plugin of the core");
+    ConfigSetDefaultString(config, "TRACE_FILE",         "",                    "If not empty, record a timeline of audio events and write it to this file (Chrome trace_event JSON format) when the game is closed");
+}
+
+static void init_audio_instance(struct audio_instance* instance, m64p_handle config)
+{
+    memset(instance, 0, sizeof(*instance));
+    instance->config = config;
+    instance->vol_percent = 80;
+    instance->vol_delta = 5;
+}
+
 /* Mupen64Plus plugin functions */
 EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Context,
                                    void (*DebugCallback)(void *, int, const char *))
@@ -140,6 +235,7 @@ EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Con
     /* first thing is to set the callback function for debug info */
     l_DebugCallback = DebugCallback;
     l_DebugCallContext = Context;
+    l_CoreHandle = CoreLibHandle;
 
     /* attach and call the CoreGetAPIVersions function, check Config API version for compatibility */
     CoreAPIVersionFunc = (ptr_CoreGetAPIVersions) osal_dynlib_getproc(CoreLibHandle, "CoreGetAPIVersions");
@@ -205,29 +301,52 @@ EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Con
     }
 
     /* set the default values for this plugin */
-    ConfigSetDefaultFloat(l_ConfigAudio, "Version",             CONFIG_PARAM_VERSION,  "Mupen64Plus SDL Audio Plugin config parameter version number");
-    ConfigSetDefaultInt(l_ConfigAudio, "DEFAULT_FREQUENCY",     DEFAULT_FREQUENCY,     "Frequency which is used if rom doesn't want to change it");
-    ConfigSetDefaultBool(l_ConfigAudio, "SWAP_CHANNELS",        0,                     "Swaps left and right channels");
-    ConfigSetDefaultInt(l_ConfigAudio, "PRIMARY_BUFFER_SIZE",   PRIMARY_BUFFER_SIZE,   "Size of primary buffer in output samples. This is where audio is loaded after it's extracted from n64's memory.");
-    ConfigSetDefaultInt(l_ConfigAudio, "PRIMARY_BUFFER_TARGET", PRIMARY_BUFFER_TARGET, "Fullness level target for Primary audio buffer, in equivalent output samples. This value must be larger than the SECONDARY_BUFFER_SIZE. Decreasing this value will reduce audio latency but requires a faster PC to avoid choppiness. Increasing this will increase audio latency but reduce the chance of drop-outs.");
-    ConfigSetDefaultInt(l_ConfigAudio, "SECONDARY_BUFFER_SIZE", SECONDARY_BUFFER_SIZE, "Size of secondary buffer in output samples. This is SDL's hardware buffer. The SDL documentation states that this should be a power of two between 512 and 8192.");
-    ConfigSetDefaultString(l_ConfigAudio, "RESAMPLE",           DEFAULT_RESAMPLER,             "Audio resampling algorithm. src-sinc-best-quality, src-sinc-medium-quality, src-sinc-fastest, src-zero-order-hold, src-linear, speex-fixed-{10-0}, trivial");
-    ConfigSetDefaultInt(l_ConfigAudio, "VOLUME_ADJUST",         5,                     "Percentage change each time the volume is increased or decreased");
-    ConfigSetDefaultInt(l_ConfigAudio, "VOLUME_DEFAULT",        80,                    "Default volume when a game is started");
-    ConfigSetDefaultBool(l_ConfigAudio, "AUDIO_SYNC",           1,                     "Synchronize Video/Audio");
+    set_config_defaults(l_ConfigAudio);
+
+    init_audio_instance(&l_DefaultInstance, l_ConfigAudio);
+
+    l_global_lock = SDL_CreateMutex();
+    if (l_global_lock == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Couldn't create the global lock: %s", SDL_GetError());
+        return M64ERR_SYSTEM_FAIL;
+    }
 
     l_PluginInit = 1;
     return M64ERR_SUCCESS;
 }
 
+
+static void instance_rom_closed(struct audio_instance* instance);
+
 EXPORT m64p_error CALL PluginShutdown(void)
 {
+    struct audio_instance* instance;
+
     if (!l_PluginInit)
         return M64ERR_NOT_INIT;
 
+    /* close the instances still open, so that their backends are released and
+     * the last one closed reports the RT checks and dumps the event trace.
+     * The others stay allocated until AudioInstanceDestroy. */
+    if (l_DefaultInstance.rom_open)
+        instance_rom_closed(&l_DefaultInstance);
+
+    for (instance = l_instances; instance != NULL; instance = instance->next)
+    {
+        if (instance->rom_open)
+            instance_rom_closed(instance);
+    }
+
+    SDL_DestroyMutex(l_global_lock);
+    l_global_lock = NULL;
+
+    trace_release();
+
     /* reset some local variables */
     l_DebugCallback = NULL;
     l_DebugCallContext = NULL;
+    l_CoreHandle = NULL;
 
     l_PluginInit = 0;
     return M64ERR_SUCCESS;
@@ -270,29 +389,354 @@ static unsigned int vi_clock_from_system_type(int system_type)
     }
 }
 
-static unsigned int dacrate2freq(unsigned int vi_clock, uint32_t dacrate)
+
+/* ----------- Instance Functions ------------- */
+static void instance_dacrate_changed(struct audio_instance* instance, int SystemType)
 {
-    return vi_clock / (dacrate + 1);
+    if (instance->sdl_backend == NULL)
+        return;
+
+    /* the DAC rate is rarely a whole number of Hz (e.g. ~32006.6Hz on NTSC), keep it exact */
+    unsigned int vi_clock = vi_clock_from_system_type(SystemType);
+    unsigned int divider = *instance->info.AI_DACRATE_REG + 1;
+
+    if (instance->ai_recorder != NULL)
+        ai_record_dacrate(instance->ai_recorder, SystemType, *instance->info.AI_DACRATE_REG);
+
+    TRACE_COUNTER("input frequency", vi_clock / divider);
+
+    sdl_set_input_rate(instance->sdl_backend, vi_clock, divider);
 }
 
-EXPORT void CALL AiDacrateChanged(int SystemType)
+static void instance_len_changed(struct audio_instance* instance)
 {
-    if (!l_PluginInit || l_sdl_backend == NULL)
+    if (instance->sdl_backend == NULL)
         return;
 
-    unsigned int frequency = dacrate2freq(vi_clock_from_system_type(SystemType), *AudioInfo.AI_DACRATE_REG);
+    const unsigned char* src = instance->info.RDRAM + (*instance->info.AI_DRAM_ADDR_REG & 0xffffff);
+
+    TRACE_THREAD_NAME("emulation");
+    TRACE_BEGIN("AiLenChanged");
+
+    if (instance->ai_recorder != NULL)
+        ai_record_len(instance->ai_recorder, src, *instance->info.AI_LEN_REG);
 
-    sdl_set_frequency(l_sdl_backend, frequency);
+    sdl_push_samples(instance->sdl_backend, src, *instance->info.AI_LEN_REG);
+
+    sdl_synchronize_audio(instance->sdl_backend);
+
+    TRACE_END("AiLenChanged");
 }
 
-EXPORT void CALL AiLenChanged(void)
+// Sets the volume level based on the contents of vol_percent and vol_is_muted
+static void instance_volume_commit(struct audio_instance* instance)
+{
+    int levelToCommit = instance->vol_is_muted ? 0 : instance->vol_percent;
+
+    if (instance->sdl_backend != NULL)
+        sdl_set_volume(instance->sdl_backend, SDL_MIX_MAXVOLUME * levelToCommit / 100);
+}
+
+static void open_global_facilities(const char* trace_file)
+{
+    SDL_LockMutex(l_global_lock);
+
+    if (l_open_instances++ == 0)
+        RT_CHECK_RESET();
+
+    if (trace_file[0] != '\0')
+    {
+        if (!TRACE_ENABLED())
+        {
+            strncpy(l_trace_file, trace_file, sizeof(l_trace_file) - 1);
+            l_trace_file[sizeof(l_trace_file) - 1] = '\0';
+            trace_start();
+        }
+        else if (strcmp(trace_file, l_trace_file) != 0)
+        {
+            DebugMessage(M64MSG_WARNING, "Event trace already recorded to %s, TRACE_FILE %s ignored", l_trace_file, trace_file);
+        }
+    }
+
+    SDL_UnlockMutex(l_global_lock);
+}
+
+static void close_global_facilities(void)
+{
+    SDL_LockMutex(l_global_lock);
+
+    if (--l_open_instances == 0)
+    {
+        RT_CHECK_REPORT();
+
+        if (TRACE_ENABLED())
+        {
+            trace_stop();
+            if (l_trace_file[0] != '\0')
+                trace_dump(l_trace_file);
+            l_trace_file[0] = '\0';
+        }
+    }
+
+    SDL_UnlockMutex(l_global_lock);
+}
+
+static int instance_rom_open(struct audio_instance* instance)
+{
+    m64p_handle config = instance->config;
+
+    if (instance->sdl_backend != NULL)
+        return 0;
+
+    /* a previous RomOpen couldn't open the backend */
+    if (instance->rom_open)
+        instance_rom_closed(instance);
+
+    instance->vol_delta = ConfigGetParamInt(config, "VOLUME_ADJUST");
+    instance->vol_percent = ConfigGetParamInt(config, "VOLUME_DEFAULT");
+
+    open_global_facilities(ConfigGetParamString(config, "TRACE_FILE"));
+    instance->rom_open = 1;
+
+    instance->sdl_backend = init_sdl_backend_from_config(config);
+
+    if (ConfigGetParamString(config, "AI_RECORD_FILE")[0] != '\0')
+        instance->ai_recorder = start_ai_recorder(ConfigGetParamString(config, "AI_RECORD_FILE"));
+
+    instance->alist_hle = init_alist_hle();
+
+    instance->rsp_fallback_warned = 0;
+    if (ConfigGetParamString(config, "ALIST_FALLBACK")[0] != '\0')
+        instance->rsp_fallback = init_rsp_fallback(ConfigGetParamString(config, "ALIST_FALLBACK"), l_CoreHandle,
+                l_DebugCallContext, l_DebugCallback, &instance->info);
+
+    if (instance->sdl_backend != NULL)
+    {
+        const char* output_file = ConfigGetParamString(config, "CAPTURE_FILE");
+        const char* raw_file = ConfigGetParamString(config, "CAPTURE_RAW_FILE");
+
+        instance_volume_commit(instance);
+
+        if (output_file[0] != '\0' || raw_file[0] != '\0')
+            sdl_start_capture(instance->sdl_backend, output_file, raw_file);
+    }
+
+    return 1;
+}
+
+static void instance_rom_closed(struct audio_instance* instance)
+{
+    if (instance->sdl_backend != NULL)
+    {
+        struct audio_stats stats;
+        sdl_get_stats(instance->sdl_backend, &stats);
+        log_audio_stats(&stats);
+    }
+
+    release_sdl_backend(instance->sdl_backend);
+    instance->sdl_backend = NULL;
+
+    stop_ai_recorder(instance->ai_recorder);
+    instance->ai_recorder = NULL;
+
+    release_alist_hle(instance->alist_hle);
+    instance->alist_hle = NULL;
+
+    release_rsp_fallback(instance->rsp_fallback);
+    instance->rsp_fallback = NULL;
+
+    hot_log_flush(1);
+
+    if (instance->rom_open)
+    {
+        instance->rom_open = 0;
+        close_global_facilities();
+    }
+}
+
+static void instance_process_alist(struct audio_instance* instance)
+{
+    if (instance->alist_hle == NULL)
+        return;
+
+    TRACE_BEGIN("ProcessAList");
+
+    if (alist_hle_process_task(instance->alist_hle, instance->info.RDRAM, instance->info.DMEM) != 0)
+    {
+        if (instance->rsp_fallback != NULL)
+        {
+            if (rsp_fallback_run_task(instance->rsp_fallback) != 0)
+            {
+                release_rsp_fallback(instance->rsp_fallback);
+                instance->rsp_fallback = NULL;
+            }
+        }
+        else if (!instance->rsp_fallback_warned)
+        {
+            DebugMessage(M64MSG_WARNING, "ProcessAList: set ALIST_FALLBACK to an RSP plugin (e.g. mupen64plus-rsp-cxd4) to run these audio lists, "
+                         "or let the RSP plugin run them (AudioListToAudioPlugin = False in mupen64plus-rsp-hle)");
+            instance->rsp_fallback_warned = 1;
+        }
+    }
+
+    TRACE_END("ProcessAList");
+}
+
+static void instance_set_speed_factor(struct audio_instance* instance, int percentage)
+{
+    if (instance->sdl_backend == NULL)
+        return;
+
+    if (instance->ai_recorder != NULL)
+        ai_record_speed(instance->ai_recorder, percentage);
+
+    sdl_set_speed_factor(instance->sdl_backend, percentage);
+}
+
+static m64p_error instance_get_stats(struct audio_instance* instance, struct audio_stats* stats)
+{
+    if (stats == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_get_stats(instance->sdl_backend, stats);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_get_timing(struct audio_instance* instance, struct audio_timing* timing)
 {
-    if (!l_PluginInit || l_sdl_backend == NULL)
+    if (timing == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_get_timing(instance->sdl_backend, timing);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_capture_start(struct audio_instance* instance, const char* output_file, const char* raw_file)
+{
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    return (sdl_start_capture(instance->sdl_backend, output_file, raw_file) == 0) ? M64ERR_SUCCESS : M64ERR_FILES;
+}
+
+static m64p_error instance_capture_stop(struct audio_instance* instance)
+{
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_stop_capture(instance->sdl_backend);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_reload_config(struct audio_instance* instance)
+{
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    instance->vol_delta = ConfigGetParamInt(instance->config, "VOLUME_ADJUST");
+
+    sdl_reload_config(instance->sdl_backend);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_checkpoint_save(struct audio_instance* instance, struct audio_checkpoint* checkpoint)
+{
+    if (checkpoint == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_save_checkpoint(instance->sdl_backend, checkpoint);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_checkpoint_restore(struct audio_instance* instance, const struct audio_checkpoint* checkpoint)
+{
+    if (checkpoint == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_restore_checkpoint(instance->sdl_backend, checkpoint);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_speculation_begin(struct audio_instance* instance)
+{
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_begin_speculation(instance->sdl_backend);
+
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error instance_speculation_end(struct audio_instance* instance, int commit)
+{
+    if (instance->sdl_backend == NULL)
+        return M64ERR_INVALID_STATE;
+
+    sdl_end_speculation(instance->sdl_backend, commit);
+
+    return M64ERR_SUCCESS;
+}
+
+static void instance_volume_mute(struct audio_instance* instance)
+{
+    // Toogle mute, vol_percent keeps the level to restore
+    instance->vol_is_muted = !instance->vol_is_muted;
+    instance_volume_commit(instance);
+}
+
+static void instance_volume_set_level(struct audio_instance* instance, int level)
+{
+    //if muted, unmute first
+    instance->vol_is_muted = 0;
+
+    // adjust volume
+    instance->vol_percent = level;
+    if (instance->vol_percent < 0)
+        instance->vol_percent = 0;
+    else if (instance->vol_percent > 100)
+        instance->vol_percent = 100;
+
+    instance_volume_commit(instance);
+}
+
+static int instance_volume_get_level(const struct audio_instance* instance)
+{
+    return instance->vol_is_muted ? 0 : instance->vol_percent;
+}
+
+/* ----------- Audio Functions ------------- */
+EXPORT void CALL AiDacrateChanged(int SystemType)
+{
+    if (!l_PluginInit)
         return;
 
-    sdl_push_samples(l_sdl_backend, AudioInfo.RDRAM + (*AudioInfo.AI_DRAM_ADDR_REG & 0xffffff), *AudioInfo.AI_LEN_REG);
+    instance_dacrate_changed(&l_DefaultInstance, SystemType);
+}
+
+EXPORT void CALL AiLenChanged(void)
+{
+    if (!l_PluginInit)
+        return;
 
-    sdl_synchronize_audio(l_sdl_backend);
+    instance_len_changed(&l_DefaultInstance);
 }
 
 EXPORT int CALL InitiateAudio(AUDIO_INFO Audio_Info)
@@ -300,22 +744,17 @@ EXPORT int CALL InitiateAudio(AUDIO_INFO Audio_Info)
     if (!l_PluginInit)
         return 0;
 
-    AudioInfo = Audio_Info;
+    l_DefaultInstance.info = Audio_Info;
 
     return 1;
 }
 
 EXPORT int CALL RomOpen(void)
 {
-    if (!l_PluginInit || l_sdl_backend != NULL)
+    if (!l_PluginInit)
         return 0;
 
-    VolDelta = ConfigGetParamInt(l_ConfigAudio, "VOLUME_ADJUST");
-    VolPercent = ConfigGetParamInt(l_ConfigAudio, "VOLUME_DEFAULT");
-
-    l_sdl_backend = init_sdl_backend_from_config(l_ConfigAudio);
-
-    return 1;
+    return instance_rom_open(&l_DefaultInstance);
 }
 
 EXPORT void CALL RomClosed(void)
@@ -323,54 +762,152 @@ EXPORT void CALL RomClosed(void)
     if (!l_PluginInit)
         return;
 
-    release_sdl_backend(l_sdl_backend);
-    l_sdl_backend = NULL;
+    instance_rom_closed(&l_DefaultInstance);
 }
 
 EXPORT void CALL ProcessAList(void)
 {
+    if (!l_PluginInit)
+        return;
+
+    instance_process_alist(&l_DefaultInstance);
 }
 
 EXPORT void CALL SetSpeedFactor(int percentage)
 {
-    if (!l_PluginInit || l_sdl_backend == NULL)
+    if (!l_PluginInit)
         return;
 
-    sdl_set_speed_factor(l_sdl_backend, percentage);
+    instance_set_speed_factor(&l_DefaultInstance, percentage);
 }
 
-size_t ResampleAndMix(void* resampler, const struct resampler_interface* iresampler,
-        void* mix_buffer,
-        const void* src, size_t src_size, unsigned int src_freq,
-        void* dst, size_t dst_size, unsigned int dst_freq)
+EXPORT m64p_error CALL AudioGetStats(struct audio_stats* stats)
 {
-    size_t consumed;
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
 
-    consumed = iresampler->resample(resampler, src, src_size, src_freq, mix_buffer, dst_size, dst_freq);
-    memset(dst, 0, dst_size);
-    SDL_MixAudio(dst, mix_buffer, dst_size, VolSDL);
+    return instance_get_stats(&l_DefaultInstance, stats);
+}
 
-    return consumed;
+EXPORT m64p_error CALL AudioGetTiming(struct audio_timing* timing)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_get_timing(&l_DefaultInstance, timing);
+}
+
+EXPORT m64p_error CALL AudioTraceStart(void)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return (trace_start() == 0) ? M64ERR_SUCCESS : M64ERR_NO_MEMORY;
+}
+
+EXPORT m64p_error CALL AudioTraceDump(const char* filename)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (filename == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return (trace_dump(filename) == 0) ? M64ERR_SUCCESS : M64ERR_FILES;
+}
+
+EXPORT m64p_error CALL AudioCaptureStart(const char* output_file, const char* raw_file)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_capture_start(&l_DefaultInstance, output_file, raw_file);
 }
 
-void SetPlaybackVolume(void)
+EXPORT m64p_error CALL AudioCaptureStop(void)
 {
-    VolSDL = SDL_MIX_MAXVOLUME * VolPercent / 100;
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_capture_stop(&l_DefaultInstance);
 }
 
+EXPORT m64p_error CALL AudioCheckpointSave(struct audio_checkpoint* checkpoint)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_checkpoint_save(&l_DefaultInstance, checkpoint);
+}
 
-// Returns the most recent ummuted volume level.
-static int VolumeGetUnmutedLevel(void)
+EXPORT m64p_error CALL AudioCheckpointRestore(const struct audio_checkpoint* checkpoint)
 {
-    return VolPercent;
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_checkpoint_restore(&l_DefaultInstance, checkpoint);
 }
 
-// Sets the volume level based on the contents of VolPercent and VolIsMuted
-static void VolumeCommit(void)
+EXPORT m64p_error CALL AudioSpeculationBegin(void)
 {
-    int levelToCommit = VolIsMuted ? 0 : VolPercent;
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_speculation_begin(&l_DefaultInstance);
+}
+
+EXPORT m64p_error CALL AudioSpeculationCommit(void)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_speculation_end(&l_DefaultInstance, 1);
+}
+
+EXPORT m64p_error CALL AudioSpeculationDiscard(void)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
 
-    VolSDL = SDL_MIX_MAXVOLUME * levelToCommit / 100;
+    return instance_speculation_end(&l_DefaultInstance, 0);
+}
+
+EXPORT m64p_error CALL AudioReloadConfig(void)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    return instance_reload_config(&l_DefaultInstance);
+}
+
+size_t ResampleAndMix(void* resampler, const struct resampler_interface* iresampler,
+        void* mix_buffer,
+        const void* src, size_t src_size, uint64_t src_rate,
+        void* dst, size_t dst_size, uint64_t dst_rate,
+        int volume)
+{
+    size_t consumed;
+
+    consumed = iresampler->resample(resampler, src, src_size, src_rate, mix_buffer, dst_size, dst_rate);
+    memset(dst, 0, dst_size);
+    SDL_MixAudio(dst, mix_buffer, dst_size, volume);
+
+    return consumed;
+}
+
+size_t ResampleAndMixPlanar(void* resampler, const struct resampler_interface* iresampler,
+        unsigned int layout, void* mix_buffer,
+        const void* const src[2], size_t src_size, uint64_t src_rate,
+        void* dst, size_t dst_size, uint64_t dst_rate,
+        int volume)
+{
+    size_t consumed;
+
+    consumed = iresampler->resample_planar(resampler, layout, src, src_size, src_rate, mix_buffer, dst_size, dst_rate);
+    memset(dst, 0, dst_size);
+    SDL_MixAudio(dst, mix_buffer, dst_size, volume);
+
+    return consumed;
 }
 
 EXPORT void CALL VolumeMute(void)
@@ -378,13 +915,7 @@ EXPORT void CALL VolumeMute(void)
     if (!l_PluginInit)
         return;
 
-    // Store the volume level in order to restore it later
-    if (!VolIsMuted)
-        VolPercent = VolumeGetUnmutedLevel();
-
-    // Toogle mute
-    VolIsMuted = !VolIsMuted;
-    VolumeCommit();
+    instance_volume_mute(&l_DefaultInstance);
 }
 
 EXPORT void CALL VolumeUp(void)
@@ -392,7 +923,7 @@ EXPORT void CALL VolumeUp(void)
     if (!l_PluginInit)
         return;
 
-    VolumeSetLevel(VolumeGetUnmutedLevel() + VolDelta);
+    instance_volume_set_level(&l_DefaultInstance, l_DefaultInstance.vol_percent + l_DefaultInstance.vol_delta);
 }
 
 EXPORT void CALL VolumeDown(void)
@@ -400,12 +931,12 @@ EXPORT void CALL VolumeDown(void)
     if (!l_PluginInit)
         return;
 
-    VolumeSetLevel(VolumeGetUnmutedLevel() - VolDelta);
+    instance_volume_set_level(&l_DefaultInstance, l_DefaultInstance.vol_percent - l_DefaultInstance.vol_delta);
 }
 
 EXPORT int CALL VolumeGetLevel(void)
 {
-    return VolIsMuted ? 0 : VolumeGetUnmutedLevel();
+    return instance_volume_get_level(&l_DefaultInstance);
 }
 
 EXPORT void CALL VolumeSetLevel(int level)
@@ -413,32 +944,303 @@ EXPORT void CALL VolumeSetLevel(int level)
     if (!l_PluginInit)
         return;
 
-    //if muted, unmute first
-    VolIsMuted = 0;
-
-    // adjust volume
-    VolPercent = level;
-    if (VolPercent < 0)
-        VolPercent = 0;
-    else if (VolPercent > 100)
-        VolPercent = 100;
-
-    VolumeCommit();
+    instance_volume_set_level(&l_DefaultInstance, level);
 }
 
 EXPORT const char * CALL VolumeGetString(void)
 {
-    static char VolumeString[32];
+    struct audio_instance* instance = &l_DefaultInstance;
 
-    if (VolIsMuted)
+    if (instance->vol_is_muted)
     {
-        strcpy(VolumeString, "Mute");
+        strcpy(instance->volume_string, "Mute");
     }
     else
     {
-        sprintf(VolumeString, "%i%%", VolPercent);
+        sprintf(instance->volume_string, "%i%%", instance->vol_percent);
     }
 
-    return VolumeString;
+    return instance->volume_string;
+}
+
+/* ----------- Instance API ------------- */
+EXPORT m64p_error CALL AudioInstanceCreate(m64p_handle config_section, const AUDIO_INFO* audio_info, struct audio_instance** instance)
+{
+    struct audio_instance* new_instance;
+
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (audio_info == NULL || instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    new_instance = malloc(sizeof(*new_instance));
+    if (new_instance == NULL)
+        return M64ERR_NO_MEMORY;
+
+    /* a section other than Audio-SDL needs its own defaults */
+    if (config_section == NULL)
+        config_section = l_ConfigAudio;
+    else
+        set_config_defaults(config_section);
+
+    init_audio_instance(new_instance, config_section);
+    new_instance->info = *audio_info;
+
+    SDL_LockMutex(l_global_lock);
+    new_instance->next = l_instances;
+    l_instances = new_instance;
+    SDL_UnlockMutex(l_global_lock);
+
+    *instance = new_instance;
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceDestroy(struct audio_instance* instance)
+{
+    struct audio_instance** link;
+
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL || instance == &l_DefaultInstance)
+        return M64ERR_INPUT_ASSERT;
+
+    SDL_LockMutex(l_global_lock);
+    for (link = &l_instances; *link != NULL && *link != instance; link = &(*link)->next)
+        ;
+    if (*link != NULL)
+        *link = instance->next;
+    SDL_UnlockMutex(l_global_lock);
+
+    if (instance->rom_open)
+        instance_rom_closed(instance);
+
+    free(instance);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceRomOpen(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->sdl_backend != NULL)
+        return M64ERR_INVALID_STATE;
+
+    instance_rom_open(instance);
+
+    return (instance->sdl_backend != NULL) ? M64ERR_SUCCESS : M64ERR_SYSTEM_FAIL;
+}
+
+EXPORT m64p_error CALL AudioInstanceRomClosed(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_rom_closed(instance);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceAiDacrateChanged(struct audio_instance* instance, int SystemType)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_dacrate_changed(instance, SystemType);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceAiLenChanged(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_len_changed(instance);
+    return M64ERR_SUCCESS;
 }
 
+EXPORT m64p_error CALL AudioInstanceProcessAList(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    if (instance->alist_hle == NULL)
+        return M64ERR_INVALID_STATE;
+
+    instance_process_alist(instance);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceSetSpeedFactor(struct audio_instance* instance, int percentage)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_set_speed_factor(instance, percentage);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceVolumeMute(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_volume_mute(instance);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceVolumeSetLevel(struct audio_instance* instance, int level)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    instance_volume_set_level(instance, level);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceVolumeGetLevel(struct audio_instance* instance, int* level)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL || level == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    *level = instance_volume_get_level(instance);
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL AudioInstanceGetStats(struct audio_instance* instance, struct audio_stats* stats)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_get_stats(instance, stats);
+}
+
+EXPORT m64p_error CALL AudioInstanceGetTiming(struct audio_instance* instance, struct audio_timing* timing)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_get_timing(instance, timing);
+}
+
+EXPORT m64p_error CALL AudioInstanceCaptureStart(struct audio_instance* instance, const char* output_file, const char* raw_file)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_capture_start(instance, output_file, raw_file);
+}
+
+EXPORT m64p_error CALL AudioInstanceCaptureStop(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_capture_stop(instance);
+}
+
+EXPORT m64p_error CALL AudioInstanceCheckpointSave(struct audio_instance* instance, struct audio_checkpoint* checkpoint)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_checkpoint_save(instance, checkpoint);
+}
+
+EXPORT m64p_error CALL AudioInstanceCheckpointRestore(struct audio_instance* instance, const struct audio_checkpoint* checkpoint)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_checkpoint_restore(instance, checkpoint);
+}
+
+EXPORT m64p_error CALL AudioInstanceSpeculationBegin(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_speculation_begin(instance);
+}
+
+EXPORT m64p_error CALL AudioInstanceSpeculationCommit(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_speculation_end(instance, 1);
+}
+
+EXPORT m64p_error CALL AudioInstanceSpeculationDiscard(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_speculation_end(instance, 0);
+}
+
+EXPORT m64p_error CALL AudioInstanceReloadConfig(struct audio_instance* instance)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    if (instance == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return instance_reload_config(instance);
+}
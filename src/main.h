@@ -23,6 +23,7 @@
 #include "m64p_config.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #if defined(__GNUC__)
 #define ATTR_FMT(fmtpos, attrpos) __attribute__ ((format (printf, fmtpos, attrpos)))
@@ -30,6 +31,12 @@
 #define ATTR_FMT(fmtpos, attrpos)
 #endif
 
+#if defined(_MSC_VER)
+#define ATTR_THREAD_LOCAL __declspec(thread)
+#else
+#define ATTR_THREAD_LOCAL __thread
+#endif
+
 struct resampler_interface;
 
 /* volume mixer types */
@@ -38,12 +45,19 @@ enum {
     VOLUME_TYPE_OSS = 2,
 };
 
-void SetPlaybackVolume(void);
-
+/* Resamples src into dst, scaled by volume (range of 0..SDL_MIX_MAXVOLUME) */
 size_t ResampleAndMix(void* resampler, const struct resampler_interface* iresampler,
         void* mix_buffer,
-        const void* src, size_t src_size, unsigned int src_freq,
-        void* dst, size_t dst_size, unsigned int dst_freq);
+        const void* src, size_t src_size, uint64_t src_rate,
+        void* dst, size_t dst_size, uint64_t dst_rate,
+        int volume);
+
+/* Same as ResampleAndMix, with src split in left and right planes of the given layout */
+size_t ResampleAndMixPlanar(void* resampler, const struct resampler_interface* iresampler,
+        unsigned int layout, void* mix_buffer,
+        const void* const src[2], size_t src_size, uint64_t src_rate,
+        void* dst, size_t dst_size, uint64_t dst_rate,
+        int volume);
 
 /* declarations of pointers to Core config functions */
 extern ptr_ConfigListSections     ConfigListSections;
@@ -0,0 +1,40 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_realtime.h                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if !defined(OSAL_REALTIME_H)
+#define OSAL_REALTIME_H
+
+#include <stddef.h>
+
+/* Lock a memory range in RAM so that it can't be paged out. Returns 0 on success. */
+int         osal_lock_memory(void *address, size_t size);
+
+void        osal_unlock_memory(void *address, size_t size);
+
+/* Raise the calling thread to a real-time scheduling class.
+ * On input, priority is the requested real-time priority, on output the applied one.
+ * Returns the name of the applied policy, or NULL if none could be applied. */
+const char *osal_set_realtime_priority(int *priority);
+
+/* Pin the calling thread to the given cpu. Returns 0 on success. */
+int         osal_set_thread_affinity(int cpu);
+
+#endif /* #define OSAL_REALTIME_H */
@@ -0,0 +1,109 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_realtime_unix.c                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "osal_realtime.h"
+
+int osal_lock_memory(void *address, size_t size)
+{
+    if (address == NULL || size == 0)
+        return -1;
+
+    return (mlock(address, size) == 0) ? 0 : -1;
+}
+
+void osal_unlock_memory(void *address, size_t size)
+{
+    if (address == NULL || size == 0)
+        return;
+
+    munlock(address, size);
+}
+
+const char *osal_set_realtime_priority(int *priority)
+{
+    static const struct {
+        int policy;
+        const char *name;
+    } policies[] = {
+        { SCHED_FIFO, "SCHED_FIFO" },
+        { SCHED_RR,   "SCHED_RR" }
+    };
+    struct sched_param param;
+    int requested = *priority;
+    size_t i;
+
+#if defined(RLIMIT_RTPRIO)
+    /* unprivileged processes can't go above RLIMIT_RTPRIO */
+    struct rlimit rlim;
+    if (geteuid() != 0 && getrlimit(RLIMIT_RTPRIO, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY)
+    {
+        if (rlim.rlim_cur == 0)
+            return NULL;
+        if ((rlim_t)requested > rlim.rlim_cur)
+            requested = (int)rlim.rlim_cur;
+    }
+#endif
+
+    for (i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+    {
+        int min = sched_get_priority_min(policies[i].policy);
+        int max = sched_get_priority_max(policies[i].policy);
+
+        param.sched_priority = (requested < min) ? min : (requested > max) ? max : requested;
+
+        if (pthread_setschedparam(pthread_self(), policies[i].policy, &param) == 0)
+        {
+            *priority = param.sched_priority;
+            return policies[i].name;
+        }
+    }
+
+    return NULL;
+}
+
+int osal_set_thread_affinity(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+        return -1;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) ? 0 : -1;
+#else
+    /* not supported */
+    return -1;
+#endif
+}
@@ -0,0 +1,74 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_realtime_win32.c                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <windows.h>
+
+#include "osal_realtime.h"
+
+int osal_lock_memory(void *address, size_t size)
+{
+    if (address == NULL || size == 0)
+        return -1;
+
+    if (VirtualLock(address, size))
+        return 0;
+
+    /* locked pages count against the working set, try to enlarge it once */
+    if (GetLastError() == ERROR_WORKING_SET_QUOTA)
+    {
+        SIZE_T min_ws, max_ws;
+        HANDLE process = GetCurrentProcess();
+
+        if (GetProcessWorkingSetSize(process, &min_ws, &max_ws)
+         && SetProcessWorkingSetSize(process, min_ws + size, max_ws + size)
+         && VirtualLock(address, size))
+            return 0;
+    }
+
+    return -1;
+}
+
+void osal_unlock_memory(void *address, size_t size)
+{
+    if (address == NULL || size == 0)
+        return;
+
+    VirtualUnlock(address, size);
+}
+
+const char *osal_set_realtime_priority(int *priority)
+{
+    /* Windows has no real-time scheduling class for a single thread,
+     * time critical is the highest priority within the process class */
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        return NULL;
+
+    *priority = THREAD_PRIORITY_TIME_CRITICAL;
+    return "THREAD_PRIORITY_TIME_CRITICAL";
+}
+
+int osal_set_thread_affinity(int cpu)
+{
+    if (cpu < 0 || cpu >= (int)(sizeof(DWORD_PTR) * 8))
+        return -1;
+
+    return (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0) ? 0 : -1;
+}
@@ -0,0 +1,42 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_shm.h                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if !defined(OSAL_SHM_H)
+#define OSAL_SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct osal_shm;
+
+/* Create a named shared memory object of the given size (zero filled), replacing any
+ * stale object of the same name, and map it read/write in *data.
+ * Returns NULL on failure. */
+struct osal_shm *osal_shm_create(const char *name, size_t size, void **data);
+
+/* Unmap and remove the shared memory object. Processes which mapped it keep their mapping. */
+void             osal_shm_destroy(struct osal_shm *shm);
+
+/* Monotonic time in nanoseconds, comparable between processes of the same machine
+ * (CLOCK_MONOTONIC on Unix, QueryPerformanceCounter on Windows). */
+uint64_t         osal_shm_clock_ns(void);
+
+#endif /* #define OSAL_SHM_H */
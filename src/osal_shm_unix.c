@@ -0,0 +1,105 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_shm_unix.c                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osal_shm.h"
+
+struct osal_shm
+{
+    char name[256];
+    void *data;
+    size_t size;
+};
+
+struct osal_shm *osal_shm_create(const char *name, size_t size, void **data)
+{
+    struct osal_shm *shm;
+    int fd;
+
+    if (name == NULL || name[0] == '\0' || size == 0)
+        return NULL;
+
+    shm = malloc(sizeof(*shm));
+    if (shm == NULL)
+        return NULL;
+
+    /* POSIX shared memory names start with a slash */
+    snprintf(shm->name, sizeof(shm->name), "%s%s", (name[0] == '/') ? "" : "/", name);
+    shm->size = size;
+
+    /* a previous instance may have crashed without removing its object */
+    shm_unlink(shm->name);
+
+    fd = shm_open(shm->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        free(shm);
+        return NULL;
+    }
+
+    if (ftruncate(fd, (off_t) size) != 0)
+    {
+        close(fd);
+        shm_unlink(shm->name);
+        free(shm);
+        return NULL;
+    }
+
+    shm->data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (shm->data == MAP_FAILED)
+    {
+        shm_unlink(shm->name);
+        free(shm);
+        return NULL;
+    }
+
+    *data = shm->data;
+    return shm;
+}
+
+void osal_shm_destroy(struct osal_shm *shm)
+{
+    if (shm == NULL)
+        return;
+
+    munmap(shm->data, shm->size);
+    shm_unlink(shm->name);
+    free(shm);
+}
+
+uint64_t osal_shm_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
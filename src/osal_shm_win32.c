@@ -0,0 +1,88 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - osal_shm_win32.c                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <windows.h>
+#include <stdlib.h>
+
+#include "osal_shm.h"
+
+struct osal_shm
+{
+    HANDLE mapping;
+    void *data;
+};
+
+struct osal_shm *osal_shm_create(const char *name, size_t size, void **data)
+{
+    struct osal_shm *shm;
+    unsigned long long size64 = size;
+
+    if (name == NULL || name[0] == '\0' || size == 0)
+        return NULL;
+
+    shm = malloc(sizeof(*shm));
+    if (shm == NULL)
+        return NULL;
+
+    /* the mapping is backed by the paging file, and disappears with its last handle */
+    shm->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                      (DWORD) (size64 >> 32), (DWORD) size64, name);
+    if (shm->mapping == NULL)
+    {
+        free(shm);
+        return NULL;
+    }
+
+    shm->data = MapViewOfFile(shm->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (shm->data == NULL)
+    {
+        CloseHandle(shm->mapping);
+        free(shm);
+        return NULL;
+    }
+
+    /* an existing mapping of the same name is reused as is */
+    ZeroMemory(shm->data, size);
+
+    *data = shm->data;
+    return shm;
+}
+
+void osal_shm_destroy(struct osal_shm *shm)
+{
+    if (shm == NULL)
+        return;
+
+    UnmapViewOfFile(shm->data);
+    CloseHandle(shm->mapping);
+    free(shm);
+}
+
+uint64_t osal_shm_clock_ns(void)
+{
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000
+         + (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+}
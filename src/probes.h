@@ -0,0 +1,66 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - probes.h                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_PROBES_H
+#define M64P_PROBES_H
+
+/* Static tracepoints (USDT) for bpftrace, perf or SystemTap, built with SDT=1.
+ *
+ * Each probe compiles to a nop and a note in the ELF file, so it costs nothing
+ * until a tracer attaches to it, and nothing at all when built without SDT.
+ * Probes belong to the m64p_audio provider, tools/bpftrace has example scripts.
+ *
+ *   push (n64_bytes, level_bytes, input_frequency)
+ *       samples pushed by AiLenChanged, primary buffer level after the push (in N64 bytes)
+ *   overflow (n64_bytes, free_bytes)
+ *       push dropped because the primary buffer is full
+ *   callback_entry (frames, needed_bytes, available_bytes)
+ *   callback_exit (consumed_bytes, remaining_bytes)
+ *       audio callback, input bytes in primary buffer units
+ *   underrun (needed_bytes, available_bytes)
+ *   sync (action, wait_ms, expected_level, latency_ms)
+ *       synchronization decision (enum audio_sync_action), expected level in output frames
+ *   pause (expected_level), unpause (expected_level)
+ *   input_rate (num, den), speed_factor (percentage)
+ *   device_lost (), device_reopened ()
+ */
+
+#if defined(USE_SDT)
+
+#include <sys/sdt.h>
+
+#define AUDIO_PROBE0(name)             DTRACE_PROBE(m64p_audio, name)
+#define AUDIO_PROBE1(name, a)          DTRACE_PROBE1(m64p_audio, name, a)
+#define AUDIO_PROBE2(name, a, b)       DTRACE_PROBE2(m64p_audio, name, a, b)
+#define AUDIO_PROBE3(name, a, b, c)    DTRACE_PROBE3(m64p_audio, name, a, b, c)
+#define AUDIO_PROBE4(name, a, b, c, d) DTRACE_PROBE4(m64p_audio, name, a, b, c, d)
+
+#else
+
+#define AUDIO_PROBE0(name)             do { } while(0)
+#define AUDIO_PROBE1(name, a)          do { } while(0)
+#define AUDIO_PROBE2(name, a, b)       do { } while(0)
+#define AUDIO_PROBE3(name, a, b, c)    do { } while(0)
+#define AUDIO_PROBE4(name, a, b, c, d) do { } while(0)
+
+#endif
+
+#endif
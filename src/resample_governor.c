@@ -0,0 +1,120 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - resample_governor.c                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "resample_governor.h"
+
+/* step up when the load is below this fraction of the budget */
+#define GOVERNOR_LOW_WATER 0.4
+/* smoothing of the load, as the weight of each new callback */
+#define GOVERNOR_LOAD_WEIGHT 0.125
+
+enum { GOVERNOR_SETTLE_CALLBACKS = 8 };
+enum { GOVERNOR_MIN_HOLD_MS = 2000 };
+enum { GOVERNOR_MAX_HOLD_MS = 60000 };
+/* a step down within this time after a step up means it was too optimistic */
+enum { GOVERNOR_REVERT_MS = 5000 };
+/* the hold time is reset after this time without switching */
+enum { GOVERNOR_STABLE_MS = 60000 };
+
+void init_resample_governor(struct resample_governor* governor, size_t level_count,
+        unsigned int budget_pct, unsigned int now)
+{
+    governor->level_count = level_count;
+    governor->level = 0;
+    governor->budget = budget_pct / 100.0;
+    governor->load = 0.0;
+    governor->load_valid = 0;
+    governor->settle = GOVERNOR_SETTLE_CALLBACKS;
+    governor->low = 0;
+    governor->low_since = now;
+    governor->up_hold_ms = GOVERNOR_MIN_HOLD_MS;
+    governor->last_switch_time = now;
+    governor->last_switch_up = 0;
+}
+
+size_t resample_governor_update(struct resample_governor* governor, double load, unsigned int now)
+{
+    unsigned int since_switch = now - governor->last_switch_time;
+
+    if (governor->load_valid) {
+        governor->load += (load - governor->load) * GOVERNOR_LOAD_WEIGHT;
+    }
+    else {
+        governor->load = load;
+        governor->load_valid = 1;
+    }
+
+    if (since_switch >= GOVERNOR_STABLE_MS) {
+        governor->up_hold_ms = GOVERNOR_MIN_HOLD_MS;
+    }
+
+    /* the load of the previous level may still dominate, only react to overruns */
+    if (governor->settle > 0) {
+        --governor->settle;
+        if (load < 1.0) {
+            return governor->level;
+        }
+    }
+
+    /* over budget, or an actual overrun */
+    if (governor->load > governor->budget || load >= 1.0) {
+        governor->low = 0;
+
+        if (governor->level + 1 < governor->level_count) {
+            if (governor->last_switch_up && since_switch < GOVERNOR_REVERT_MS) {
+                governor->up_hold_ms *= 2;
+                if (governor->up_hold_ms > GOVERNOR_MAX_HOLD_MS) {
+                    governor->up_hold_ms = GOVERNOR_MAX_HOLD_MS;
+                }
+            }
+            return governor->level + 1;
+        }
+        return governor->level;
+    }
+
+    if (governor->load >= governor->budget * GOVERNOR_LOW_WATER) {
+        governor->low = 0;
+        return governor->level;
+    }
+
+    if (!governor->low) {
+        governor->low = 1;
+        governor->low_since = now;
+    }
+
+    if (governor->level > 0
+     && now - governor->low_since >= governor->up_hold_ms
+     && since_switch >= governor->up_hold_ms) {
+        return governor->level - 1;
+    }
+
+    return governor->level;
+}
+
+void resample_governor_switched(struct resample_governor* governor, size_t level, unsigned int now)
+{
+    governor->last_switch_up = (level < governor->level);
+    governor->level = level;
+    governor->last_switch_time = now;
+    governor->load_valid = 0;
+    governor->settle = GOVERNOR_SETTLE_CALLBACKS;
+    governor->low = 0;
+}
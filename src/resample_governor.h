@@ -0,0 +1,73 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - resample_governor.h                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_RESAMPLE_GOVERNOR_H
+#define M64P_RESAMPLE_GOVERNOR_H
+
+#include <stddef.h>
+
+/* Quality governor of the adaptive resampler (RESAMPLE=auto).
+ *
+ * Levels go from 0 (best quality) to level_count - 1 (cheapest).
+ * The governor is fed the resampling load of each audio callback (time spent
+ * resampling / callback period). It steps down as soon as the smoothed load
+ * exceeds the budget (or a single callback overruns its period), and steps up
+ * only after the load has stayed well below the budget for a hold time.
+ * A step up quickly followed by a step down doubles the hold time, so that
+ * quality doesn't oscillate around a level the machine can barely sustain.
+ */
+struct resample_governor
+{
+    size_t level_count;
+    size_t level;
+
+    /* resampling load budget, as a fraction of the callback period */
+    double budget;
+
+    /* smoothed resampling load, restarted at each switch */
+    double load;
+    int load_valid;
+
+    /* callbacks to wait after a switch before trusting the load */
+    unsigned int settle;
+
+    /* time (in ms) since when the load allows to step up, if low */
+    int low;
+    unsigned int low_since;
+
+    /* hold time before stepping up (in ms) */
+    unsigned int up_hold_ms;
+
+    unsigned int last_switch_time;
+    int last_switch_up;
+};
+
+void init_resample_governor(struct resample_governor* governor, size_t level_count,
+        unsigned int budget_pct, unsigned int now);
+
+/* Feed the load of a callback at time now (in ms).
+ * Returns the level to switch to, or the current level to stay. */
+size_t resample_governor_update(struct resample_governor* governor, double load, unsigned int now);
+
+/* Report that the switch to level is done */
+void resample_governor_switched(struct resample_governor* governor, size_t level, unsigned int now);
+
+#endif
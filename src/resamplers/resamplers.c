@@ -39,22 +39,22 @@ extern const struct resampler_interface g_src_iresampler;
 
 #define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
 
-const struct resampler_interface* get_iresampler(const char* resampler_id, void** resampler)
-{
-    size_t i;
-
-    static const struct {
-        const struct resampler_interface* iresampler;
-        const char* cmp_str;
-    } resamplers[] = {
-        { &g_trivial_iresampler, "trivial" },
+static const struct {
+    const struct resampler_interface* iresampler;
+    const char* cmp_str;
+} resamplers[] = {
+    { &g_trivial_iresampler, "trivial" },
 #ifdef USE_SPEEX
-        { &g_speex_iresampler, "speex-" },
+    { &g_speex_iresampler, "speex-" },
 #endif
 #ifdef USE_SRC
-        { &g_src_iresampler, "src-" }
+    { &g_src_iresampler, "src-" }
 #endif
-    };
+};
+
+const struct resampler_interface* get_iresampler(const char* resampler_id, void** resampler)
+{
+    size_t i;
 
     /* search matching resampler */
     for(i = 0; i < ARRAY_SIZE(resamplers); ++i) {
@@ -76,3 +76,25 @@ const struct resampler_interface* get_iresampler(const char* resampler_id, void*
     *resampler = resamplers[i].iresampler->init_from_id(resampler_id);
     return resamplers[i].iresampler;
 }
+
+const char* get_resampler_id(size_t index)
+{
+    size_t i;
+    const char* id;
+
+    for(i = 0; i < ARRAY_SIZE(resamplers); ++i) {
+        size_t j;
+        for (j = 0; (id = resamplers[i].iresampler->get_id(j)) != NULL; ++j) {
+            if (index-- == 0) {
+                return id;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+size_t get_resampler_frame_bytes(unsigned int layout)
+{
+    return (layout == RESAMPLER_LAYOUT_F32_PLANAR) ? 2 * sizeof(float) : 2 * sizeof(int16_t);
+}
@@ -23,22 +23,60 @@
 #define M64P_RESAMPLERS_RESAMPLERS_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+/* Layouts of the resampler input, i.e. of the primary buffer */
+enum
+{
+    /* left/right int16 frames */
+    RESAMPLER_LAYOUT_S16_INTERLEAVED = 0x1,
+    /* left and right int16 channels, in separate planes */
+    RESAMPLER_LAYOUT_S16_PLANAR = 0x2,
+    /* left and right float channels (in [-1, 1)), in separate planes */
+    RESAMPLER_LAYOUT_F32_PLANAR = 0x4
+};
 
 struct resampler_interface
 {
     const char* name;
 
+    /* Bitmask of the input layouts this resampler accepts (RESAMPLER_LAYOUT_*).
+     * resample takes the interleaved one, resample_planar the planar ones. */
+    unsigned int layouts;
+
+    /* Return the index-th RESAMPLE configuration handled by this resampler, or NULL past the last one */
+    const char* (*get_id)(size_t index);
+
     void* (*init_from_id)(const char* resampler_id);
 
     void (*release)(void* resampler);
 
+    /* Only the src_rate/dst_rate ratio matters: both rates may be scaled by a common factor,
+     * so that fractional frequencies are represented exactly */
     size_t (*resample)(void* resampler,
-                       const void* src, size_t src_size, unsigned int src_freq,
-                       void* dst, size_t dst_size, unsigned int dst_freq);
+                       const void* src, size_t src_size, uint64_t src_rate,
+                       void* dst, size_t dst_size, uint64_t dst_rate);
+
+    /* Same as resample, with the left and right channels of the input in the src[0] and src[1] planes.
+     * src_size and the returned consumed size count the bytes of both planes.
+     * Output is still interleaved int16. NULL if no planar layout is accepted. */
+    size_t (*resample_planar)(void* resampler, unsigned int layout,
+                              const void* const src[2], size_t src_size, uint64_t src_rate,
+                              void* dst, size_t dst_size, uint64_t dst_rate);
+
+    /* Preallocate and prefault internal buffers for resampling up to src_size/dst_size bytes
+     * of input in the given layout, so that resampling doesn't allocate. Optionally lock them in memory. */
+    void (*reserve)(void* resampler, unsigned int layout, size_t src_size, size_t dst_size, int lock_memory);
 };
 
 const struct resampler_interface* get_iresampler(const char* resampler_id, void** resampler);
 
+/* Return the index-th RESAMPLE configuration supported by this build, or NULL past the last one */
+const char* get_resampler_id(size_t index);
+
+/* Size in bytes of one left/right frame of input in the given layout */
+size_t get_resampler_frame_bytes(unsigned int layout);
+
 /* default resampler */
 #if defined(USE_SPEEX)
     #define DEFAULT_RESAMPLER "speex-fixed-4"
@@ -48,4 +86,13 @@ const struct resampler_interface* get_iresampler(const char* resampler_id, void*
     #define DEFAULT_RESAMPLER "trivial"
 #endif
 
+/* levels of RESAMPLE=auto, from best quality to cheapest */
+#if defined(USE_SPEEX)
+    #define AUTO_RESAMPLER_LEVELS "speex-fixed-10,speex-fixed-8,speex-fixed-6,speex-fixed-4,speex-fixed-2,speex-fixed-0,trivial"
+#elif defined(USE_SRC)
+    #define AUTO_RESAMPLER_LEVELS "src-sinc-best-quality,src-sinc-medium-quality,src-sinc-fastest,src-linear,trivial"
+#else
+    #define AUTO_RESAMPLER_LEVELS "trivial"
+#endif
+
 #endif
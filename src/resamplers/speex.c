@@ -20,12 +20,14 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "resamplers/resamplers.h"
+#include "hot_log.h"
 #include "main.h"
 
 #include <speex/speex_resampler.h>
 
 #include "m64p_types.h"
 
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
@@ -35,26 +37,31 @@
 /* assume 2x16bit interleaved channels */
 enum { BYTES_PER_SAMPLE = 4 };
 
+static const char *types[] =
+{
+    "speex-fixed-0",
+    "speex-fixed-1",
+    "speex-fixed-2",
+    "speex-fixed-3",
+    "speex-fixed-4",
+    "speex-fixed-5",
+    "speex-fixed-6",
+    "speex-fixed-7",
+    "speex-fixed-8",
+    "speex-fixed-9",
+    "speex-fixed-10",
+};
 
 
+static const char* speex_get_id(size_t index)
+{
+    return (index < ARRAY_SIZE(types)) ? types[index] : NULL;
+}
+
 static void* speex_init_from_id(const char* resampler_id)
 {
     size_t i;
     int error;
-    static const char *types[] =
-    {
-        "speex-fixed-0",
-        "speex-fixed-1",
-        "speex-fixed-2",
-        "speex-fixed-3",
-        "speex-fixed-4",
-        "speex-fixed-5",
-        "speex-fixed-6",
-        "speex-fixed-7",
-        "speex-fixed-8",
-        "speex-fixed-9",
-        "speex-fixed-10",
-    };
 
     /* select resampler configuration */
     for (i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -93,14 +100,97 @@ static void speex_release(void* resampler)
     speex_resampler_destroy(spx_state);
 }
 
+/* Replaces *num / *den by the closest fraction whose terms are within max_num and max_den:
+ * the last continued fraction convergent within range, or the semiconvergent after it
+ * if that one is closer */
+static void best_fraction(uint64_t* num, uint64_t* den, uint64_t max_num, uint64_t max_den)
+{
+    uint64_t n = *num;
+    uint64_t d = *den;
+    uint64_t p0 = 0, q0 = 1;
+    uint64_t p1 = 1, q1 = 0;
+
+    while (d != 0) {
+        uint64_t a = n / d;
+        uint64_t r = n % d;
+        uint64_t k;
+
+        if ((p1 != 0 && a > (max_num - p0) / p1) || (q1 != 0 && a > (max_den - q0) / q1)) {
+            /* largest semiconvergent (k * p1 + p0) / (k * q1 + q0) within range */
+            k = (p1 != 0) ? (max_num - p0) / p1 : a;
+            if (q1 != 0 && (max_den - q0) / q1 < k) {
+                k = (max_den - q0) / q1;
+            }
+
+            if (k != 0 && q1 != 0) {
+                double x = (double)*num / (double)*den;
+                double semi = (double)(k * p1 + p0) / (double)(k * q1 + q0);
+                double conv = (double)p1 / (double)q1;
+
+                if (fabs(semi - x) < fabs(conv - x)) {
+                    p1 = k * p1 + p0;
+                    q1 = k * q1 + q0;
+                }
+            }
+            else if (q1 == 0) {
+                /* the integer part alone is out of range */
+                p1 = (k != 0) ? k : 1;
+                q1 = 1;
+            }
+            break;
+        }
+
+        p0 += a * p1; q0 += a * q1;
+        k = p0; p0 = p1; p1 = k;
+        k = q0; q0 = q1; q1 = k;
+
+        n = d;
+        d = r;
+    }
+
+    /* speex needs a non-zero ratio */
+    *num = (p1 != 0) ? p1 : 1;
+    *den = q1;
+}
+
+/* Speex takes the ratio as 32 bits integers, and its interpolating filter multiplies
+ * the phase (below the denominator) by the oversampling factor (up to 32) in 32 bits.
+ * The ratio is reduced by its GCD first, which keeps it exact for the N64 rates at
+ * usual speed factors (e.g. NTSC to 44.1 or 48 kHz at 100%); only an unusual speed
+ * factor can leave terms out of range, and then the closest fraction within range is used */
+static void speex_set_rate(SpeexResamplerState* spx_state, uint64_t src_rate, uint64_t dst_rate)
+{
+    enum { SPEEX_MAX_OVERSAMPLE = 32 };
+    const uint64_t max_num = UINT32_MAX;
+    const uint64_t max_den = UINT32_MAX / SPEEX_MAX_OVERSAMPLE;
+    uint64_t a = src_rate;
+    uint64_t b = dst_rate;
+
+    while (b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+
+    src_rate /= a;
+    dst_rate /= a;
+
+    if (src_rate > max_num || dst_rate > max_den) {
+        best_fraction(&src_rate, &dst_rate, max_num, max_den);
+    }
+
+    speex_resampler_set_rate_frac(spx_state, (spx_uint32_t)src_rate, (spx_uint32_t)dst_rate,
+            (spx_uint32_t)src_rate, (spx_uint32_t)dst_rate);
+}
+
 static size_t speex_resample(void* resampler,
-                             const void* src, size_t src_size, unsigned int src_freq,
-                             void* dst, size_t dst_size, unsigned int dst_freq)
+                             const void* src, size_t src_size, uint64_t src_rate,
+                             void* dst, size_t dst_size, uint64_t dst_rate)
 {
     SpeexResamplerState* spx_state = (SpeexResamplerState*)resampler;
 
     /* update resampling rates */
-    speex_resampler_set_rate(spx_state, src_freq, dst_freq);
+    speex_set_rate(spx_state, src_rate, dst_rate);
 
     /* perform resampling */
     spx_uint32_t in_len = src_size / BYTES_PER_SAMPLE;
@@ -110,24 +200,92 @@ static size_t speex_resample(void* resampler,
     /* in case of error, display error, zero output buffer and discard input buffer */
     if (error != RESAMPLER_ERR_SUCCESS)
     {
-        DebugMessage(M64MSG_ERROR, "Speex error: %s", speex_resampler_strerror(error));
+        HOT_LOG(M64MSG_ERROR, "Speex error: resampling failed with error code %zu", error, 0);
         memset(dst, 0, dst_size);
         return src_size;
     }
 
     if (dst_size != out_len * BYTES_PER_SAMPLE) {
-        DebugMessage(M64MSG_WARNING, "dst_size = %u != outlen*4 = %u",
-                (uint32_t) dst_size, out_len * BYTES_PER_SAMPLE);
+        HOT_LOG(M64MSG_WARNING, "dst_size = %zu != outlen*4 = %zu",
+                dst_size, out_len * BYTES_PER_SAMPLE);
     }
     memset((char*)dst + out_len * BYTES_PER_SAMPLE, 0, dst_size - out_len * BYTES_PER_SAMPLE);
 
     return in_len * BYTES_PER_SAMPLE;
 }
 
+/* Only takes RESAMPLER_LAYOUT_S16_PLANAR input: each channel is resampled from its plane
+ * (unit input stride) straight to its interleaved output slot */
+static size_t speex_resample_planar(void* resampler, unsigned int layout,
+                                    const void* const src[2], size_t src_size, uint64_t src_rate,
+                                    void* dst, size_t dst_size, uint64_t dst_rate)
+{
+    SpeexResamplerState* spx_state = (SpeexResamplerState*)resampler;
+    spx_uint32_t in_len = 0;
+    spx_uint32_t out_len = 0;
+    int error = RESAMPLER_ERR_SUCCESS;
+    spx_uint32_t channel;
+
+    /* update resampling rates */
+    speex_set_rate(spx_state, src_rate, dst_rate);
+
+    /* both channels consume and produce the same amount of frames */
+    speex_resampler_set_output_stride(spx_state, 2);
+    for (channel = 0; channel < 2 && error == RESAMPLER_ERR_SUCCESS; ++channel) {
+        in_len = src_size / BYTES_PER_SAMPLE;
+        out_len = dst_size / BYTES_PER_SAMPLE;
+        error = speex_resampler_process_int(spx_state, channel, (const spx_int16_t *)src[channel], &in_len,
+                (spx_int16_t *)dst + channel, &out_len);
+    }
+    speex_resampler_set_output_stride(spx_state, 1);
+
+    /* in case of error, display error, zero output buffer and discard input buffer */
+    if (error != RESAMPLER_ERR_SUCCESS)
+    {
+        HOT_LOG(M64MSG_ERROR, "Speex error: resampling failed with error code %zu", error, 0);
+        memset(dst, 0, dst_size);
+        return src_size;
+    }
+
+    if (dst_size != out_len * BYTES_PER_SAMPLE) {
+        HOT_LOG(M64MSG_WARNING, "dst_size = %zu != outlen*4 = %zu",
+                dst_size, out_len * BYTES_PER_SAMPLE);
+    }
+    memset((char*)dst + out_len * BYTES_PER_SAMPLE, 0, dst_size - out_len * BYTES_PER_SAMPLE);
+
+    return in_len * BYTES_PER_SAMPLE;
+}
+
+static void speex_reserve(void* resampler, unsigned int layout, size_t src_size, size_t dst_size, int lock_memory)
+{
+    SpeexResamplerState* spx_state = (SpeexResamplerState*)resampler;
+    spx_int16_t frames[2 * 2 * 64];
+
+    if (spx_state == NULL) {
+        return;
+    }
+
+    /* speex doesn't allocate while resampling, but its state is only touched once resampling starts.
+     * Run a block of silence through it to prefault the state, then forget about it */
+    spx_uint32_t in_len = 64;
+    spx_uint32_t out_len = 64;
+    memset(frames, 0, sizeof(frames));
+    speex_resampler_process_interleaved_int(spx_state, frames, &in_len, frames + 2 * 64, &out_len);
+    speex_resampler_reset_mem(spx_state);
+
+    if (lock_memory) {
+        DebugMessage(M64MSG_VERBOSE, "Speex resampler state prefaulted but not locked (opaque state)");
+    }
+}
+
 
 const struct resampler_interface g_speex_iresampler = {
     "speex",
+    RESAMPLER_LAYOUT_S16_INTERLEAVED | RESAMPLER_LAYOUT_S16_PLANAR,
+    speex_get_id,
     speex_init_from_id,
     speex_release,
-    speex_resample
+    speex_resample,
+    speex_resample_planar,
+    speex_reserve
 };
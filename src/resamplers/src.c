@@ -20,7 +20,10 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "resamplers/resamplers.h"
+#include "hot_log.h"
 #include "main.h"
+#include "osal_realtime.h"
+#include "sample_format.h"
 
 #include <samplerate.h>
 
@@ -31,17 +34,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "rt_check.h"
+
 #define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
 
 struct fbuffer
 {
     float* data;
     size_t size;
+    int locked;
 };
 
 static void grow_fbuffer(struct fbuffer* fbuffer, size_t new_size)
 {
     if (fbuffer->size < new_size) {
+        if (fbuffer->locked) {
+            osal_unlock_memory(fbuffer->data, fbuffer->size);
+            fbuffer->locked = 0;
+        }
         fbuffer->data = realloc(fbuffer->data, new_size);
         fbuffer->size = new_size;
     }
@@ -49,9 +59,13 @@ static void grow_fbuffer(struct fbuffer* fbuffer, size_t new_size)
 
 static void free_fbuffer(struct fbuffer* fbuffer)
 {
+    if (fbuffer->locked) {
+        osal_unlock_memory(fbuffer->data, fbuffer->size);
+    }
     free(fbuffer->data);
     fbuffer->data = NULL;
     fbuffer->size = 0;
+    fbuffer->locked = 0;
 }
 
 
@@ -62,25 +76,37 @@ struct src_resampler
 
     /* 2 intermediate buffers are needed for float/int conversion */
     struct fbuffer fbuffers[2];
+
+    /* Planar input is resampled by one mono converter per channel, created on first use,
+     * from its input plane (converted from int16 if needed) to its output plane */
+    int converter_type;
+    SRC_STATE* plane_states[2];
+    struct fbuffer plane_inputs[2];
+    struct fbuffer plane_outputs[2];
 };
 
+static const struct {
+    const char* name;
+    int converter_type;
+} types[] =
+{
+    { "src-sinc-best-quality", SRC_SINC_BEST_QUALITY },
+    { "src-sinc-medium-quality", SRC_SINC_MEDIUM_QUALITY },
+    { "src-sinc-fastest", SRC_SINC_FASTEST },
+    { "src-zero-order-hold", SRC_ZERO_ORDER_HOLD },
+    { "src-linear",  SRC_LINEAR }
+};
+
+static const char* src_get_id(size_t index)
+{
+    return (index < ARRAY_SIZE(types)) ? types[index].name : NULL;
+}
+
 static void* src_init_from_id(const char* resampler_id)
 {
     size_t i;
     int error = 0;
 
-    static const struct {
-        const char* name;
-        int converter_type;
-    } types[] =
-    {
-        { "src-sinc-best-quality", SRC_SINC_BEST_QUALITY },
-        { "src-sinc-medium-quality", SRC_SINC_MEDIUM_QUALITY },
-        { "src-sinc-fastest", SRC_SINC_FASTEST },
-        { "src-zero-order-hold", SRC_ZERO_ORDER_HOLD },
-        { "src-linear",  SRC_LINEAR }
-    };
-
     /* select resampler configuration */
     for (i = 0; i < ARRAY_SIZE(types); ++i) {
         if (strcmp(types[i].name, resampler_id) == 0) {
@@ -107,6 +133,7 @@ static void* src_init_from_id(const char* resampler_id)
     /* lazy-alloc of fbuffers */
     memset(src_resampler, 0, sizeof(*src_resampler));
 
+    src_resampler->converter_type = types[i].converter_type;
     src_resampler->state = src_new(types[i].converter_type, 2, &error);
     if (error != 0) {
         DebugMessage(M64MSG_ERROR, "SRC error: %s", src_strerror(error));
@@ -130,12 +157,18 @@ static void src_release(void* resampler)
 
     for(i = 0; i < 2; ++i) {
         free_fbuffer(&src_resampler->fbuffers[i]);
+
+        if (src_resampler->plane_states[i] != NULL) {
+            src_delete(src_resampler->plane_states[i]);
+        }
+        free_fbuffer(&src_resampler->plane_inputs[i]);
+        free_fbuffer(&src_resampler->plane_outputs[i]);
     }
 }
 
 static size_t src_resample(void* resampler,
-                           const void* src, size_t src_size, unsigned int src_freq,
-                           void* dst, size_t dst_size, unsigned int dst_freq)
+                           const void* src, size_t src_size, uint64_t src_rate,
+                           void* dst, size_t dst_size, uint64_t dst_rate)
 {
     struct src_resampler* src_resampler = (struct src_resampler*)resampler;
 
@@ -167,7 +200,7 @@ static size_t src_resample(void* resampler,
     src_data.data_out = src_resampler->fbuffers[1].data;
     src_data.output_frames = dst_size/4;
 
-    src_data.src_ratio = (float)dst_freq / src_freq;
+    src_data.src_ratio = (double)dst_rate / src_rate;
     src_data.end_of_input = 0;
 
     int error = src_process(src_resampler->state, &src_data);
@@ -175,14 +208,14 @@ static size_t src_resample(void* resampler,
     /* in case of error, display error, zero output buffer and discard input buffer */
     if (error)
     {
-        DebugMessage(M64MSG_ERROR, "SRC error: %s", src_strerror(error));
+        HOT_LOG(M64MSG_ERROR, "SRC error: resampling failed with error code %zu", error, 0);
         memset(dst, 0, dst_size);
         return src_size;
     }
 
-    if (dst_size != src_data.output_frames_gen*4) {
-        DebugMessage(M64MSG_WARNING, "dst_size = %u != output_frames_gen*4 = %u",
-                (uint32_t) dst_size, (uint32_t) src_data.output_frames_gen*4);
+    if (dst_size != (size_t)src_data.output_frames_gen*4) {
+        HOT_LOG(M64MSG_WARNING, "dst_size = %zu != output_frames_gen*4 = %zu",
+                dst_size, src_data.output_frames_gen*4);
     }
 
     src_float_to_short_array(src_resampler->fbuffers[1].data, (short*)dst, src_data.output_frames_gen*2);
@@ -191,10 +224,160 @@ static size_t src_resample(void* resampler,
     return src_data.input_frames_used * 4;
 }
 
+static int create_plane_states(struct src_resampler* src_resampler)
+{
+    size_t i;
+    int error = 0;
+
+    for (i = 0; i < 2 && error == 0; ++i) {
+        if (src_resampler->plane_states[i] == NULL) {
+            src_resampler->plane_states[i] = src_new(src_resampler->converter_type, 1, &error);
+        }
+    }
+
+    return error;
+}
+
+/* Takes RESAMPLER_LAYOUT_S16_PLANAR and RESAMPLER_LAYOUT_F32_PLANAR input */
+static size_t src_resample_planar(void* resampler, unsigned int layout,
+                                  const void* const src[2], size_t src_size, uint64_t src_rate,
+                                  void* dst, size_t dst_size, uint64_t dst_rate)
+{
+    struct src_resampler* src_resampler = (struct src_resampler*)resampler;
+    size_t frame_bytes = get_resampler_frame_bytes(layout);
+    size_t src_frames = src_size / frame_bytes;
+    size_t dst_frames = dst_size / 4;
+    SRC_DATA src_data[2];
+    int error;
+    size_t i;
+
+    /* same limit as src_resample */
+    if (src_frames > dst_frames * 5 / 2) {
+        src_frames = dst_frames * 5 / 2;
+    }
+
+    error = create_plane_states(src_resampler);
+
+    for (i = 0; i < 2 && error == 0; ++i) {
+        const float* input = (const float*)src[i];
+
+        if (layout == RESAMPLER_LAYOUT_S16_PLANAR) {
+            grow_fbuffer(&src_resampler->plane_inputs[i], src_frames * sizeof(float));
+            src_short_to_float_array((const short*)src[i], src_resampler->plane_inputs[i].data, (int)src_frames);
+            input = src_resampler->plane_inputs[i].data;
+        }
+
+        grow_fbuffer(&src_resampler->plane_outputs[i], dst_frames * sizeof(float));
+
+        src_data[i].data_in = input;
+        src_data[i].input_frames = src_frames;
+
+        src_data[i].data_out = src_resampler->plane_outputs[i].data;
+        src_data[i].output_frames = dst_frames;
+
+        src_data[i].src_ratio = (double)dst_rate / src_rate;
+        src_data[i].end_of_input = 0;
+
+        error = src_process(src_resampler->plane_states[i], &src_data[i]);
+    }
+
+    /* in case of error, display error, zero output buffer and discard input buffer */
+    if (error)
+    {
+        HOT_LOG(M64MSG_ERROR, "SRC error: resampling failed with error code %zu", error, 0);
+        memset(dst, 0, dst_size);
+        return src_frames * frame_bytes;
+    }
+
+    /* both channels consume and produce the same amount of frames */
+    if (dst_frames != (size_t)src_data[0].output_frames_gen) {
+        HOT_LOG(M64MSG_WARNING, "dst_size = %zu != output_frames_gen*4 = %zu",
+                dst_size, src_data[0].output_frames_gen*4);
+    }
+
+    interleave_f32_to_s16((int16_t*)dst, src_resampler->plane_outputs[0].data, src_resampler->plane_outputs[1].data,
+            src_data[0].output_frames_gen);
+    memset((char*)dst + src_data[0].output_frames_gen*4, 0, dst_size - src_data[0].output_frames_gen*4);
+
+    return src_data[0].input_frames_used * frame_bytes;
+}
+
+static void src_reserve(void* resampler, unsigned int layout, size_t src_size, size_t dst_size, int lock_memory)
+{
+    size_t i;
+    size_t locked = 0;
+    struct src_resampler* src_resampler = (struct src_resampler*)resampler;
+    struct fbuffer* fbuffers[4];
+    size_t count;
+
+    if (src_resampler == NULL) {
+        return;
+    }
+
+    if (layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) {
+        /* same sizes as in src_resample */
+        if (src_size > dst_size * 5 / 2) {
+            src_size = dst_size * 5 / 2;
+        }
+
+        grow_fbuffer(&src_resampler->fbuffers[0], src_size*2);
+        grow_fbuffer(&src_resampler->fbuffers[1], dst_size*2);
+
+        fbuffers[0] = &src_resampler->fbuffers[0];
+        fbuffers[1] = &src_resampler->fbuffers[1];
+        count = 2;
+    }
+    else {
+        /* same sizes as in src_resample_planar */
+        size_t src_frames = src_size / get_resampler_frame_bytes(layout);
+        size_t dst_frames = dst_size / 4;
+
+        if (src_frames > dst_frames * 5 / 2) {
+            src_frames = dst_frames * 5 / 2;
+        }
+
+        if (create_plane_states(src_resampler) != 0) {
+            DebugMessage(M64MSG_ERROR, "SRC error: couldn't create planar converters");
+        }
+
+        count = 0;
+        for (i = 0; i < 2; ++i) {
+            if (layout == RESAMPLER_LAYOUT_S16_PLANAR) {
+                grow_fbuffer(&src_resampler->plane_inputs[i], src_frames * sizeof(float));
+                fbuffers[count++] = &src_resampler->plane_inputs[i];
+            }
+            grow_fbuffer(&src_resampler->plane_outputs[i], dst_frames * sizeof(float));
+            fbuffers[count++] = &src_resampler->plane_outputs[i];
+        }
+    }
+
+    for (i = 0; i < count; ++i) {
+        struct fbuffer* fbuffer = fbuffers[i];
+
+        /* prefault */
+        memset(fbuffer->data, 0, fbuffer->size);
+
+        if (lock_memory && !fbuffer->locked) {
+            fbuffer->locked = (osal_lock_memory(fbuffer->data, fbuffer->size) == 0);
+        }
+        if (fbuffer->locked) {
+            locked += fbuffer->size;
+        }
+    }
+
+    if (lock_memory) {
+        DebugMessage(M64MSG_VERBOSE, "SRC resampler buffers: %u bytes locked", (uint32_t) locked);
+    }
+}
+
 
 const struct resampler_interface g_src_iresampler = {
     "src",
+    RESAMPLER_LAYOUT_S16_INTERLEAVED | RESAMPLER_LAYOUT_S16_PLANAR | RESAMPLER_LAYOUT_F32_PLANAR,
+    src_get_id,
     src_init_from_id,
     src_release,
-    src_resample
+    src_resample,
+    src_resample_planar,
+    src_reserve
 };
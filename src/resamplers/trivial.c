@@ -23,42 +23,57 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { BYTES_PER_SAMPLE = 4 };
+
+struct trivial_resampler
+{
+    /* position between the last consumed input sample and the next one, in 1/dst_rate units.
+     * Carried over calls so that fractional ratios don't drift */
+    uint64_t phase;
+};
+
+static const char* trivial_get_id(size_t index)
+{
+    return (index == 0) ? "trivial" : NULL;
+}
 
 static void* trivial_init_from_id(const char* resampler_id)
 {
-    /* nothing to do */
-    return NULL;
+    return calloc(1, sizeof(struct trivial_resampler));
 }
 
 static void trivial_release(void* resampler)
 {
-    /* nothing to do */
+    free(resampler);
 }
 
 static size_t trivial_resample(void* resampler,
-                               const void* src, size_t src_size, unsigned int src_freq,
-                               void* dst, size_t dst_size, unsigned int dst_freq)
+                               const void* src, size_t src_size, uint64_t src_rate,
+                               void* dst, size_t dst_size, uint64_t dst_rate)
 {
-    enum { BYTES_PER_SAMPLE = 4 };
+    struct trivial_resampler* trivial = (struct trivial_resampler*)resampler;
+    size_t src_frames = src_size / BYTES_PER_SAMPLE;
+    uint64_t phase = trivial->phase % dst_rate;
     size_t i;
     size_t j = 0;
 
-    if (dst_freq >= src_freq) {
-        const int dpos = 2*src_freq;
-        const int dneg = dpos - 2*dst_freq;
-
-        int criteria = dpos - dst_freq;
+    if (src_frames == 0) {
+        memset(dst, 0, dst_size);
+        return 0;
+    }
 
+    if (dst_rate >= src_rate) {
         for (i = 0; i < dst_size/BYTES_PER_SAMPLE; ++i) {
 
-            ((uint32_t*)dst)[i] = ((const uint32_t*)src)[j];
+            ((uint32_t*)dst)[i] = ((const uint32_t*)src)[(j < src_frames) ? j : src_frames - 1];
 
-            if (criteria >= 0) {
+            phase += src_rate;
+            if (phase >= dst_rate) {
+                phase -= dst_rate;
                 ++j;
-                criteria += dneg;
-            }
-            else {
-                criteria += dpos;
             }
         }
     }
@@ -66,18 +81,79 @@ static size_t trivial_resample(void* resampler,
         /* Can happen when speed_factor > 1 */
         for (i = 0; i < dst_size/BYTES_PER_SAMPLE; ++i) {
 
-            j = i * src_freq / dst_freq;
-            ((uint32_t*)dst)[i] = ((const uint32_t*)src)[j];
+            ((uint32_t*)dst)[i] = ((const uint32_t*)src)[(j < src_frames) ? j : src_frames - 1];
+
+            phase += src_rate;
+            j += (size_t)(phase / dst_rate);
+            phase %= dst_rate;
         }
     }
 
-    return j * 4;
+    /* don't consume more than what was given, the position is then approximate */
+    if (j > src_frames) {
+        j = src_frames;
+        phase = 0;
+    }
+
+    trivial->phase = phase;
+
+    return j * BYTES_PER_SAMPLE;
+}
+
+/* Only takes RESAMPLER_LAYOUT_S16_PLANAR input */
+static size_t trivial_resample_planar(void* resampler, unsigned int layout,
+                                      const void* const src[2], size_t src_size, uint64_t src_rate,
+                                      void* dst, size_t dst_size, uint64_t dst_rate)
+{
+    struct trivial_resampler* trivial = (struct trivial_resampler*)resampler;
+    const int16_t* left = (const int16_t*)src[0];
+    const int16_t* right = (const int16_t*)src[1];
+    int16_t* out = (int16_t*)dst;
+    size_t src_frames = src_size / BYTES_PER_SAMPLE;
+    uint64_t phase = trivial->phase % dst_rate;
+    size_t i;
+    size_t j = 0;
+
+    if (src_frames == 0) {
+        memset(dst, 0, dst_size);
+        return 0;
+    }
+
+    for (i = 0; i < dst_size/BYTES_PER_SAMPLE; ++i) {
+        size_t k = (j < src_frames) ? j : src_frames - 1;
+
+        out[2 * i] = left[k];
+        out[2 * i + 1] = right[k];
+
+        phase += src_rate;
+        j += (size_t)(phase / dst_rate);
+        phase %= dst_rate;
+    }
+
+    /* don't consume more than what was given, the position is then approximate */
+    if (j > src_frames) {
+        j = src_frames;
+        phase = 0;
+    }
+
+    trivial->phase = phase;
+
+    return j * BYTES_PER_SAMPLE;
+}
+
+static void trivial_reserve(void* resampler, unsigned int layout, size_t src_size, size_t dst_size, int lock_memory)
+{
+    /* nothing to do */
 }
 
 
 const struct resampler_interface g_trivial_iresampler = {
     "trivial",
+    RESAMPLER_LAYOUT_S16_INTERLEAVED | RESAMPLER_LAYOUT_S16_PLANAR,
+    trivial_get_id,
     trivial_init_from_id,
     trivial_release,
-    trivial_resample
+    trivial_resample,
+    trivial_resample_planar,
+    trivial_reserve
 };
@@ -0,0 +1,223 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - rsp_fallback.c                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "osal_dynamiclib.h"
+#include "rsp_fallback.h"
+
+#include "m64p_common.h"
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+/* registers of the RSP_INFO given to the fallback, only the SP status and PC matter to audio tasks */
+enum rsp_fallback_register
+{
+    RSP_REG_MI_INTR,
+    RSP_REG_SP_MEM_ADDR,
+    RSP_REG_SP_DRAM_ADDR,
+    RSP_REG_SP_RD_LEN,
+    RSP_REG_SP_WR_LEN,
+    RSP_REG_SP_STATUS,
+    RSP_REG_SP_DMA_FULL,
+    RSP_REG_SP_DMA_BUSY,
+    RSP_REG_SP_PC,
+    RSP_REG_SP_SEMAPHORE,
+    RSP_REG_DPC_START,
+    RSP_REG_DPC_END,
+    RSP_REG_DPC_CURRENT,
+    RSP_REG_DPC_STATUS,
+    RSP_REG_DPC_CLOCK,
+    RSP_REG_DPC_BUFBUSY,
+    RSP_REG_DPC_PIPEBUSY,
+    RSP_REG_DPC_TMEM,
+    RSP_REG_COUNT
+};
+
+enum { SP_STATUS_HALT = 0x1 };
+
+struct rsp_fallback
+{
+    m64p_dynlib_handle handle;
+
+    ptr_PluginShutdown PluginShutdown;
+    ptr_DoRspCycles DoRspCycles;
+    ptr_RomClosed RomClosed;
+
+    unsigned int registers[RSP_REG_COUNT];
+};
+
+/* set while an instance uses the fallback */
+static SDL_atomic_t l_in_use;
+/* set when the fallback forwards the audio list back instead of running it */
+static int l_forwarded;
+
+static void forwarded_alist(void)
+{
+    l_forwarded = 1;
+}
+
+/* the audio plugin raises no interrupt: the RSP plugin which forwarded the task does */
+static void no_interrupts(void)
+{
+}
+
+static void no_list(void)
+{
+}
+
+struct rsp_fallback* init_rsp_fallback(const char* path, m64p_dynlib_handle core_handle,
+        void* debug_context, void (*debug_callback)(void*, int, const char*),
+        const AUDIO_INFO* audio_info)
+{
+    struct rsp_fallback* fallback;
+    ptr_PluginGetVersion PluginGetVersion;
+    ptr_PluginStartup PluginStartup;
+    ptr_InitiateRSP InitiateRSP;
+    m64p_plugin_type plugin_type;
+    const char* plugin_name = NULL;
+    RSP_INFO rsp_info;
+    unsigned int cycle_count = 0;
+    m64p_error error;
+
+    if (!SDL_AtomicCAS(&l_in_use, 0, 1)) {
+        DebugMessage(M64MSG_WARNING, "ALIST_FALLBACK %s already used by another instance", path);
+        return NULL;
+    }
+
+    fallback = calloc(1, sizeof(*fallback));
+    if (fallback == NULL) {
+        SDL_AtomicSet(&l_in_use, 0);
+        return NULL;
+    }
+
+    if (osal_dynlib_open(&fallback->handle, path) != M64ERR_SUCCESS) {
+        DebugMessage(M64MSG_ERROR, "Couldn't load ALIST_FALLBACK %s", path);
+        free(fallback);
+        SDL_AtomicSet(&l_in_use, 0);
+        return NULL;
+    }
+
+    PluginGetVersion = (ptr_PluginGetVersion) osal_dynlib_getproc(fallback->handle, "PluginGetVersion");
+    PluginStartup = (ptr_PluginStartup) osal_dynlib_getproc(fallback->handle, "PluginStartup");
+    fallback->PluginShutdown = (ptr_PluginShutdown) osal_dynlib_getproc(fallback->handle, "PluginShutdown");
+    InitiateRSP = (ptr_InitiateRSP) osal_dynlib_getproc(fallback->handle, "InitiateRSP");
+    fallback->DoRspCycles = (ptr_DoRspCycles) osal_dynlib_getproc(fallback->handle, "DoRspCycles");
+    fallback->RomClosed = (ptr_RomClosed) osal_dynlib_getproc(fallback->handle, "RomClosed");
+
+    if (PluginGetVersion == NULL || PluginStartup == NULL || fallback->PluginShutdown == NULL
+     || InitiateRSP == NULL || fallback->DoRspCycles == NULL || fallback->RomClosed == NULL
+     || PluginGetVersion(&plugin_type, NULL, NULL, &plugin_name, NULL) != M64ERR_SUCCESS
+     || plugin_type != M64PLUGIN_RSP) {
+        DebugMessage(M64MSG_ERROR, "ALIST_FALLBACK %s isn't an RSP plugin", path);
+        osal_dynlib_close(fallback->handle);
+        free(fallback);
+        SDL_AtomicSet(&l_in_use, 0);
+        return NULL;
+    }
+
+    error = PluginStartup(core_handle, debug_context, debug_callback);
+    if (error != M64ERR_SUCCESS) {
+        if (error == M64ERR_ALREADY_INIT) {
+            /* most likely the core's RSP plugin, whose state we would clobber */
+            DebugMessage(M64MSG_ERROR, "ALIST_FALLBACK %s is already in use, it can't be the RSP plugin of the core", path);
+        }
+        else {
+            DebugMessage(M64MSG_ERROR, "ALIST_FALLBACK %s failed to start", path);
+        }
+        osal_dynlib_close(fallback->handle);
+        free(fallback);
+        SDL_AtomicSet(&l_in_use, 0);
+        return NULL;
+    }
+
+    memset(&rsp_info, 0, sizeof(rsp_info));
+    rsp_info.hInst = audio_info->hinst;
+    rsp_info.MemoryBswaped = audio_info->MemoryBswaped;
+    rsp_info.RDRAM = audio_info->RDRAM;
+    rsp_info.DMEM = audio_info->DMEM;
+    rsp_info.IMEM = audio_info->IMEM;
+    rsp_info.MI_INTR_REG = &fallback->registers[RSP_REG_MI_INTR];
+    rsp_info.SP_MEM_ADDR_REG = &fallback->registers[RSP_REG_SP_MEM_ADDR];
+    rsp_info.SP_DRAM_ADDR_REG = &fallback->registers[RSP_REG_SP_DRAM_ADDR];
+    rsp_info.SP_RD_LEN_REG = &fallback->registers[RSP_REG_SP_RD_LEN];
+    rsp_info.SP_WR_LEN_REG = &fallback->registers[RSP_REG_SP_WR_LEN];
+    rsp_info.SP_STATUS_REG = &fallback->registers[RSP_REG_SP_STATUS];
+    rsp_info.SP_DMA_FULL_REG = &fallback->registers[RSP_REG_SP_DMA_FULL];
+    rsp_info.SP_DMA_BUSY_REG = &fallback->registers[RSP_REG_SP_DMA_BUSY];
+    rsp_info.SP_PC_REG = &fallback->registers[RSP_REG_SP_PC];
+    rsp_info.SP_SEMAPHORE_REG = &fallback->registers[RSP_REG_SP_SEMAPHORE];
+    rsp_info.DPC_START_REG = &fallback->registers[RSP_REG_DPC_START];
+    rsp_info.DPC_END_REG = &fallback->registers[RSP_REG_DPC_END];
+    rsp_info.DPC_CURRENT_REG = &fallback->registers[RSP_REG_DPC_CURRENT];
+    rsp_info.DPC_STATUS_REG = &fallback->registers[RSP_REG_DPC_STATUS];
+    rsp_info.DPC_CLOCK_REG = &fallback->registers[RSP_REG_DPC_CLOCK];
+    rsp_info.DPC_BUFBUSY_REG = &fallback->registers[RSP_REG_DPC_BUFBUSY];
+    rsp_info.DPC_PIPEBUSY_REG = &fallback->registers[RSP_REG_DPC_PIPEBUSY];
+    rsp_info.DPC_TMEM_REG = &fallback->registers[RSP_REG_DPC_TMEM];
+    rsp_info.CheckInterrupts = no_interrupts;
+    rsp_info.ProcessDlistList = no_list;
+    rsp_info.ProcessAlistList = forwarded_alist;
+    rsp_info.ProcessRdpList = no_list;
+    rsp_info.ShowCFB = no_list;
+
+    fallback->registers[RSP_REG_SP_STATUS] = SP_STATUS_HALT;
+    InitiateRSP(rsp_info, &cycle_count);
+
+    DebugMessage(M64MSG_INFO, "Unsupported audio microcodes run by %s", (plugin_name != NULL) ? plugin_name : path);
+
+    return fallback;
+}
+
+void release_rsp_fallback(struct rsp_fallback* fallback)
+{
+    if (fallback == NULL) {
+        return;
+    }
+
+    fallback->RomClosed();
+    fallback->PluginShutdown();
+    osal_dynlib_close(fallback->handle);
+    free(fallback);
+
+    SDL_AtomicSet(&l_in_use, 0);
+}
+
+int rsp_fallback_run_task(struct rsp_fallback* fallback)
+{
+    /* the task starts with the boot microcode, at the start of IMEM */
+    fallback->registers[RSP_REG_SP_STATUS] = 0;
+    fallback->registers[RSP_REG_SP_PC] = 0;
+    l_forwarded = 0;
+
+    fallback->DoRspCycles(0xffffffff);
+
+    if (l_forwarded) {
+        DebugMessage(M64MSG_ERROR, "ALIST_FALLBACK forwards audio lists back to the audio plugin, disable its AudioListToAudioPlugin");
+        return -1;
+    }
+
+    return 0;
+}
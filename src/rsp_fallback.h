@@ -0,0 +1,57 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - rsp_fallback.h                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef M64P_RSP_FALLBACK_H
+#define M64P_RSP_FALLBACK_H
+
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+/* RSP plugin running the audio tasks whose microcode alist can't emulate.
+ *
+ * RSP plugins forwarding audio lists to the audio plugin (e.g. mupen64plus-rsp-hle
+ * with AudioListToAudioPlugin) forward all of them, and can't be told to run some
+ * themselves. Tasks of an unsupported microcode (ABI2, ABI3, MusyX) are instead run
+ * by a second RSP plugin (ALIST_FALLBACK, e.g. mupen64plus-rsp-cxd4), loaded on the
+ * memories of the audio plugin, the same way mupen64plus-rsp-hle runs the tasks
+ * it doesn't support with its RspFallback.
+ *
+ * The fallback must not be the library of the core's RSP plugin, and must not forward
+ * audio lists itself. RSP plugins keep global state, so only one instance at a time
+ * can use a fallback. */
+
+struct rsp_fallback;
+
+/* Load the RSP plugin at path to run tasks in the memories of audio_info.
+ * core_handle, debug_context and debug_callback are passed to its PluginStartup.
+ * Return NULL if it can't be used. */
+struct rsp_fallback* init_rsp_fallback(const char* path, m64p_dynlib_handle core_handle,
+        void* debug_context, void (*debug_callback)(void*, int, const char*),
+        const AUDIO_INFO* audio_info);
+
+void release_rsp_fallback(struct rsp_fallback* fallback);
+
+/* Run the task described by the task header in DMEM.
+ * Return 0 if it ran, -1 if the fallback turned out to be unusable. */
+int rsp_fallback_run_task(struct rsp_fallback* fallback);
+
+#endif
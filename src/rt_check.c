@@ -0,0 +1,121 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - rt_check.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "rt_check.h"
+
+#include "m64p_types.h"
+
+struct rt_check_location
+{
+    const char* file;
+    int line;
+};
+
+static ATTR_THREAD_LOCAL int l_in_callback = 0;
+static int l_trap = 0;
+static SDL_atomic_t l_counts[RT_CHECK_KIND_COUNT];
+static SDL_atomic_t l_first_claimed[RT_CHECK_KIND_COUNT];
+static struct rt_check_location l_first[RT_CHECK_KIND_COUNT];
+
+static const char* const l_kind_names[RT_CHECK_KIND_COUNT] =
+{
+    "malloc",
+    "realloc",
+    "free",
+    "lock",
+    "logging"
+};
+
+
+void rt_check_reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < RT_CHECK_KIND_COUNT; ++i) {
+        SDL_AtomicSet(&l_counts[i], 0);
+        SDL_AtomicSet(&l_first_claimed[i], 0);
+        l_first[i].file = NULL;
+        l_first[i].line = 0;
+    }
+
+    l_trap = (getenv("RT_CHECK_TRAP") != NULL);
+}
+
+void rt_check_report(void)
+{
+    size_t i;
+    int total = 0;
+
+    for (i = 0; i < RT_CHECK_KIND_COUNT; ++i) {
+        int count = SDL_AtomicGet(&l_counts[i]);
+        if (count == 0) {
+            continue;
+        }
+
+        total += count;
+        DebugMessage(M64MSG_WARNING, "RT check: %d %s call(s) in audio callback, first at %s:%d",
+                count, l_kind_names[i],
+                (l_first[i].file != NULL) ? l_first[i].file : "?", l_first[i].line);
+    }
+
+    if (total == 0) {
+        DebugMessage(M64MSG_INFO, "RT check: no real-time safety violation in audio callback");
+    }
+}
+
+int rt_check_violations(void)
+{
+    size_t i;
+    int total = 0;
+
+    for (i = 0; i < RT_CHECK_KIND_COUNT; ++i) {
+        total += SDL_AtomicGet(&l_counts[i]);
+    }
+
+    return total;
+}
+
+void rt_check_set_audio_thread(int in_callback)
+{
+    l_in_callback = in_callback;
+}
+
+void rt_check_point(enum rt_check_kind kind, const char* file, int line)
+{
+    if (!l_in_callback) {
+        return;
+    }
+
+    SDL_AtomicAdd(&l_counts[kind], 1);
+
+    if (SDL_AtomicCAS(&l_first_claimed[kind], 0, 1)) {
+        l_first[kind].file = file;
+        l_first[kind].line = line;
+    }
+
+    if (l_trap) {
+        abort();
+    }
+}
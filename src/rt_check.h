@@ -0,0 +1,80 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - rt_check.h                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_RT_CHECK_H
+#define M64P_RT_CHECK_H
+
+/* Real-time safety checker (debug builds, RT_CHECK=1 makefile option).
+ *
+ * The SDL audio callback marks its thread with RT_CHECK_ENTER_CALLBACK/RT_CHECK_LEAVE_CALLBACK.
+ * Memory allocations, locks and logging done from the plugin while the mark is set
+ * are counted (or trapped if the RT_CHECK_TRAP environment variable is set),
+ * and reported by RT_CHECK_REPORT. RT_CHECK_VIOLATIONS returns their total.
+ *
+ * This header must be included after the system and SDL headers, as it wraps some of their functions.
+ */
+
+enum rt_check_kind
+{
+    RT_CHECK_MALLOC,
+    RT_CHECK_REALLOC,
+    RT_CHECK_FREE,
+    RT_CHECK_LOCK,
+    RT_CHECK_LOG,
+    RT_CHECK_KIND_COUNT
+};
+
+#if defined(RT_CHECK)
+
+void rt_check_reset(void);
+void rt_check_report(void);
+int rt_check_violations(void);
+void rt_check_set_audio_thread(int in_callback);
+void rt_check_point(enum rt_check_kind kind, const char* file, int line);
+
+#define RT_CHECK_RESET()          rt_check_reset()
+#define RT_CHECK_REPORT()         rt_check_report()
+#define RT_CHECK_VIOLATIONS()     rt_check_violations()
+#define RT_CHECK_ENTER_CALLBACK() rt_check_set_audio_thread(1)
+#define RT_CHECK_LEAVE_CALLBACK() rt_check_set_audio_thread(0)
+#define RT_CHECK_POINT(kind)      rt_check_point((kind), __FILE__, __LINE__)
+
+/* wrap unsafe functions (a macro is not expanded inside its own definition) */
+#define malloc(size)               (RT_CHECK_POINT(RT_CHECK_MALLOC), malloc(size))
+#define calloc(count, size)        (RT_CHECK_POINT(RT_CHECK_MALLOC), calloc((count), (size)))
+#define realloc(ptr, size)         (RT_CHECK_POINT(RT_CHECK_REALLOC), realloc((ptr), (size)))
+#define free(ptr)                  (RT_CHECK_POINT(RT_CHECK_FREE), free(ptr))
+#define SDL_LockAudioDevice(dev)   (RT_CHECK_POINT(RT_CHECK_LOCK), SDL_LockAudioDevice(dev))
+#define SDL_LockMutex(mutex)       (RT_CHECK_POINT(RT_CHECK_LOCK), SDL_LockMutex(mutex))
+
+#else
+
+/* statements that still need their semicolon, e.g. as the body of an if */
+#define RT_CHECK_RESET()          do { } while (0)
+#define RT_CHECK_REPORT()         do { } while (0)
+#define RT_CHECK_VIOLATIONS()     (0)
+#define RT_CHECK_ENTER_CALLBACK() do { } while (0)
+#define RT_CHECK_LEAVE_CALLBACK() do { } while (0)
+#define RT_CHECK_POINT(kind)      do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,223 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - sample_format.c                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <math.h>
+#include <string.h>
+
+#include "dsp/dsp_simd.h"
+#include "sample_format.h"
+
+void copy_n64_samples(void* dst, const void* src, size_t size, int swap_channels)
+{
+    /* Confusing logic but, for LittleEndian host using memcpy will result in swapped channels,
+     * whereas the other branch will result in non-swapped channels.
+     * For BigEndian host this logic is inverted, memcpy will result in non swapped channels
+     * and the other branch will result in swapped channels.
+     *
+     * This is due to the fact that the core stores 32bit words in native order in RDRAM.
+     * For instance N64 bytes "Lh Ll Rh Rl" will be stored as "Rl Rh Ll Lh" on LittleEndian host
+     * and therefore should the non-memcpy path to get non swapped channels,
+     * whereas on BigEndian host the bytes will be stored as "Lh Ll Rh Rl" and therefore
+     * memcpy path results in the non-swapped channels outcome.
+     */
+    if (swap_channels ^ (SDL_BYTEORDER == SDL_BIG_ENDIAN)) {
+        memcpy(dst, src, size);
+    }
+    else {
+        size_t i;
+        for (i = 0 ; i < size ; i += 4 )
+        {
+            memcpy((unsigned char*)dst + i + 0, (const unsigned char*)src + i + 2, 2); /* Left */
+            memcpy((unsigned char*)dst + i + 2, (const unsigned char*)src + i + 0, 2); /* Right */
+        }
+    }
+}
+
+void split_n64_samples(void* left, void* right, int to_float, const void* src, size_t size, int swap_channels)
+{
+    /* same channel order as copy_n64_samples: the memcpy path keeps left samples first */
+    void* first = (swap_channels ^ (SDL_BYTEORDER == SDL_BIG_ENDIAN)) ? left : right;
+    void* second = (first == left) ? right : left;
+
+    if (to_float) {
+        deinterleave_s16_to_f32((float*)first, (float*)second, src, size);
+    }
+    else {
+        deinterleave_s16((int16_t*)first, (int16_t*)second, src, size);
+    }
+}
+
+void deinterleave_s16(int16_t* first, int16_t* second, const void* src, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)src;
+    size_t frames = size / 4;
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    /* 8 frames at a time: first words sign extended from the low halves of 32bit lanes,
+     * second words from the high halves */
+    for (; i + 8 <= frames; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + 4 * i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + 4 * i + 16));
+
+        _mm_storeu_si128((__m128i*)(first + i), _mm_packs_epi32(
+                    _mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                    _mm_srai_epi32(_mm_slli_epi32(b, 16), 16)));
+        _mm_storeu_si128((__m128i*)(second + i), _mm_packs_epi32(
+                    _mm_srai_epi32(a, 16),
+                    _mm_srai_epi32(b, 16)));
+    }
+#endif
+
+    for (; i < frames; ++i) {
+        memcpy(first + i, p + 4 * i, 2);
+        memcpy(second + i, p + 4 * i + 2, 2);
+    }
+}
+
+void deinterleave_s16_to_f32(float* first, float* second, const void* src, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)src;
+    size_t frames = size / 4;
+    size_t i = 0;
+    int16_t w[2];
+
+#if defined(DSP_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    for (; i + 4 <= frames; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + 4 * i));
+
+        _mm_storeu_ps(first + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16)), scale));
+        _mm_storeu_ps(second + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(a, 16)), scale));
+    }
+#endif
+
+    for (; i < frames; ++i) {
+        memcpy(w, p + 4 * i, 4);
+        first[i] = w[0] * (1.0f / 32768.0f);
+        second[i] = w[1] * (1.0f / 32768.0f);
+    }
+}
+
+static int16_t f32_to_s16(float x)
+{
+    x *= 32768.0f;
+    x = (x > 32767.0f) ? 32767.0f : (x < -32768.0f) ? -32768.0f : x;
+
+    return (int16_t)lrintf(x);
+}
+
+void interleave_f32_to_s16(int16_t* dst, const float* left, const float* right, size_t frames)
+{
+    size_t i = 0;
+
+#if defined(DSP_SSE2)
+    /* clamp before converting: out of range conversions give INT_MIN */
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+
+    for (; i + 8 <= frames; i += 8) {
+        __m128i l = _mm_packs_epi32(
+                _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + i), scale), lo), hi)),
+                _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + i + 4), scale), lo), hi)));
+        __m128i r = _mm_packs_epi32(
+                _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + i), scale), lo), hi)),
+                _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + i + 4), scale), lo), hi)));
+
+        _mm_storeu_si128((__m128i*)(dst + 2 * i), _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i*)(dst + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+    }
+#endif
+
+    for (; i < frames; ++i) {
+        dst[2 * i] = f32_to_s16(left[i]);
+        dst[2 * i + 1] = f32_to_s16(right[i]);
+    }
+}
+
+int is_steady_block(const void* samples, size_t size, uint32_t* frame)
+{
+    const unsigned char* p = (const unsigned char*)samples;
+    size_t i = 0;
+    uint32_t first;
+    uint32_t x;
+
+    if (size < 4) {
+        return 1;
+    }
+
+    memcpy(&first, p, 4);
+
+#if defined(DSP_SSE2)
+    {
+        const __m128i ref = _mm_set1_epi32((int)first);
+
+        /* check 64 bytes at a time, so that audible input bails out early */
+        for (; i + 64 <= size; i += 64) {
+            __m128i diff = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + i)), ref),
+                        _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + i + 16)), ref)),
+                    _mm_or_si128(
+                        _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + i + 32)), ref),
+                        _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + i + 48)), ref)));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xffff) {
+                return 0;
+            }
+        }
+    }
+#endif
+
+    for (; i + 4 <= size; i += 4) {
+        memcpy(&x, p + i, 4);
+        if (x != first) {
+            return 0;
+        }
+    }
+
+    *frame = first;
+    return 1;
+}
+
+void fill_steady_block(void* samples, size_t size, uint32_t frame, int volume)
+{
+    unsigned char* p = (unsigned char*)samples;
+    int16_t scaled[2];
+    size_t i;
+
+    if (frame == 0) {
+        memset(samples, 0, size);
+        return;
+    }
+
+    /* same volume scaling as SDL_MixAudio */
+    memcpy(scaled, &frame, sizeof(scaled));
+    scaled[0] = (int16_t)(scaled[0] * volume / SDL_MIX_MAXVOLUME);
+    scaled[1] = (int16_t)(scaled[1] * volume / SDL_MIX_MAXVOLUME);
+
+    for (i = 0; i + 4 <= size; i += 4) {
+        memcpy(p + i, scaled, sizeof(scaled));
+    }
+}
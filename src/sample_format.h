@@ -0,0 +1,53 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - sample_format.h                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_SAMPLE_FORMAT_H
+#define M64P_SAMPLE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Copy size bytes of N64 AI samples (2x16bit words in core RDRAM order)
+ * to SDL interleaved left/right samples, optionally swapping channels. */
+void copy_n64_samples(void* dst, const void* src, size_t size, int swap_channels);
+
+/* Split size bytes of N64 AI samples into left and right planes of int16 samples,
+ * or of float samples in [-1, 1) if to_float is set, optionally swapping channels. */
+void split_n64_samples(void* left, void* right, int to_float, const void* src, size_t size, int swap_channels);
+
+/* Split size bytes of interleaved 16bit words into planes of their first and second words,
+ * as int16 or as float in [-1, 1) */
+void deinterleave_s16(int16_t* first, int16_t* second, const void* src, size_t size);
+void deinterleave_s16_to_f32(float* first, float* second, const void* src, size_t size);
+
+/* Interleave left and right planes of float samples into int16 frames, with rounding and saturation */
+void interleave_f32_to_s16(int16_t* dst, const float* left, const float* right, size_t frames);
+
+/* Check whether size bytes of SDL samples are all copies of their first left/right frame
+ * (digital silence or DC), which is then stored in frame.
+ * An empty block is steady and leaves frame untouched. */
+int is_steady_block(const void* samples, size_t size, uint32_t* frame);
+
+/* Fill size bytes of SDL samples with copies of a left/right frame, scaled by volume
+ * (0 to SDL_MIX_MAXVOLUME) the same way as SDL_MixAudio. */
+void fill_steady_block(void* samples, size_t size, uint32_t frame, int volume);
+
+#endif
@@ -24,9 +24,26 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "audio_checkpoint.h"
+#include "audio_stats.h"
+#include "audio_sync.h"
+#include "audio_timing.h"
+#include "capture.h"
 #include "circular_buffer.h"
+#include "concealment.h"
+#include "dsp/dsp.h"
+#include "hot_log.h"
+#include "latency_probe.h"
 #include "main.h"
+#include "osal_realtime.h"
+#include "probes.h"
+#include "resample_governor.h"
 #include "resamplers/resamplers.h"
+#include "rt_check.h"
+#include "sample_format.h"
+#include "sdl_backend.h"
+#include "shm_tap.h"
+#include "trace.h"
 
 #define M64P_PLUGIN_PROTOTYPES 1
 #include "m64p_common.h"
@@ -41,44 +58,222 @@
 #define SDL_UnlockAudio() SDL_UnlockAudioDevice(sdl_backend->device)
 #define SDL_PauseAudio(A) SDL_PauseAudioDevice(sdl_backend->device, A)
 #define SDL_CloseAudio() SDL_CloseAudioDevice(sdl_backend->device)
-#define SDL_OpenAudio(A, B) ((sdl_backend->device = SDL_OpenAudioDevice(NULL, 0, A, B, 0)) - 1)
+
+/* Interval (in ms) between attempts to reopen a lost device */
+enum { DEVICE_RETRY_MS = 1000 };
+
+/* Input frames of a steady span the resampler has to go through before it can be skipped,
+ * so that its filter history only holds the steady frame (longer than any resampler filter) */
+enum { STEADY_SETTLE_FRAMES = 1024 };
+
+/* RESAMPLE=auto */
+enum { AUTO_RESAMPLER_MAX_LEVELS = 16 };
+
+/* SDL subsystem init/quit isn't thread-safe, and the subsystems are shared by all the
+ * backends of the process: only the first one initializes them and the last one quits them */
+static SDL_SpinLock l_sdl_subsystem_lock = 0;
+static int l_sdl_subsystem_users = 0;
+
+/* Handover of the next resampler level from the callback to the emulation thread and back,
+ * encoded as phase | level */
+enum
+{
+    AUTO_HANDOVER_IDLE = 0,
+    /* level picked by the callback */
+    AUTO_HANDOVER_REQUESTED = 0x100,
+    /* being prepared by the emulation thread */
+    AUTO_HANDOVER_PREPARING = 0x200,
+    /* ready to be crossfaded to by the callback */
+    AUTO_HANDOVER_READY = 0x300,
+
+    AUTO_HANDOVER_PHASE_MASK = 0xf00,
+    AUTO_HANDOVER_LEVEL_MASK = 0x0ff
+};
+
+struct auto_resampler_level
+{
+    char id[64];
+    void* resampler;
+    const struct resampler_interface* iresampler;
+};
+
+/* Live change of RESAMPLE: the emulation thread builds and prepares the new resampler,
+ * the callback crossfades to it, then the emulation thread releases the old one */
+enum
+{
+    RESAMPLER_RELOAD_IDLE = 0,
+    /* prepared, to be crossfaded to by the callback */
+    RESAMPLER_RELOAD_READY,
+    /* in use by the callback, the old resampler is to be released */
+    RESAMPLER_RELOAD_SWITCHED
+};
+
+struct resampler_reload
+{
+    char id[256];
+    /* levels of RESAMPLE=auto, or the fixed resampler in levels[0] (level_count is 0 then) */
+    struct auto_resampler_level levels[AUTO_RESAMPLER_MAX_LEVELS];
+    size_t level_count;
+    /* fixed resampler replaced by the reload */
+    void* old_resampler;
+    const struct resampler_interface* old_iresampler;
+};
+
+/* Timing of the last audio callback, for sdl_get_timing */
+struct callback_timing
+{
+    /* performance counter at the start of the callback */
+    uint64_t counter;
+    /* callback period (in output frames) */
+    uint64_t frames;
+    unsigned int output_frequency;
+    uint64_t src_rate;
+    uint64_t dst_rate;
+};
+
 struct sdl_backend
 {
     SDL_AudioDeviceID device;
     m64p_handle config;
 
+    /* SDL subsystems are reference counted: each backend holds its own reference */
+    int sdl_initialized;
+
     struct circular_buffer primary_buffer;
 
+    /* Layout of the primary buffer (RESAMPLER_LAYOUT_*), and size of one of its left/right frames.
+     * Planar layouts hold the left plane in the first half of the buffer and the right one in the second half. */
+    unsigned int layout;
+    size_t input_frame_bytes;
+
+    /* Interleaved copy of pushed samples, for the latency probe and the raw capture with planar layouts */
+    unsigned char* push_buffer;
+    size_t push_buffer_size;
+
     /* Primary buffer size (in output samples) */
     size_t primary_buffer_size;
 
     /* Primary buffer fullness target (in output samples) */
     size_t target;
 
-    /* Secondary buffer size (in output samples) */
+    /* Secondary buffer size (in output samples), and the SECONDARY_BUFFER_SIZE it was requested with */
     size_t secondary_buffer_size;
+    size_t requested_secondary_buffer_size;
 
     /* Mixing buffer used for volume control */
     unsigned char* mix_buffer;
+    size_t mix_buffer_size;
 
     unsigned int last_cb_time;
+    /* Input rate is input_rate_num/input_rate_den Hz,
+     * input_frequency is its integer part */
+    unsigned int input_rate_num;
+    unsigned int input_rate_den;
     unsigned int input_frequency;
     unsigned int output_frequency;
     unsigned int speed_factor;
 
     unsigned int swap_channels;
 
-    unsigned int audio_sync;
+    /* volume passed to SDL_MixAudio, range of 0..SDL_MIX_MAXVOLUME */
+    SDL_atomic_t volume;
 
-    unsigned int paused_for_sync;
+    struct audio_sync_policy sync_policy;
 
-    unsigned int underrun_count;
+    unsigned int paused_for_sync;
 
     unsigned int error;
 
-    /* Resampler */
+    /* Device loss: when the device is removed, or stops calling back for device_timeout_ms while playing,
+     * it is closed and the primary buffer is drained on a virtual clock (virtual_frames output frames
+     * played since virtual_start) until the default device can be reopened */
+    unsigned int device_timeout_ms;
+    unsigned int device_lost;
+    unsigned int unpause_time;
+    unsigned int virtual_start;
+    uint64_t virtual_frames;
+    unsigned int device_retry_time;
+
+    /* Low latency mode: audio buffers are locked in memory
+     * and the audio thread is switched to real-time scheduling */
+    unsigned int low_latency;
+    int rt_priority;
+    int audio_cpu;
+    int primary_buffer_locked;
+    int mix_buffer_locked;
+
+    /* audio thread setup is requested when the device is opened, done by the callback,
+     * and reported back on the emulation thread */
+    SDL_atomic_t audio_thread_setup_pending;
+    SDL_atomic_t audio_thread_report_pending;
+    const char* rt_policy;
+    int rt_priority_applied;
+    int audio_cpu_applied;
+
+    /* Published for sdl_get_timing with a sequence lock: the callback (or the emulation thread
+     * while there is no callback) makes timing_seq odd while writing timing.
+     * buffered_bytes is the primary buffer level, updated after each change. */
+    SDL_atomic_t timing_seq;
+    struct callback_timing timing;
+    SDL_atomic_t buffered_bytes;
+
+    /* Runtime statistics */
+    struct audio_stats_collector stats;
+
+    /* Captures of the output stream and of the raw N64 stream.
+     * Only changed while holding the audio lock */
+    struct audio_capture* output_capture;
+    struct audio_capture* raw_capture;
+
+    /* End-to-end latency measurement, if enabled.
+     * Only changed while holding the audio lock */
+    struct latency_probe* latency_probe;
+
+    /* Shared memory tap of the output, if enabled.
+     * Only changed while holding the audio lock */
+    struct shm_tap* shm_tap;
+
+    /* Post-processing of the output, if enabled, and the DSP_CHAIN it was built from */
+    struct dsp_chain* dsp_chain;
+    char dsp_chain_id[1024];
+
+    /* Underrun concealment, disabled if concealment.frames is 0 */
+    struct concealment concealment;
+
+    /* Steady state fast path: primary buffer bytes from steady_start on are all copies
+     * of steady_frame (digital silence or DC). steady_fed counts the input frames of that
+     * span the resampler went through, once it is settled the callback skips resampling
+     * and tracks the input position in steady_phase (in dst_rate units) instead. */
+    size_t steady_start;
+    uint32_t steady_frame;
+    size_t steady_fed;
+    uint64_t steady_phase;
+
+    /* Run-ahead and rollback: bytes queued in the primary buffer since init (without staged ones),
+     * and whether pushes are staged */
+    uint64_t pushed_bytes;
+    unsigned int speculating;
+
+    /* Resampler, and the RESAMPLE it was built from */
     void* resampler;
     const struct resampler_interface* iresampler;
+    char resampler_id[256];
+
+    /* Adaptive resampler (RESAMPLE=auto), auto_level_count is 0 otherwise.
+     * The callback owns the active level (governor.level) and picks the next one,
+     * which the emulation thread prepares before the callback crossfades to it. */
+    struct auto_resampler_level auto_levels[AUTO_RESAMPLER_MAX_LEVELS];
+    size_t auto_level_count;
+    struct resample_governor governor;
+    SDL_atomic_t auto_handover;
+
+    /* Resampler switch in progress, NULL if none.
+     * Owned by the emulation thread, read by the callback while reload_state is RESAMPLER_RELOAD_READY */
+    struct resampler_reload* reload;
+    SDL_atomic_t reload_state;
+
+    /* output of the next resampler during a crossfade */
+    unsigned char* xfade_buffer;
 };
 
 /* SDL_AudioFormat.format format specifier and args builder */
@@ -89,40 +284,384 @@ struct sdl_backend
         SDL_AUDIO_ISBIGENDIAN(x) ? "BE" : "LE"
 
 
+static void setup_audio_thread(struct sdl_backend* sdl_backend)
+{
+    sdl_backend->rt_priority_applied = sdl_backend->rt_priority;
+    sdl_backend->rt_policy = osal_set_realtime_priority(&sdl_backend->rt_priority_applied);
+
+    sdl_backend->audio_cpu_applied = (sdl_backend->audio_cpu >= 0)
+        && (osal_set_thread_affinity(sdl_backend->audio_cpu) == 0);
+
+    SDL_AtomicSet(&sdl_backend->audio_thread_setup_pending, 0);
+    SDL_AtomicSet(&sdl_backend->audio_thread_report_pending, 1);
+}
+
+static void report_audio_thread_setup(const struct sdl_backend* sdl_backend)
+{
+    if (sdl_backend->rt_policy != NULL) {
+        DebugMessage(M64MSG_INFO, "Low latency: audio thread scheduled with %s, priority %d",
+                sdl_backend->rt_policy, sdl_backend->rt_priority_applied);
+    }
+    else {
+        DebugMessage(M64MSG_WARNING, "Low latency: couldn't switch audio thread to real-time scheduling (check RLIMIT_RTPRIO), keeping SDL priority");
+    }
+
+    if (sdl_backend->audio_cpu >= 0) {
+        if (sdl_backend->audio_cpu_applied) {
+            DebugMessage(M64MSG_INFO, "Low latency: audio thread pinned to CPU %d", sdl_backend->audio_cpu);
+        }
+        else {
+            DebugMessage(M64MSG_WARNING, "Low latency: couldn't pin audio thread to CPU %d", sdl_backend->audio_cpu);
+        }
+    }
+}
+
+static int lock_audio_buffer(const char* name, void* data, size_t size)
+{
+    if (osal_lock_memory(data, size) != 0) {
+        DebugMessage(M64MSG_WARNING, "Low latency: couldn't lock %s (%u bytes) in memory (check RLIMIT_MEMLOCK)", name, (uint32_t) size);
+        return 0;
+    }
+
+    DebugMessage(M64MSG_VERBOSE, "Low latency: %s (%u bytes) locked in memory", name, (uint32_t) size);
+    return 1;
+}
+
+static size_t primary_buffer_planes(const struct sdl_backend* sdl_backend)
+{
+    return (sdl_backend->layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) ? 1 : 2;
+}
+
+/* Primary buffer size in bytes, counted in N64 samples */
+static size_t to_n64_bytes(const struct sdl_backend* sdl_backend, size_t size)
+{
+    return size / sdl_backend->input_frame_bytes * N64_SAMPLE_BYTES;
+}
+
+/* Resample the first src_size bytes of the primary buffer with a resampler level, in the primary buffer layout */
+static size_t resample_primary_buffer(struct sdl_backend* sdl_backend,
+        void* resampler, const struct resampler_interface* iresampler,
+        size_t src_size, uint64_t src_rate,
+        void* dst, size_t dst_size, uint64_t dst_rate, int volume)
+{
+    if (sdl_backend->layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) {
+        return ResampleAndMix(resampler, iresampler,
+                sdl_backend->mix_buffer,
+                sdl_backend->primary_buffer.data, src_size, src_rate,
+                dst, dst_size, dst_rate,
+                volume);
+    }
+    else {
+        const void* planes[2];
+
+        planes[0] = cbuff_plane(&sdl_backend->primary_buffer, 0, 2);
+        planes[1] = cbuff_plane(&sdl_backend->primary_buffer, 1, 2);
+
+        return ResampleAndMixPlanar(resampler, iresampler,
+                sdl_backend->layout, sdl_backend->mix_buffer,
+                planes, src_size, src_rate,
+                dst, dst_size, dst_rate,
+                volume);
+    }
+}
+
+/* Resample with both the active and the next resampler (level), crossfading from one to the other
+ * over the callback. The next one then becomes the active one. */
+static size_t crossfade_resampler(struct sdl_backend* sdl_backend, const struct auto_resampler_level* next,
+        size_t src_size, uint64_t src_rate,
+        unsigned char* stream, size_t len, uint64_t dst_rate, int volume)
+{
+    int16_t* out = (int16_t*)stream;
+    const int16_t* in = (const int16_t*)sdl_backend->xfade_buffer;
+    size_t frames = len / SDL_SAMPLE_BYTES;
+    size_t consumed;
+    size_t i;
+
+    resample_primary_buffer(sdl_backend, sdl_backend->resampler, sdl_backend->iresampler,
+            src_size, src_rate,
+            stream, len, dst_rate,
+            volume);
+
+    /* from now on the input is consumed at the pace of the next level */
+    consumed = resample_primary_buffer(sdl_backend, next->resampler, next->iresampler,
+            src_size, src_rate,
+            sdl_backend->xfade_buffer, len, dst_rate,
+            volume);
+
+    for (i = 0; i < frames; ++i) {
+        int32_t w = (int32_t)((i << 15) / frames);
+
+        out[2 * i] = (int16_t)((out[2 * i] * (32768 - w) + in[2 * i] * w) >> 15);
+        out[2 * i + 1] = (int16_t)((out[2 * i + 1] * (32768 - w) + in[2 * i + 1] * w) >> 15);
+    }
+
+    sdl_backend->resampler = next->resampler;
+    sdl_backend->iresampler = next->iresampler;
+
+    return consumed;
+}
+
+/* Resampling ratio from input to output, as src_rate:dst_rate.
+ * Both are scaled by the input rate denominator and by 100 (for the speed factor),
+ * so that fractional input frequencies don't drift */
+static void get_resample_rates(const struct sdl_backend* sdl_backend, uint64_t* src_rate, uint64_t* dst_rate)
+{
+    *src_rate = (uint64_t)sdl_backend->input_rate_num * sdl_backend->speed_factor;
+    *dst_rate = (uint64_t)sdl_backend->input_rate_den * sdl_backend->output_frequency * 100;
+}
+
+static void publish_timing(struct sdl_backend* sdl_backend, uint64_t counter, size_t frames,
+        uint64_t src_rate, uint64_t dst_rate)
+{
+    SDL_AtomicAdd(&sdl_backend->timing_seq, 1);
+    SDL_MemoryBarrierRelease();
+
+    sdl_backend->timing.counter = counter;
+    sdl_backend->timing.frames = frames;
+    sdl_backend->timing.output_frequency = sdl_backend->output_frequency;
+    sdl_backend->timing.src_rate = src_rate;
+    sdl_backend->timing.dst_rate = dst_rate;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&sdl_backend->timing_seq, 1);
+}
+
+static void publish_buffered_bytes(struct sdl_backend* sdl_backend)
+{
+    SDL_AtomicSet(&sdl_backend->buffered_bytes, (int)sdl_backend->primary_buffer.head);
+}
+
+/* Feed the governor with the resampling time of this callback, and request a level change if needed */
+static void update_auto_resampler(struct sdl_backend* sdl_backend, uint64_t resample_ticks, size_t len)
+{
+    double period = (double)(len / SDL_SAMPLE_BYTES) / sdl_backend->output_frequency;
+    double load = (double)resample_ticks / (period * sdl_backend->stats.perf_frequency);
+    size_t level = resample_governor_update(&sdl_backend->governor, load, sdl_backend->last_cb_time);
+
+    if (level != sdl_backend->governor.level) {
+        /* only one handover at a time */
+        if (SDL_AtomicCAS(&sdl_backend->auto_handover, AUTO_HANDOVER_IDLE, AUTO_HANDOVER_REQUESTED | (int)level)) {
+            HOT_LOG(M64MSG_VERBOSE, "Auto resampler: requesting level %zu (resampling load %zu%%)",
+                    level, (size_t)(load * 100.0));
+        }
+    }
+}
+
+/* Consume input which went through the resampler, keeping track of the steady span */
+static void consume_resampled(struct sdl_backend* sdl_backend, size_t consumed)
+{
+    if (sdl_backend->steady_start == 0) {
+        sdl_backend->steady_fed += consumed / sdl_backend->input_frame_bytes;
+    }
+    else if (consumed > sdl_backend->steady_start) {
+        sdl_backend->steady_fed = (consumed - sdl_backend->steady_start) / sdl_backend->input_frame_bytes;
+        sdl_backend->steady_start = 0;
+    }
+    else {
+        sdl_backend->steady_fed = 0;
+        sdl_backend->steady_start -= consumed;
+    }
+
+    consume_cbuff_planes(&sdl_backend->primary_buffer, consumed, primary_buffer_planes(sdl_backend));
+}
+
+/* Produce a callback worth of the steady frame without resampling it.
+ * Returns the number of input bytes it stands for. */
+static size_t render_steady(struct sdl_backend* sdl_backend, unsigned char* stream, size_t len,
+        size_t available, uint64_t src_rate, uint64_t dst_rate, int volume)
+{
+    size_t frames = len / SDL_SAMPLE_BYTES;
+    uint64_t position = (uint64_t)frames * src_rate + sdl_backend->steady_phase;
+    size_t consumed = (size_t)(position / dst_rate);
+
+    sdl_backend->steady_phase = position % dst_rate;
+    if (consumed > available / sdl_backend->input_frame_bytes) {
+        consumed = available / sdl_backend->input_frame_bytes;
+        sdl_backend->steady_phase = 0;
+    }
+
+    fill_steady_block(stream, len, sdl_backend->steady_frame, volume);
+
+    return consumed * sdl_backend->input_frame_bytes;
+}
+
 static void my_audio_callback(void* userdata, unsigned char* stream, int len)
 {
     struct sdl_backend* sdl_backend = (struct sdl_backend*)userdata;
+    uint64_t cb_start = SDL_GetPerformanceCounter();
+
+    RT_CHECK_ENTER_CALLBACK();
+    TRACE_THREAD_NAME("SDL audio callback");
+    TRACE_BEGIN("my_audio_callback");
+
+    if (SDL_AtomicGet(&sdl_backend->audio_thread_setup_pending)) {
+        setup_audio_thread(sdl_backend);
+    }
 
     /* mark the time, for synchronization on the input side */
     sdl_backend->last_cb_time = SDL_GetTicks();
 
-    unsigned int newsamplerate = sdl_backend->output_frequency * 100 / sdl_backend->speed_factor;
-    unsigned int oldsamplerate = sdl_backend->input_frequency;
-    size_t needed = (len * oldsamplerate) / newsamplerate;
+    uint64_t src_rate;
+    uint64_t dst_rate;
+    size_t needed;
     size_t available;
-    size_t consumed;
+    size_t consumed = 0;
+
+    get_resample_rates(sdl_backend, &src_rate, &dst_rate);
+    needed = (size_t)(((uint64_t)len * src_rate) / dst_rate * sdl_backend->input_frame_bytes / N64_SAMPLE_BYTES);
+
+    cbuff_tail(&sdl_backend->primary_buffer, &available);
+    TRACE_COUNTER("callback available bytes", available);
+    AUDIO_PROBE3(callback_entry, len / SDL_SAMPLE_BYTES, needed, available);
 
-    const void* src = cbuff_tail(&sdl_backend->primary_buffer, &available);
-    if ((available > 0) && (available >= needed))
+    /* when concealing, render what's there and conceal the rest */
+    if ((available < needed) && (sdl_backend->concealment.frames != 0))
     {
-        consumed = ResampleAndMix(sdl_backend->resampler, sdl_backend->iresampler,
-                sdl_backend->mix_buffer,
-                src, available, oldsamplerate,
-                stream, len, newsamplerate);
+        size_t frames = (size_t)((uint64_t)(available / sdl_backend->input_frame_bytes) * dst_rate / src_rate);
+        size_t rendered = 0;
+
+        ++sdl_backend->stats.underruns;
+        TRACE_INSTANT("underrun");
+        AUDIO_PROBE2(underrun, needed, available);
+
+        if (frames > 0)
+        {
+            uint64_t resample_start = SDL_GetPerformanceCounter();
+
+            rendered = frames * SDL_SAMPLE_BYTES;
+            if (rendered > (size_t)len) {
+                rendered = len;
+            }
+
+            /* a pending handover waits for a full callback */
+            consumed = resample_primary_buffer(sdl_backend, sdl_backend->resampler, sdl_backend->iresampler,
+                    available, src_rate,
+                    stream, rendered, dst_rate,
+                    SDL_AtomicGet(&sdl_backend->volume));
+
+            sdl_backend->stats.resample_ticks += SDL_GetPerformanceCounter() - resample_start;
+            ++sdl_backend->stats.resampled_callbacks;
+            consume_resampled(sdl_backend, consumed);
+
+            concealment_render(&sdl_backend->concealment, (int16_t*)stream, rendered / SDL_SAMPLE_BYTES);
+        }
+
+        concealment_conceal(&sdl_backend->concealment, (int16_t*)(stream + rendered), (len - rendered) / SDL_SAMPLE_BYTES);
+    }
+    else if ((available > 0) && (available >= needed)
+            && (sdl_backend->steady_start == 0) && (sdl_backend->steady_fed >= STEADY_SETTLE_FRAMES)
+            && ((SDL_AtomicGet(&sdl_backend->auto_handover) & AUTO_HANDOVER_PHASE_MASK) != AUTO_HANDOVER_READY)
+            && (SDL_AtomicGet(&sdl_backend->reload_state) != RESAMPLER_RELOAD_READY))
+    {
+        /* the resampler history only holds the steady frame, and will still do when resuming */
+        consumed = render_steady(sdl_backend, stream, len, available, src_rate, dst_rate,
+                SDL_AtomicGet(&sdl_backend->volume));
+
+        ++sdl_backend->stats.steady_callbacks;
+        consume_cbuff_planes(&sdl_backend->primary_buffer, consumed, primary_buffer_planes(sdl_backend));
+
+        concealment_render(&sdl_backend->concealment, (int16_t*)stream, len / SDL_SAMPLE_BYTES);
+    }
+    else if ((available > 0) && (available >= needed))
+    {
+        uint64_t resample_start = SDL_GetPerformanceCounter();
+        uint64_t resample_ticks;
+        int reload = SDL_AtomicGet(&sdl_backend->reload_state);
+        /* the auto resampler holds still while RESAMPLE is being changed */
+        int handover = (sdl_backend->auto_level_count != 0 && reload == RESAMPLER_RELOAD_IDLE)
+            ? SDL_AtomicGet(&sdl_backend->auto_handover)
+            : AUTO_HANDOVER_IDLE;
+
+        if (reload == RESAMPLER_RELOAD_READY) {
+            SDL_MemoryBarrierAcquire();
+
+            consumed = crossfade_resampler(sdl_backend, &sdl_backend->reload->levels[0],
+                    available, src_rate,
+                    stream, len, dst_rate,
+                    SDL_AtomicGet(&sdl_backend->volume));
+
+            SDL_AtomicSet(&sdl_backend->reload_state, RESAMPLER_RELOAD_SWITCHED);
+
+            /* the new resampler was prepared with silence, not with the steady frame */
+            sdl_backend->steady_fed = 0;
+        }
+        else if ((handover & AUTO_HANDOVER_PHASE_MASK) == AUTO_HANDOVER_READY) {
+            size_t level = handover & AUTO_HANDOVER_LEVEL_MASK;
+
+            consumed = crossfade_resampler(sdl_backend, &sdl_backend->auto_levels[level],
+                    available, src_rate,
+                    stream, len, dst_rate,
+                    SDL_AtomicGet(&sdl_backend->volume));
 
-        consume_cbuff_data(&sdl_backend->primary_buffer, consumed);
+            resample_governor_switched(&sdl_backend->governor, level, sdl_backend->last_cb_time);
+            SDL_AtomicSet(&sdl_backend->auto_handover, AUTO_HANDOVER_IDLE);
+
+            /* the new level was prepared with silence, not with the steady frame */
+            sdl_backend->steady_fed = 0;
+        }
+        else {
+            consumed = resample_primary_buffer(sdl_backend, sdl_backend->resampler, sdl_backend->iresampler,
+                    available, src_rate,
+                    stream, len, dst_rate,
+                    SDL_AtomicGet(&sdl_backend->volume));
+        }
+
+        resample_ticks = SDL_GetPerformanceCounter() - resample_start;
+        sdl_backend->stats.resample_ticks += resample_ticks;
+        ++sdl_backend->stats.resampled_callbacks;
+
+        /* a crossfade resamples twice, it says nothing about the load of either level */
+        if (sdl_backend->auto_level_count != 0 && handover == AUTO_HANDOVER_IDLE && reload == RESAMPLER_RELOAD_IDLE) {
+            update_auto_resampler(sdl_backend, resample_ticks, len);
+        }
+
+        consume_resampled(sdl_backend, consumed);
+
+        concealment_render(&sdl_backend->concealment, (int16_t*)stream, len / SDL_SAMPLE_BYTES);
     }
     else
     {
-        ++sdl_backend->underrun_count;
+        ++sdl_backend->stats.underruns;
+        TRACE_INSTANT("underrun");
+        AUDIO_PROBE2(underrun, needed, available);
         memset(stream, 0, len);
     }
+
+    /* also run on silence, to let filters and limiter decay */
+    if (sdl_backend->dsp_chain != NULL) {
+        dsp_chain_process(sdl_backend->dsp_chain, stream, len / SDL_SAMPLE_BYTES);
+    }
+
+    if (sdl_backend->output_capture != NULL) {
+        audio_capture_push(sdl_backend->output_capture, stream, len, sdl_backend->output_frequency);
+    }
+
+    if (sdl_backend->latency_probe != NULL) {
+        latency_probe_output(sdl_backend->latency_probe, stream, len, sdl_backend->output_frequency, cb_start);
+    }
+
+    if (sdl_backend->shm_tap != NULL) {
+        shm_tap_push(sdl_backend->shm_tap, stream, len, sdl_backend->output_frequency);
+    }
+
+    publish_buffered_bytes(sdl_backend);
+    publish_timing(sdl_backend, cb_start, len / SDL_SAMPLE_BYTES, src_rate, dst_rate);
+    AUDIO_PROBE2(callback_exit, consumed, sdl_backend->primary_buffer.head);
+
+    stats_add_callback_duration(&sdl_backend->stats, SDL_GetPerformanceCounter() - cb_start);
+
+    TRACE_END("my_audio_callback");
+    RT_CHECK_LEAVE_CALLBACK();
 }
 
 static size_t new_primary_buffer_size(const struct sdl_backend* sdl_backend)
 {
-    return N64_SAMPLE_BYTES * ((uint64_t)sdl_backend->primary_buffer_size * sdl_backend->input_frequency * sdl_backend->speed_factor) /
-        (sdl_backend->output_frequency * 100);
+    uint64_t src_rate;
+    uint64_t dst_rate;
+
+    get_resample_rates(sdl_backend, &src_rate, &dst_rate);
+
+    return sdl_backend->input_frame_bytes * (size_t)(((uint64_t)sdl_backend->primary_buffer_size * src_rate) / dst_rate);
 }
 
 static void resize_primary_buffer(struct sdl_backend* sdl_backend, size_t new_size)
@@ -130,13 +669,45 @@ static void resize_primary_buffer(struct sdl_backend* sdl_backend, size_t new_si
     /* only grows the buffer */
     if (new_size > sdl_backend->primary_buffer.size) {
         SDL_LockAudio();
+        if (sdl_backend->primary_buffer_locked) {
+            osal_unlock_memory(sdl_backend->primary_buffer.data, sdl_backend->primary_buffer.size);
+            sdl_backend->primary_buffer_locked = 0;
+        }
         sdl_backend->primary_buffer.data = realloc(sdl_backend->primary_buffer.data, new_size);
         memset((unsigned char*)sdl_backend->primary_buffer.data + sdl_backend->primary_buffer.size, 0, new_size - sdl_backend->primary_buffer.size);
+
+        /* the right plane starts at the middle of the buffer */
+        if (primary_buffer_planes(sdl_backend) == 2) {
+            memmove((unsigned char*)sdl_backend->primary_buffer.data + new_size / 2,
+                    (unsigned char*)sdl_backend->primary_buffer.data + sdl_backend->primary_buffer.size / 2,
+                    sdl_backend->primary_buffer.size / 2);
+        }
         sdl_backend->primary_buffer.size = new_size;
+        if (sdl_backend->low_latency) {
+            sdl_backend->primary_buffer_locked = lock_audio_buffer("primary buffer", sdl_backend->primary_buffer.data, new_size);
+        }
         SDL_UnlockAudio();
     }
 }
 
+static void resize_mix_buffer(struct sdl_backend* sdl_backend, size_t new_size)
+{
+    if (sdl_backend->mix_buffer_locked) {
+        osal_unlock_memory(sdl_backend->mix_buffer, sdl_backend->mix_buffer_size);
+        sdl_backend->mix_buffer_locked = 0;
+    }
+
+    sdl_backend->mix_buffer = realloc(sdl_backend->mix_buffer, new_size);
+    sdl_backend->mix_buffer_size = new_size;
+
+    /* prefault */
+    memset(sdl_backend->mix_buffer, 0, new_size);
+
+    if (sdl_backend->low_latency) {
+        sdl_backend->mix_buffer_locked = lock_audio_buffer("mix buffer", sdl_backend->mix_buffer, new_size);
+    }
+}
+
 static unsigned int select_output_frequency(unsigned int input_frequency)
 {
     if (input_frequency <= 11025) { return 11025; }
@@ -144,27 +715,221 @@ static unsigned int select_output_frequency(unsigned int input_frequency)
     else { return 44100; }
 }
 
+/* Clamp the primary buffer size and target to the secondary buffer, and grow the primary buffer to match */
+static void apply_primary_buffer_size(struct sdl_backend* sdl_backend)
+{
+    if (sdl_backend->target < sdl_backend->secondary_buffer_size)
+        sdl_backend->target = sdl_backend->secondary_buffer_size;
+
+    if (sdl_backend->primary_buffer_size < sdl_backend->target)
+        sdl_backend->primary_buffer_size = sdl_backend->target;
+    if (sdl_backend->primary_buffer_size < sdl_backend->secondary_buffer_size * 2)
+        sdl_backend->primary_buffer_size = sdl_backend->secondary_buffer_size * 2;
+
+    resize_primary_buffer(sdl_backend, new_primary_buffer_size(sdl_backend));
+}
+
+/* Run silence through a resampler (level): this configures it for the current rates
+ * (which may allocate) outside of the callback, and clears the stale history of its last use. */
+static void prime_resampler(struct sdl_backend* sdl_backend, void* resampler, const struct resampler_interface* iresampler)
+{
+    enum { SILENCE_FRAMES = 256, SILENCE_BLOCKS = 8 };
+    /* zeroes are silence in every layout */
+    float silence[2 * SILENCE_FRAMES];
+    const void* planes[2] = { silence, silence + SILENCE_FRAMES };
+    int16_t output[2 * SILENCE_FRAMES];
+    uint64_t src_rate;
+    uint64_t dst_rate;
+    size_t i;
+
+    get_resample_rates(sdl_backend, &src_rate, &dst_rate);
+
+    memset(silence, 0, sizeof(silence));
+    for (i = 0; i < SILENCE_BLOCKS; ++i) {
+        if (sdl_backend->layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) {
+            iresampler->resample(resampler,
+                    silence, SILENCE_FRAMES * sdl_backend->input_frame_bytes, src_rate,
+                    output, sizeof(output), dst_rate);
+        }
+        else {
+            iresampler->resample_planar(resampler, sdl_backend->layout,
+                    planes, SILENCE_FRAMES * sdl_backend->input_frame_bytes, src_rate,
+                    output, sizeof(output), dst_rate);
+        }
+    }
+}
+
+/* Reserve the buffers of every new level, and prime the one the callback switches to */
+static void prepare_resampler_reload(struct sdl_backend* sdl_backend, struct resampler_reload* reload)
+{
+    size_t count = (reload->level_count != 0) ? reload->level_count : 1;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        reload->levels[i].iresampler->reserve(reload->levels[i].resampler,
+                sdl_backend->layout, sdl_backend->primary_buffer.size, sdl_backend->mix_buffer_size,
+                sdl_backend->low_latency);
+    }
+
+    prime_resampler(sdl_backend, reload->levels[0].resampler, reload->levels[0].iresampler);
+}
+
+static void release_resampler_levels(struct auto_resampler_level* levels, size_t level_count)
+{
+    size_t count = (level_count != 0) ? level_count : 1;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        levels[i].iresampler->release(levels[i].resampler);
+    }
+}
+
+/* Preallocate the resampler buffers for the current primary buffer, mix buffer and rates,
+ * so that the audio callback doesn't have to. The callback must not run meanwhile. */
+static void prepare_resamplers(struct sdl_backend* sdl_backend)
+{
+    if (sdl_backend->auto_level_count != 0) {
+        size_t i;
+
+        for (i = 0; i < sdl_backend->auto_level_count; ++i) {
+            sdl_backend->auto_levels[i].iresampler->reserve(sdl_backend->auto_levels[i].resampler,
+                    sdl_backend->layout, sdl_backend->primary_buffer.size, sdl_backend->mix_buffer_size,
+                    sdl_backend->low_latency);
+        }
+
+        /* a level prepared for the previous rates would reconfigure itself in the callback */
+        SDL_AtomicSet(&sdl_backend->auto_handover, AUTO_HANDOVER_IDLE);
+    }
+    else {
+        sdl_backend->iresampler->reserve(sdl_backend->resampler,
+                sdl_backend->layout, sdl_backend->primary_buffer.size, sdl_backend->mix_buffer_size,
+                sdl_backend->low_latency);
+    }
+
+    prime_resampler(sdl_backend, sdl_backend->resampler, sdl_backend->iresampler);
+
+    /* a pending resampler switch has to be prepared for the new rates too */
+    if (SDL_AtomicGet(&sdl_backend->reload_state) == RESAMPLER_RELOAD_READY) {
+        prepare_resampler_reload(sdl_backend, sdl_backend->reload);
+    }
+
+    /* priming replaced the history the steady input fast path relies on */
+    sdl_backend->steady_fed = 0;
+    sdl_backend->steady_phase = 0;
+}
+
+/* Adopt the resampler the callback switched to, and release the old one */
+static void finish_resampler_reload(struct sdl_backend* sdl_backend)
+{
+    struct resampler_reload* reload = sdl_backend->reload;
+    struct auto_resampler_level old_levels[AUTO_RESAMPLER_MAX_LEVELS];
+    size_t old_level_count = sdl_backend->auto_level_count;
+
+    memcpy(old_levels, sdl_backend->auto_levels, sizeof(old_levels));
+
+    SDL_LockAudio();
+    memcpy(sdl_backend->auto_levels, reload->levels, sizeof(sdl_backend->auto_levels));
+    sdl_backend->auto_level_count = reload->level_count;
+    if (reload->level_count != 0) {
+        init_resample_governor(&sdl_backend->governor, reload->level_count,
+                ConfigGetParamInt(sdl_backend->config, "RESAMPLE_BUDGET"), SDL_GetTicks());
+    }
+    SDL_AtomicSet(&sdl_backend->auto_handover, AUTO_HANDOVER_IDLE);
+    sdl_backend->reload = NULL;
+    SDL_AtomicSet(&sdl_backend->reload_state, RESAMPLER_RELOAD_IDLE);
+    SDL_UnlockAudio();
+
+    if (old_level_count != 0) {
+        release_resampler_levels(old_levels, old_level_count);
+    }
+    else {
+        reload->old_iresampler->release(reload->old_resampler);
+    }
+
+    strcpy(sdl_backend->resampler_id, reload->id);
+    DebugMessage(M64MSG_INFO, "Switched to resampler %s", reload->id);
+
+    free(reload);
+}
+
+/* Drop a pending resampler switch, or finish it if the callback already went through it */
+static void cancel_resampler_reload(struct sdl_backend* sdl_backend)
+{
+    struct resampler_reload* reload;
+
+    SDL_LockAudio();
+    if (SDL_AtomicGet(&sdl_backend->reload_state) == RESAMPLER_RELOAD_SWITCHED) {
+        /* too late */
+        SDL_UnlockAudio();
+        finish_resampler_reload(sdl_backend);
+        return;
+    }
+    reload = sdl_backend->reload;
+    sdl_backend->reload = NULL;
+    SDL_AtomicSet(&sdl_backend->reload_state, RESAMPLER_RELOAD_IDLE);
+    SDL_UnlockAudio();
+
+    if (reload != NULL) {
+        release_resampler_levels(reload->levels, reload->level_count);
+        free(reload);
+    }
+}
+
+static int acquire_sdl_subsystems(void)
+{
+    int result = 0;
+
+    SDL_AtomicLock(&l_sdl_subsystem_lock);
+    if (l_sdl_subsystem_users == 0)
+        result = SDL_InitSubSystem(SDL_INIT_AUDIO | SDL_INIT_TIMER);
+    if (result >= 0)
+        ++l_sdl_subsystem_users;
+    SDL_AtomicUnlock(&l_sdl_subsystem_lock);
+
+    return result;
+}
+
+static void release_sdl_subsystems(void)
+{
+    SDL_AtomicLock(&l_sdl_subsystem_lock);
+    if (--l_sdl_subsystem_users == 0)
+        SDL_QuitSubSystem(SDL_INIT_AUDIO | SDL_INIT_TIMER);
+    SDL_AtomicUnlock(&l_sdl_subsystem_lock);
+}
+
 static void sdl_init_audio_device(struct sdl_backend* sdl_backend)
 {
     SDL_AudioSpec desired, obtained;
+    uint64_t src_rate;
+    uint64_t dst_rate;
 
     sdl_backend->error = 0;
 
-    if (SDL_WasInit(SDL_INIT_AUDIO|SDL_INIT_TIMER) == (SDL_INIT_AUDIO|SDL_INIT_TIMER) )
+    /* the resampler the callback switched to is the one to configure for the new rates */
+    if (SDL_AtomicGet(&sdl_backend->reload_state) == RESAMPLER_RELOAD_SWITCHED) {
+        finish_resampler_reload(sdl_backend);
+    }
+
+    if (sdl_backend->sdl_initialized)
     {
         DebugMessage(M64MSG_VERBOSE, "sdl_init_audio_device(): SDL Audio sub-system already initialized.");
 
-        SDL_PauseAudio(1);
-        SDL_CloseAudio();
+        if (sdl_backend->device != 0)
+        {
+            SDL_PauseAudio(1);
+            SDL_CloseAudio();
+            sdl_backend->device = 0;
+        }
     }
     else
     {
-        if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_TIMER) < 0)
+        if (acquire_sdl_subsystems() < 0)
         {
             DebugMessage(M64MSG_ERROR, "Failed to initialize SDL audio subsystem.");
             sdl_backend->error = 1;
             return;
         }
+        sdl_backend->sdl_initialized = 1;
     }
 
     sdl_backend->paused_for_sync = 1;
@@ -173,6 +938,11 @@ static void sdl_init_audio_device(struct sdl_backend* sdl_backend)
     sdl_backend->primary_buffer_size = ConfigGetParamInt(sdl_backend->config, "PRIMARY_BUFFER_SIZE");
     sdl_backend->target = ConfigGetParamInt(sdl_backend->config, "PRIMARY_BUFFER_TARGET");
     sdl_backend->secondary_buffer_size = ConfigGetParamInt(sdl_backend->config, "SECONDARY_BUFFER_SIZE");
+    sdl_backend->requested_secondary_buffer_size = sdl_backend->secondary_buffer_size;
+    sdl_backend->low_latency = ConfigGetParamBool(sdl_backend->config, "LOW_LATENCY");
+    sdl_backend->rt_priority = ConfigGetParamInt(sdl_backend->config, "RT_PRIORITY");
+    sdl_backend->audio_cpu = ConfigGetParamInt(sdl_backend->config, "AUDIO_CPU");
+    sdl_backend->device_timeout_ms = ConfigGetParamInt(sdl_backend->config, "DEVICE_TIMEOUT_MS");
 
     DebugMessage(M64MSG_INFO,    "Initializing SDL audio subsystem...");
     DebugMessage(M64MSG_VERBOSE, "Primary buffer: %i output samples.", (uint32_t) sdl_backend->primary_buffer_size);
@@ -191,7 +961,8 @@ static void sdl_init_audio_device(struct sdl_backend* sdl_backend)
     DebugMessage(M64MSG_VERBOSE, "Requesting format: " AFMT_FMTSPEC ".", AFMT_ARGS(desired.format));
 
     /* Open the audio device */
-    if (SDL_OpenAudio(&desired, &obtained) < 0)
+    sdl_backend->device = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, 0);
+    if (sdl_backend->device == 0)
     {
         DebugMessage(M64MSG_ERROR, "Couldn't open audio: %s", SDL_GetError());
         sdl_backend->error = 1;
@@ -208,54 +979,137 @@ static void sdl_init_audio_device(struct sdl_backend* sdl_backend)
 
     /* adjust some variables given the obtained audio spec */
     sdl_backend->output_frequency = obtained.freq;
+
+    /* the device is still paused, no need to lock */
+    if (sdl_backend->dsp_chain != NULL) {
+        dsp_chain_set_frequency(sdl_backend->dsp_chain, obtained.freq);
+    }
     sdl_backend->secondary_buffer_size = obtained.samples;
 
-    if (sdl_backend->target < sdl_backend->secondary_buffer_size)
-        sdl_backend->target = sdl_backend->secondary_buffer_size;
+    /* allocate memory for audio buffers */
+    apply_primary_buffer_size(sdl_backend);
+    resize_mix_buffer(sdl_backend, sdl_backend->secondary_buffer_size * SDL_SAMPLE_BYTES);
 
-    if (sdl_backend->primary_buffer_size < sdl_backend->target)
-        sdl_backend->primary_buffer_size = sdl_backend->target;
-    if (sdl_backend->primary_buffer_size < sdl_backend->secondary_buffer_size * 2)
-        sdl_backend->primary_buffer_size = sdl_backend->secondary_buffer_size * 2;
+    /* the device is still paused, no need to lock */
+    prepare_resamplers(sdl_backend);
 
-    /* allocate memory for audio buffers */
-    resize_primary_buffer(sdl_backend, new_primary_buffer_size(sdl_backend));
-    sdl_backend->mix_buffer = realloc(sdl_backend->mix_buffer, sdl_backend->secondary_buffer_size * SDL_SAMPLE_BYTES);
+    /* any resampler switch crossfades, prefaulted like the mix buffer */
+    sdl_backend->xfade_buffer = realloc(sdl_backend->xfade_buffer, sdl_backend->mix_buffer_size);
+    memset(sdl_backend->xfade_buffer, 0, sdl_backend->mix_buffer_size);
+
+    /* the device is still paused, no need to lock */
+    init_concealment(&sdl_backend->concealment,
+            (size_t)ConfigGetParamInt(sdl_backend->config, "CONCEAL_MS") * sdl_backend->output_frequency / 1000);
+
+    /* real-time scheduling has to be set from the audio thread itself */
+    SDL_AtomicSet(&sdl_backend->audio_thread_setup_pending, sdl_backend->low_latency);
 
     /* preset the last callback time */
     if (sdl_backend->last_cb_time == 0) {
         sdl_backend->last_cb_time = SDL_GetTicks();
     }
 
+    /* until the first callback, the device is still paused */
+    get_resample_rates(sdl_backend, &src_rate, &dst_rate);
+    publish_timing(sdl_backend, SDL_GetPerformanceCounter(), sdl_backend->secondary_buffer_size, src_rate, dst_rate);
+
     DebugMessage(M64MSG_VERBOSE, "Frequency: %i", obtained.freq);
     DebugMessage(M64MSG_VERBOSE, "Format: " AFMT_FMTSPEC, AFMT_ARGS(obtained.format));
     DebugMessage(M64MSG_VERBOSE, "Channels: %i", obtained.channels);
     DebugMessage(M64MSG_VERBOSE, "Silence: %i", obtained.silence);
     DebugMessage(M64MSG_VERBOSE, "Samples: %i", obtained.samples);
     DebugMessage(M64MSG_VERBOSE, "Size: %i", obtained.size);
-
-    /* set playback volume */
-    SetPlaybackVolume();
 }
 
 static void release_audio_device(struct sdl_backend* sdl_backend)
 {
-    if (SDL_WasInit(SDL_INIT_AUDIO) != 0) {
+    if (sdl_backend->device != 0) {
         SDL_PauseAudio(1);
         SDL_CloseAudio();
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        sdl_backend->device = 0;
     }
 
-    if (SDL_WasInit(SDL_INIT_TIMER) != 0) {
-        SDL_QuitSubSystem(SDL_INIT_TIMER);
+    if (sdl_backend->sdl_initialized) {
+        release_sdl_subsystems();
+        sdl_backend->sdl_initialized = 0;
     }
 }
 
 
+static int is_auto_resampler_id(const char* resampler_id)
+{
+    return strncmp(resampler_id, "auto", 4) == 0 && (resampler_id[4] == '\0' || resampler_id[4] == ':');
+}
+
+/* Instantiate every level of RESAMPLE=auto[:ID,ID...] into auto_levels, returns the number of levels */
+static size_t init_auto_resampler(struct sdl_backend* sdl_backend, struct auto_resampler_level* auto_levels,
+        const char* resampler_id)
+{
+    const char* levels = (resampler_id[4] == ':') ? resampler_id + 5 : AUTO_RESAMPLER_LEVELS;
+    size_t count = 0;
+
+    while (*levels != '\0' && count < AUTO_RESAMPLER_MAX_LEVELS) {
+        struct auto_resampler_level* level = &auto_levels[count];
+        size_t len = strcspn(levels, ",");
+
+        if (len > 0 && len < sizeof(level->id)) {
+            memcpy(level->id, levels, len);
+            level->id[len] = '\0';
+
+            level->iresampler = get_iresampler(level->id, &level->resampler);
+            if (level->iresampler != NULL && level->resampler != NULL) {
+                ++count;
+            }
+        }
+
+        levels += len;
+        if (*levels == ',') {
+            ++levels;
+        }
+    }
+
+    DebugMessage(M64MSG_INFO, "Auto resampler: %u levels, budget %u%% of the callback period",
+            (unsigned int)count, (unsigned int)ConfigGetParamInt(sdl_backend->config, "RESAMPLE_BUDGET"));
+
+    return count;
+}
+
+/* Pick the PRIMARY_BUFFER_LAYOUT layout, if accepted by every resampler (level) */
+static unsigned int select_primary_buffer_layout(const char* name, unsigned int layouts)
+{
+    unsigned int layout;
+
+    if (strcmp(name, "planar") == 0) {
+        layout = (layouts & RESAMPLER_LAYOUT_F32_PLANAR) ? RESAMPLER_LAYOUT_F32_PLANAR : RESAMPLER_LAYOUT_S16_PLANAR;
+    }
+    else if (strcmp(name, "planar-f32") == 0) {
+        layout = RESAMPLER_LAYOUT_F32_PLANAR;
+    }
+    else if (strcmp(name, "planar-s16") == 0) {
+        layout = RESAMPLER_LAYOUT_S16_PLANAR;
+    }
+    else {
+        if (strcmp(name, "interleaved") != 0) {
+            DebugMessage(M64MSG_WARNING, "Unknown PRIMARY_BUFFER_LAYOUT %s; use interleaved", name);
+        }
+        return RESAMPLER_LAYOUT_S16_INTERLEAVED;
+    }
+
+    if ((layouts & layout) == 0) {
+        DebugMessage(M64MSG_WARNING, "Resampler doesn't accept PRIMARY_BUFFER_LAYOUT %s; use interleaved", name);
+        return RESAMPLER_LAYOUT_S16_INTERLEAVED;
+    }
+
+    DebugMessage(M64MSG_INFO, "Primary buffer layout: %s",
+            (layout == RESAMPLER_LAYOUT_F32_PLANAR) ? "planar-f32" : "planar-s16");
+
+    return layout;
+}
+
 static struct sdl_backend* init_sdl_backend(m64p_handle config,
                                             unsigned int default_frequency,
                                             unsigned int swap_channels,
-                                            unsigned int audio_sync,
+                                            const struct audio_sync_policy* sync_policy,
                                             const char* resampler_id)
 {
     /* allocate memory for sdl_backend */
@@ -267,39 +1121,101 @@ static struct sdl_backend* init_sdl_backend(m64p_handle config,
     /* reset sdl_backend */
     memset(sdl_backend, 0, sizeof(*sdl_backend));
 
+    sdl_backend->config = config;
+
     /* instanciate resampler */
     void* resampler = NULL;
-    const struct resampler_interface* iresampler = get_iresampler(resampler_id, &resampler);
-    if (iresampler == NULL) {
+    const struct resampler_interface* iresampler = NULL;
+
+    if (is_auto_resampler_id(resampler_id)) {
+        sdl_backend->auto_level_count = init_auto_resampler(sdl_backend, sdl_backend->auto_levels, resampler_id);
+        if (sdl_backend->auto_level_count != 0) {
+            resampler = sdl_backend->auto_levels[0].resampler;
+            iresampler = sdl_backend->auto_levels[0].iresampler;
+            init_resample_governor(&sdl_backend->governor, sdl_backend->auto_level_count,
+                    ConfigGetParamInt(config, "RESAMPLE_BUDGET"), SDL_GetTicks());
+        }
+    }
+    else {
+        iresampler = get_iresampler(resampler_id, &resampler);
+    }
+
+    /* resamplers return NULL when they can't allocate their state */
+    if (iresampler == NULL || resampler == NULL) {
+        DebugMessage(M64MSG_ERROR, "Couldn't create resampler %s", resampler_id);
         free(sdl_backend);
         return NULL;
     }
 
-    sdl_backend->config = config;
+    if (sdl_backend->auto_level_count != 0) {
+        unsigned int layouts = ~0u;
+        size_t i;
+
+        for (i = 0; i < sdl_backend->auto_level_count; ++i) {
+            layouts &= sdl_backend->auto_levels[i].iresampler->layouts;
+        }
+        sdl_backend->layout = select_primary_buffer_layout(ConfigGetParamString(config, "PRIMARY_BUFFER_LAYOUT"), layouts);
+    }
+    else {
+        sdl_backend->layout = select_primary_buffer_layout(ConfigGetParamString(config, "PRIMARY_BUFFER_LAYOUT"), iresampler->layouts);
+    }
+    sdl_backend->input_frame_bytes = get_resampler_frame_bytes(sdl_backend->layout);
+
+    sdl_backend->input_rate_num = default_frequency;
+    sdl_backend->input_rate_den = 1;
     sdl_backend->input_frequency = default_frequency;
     sdl_backend->swap_channels = swap_channels;
-    sdl_backend->audio_sync = audio_sync;
+    sdl_backend->sync_policy = *sync_policy;
     sdl_backend->paused_for_sync = 1;
     sdl_backend->speed_factor = 100;
+    SDL_AtomicSet(&sdl_backend->volume, SDL_MIX_MAXVOLUME);
     sdl_backend->resampler = resampler;
     sdl_backend->iresampler = iresampler;
+    strncpy(sdl_backend->resampler_id, resampler_id, sizeof(sdl_backend->resampler_id) - 1);
+
+    init_audio_stats_collector(&sdl_backend->stats);
+
+    strncpy(sdl_backend->dsp_chain_id, ConfigGetParamString(config, "DSP_CHAIN"), sizeof(sdl_backend->dsp_chain_id) - 1);
+    sdl_backend->dsp_chain = init_dsp_chain(sdl_backend->dsp_chain_id);
 
     sdl_init_audio_device(sdl_backend);
 
+    /* the device is still paused, no need to lock */
+    if (sdl_backend->error == 0) {
+        sdl_backend->latency_probe = start_latency_probe(
+                ConfigGetParamInt(config, "LATENCY_PROBE_MS"),
+                ConfigGetParamString(config, "LATENCY_PROBE_CAPTURE"));
+
+        if (ConfigGetParamString(config, "SHM_TAP_NAME")[0] != '\0') {
+            sdl_backend->shm_tap = start_shm_tap(
+                    ConfigGetParamString(config, "SHM_TAP_NAME"),
+                    ConfigGetParamInt(config, "SHM_TAP_FRAMES"));
+        }
+    }
+
     return sdl_backend;
 }
 
+static void read_sync_policy(m64p_handle config, struct audio_sync_policy* sync_policy)
+{
+    sync_policy->audio_sync = ConfigGetParamBool(config, "AUDIO_SYNC");
+    sync_policy->tolerance_ms = ConfigGetParamInt(config, "SYNC_TOLERANCE_MS");
+    sync_policy->resume_ms = ConfigGetParamInt(config, "SYNC_RESUME_MS");
+}
+
 struct sdl_backend* init_sdl_backend_from_config(m64p_handle config)
 {
     unsigned int default_frequency = ConfigGetParamInt(config, "DEFAULT_FREQUENCY");
     unsigned int swap_channels = ConfigGetParamBool(config, "SWAP_CHANNELS");
-    unsigned int audio_sync = ConfigGetParamBool(config, "AUDIO_SYNC");
     const char* resampler_id = ConfigGetParamString(config, "RESAMPLE");
+    struct audio_sync_policy sync_policy;
+
+    read_sync_policy(config, &sync_policy);
 
     return init_sdl_backend(config,
             default_frequency,
             swap_channels,
-            audio_sync,
+            &sync_policy,
             resampler_id);
 }
 
@@ -310,85 +1226,467 @@ void release_sdl_backend(struct sdl_backend* sdl_backend)
         return;
     }
 
+    sdl_stop_capture(sdl_backend);
+
     if (sdl_backend->error == 0) {
-        release_audio_device(sdl_backend);
+        /* detach latency probe before closing its capture device */
+        struct latency_probe* latency_probe;
+        struct shm_tap* shm_tap;
+
+        SDL_LockAudio();
+        latency_probe = sdl_backend->latency_probe;
+        sdl_backend->latency_probe = NULL;
+        shm_tap = sdl_backend->shm_tap;
+        sdl_backend->shm_tap = NULL;
+        SDL_UnlockAudio();
+
+        stop_latency_probe(latency_probe);
+        stop_shm_tap(shm_tap);
     }
 
+    release_audio_device(sdl_backend);
+
+    /* the callback is stopped, a pending resampler switch won't happen any more */
+    cancel_resampler_reload(sdl_backend);
+
     /* release primary buffer */
+    if (sdl_backend->primary_buffer_locked) {
+        osal_unlock_memory(sdl_backend->primary_buffer.data, sdl_backend->primary_buffer.size);
+    }
     release_cbuff(&sdl_backend->primary_buffer);
 
     /* release mix buffer */
+    if (sdl_backend->mix_buffer_locked) {
+        osal_unlock_memory(sdl_backend->mix_buffer, sdl_backend->mix_buffer_size);
+    }
     free(sdl_backend->mix_buffer);
 
+    free(sdl_backend->push_buffer);
+
+    release_dsp_chain(sdl_backend->dsp_chain);
+    release_concealment(&sdl_backend->concealment);
+
     /* release resampler */
-    sdl_backend->iresampler->release(sdl_backend->resampler);
+    if (sdl_backend->auto_level_count != 0) {
+        size_t i;
+
+        for (i = 0; i < sdl_backend->auto_level_count; ++i) {
+            sdl_backend->auto_levels[i].iresampler->release(sdl_backend->auto_levels[i].resampler);
+        }
+    }
+    else {
+        sdl_backend->iresampler->release(sdl_backend->resampler);
+    }
+    free(sdl_backend->xfade_buffer);
 
     /* release sdl backend */
     free(sdl_backend);
 }
 
-void sdl_set_frequency(struct sdl_backend* sdl_backend, unsigned int frequency)
+void sdl_set_input_rate(struct sdl_backend* sdl_backend, unsigned int num, unsigned int den)
 {
-    if (sdl_backend->error != 0)
+    if (sdl_backend->error != 0 || num == 0 || den == 0)
+        return;
+
+    sdl_backend->input_rate_num = num;
+    sdl_backend->input_rate_den = den;
+    sdl_backend->input_frequency = num / den;
+    AUDIO_PROBE2(input_rate, num, den);
+
+    if (sdl_backend->device_lost) {
+        /* the device is reopened for the new rate by the next synchronization */
+        resize_primary_buffer(sdl_backend, new_primary_buffer_size(sdl_backend));
+        sdl_backend->device_retry_time = SDL_GetTicks() - DEVICE_RETRY_MS;
         return;
+    }
 
-    sdl_backend->input_frequency = frequency;
     sdl_init_audio_device(sdl_backend);
 }
 
 
+/* Build the resampler for RESAMPLE=resampler_id and hand it over to the callback */
+static void start_resampler_reload(struct sdl_backend* sdl_backend, const char* resampler_id)
+{
+    struct resampler_reload* reload = malloc(sizeof(*reload));
+    unsigned int layouts = ~0u;
+    size_t i;
+
+    if (reload == NULL) {
+        return;
+    }
+    memset(reload, 0, sizeof(*reload));
+    strncpy(reload->id, resampler_id, sizeof(reload->id) - 1);
+
+    if (is_auto_resampler_id(resampler_id)) {
+        reload->level_count = init_auto_resampler(sdl_backend, reload->levels, resampler_id);
+        if (reload->level_count == 0) {
+            DebugMessage(M64MSG_WARNING, "No usable level in RESAMPLE %s; keep resampler %s",
+                    resampler_id, sdl_backend->resampler_id);
+            free(reload);
+            return;
+        }
+    }
+    else {
+        strncpy(reload->levels[0].id, resampler_id, sizeof(reload->levels[0].id) - 1);
+        reload->levels[0].iresampler = get_iresampler(resampler_id, &reload->levels[0].resampler);
+        if (reload->levels[0].resampler == NULL) {
+            DebugMessage(M64MSG_WARNING, "Couldn't create resampler %s; keep resampler %s",
+                    resampler_id, sdl_backend->resampler_id);
+            free(reload);
+            return;
+        }
+    }
+
+    for (i = 0; i < ((reload->level_count != 0) ? reload->level_count : 1); ++i) {
+        layouts &= reload->levels[i].iresampler->layouts;
+    }
+
+    /* the primary buffer layout is only chosen when the ROM is opened */
+    if ((layouts & sdl_backend->layout) == 0) {
+        DebugMessage(M64MSG_WARNING, "RESAMPLE %s doesn't accept the primary buffer layout; keep resampler %s",
+                resampler_id, sdl_backend->resampler_id);
+        release_resampler_levels(reload->levels, reload->level_count);
+        free(reload);
+        return;
+    }
+
+    /* only the emulation thread changes a fixed resampler */
+    if (sdl_backend->auto_level_count == 0) {
+        reload->old_resampler = sdl_backend->resampler;
+        reload->old_iresampler = sdl_backend->iresampler;
+    }
+
+    prepare_resampler_reload(sdl_backend, reload);
+
+    sdl_backend->reload = reload;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&sdl_backend->reload_state, RESAMPLER_RELOAD_READY);
+
+    DebugMessage(M64MSG_VERBOSE, "Switching to resampler %s", resampler_id);
+}
+
+void sdl_reload_config(struct sdl_backend* sdl_backend)
+{
+    m64p_handle config = sdl_backend->config;
+    const char* resampler_id = ConfigGetParamString(config, "RESAMPLE");
+    const char* dsp_chain_id = ConfigGetParamString(config, "DSP_CHAIN");
+    size_t conceal_frames;
+
+    if (sdl_backend->error != 0)
+        return;
+
+    if (SDL_AtomicGet(&sdl_backend->reload_state) == RESAMPLER_RELOAD_SWITCHED) {
+        finish_resampler_reload(sdl_backend);
+    }
+
+    read_sync_policy(config, &sdl_backend->sync_policy);
+    sdl_backend->swap_channels = ConfigGetParamBool(config, "SWAP_CHANNELS");
+
+    sdl_backend->device_timeout_ms = ConfigGetParamInt(config, "DEVICE_TIMEOUT_MS");
+
+    /* a lost device is reopened with the new parameters */
+    if (sdl_backend->device_lost) {
+        sdl_backend->device_retry_time = SDL_GetTicks() - DEVICE_RETRY_MS;
+    }
+    else if ((size_t)ConfigGetParamInt(config, "SECONDARY_BUFFER_SIZE") != sdl_backend->requested_secondary_buffer_size) {
+        /* SDL can't resize the hardware buffer of an open device */
+        DebugMessage(M64MSG_INFO, "Reopening audio device for the new secondary buffer size");
+        sdl_init_audio_device(sdl_backend);
+        if (sdl_backend->error != 0)
+            return;
+    }
+    else {
+        sdl_backend->primary_buffer_size = ConfigGetParamInt(config, "PRIMARY_BUFFER_SIZE");
+        sdl_backend->target = ConfigGetParamInt(config, "PRIMARY_BUFFER_TARGET");
+        apply_primary_buffer_size(sdl_backend);
+
+        /* the concealment window is reset when the device is reopened */
+        conceal_frames = (size_t)ConfigGetParamInt(config, "CONCEAL_MS") * sdl_backend->output_frequency / 1000;
+        if (conceal_frames != sdl_backend->concealment.frames) {
+            struct concealment concealment;
+            struct concealment old_concealment;
+
+            memset(&concealment, 0, sizeof(concealment));
+            init_concealment(&concealment, conceal_frames);
+
+            SDL_LockAudio();
+            old_concealment = sdl_backend->concealment;
+            sdl_backend->concealment = concealment;
+            SDL_UnlockAudio();
+
+            release_concealment(&old_concealment);
+        }
+    }
+
+    if (strcmp(dsp_chain_id, sdl_backend->dsp_chain_id) != 0) {
+        struct dsp_chain* dsp_chain = init_dsp_chain(dsp_chain_id);
+        struct dsp_chain* old_dsp_chain;
+
+        if (dsp_chain != NULL) {
+            dsp_chain_set_frequency(dsp_chain, sdl_backend->output_frequency);
+        }
+
+        SDL_LockAudio();
+        old_dsp_chain = sdl_backend->dsp_chain;
+        sdl_backend->dsp_chain = dsp_chain;
+        SDL_UnlockAudio();
+
+        release_dsp_chain(old_dsp_chain);
+        strncpy(sdl_backend->dsp_chain_id, dsp_chain_id, sizeof(sdl_backend->dsp_chain_id) - 1);
+        sdl_backend->dsp_chain_id[sizeof(sdl_backend->dsp_chain_id) - 1] = '\0';
+    }
+
+    /* read by the governor in the callback */
+    if (sdl_backend->auto_level_count != 0) {
+        SDL_LockAudio();
+        sdl_backend->governor.budget = ConfigGetParamInt(config, "RESAMPLE_BUDGET") / 100.0;
+        SDL_UnlockAudio();
+    }
+
+    /* only the last requested resampler matters */
+    if (strcmp(resampler_id, (sdl_backend->reload != NULL) ? sdl_backend->reload->id : sdl_backend->resampler_id) != 0) {
+        cancel_resampler_reload(sdl_backend);
+
+        if (strcmp(resampler_id, sdl_backend->resampler_id) != 0) {
+            start_resampler_reload(sdl_backend, resampler_id);
+        }
+    }
+}
+
+/* Output latency of the next pushed sample, as predicted by the synchronization model:
+ * expected primary buffer level at next callback plus SDL's hardware buffer */
+static double predicted_latency_ms(const struct sdl_backend* sdl_backend)
+{
+    size_t expected_level = estimate_audio_level(to_n64_bytes(sdl_backend, sdl_backend->primary_buffer.head),
+            sdl_backend->input_rate_num, sdl_backend->input_rate_den,
+            sdl_backend->output_frequency, sdl_backend->speed_factor,
+            sdl_backend->secondary_buffer_size, sdl_backend->last_cb_time, SDL_GetTicks());
+
+    return (double)(expected_level + sdl_backend->secondary_buffer_size) * 1000.0 / sdl_backend->output_frequency;
+}
+
+/* Write pushed samples to the primary buffer, in its layout.
+ * Returns the interleaved copy of the samples if there is one, NULL otherwise. */
+/* Hand the samples pushed by the game to the latency probe and the raw capture */
+static void inspect_input_samples(struct sdl_backend* sdl_backend, unsigned char* samples, size_t size)
+{
+    if (sdl_backend->latency_probe != NULL) {
+        latency_probe_push(sdl_backend->latency_probe, samples, size, predicted_latency_ms(sdl_backend));
+    }
+
+    if (sdl_backend->raw_capture != NULL) {
+        audio_capture_push(sdl_backend->raw_capture, samples, size, sdl_backend->input_frequency);
+    }
+}
+
+static const void* write_primary_buffer(struct sdl_backend* sdl_backend, const void* src, size_t size)
+{
+    size_t offset = sdl_backend->primary_buffer.head + sdl_backend->primary_buffer.staged;
+    unsigned char* samples;
+
+    if (sdl_backend->layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) {
+        samples = (unsigned char*)sdl_backend->primary_buffer.data + offset;
+        copy_n64_samples(samples, src, size, sdl_backend->swap_channels);
+        inspect_input_samples(sdl_backend, samples, size);
+    }
+    else {
+        unsigned char* left = (unsigned char*)cbuff_plane(&sdl_backend->primary_buffer, 0, 2) + offset / 2;
+        unsigned char* right = (unsigned char*)cbuff_plane(&sdl_backend->primary_buffer, 1, 2) + offset / 2;
+
+        /* straight to the planes in one pass, unless samples have to be inspected or altered first */
+        if (sdl_backend->latency_probe == NULL && sdl_backend->raw_capture == NULL) {
+            split_n64_samples(left, right, sdl_backend->layout == RESAMPLER_LAYOUT_F32_PLANAR,
+                    src, size, sdl_backend->swap_channels);
+            return NULL;
+        }
+
+        samples = sdl_backend->push_buffer;
+        copy_n64_samples(samples, src, size, sdl_backend->swap_channels);
+        inspect_input_samples(sdl_backend, samples, size);
+
+        if (sdl_backend->layout == RESAMPLER_LAYOUT_F32_PLANAR) {
+            deinterleave_s16_to_f32((float*)left, (float*)right, samples, size);
+        }
+        else {
+            deinterleave_s16((int16_t*)left, (int16_t*)right, samples, size);
+        }
+    }
+
+    return samples;
+}
+
 void sdl_push_samples(struct sdl_backend* sdl_backend, const void* src, size_t size)
 {
     size_t available;
+    size_t produced;
 
     if (sdl_backend->error != 0)
         return;
 
     /* truncate to full samples */
     if (size & 0x3) {
-        DebugMessage(M64MSG_WARNING, "sdl_push_samples: pushing non full samples: %zu bytes !", size);
+        HOT_LOG(M64MSG_WARNING, "sdl_push_samples: pushing non full samples: %zu bytes !", size, 0);
+        sdl_backend->stats.dropped_bytes += size & 0x3;
     }
     size = (size / 4) * 4;
+    produced = size / N64_SAMPLE_BYTES * sdl_backend->input_frame_bytes;
+
+    TRACE_BEGIN("sdl_push_samples");
+
+    /* latency probe and captures are only attached or detached from this thread */
+    if (sdl_backend->layout != RESAMPLER_LAYOUT_S16_INTERLEAVED
+            && (sdl_backend->latency_probe != NULL || sdl_backend->raw_capture != NULL)
+            && size > sdl_backend->push_buffer_size) {
+        sdl_backend->push_buffer = realloc(sdl_backend->push_buffer, size);
+        sdl_backend->push_buffer_size = size;
+    }
 
     /* We need to lock audio before accessing cbuff */
     SDL_LockAudio();
-    unsigned char* dst = cbuff_head(&sdl_backend->primary_buffer, &available);
-    if (size <= available)
+    cbuff_head(&sdl_backend->primary_buffer, &available);
+    if (produced <= available)
     {
-        /* Confusing logic but, for LittleEndian host using memcpy will result in swapped channels,
-         * whereas the other branch will result in non-swapped channels.
-         * For BigEndian host this logic is inverted, memcpy will result in non swapped channels
-         * and the other branch will result in swapped channels.
-         *
-         * This is due to the fact that the core stores 32bit words in native order in RDRAM.
-         * For instance N64 bytes "Lh Ll Rh Rl" will be stored as "Rl Rh Ll Lh" on LittleEndian host
-         * and therefore should the non-memcpy path to get non swapped channels,
-         * whereas on BigEndian host the bytes will be stored as "Lh Ll Rh Rl" and therefore
-         * memcpy path results in the non-swapped channels outcome.
-         */
-        if (sdl_backend->swap_channels ^ (SDL_BYTEORDER == SDL_BIG_ENDIAN)) {
-            memcpy(dst, src, size);
+        const void* samples = write_primary_buffer(sdl_backend, src, size);
+
+        if (sdl_backend->speculating) {
+            /* the steady span is only extended by queued samples, see sdl_end_speculation */
+            stage_cbuff_data(&sdl_backend->primary_buffer, produced);
         }
         else {
-            size_t i;
-            for (i = 0 ; i < size ; i += 4 )
-            {
-                memcpy(dst + i + 0, (const unsigned char*)src + i + 2, 2); /* Left */
-                memcpy(dst + i + 2, (const unsigned char*)src + i + 0, 2); /* Right */
+            uint32_t frame = sdl_backend->steady_frame;
+            int steady;
+
+            if (samples != NULL) {
+                steady = is_steady_block(samples, size, &frame);
+            }
+            else {
+                /* N64 samples, the steady frame is then put in SDL order */
+                steady = is_steady_block(src, size, &frame);
+                if (steady && size != 0) {
+                    uint32_t n64_frame = frame;
+                    copy_n64_samples(&frame, &n64_frame, N64_SAMPLE_BYTES, sdl_backend->swap_channels);
+                }
             }
-        }
 
-        produce_cbuff_data(&sdl_backend->primary_buffer, size);
+            /* extend or restart the steady span */
+            if (!steady) {
+                sdl_backend->steady_start = sdl_backend->primary_buffer.head + produced;
+            }
+            else if (frame != sdl_backend->steady_frame) {
+                sdl_backend->steady_start = sdl_backend->primary_buffer.head;
+                sdl_backend->steady_frame = frame;
+                sdl_backend->steady_fed = 0;
+            }
+
+            produce_cbuff_data(&sdl_backend->primary_buffer, produced);
+            sdl_backend->pushed_bytes += produced;
+        }
     }
+    else
+    {
+        ++sdl_backend->stats.overflows;
+        sdl_backend->stats.dropped_bytes += size;
+        TRACE_INSTANT("overflow");
+        AUDIO_PROBE2(overflow, size, to_n64_bytes(sdl_backend, available));
+    }
+    publish_buffered_bytes(sdl_backend);
     SDL_UnlockAudio();
 
-    if (size > available)
+    TRACE_COUNTER("primary buffer bytes", sdl_backend->primary_buffer.head);
+    AUDIO_PROBE3(push, size, to_n64_bytes(sdl_backend, sdl_backend->primary_buffer.head), sdl_backend->input_frequency);
+    TRACE_END("sdl_push_samples");
+
+    if (produced > available)
     {
-        DebugMessage(M64MSG_WARNING, "sdl_push_samples: pushing %zu bytes, but only %zu available !", size, available);
+        HOT_LOG(M64MSG_WARNING, "sdl_push_samples: pushing %zu bytes, but only %zu available !", produced, available);
     }
 }
 
 
+void sdl_save_checkpoint(struct sdl_backend* sdl_backend, struct audio_checkpoint* checkpoint)
+{
+    checkpoint->pushed = sdl_backend->pushed_bytes;
+    checkpoint->input_rate_num = sdl_backend->input_rate_num;
+    checkpoint->input_rate_den = sdl_backend->input_rate_den;
+    checkpoint->speed_factor = sdl_backend->speed_factor;
+}
+
+void sdl_restore_checkpoint(struct sdl_backend* sdl_backend, const struct audio_checkpoint* checkpoint)
+{
+    uint64_t pushed = (sdl_backend->pushed_bytes > checkpoint->pushed)
+        ? sdl_backend->pushed_bytes - checkpoint->pushed
+        : 0;
+    size_t staged;
+    size_t dropped;
+    size_t played = 0;
+
+    if (sdl_backend->error != 0)
+        return;
+
+    SDL_LockAudio();
+    staged = sdl_backend->primary_buffer.staged;
+    discard_cbuff_data(&sdl_backend->primary_buffer);
+
+    /* what the callback consumed is being played, and can't be taken back */
+    if (pushed > sdl_backend->primary_buffer.head) {
+        played = (size_t)(pushed - sdl_backend->primary_buffer.head);
+        dropped = sdl_backend->primary_buffer.head;
+    }
+    else {
+        dropped = (size_t)pushed;
+    }
+    unproduce_cbuff_data(&sdl_backend->primary_buffer, dropped);
+
+    if (sdl_backend->steady_start > sdl_backend->primary_buffer.head) {
+        sdl_backend->steady_start = sdl_backend->primary_buffer.head;
+    }
+    publish_buffered_bytes(sdl_backend);
+    SDL_UnlockAudio();
+
+    sdl_backend->pushed_bytes -= dropped;
+    sdl_backend->speculating = 0;
+    sdl_backend->stats.rollback_dropped_bytes += to_n64_bytes(sdl_backend, staged + dropped);
+    sdl_backend->stats.rollback_played_bytes += to_n64_bytes(sdl_backend, played);
+
+    if (checkpoint->input_rate_num != sdl_backend->input_rate_num || checkpoint->input_rate_den != sdl_backend->input_rate_den) {
+        sdl_set_input_rate(sdl_backend, checkpoint->input_rate_num, checkpoint->input_rate_den);
+    }
+    if (checkpoint->speed_factor != sdl_backend->speed_factor) {
+        sdl_set_speed_factor(sdl_backend, checkpoint->speed_factor);
+    }
+}
+
+void sdl_begin_speculation(struct sdl_backend* sdl_backend)
+{
+    sdl_backend->speculating = 1;
+}
+
+void sdl_end_speculation(struct sdl_backend* sdl_backend, int commit)
+{
+    size_t staged;
+
+    SDL_LockAudio();
+    staged = sdl_backend->primary_buffer.staged;
+    if (commit) {
+        commit_cbuff_data(&sdl_backend->primary_buffer);
+        /* not inspected, so not part of the steady span */
+        sdl_backend->steady_start = sdl_backend->primary_buffer.head;
+    }
+    else {
+        discard_cbuff_data(&sdl_backend->primary_buffer);
+    }
+    publish_buffered_bytes(sdl_backend);
+    SDL_UnlockAudio();
+
+    if (commit) {
+        sdl_backend->pushed_bytes += staged;
+    }
+    else {
+        sdl_backend->stats.rollback_dropped_bytes += to_n64_bytes(sdl_backend, staged);
+    }
+    sdl_backend->speculating = 0;
+}
+
 static size_t estimate_level_at_next_audio_cb(struct sdl_backend* sdl_backend)
 {
     size_t available;
@@ -397,52 +1695,233 @@ static size_t estimate_level_at_next_audio_cb(struct sdl_backend* sdl_backend)
     /* NOTE: given that we only access "available" counter from cbuff, we don't need to protect it's access with LockAudio/UnlockAudio */
     cbuff_tail(&sdl_backend->primary_buffer, &available);
 
-    /* Start by calculating the current Primary buffer fullness in terms of output samples */
-    size_t expected_level = (size_t)(((int64_t)(available/N64_SAMPLE_BYTES) * sdl_backend->output_frequency * 100) / (sdl_backend->input_frequency * sdl_backend->speed_factor));
+    return estimate_audio_level(to_n64_bytes(sdl_backend, available),
+            sdl_backend->input_rate_num, sdl_backend->input_rate_den,
+            sdl_backend->output_frequency, sdl_backend->speed_factor,
+            sdl_backend->secondary_buffer_size, sdl_backend->last_cb_time, now);
+}
 
-    /* Next, extrapolate to the buffer level at the expected time of the next audio callback, assuming that the
-       buffer is filled at the same rate as the output frequency */
-    unsigned int expected_next_cb_time = sdl_backend->last_cb_time + ((1000 * sdl_backend->secondary_buffer_size) / sdl_backend->output_frequency);
+/* Prepare the resampler level requested by the callback */
+static void prepare_auto_resampler(struct sdl_backend* sdl_backend)
+{
+    int handover = SDL_AtomicGet(&sdl_backend->auto_handover);
+    struct auto_resampler_level* level;
 
-    if (now < expected_next_cb_time) {
-        expected_level += (expected_next_cb_time - now) * sdl_backend->output_frequency / 1000;
+    if ((handover & AUTO_HANDOVER_PHASE_MASK) != AUTO_HANDOVER_REQUESTED) {
+        return;
     }
 
-    return expected_level;
+    level = &sdl_backend->auto_levels[handover & AUTO_HANDOVER_LEVEL_MASK];
+    SDL_AtomicSet(&sdl_backend->auto_handover, AUTO_HANDOVER_PREPARING | (handover & AUTO_HANDOVER_LEVEL_MASK));
+
+    prime_resampler(sdl_backend, level->resampler, level->iresampler);
+
+    DebugMessage(M64MSG_VERBOSE, "Auto resampler: switching to %s", level->id);
+
+    SDL_AtomicSet(&sdl_backend->auto_handover, AUTO_HANDOVER_READY | (handover & AUTO_HANDOVER_LEVEL_MASK));
+}
+
+static void lose_audio_device(struct sdl_backend* sdl_backend, unsigned int now, const char* reason)
+{
+    DebugMessage(M64MSG_WARNING, "Audio device %s; keep running on a virtual clock until it can be reopened", reason);
+
+    if (sdl_backend->device != 0) {
+        SDL_PauseAudio(1);
+        SDL_CloseAudio();
+        sdl_backend->device = 0;
+    }
+
+    AUDIO_PROBE0(device_lost);
+    ++sdl_backend->stats.device_losses;
+    sdl_backend->device_lost = 1;
+    sdl_backend->virtual_start = now;
+    sdl_backend->virtual_frames = 0;
+    sdl_backend->device_retry_time = now;
+}
+
+/* Tell whether the device went away (SDL disables removed devices) or starves the callback */
+static void check_audio_device(struct sdl_backend* sdl_backend, unsigned int now)
+{
+    unsigned int since;
+
+    if (SDL_GetAudioDeviceStatus(sdl_backend->device) == SDL_AUDIO_STOPPED) {
+        lose_audio_device(sdl_backend, now, "removed");
+        return;
+    }
+
+    /* callbacks are only expected while playing */
+    if (sdl_backend->paused_for_sync || sdl_backend->device_timeout_ms == 0) {
+        return;
+    }
+
+    since = ((int)(sdl_backend->last_cb_time - sdl_backend->unpause_time) > 0)
+        ? sdl_backend->last_cb_time
+        : sdl_backend->unpause_time;
+
+    if (now - since > sdl_backend->device_timeout_ms) {
+        lose_audio_device(sdl_backend, now, "stopped playing");
+    }
+}
+
+/* Without a device, consume the primary buffer as the callbacks would,
+ * so that synchronization keeps pacing the emulation at full speed */
+static void drain_virtual_clock(struct sdl_backend* sdl_backend, unsigned int now)
+{
+    uint64_t due;
+    uint64_t frames;
+    uint64_t src_rate;
+    uint64_t dst_rate;
+    size_t available;
+    size_t consumed;
+
+    /* there would be no callback either */
+    if (sdl_backend->paused_for_sync) {
+        sdl_backend->virtual_start = now;
+        sdl_backend->virtual_frames = 0;
+        return;
+    }
+
+    /* whole callbacks only */
+    due = (uint64_t)(now - sdl_backend->virtual_start) * sdl_backend->output_frequency / 1000;
+    frames = (due - sdl_backend->virtual_frames) / sdl_backend->secondary_buffer_size * sdl_backend->secondary_buffer_size;
+    if (frames == 0) {
+        return;
+    }
+
+    get_resample_rates(sdl_backend, &src_rate, &dst_rate);
+    cbuff_tail(&sdl_backend->primary_buffer, &available);
+
+    consumed = (size_t)(frames * src_rate / dst_rate) * sdl_backend->input_frame_bytes;
+    if (consumed > available) {
+        consumed = available;
+    }
+
+    /* the callback is gone, no need to lock */
+    consume_resampled(sdl_backend, consumed);
+
+    sdl_backend->virtual_frames += frames;
+    sdl_backend->stats.virtual_callbacks += frames / sdl_backend->secondary_buffer_size;
+    sdl_backend->last_cb_time = now;
+
+    publish_buffered_bytes(sdl_backend);
+    publish_timing(sdl_backend, SDL_GetPerformanceCounter(), sdl_backend->secondary_buffer_size, src_rate, dst_rate);
+}
+
+static void recover_audio_device(struct sdl_backend* sdl_backend, unsigned int now)
+{
+    if (now - sdl_backend->device_retry_time < DEVICE_RETRY_MS) {
+        return;
+    }
+    sdl_backend->device_retry_time = now;
+
+    /* a negative count means SDL can't list devices, the default one may still open */
+    if (SDL_GetNumAudioDevices(0) == 0) {
+        return;
+    }
+
+    sdl_init_audio_device(sdl_backend);
+    if (sdl_backend->error != 0) {
+        /* keep going on the virtual clock */
+        sdl_backend->error = 0;
+        return;
+    }
+
+    AUDIO_PROBE0(device_reopened);
+    ++sdl_backend->stats.device_recoveries;
+    sdl_backend->device_lost = 0;
+    DebugMessage(M64MSG_INFO, "Audio device reopened");
 }
 
 void sdl_synchronize_audio(struct sdl_backend* sdl_backend)
 {
-    enum { TOLERANCE_MS = 10 };
+    unsigned int wait_time = 0;
+    unsigned int now = SDL_GetTicks();
+    size_t expected_level;
+    uint32_t latency_ms;
+    enum audio_sync_action action;
 
-    size_t expected_level = estimate_level_at_next_audio_cb(sdl_backend);
+    /* speculative frames run as fast as they can, the queued ones are paced */
+    if (sdl_backend->speculating) {
+        return;
+    }
 
-    /* If the expected value of the Primary Buffer Fullness at the time of the next audio callback is more than 10
-       milliseconds ahead of our target buffer fullness level, then insert a delay now */
-    if (sdl_backend->audio_sync && expected_level >= sdl_backend->target + sdl_backend->output_frequency * TOLERANCE_MS / 1000)
-    {
-        /* Core is ahead of SDL audio thread,
-         * delay emulation to allow the SDL audio thread to catch up */
-        unsigned int wait_time = (expected_level - sdl_backend->target) * 1000 / sdl_backend->output_frequency;
+    if (sdl_backend->error == 0) {
+        if (!sdl_backend->device_lost) {
+            check_audio_device(sdl_backend, now);
+        }
+        if (sdl_backend->device_lost) {
+            drain_virtual_clock(sdl_backend, now);
+            recover_audio_device(sdl_backend, now);
+        }
+    }
 
-        if (sdl_backend->paused_for_sync) { SDL_PauseAudio(0); }
-        sdl_backend->paused_for_sync = 0;
+    expected_level = estimate_level_at_next_audio_cb(sdl_backend);
 
-        SDL_Delay(wait_time);
+    /* report what happened on hot paths since last time */
+    hot_log_flush(0);
+
+    if (SDL_AtomicGet(&sdl_backend->audio_thread_report_pending)) {
+        SDL_AtomicSet(&sdl_backend->audio_thread_report_pending, 0);
+        report_audio_thread_setup(sdl_backend);
     }
-    else if (expected_level < sdl_backend->secondary_buffer_size)
-    {
-        /* Core is behind SDL audio thread (predicting an underflow),
-         * pause the audio to let the Core catch up */
-        if (!sdl_backend->paused_for_sync) { SDL_PauseAudio(1); }
-        sdl_backend->paused_for_sync = 1;
+
+    if (SDL_AtomicGet(&sdl_backend->reload_state) == RESAMPLER_RELOAD_SWITCHED) {
+        finish_resampler_reload(sdl_backend);
     }
-    else
+
+    if (sdl_backend->auto_level_count != 0) {
+        prepare_auto_resampler(sdl_backend);
+    }
+
+    TRACE_COUNTER("expected level", expected_level);
+
+    /* expected output latency is the primary buffer content plus SDL's hardware buffer */
+    latency_ms = (uint32_t)((uint64_t)(expected_level + sdl_backend->secondary_buffer_size) * 1000 / sdl_backend->output_frequency);
+    stats_add_level(&sdl_backend->stats, expected_level, sdl_backend->target, latency_ms);
+
+    action = audio_sync_decide(&sdl_backend->sync_policy,
+            expected_level, sdl_backend->target, sdl_backend->secondary_buffer_size,
+            sdl_backend->output_frequency, sdl_backend->paused_for_sync, &wait_time);
+    AUDIO_PROBE4(sync, action, wait_time, expected_level, latency_ms);
+
+    switch (action)
     {
-        /* Expected fullness is within tolerance,
-         * audio thread is running */
-        if (sdl_backend->paused_for_sync) { SDL_PauseAudio(0); }
+    case AUDIO_SYNC_DELAY:
+        if (sdl_backend->paused_for_sync) {
+            SDL_PauseAudio(0);
+            sdl_backend->unpause_time = now;
+            TRACE_INSTANT("unpause");
+            AUDIO_PROBE1(unpause, expected_level);
+        }
+        sdl_backend->paused_for_sync = 0;
+
+        ++sdl_backend->stats.sync_sleeps;
+        sdl_backend->stats.sync_sleep_ms += wait_time;
+
+        TRACE_BEGIN("sync sleep");
+        SDL_Delay(wait_time);
+        TRACE_END("sync sleep");
+        break;
+
+    case AUDIO_SYNC_PAUSE:
+        if (!sdl_backend->paused_for_sync) {
+            SDL_PauseAudio(1);
+            ++sdl_backend->stats.sync_pauses;
+            TRACE_INSTANT("pause");
+            AUDIO_PROBE1(pause, expected_level);
+        }
+        sdl_backend->paused_for_sync = 1;
+        break;
+
+    case AUDIO_SYNC_RUN:
+        if (sdl_backend->paused_for_sync) {
+            SDL_PauseAudio(0);
+            sdl_backend->unpause_time = now;
+            TRACE_INSTANT("unpause");
+            AUDIO_PROBE1(unpause, expected_level);
+        }
         sdl_backend->paused_for_sync = 0;
+        break;
     }
 }
 
@@ -452,7 +1931,113 @@ void sdl_set_speed_factor(struct sdl_backend* sdl_backend, unsigned int speed_fa
         return;
 
     sdl_backend->speed_factor = speed_factor;
+    AUDIO_PROBE1(speed_factor, speed_factor);
 
     /* we need a different size primary buffer to store the N64 samples when the speed changes */
     resize_primary_buffer(sdl_backend, new_primary_buffer_size(sdl_backend));
+
+    /* and resamplers reserved and configured for it and the new rate */
+    if (sdl_backend->error == 0 && !sdl_backend->device_lost) {
+        SDL_LockAudio();
+        prepare_resamplers(sdl_backend);
+        SDL_UnlockAudio();
+    }
+}
+
+void sdl_set_volume(struct sdl_backend* sdl_backend, int sdl_volume)
+{
+    /* read by the audio callback without locking */
+    SDL_AtomicSet(&sdl_backend->volume, sdl_volume);
+}
+
+void sdl_get_timing(struct sdl_backend* sdl_backend, struct audio_timing* timing)
+{
+    struct callback_timing last;
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t now;
+    uint64_t elapsed_us;
+    uint64_t period_us;
+    uint64_t buffered_frames;
+    int seq;
+
+    /* retry while the callback is publishing */
+    do {
+        seq = SDL_AtomicGet(&sdl_backend->timing_seq);
+        SDL_MemoryBarrierAcquire();
+        last = sdl_backend->timing;
+        SDL_MemoryBarrierAcquire();
+    } while ((seq & 1) != 0 || seq != SDL_AtomicGet(&sdl_backend->timing_seq));
+
+    now = SDL_GetPerformanceCounter();
+
+    memset(timing, 0, sizeof(*timing));
+    timing->timestamp = now;
+    timing->timestamp_frequency = frequency;
+
+    if (last.output_frequency == 0 || last.src_rate == 0) {
+        return;
+    }
+
+    elapsed_us = (now - last.counter) * 1000000 / frequency;
+    period_us = last.frames * 1000000 / last.output_frequency;
+    buffered_frames = (uint64_t)SDL_AtomicGet(&sdl_backend->buffered_bytes) / sdl_backend->input_frame_bytes
+        * last.dst_rate / last.src_rate;
+
+    timing->buffered_us = buffered_frames * 1000000 / last.output_frequency;
+    timing->next_callback_us = (elapsed_us < period_us) ? period_us - elapsed_us : 0;
+    timing->device_latency_us = period_us;
+    timing->latency_us = timing->next_callback_us + timing->device_latency_us + timing->buffered_us;
+    timing->resample_ratio = (double)last.src_rate / (double)last.dst_rate;
+    timing->output_frequency = last.output_frequency;
+}
+
+void sdl_get_stats(struct sdl_backend* sdl_backend, struct audio_stats* stats)
+{
+    /* callback counters are updated from the audio thread */
+    SDL_LockAudio();
+    get_audio_stats(&sdl_backend->stats, stats);
+    SDL_UnlockAudio();
+}
+
+int sdl_start_capture(struct sdl_backend* sdl_backend, const char* output_file, const char* raw_file)
+{
+    struct audio_capture* output_capture = NULL;
+    struct audio_capture* raw_capture = NULL;
+    int error = 0;
+
+    sdl_stop_capture(sdl_backend);
+
+    if (output_file != NULL && output_file[0] != '\0') {
+        output_capture = start_audio_capture(output_file);
+        error |= (output_capture == NULL);
+    }
+
+    if (raw_file != NULL && raw_file[0] != '\0') {
+        raw_capture = start_audio_capture(raw_file);
+        error |= (raw_capture == NULL);
+    }
+
+    SDL_LockAudio();
+    sdl_backend->output_capture = output_capture;
+    sdl_backend->raw_capture = raw_capture;
+    SDL_UnlockAudio();
+
+    return error ? -1 : 0;
+}
+
+void sdl_stop_capture(struct sdl_backend* sdl_backend)
+{
+    struct audio_capture* output_capture;
+    struct audio_capture* raw_capture;
+
+    /* detach captures, so that no one pushes to them anymore */
+    SDL_LockAudio();
+    output_capture = sdl_backend->output_capture;
+    raw_capture = sdl_backend->raw_capture;
+    sdl_backend->output_capture = NULL;
+    sdl_backend->raw_capture = NULL;
+    SDL_UnlockAudio();
+
+    stop_audio_capture(output_capture);
+    stop_audio_capture(raw_capture);
 }
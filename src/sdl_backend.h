@@ -24,18 +24,50 @@
 
 #include <stddef.h>
 
+struct audio_checkpoint;
+struct audio_stats;
+struct audio_timing;
 struct sdl_backend;
 
 struct sdl_backend* init_sdl_backend_from_config(m64p_handle config);
 
 void release_sdl_backend(struct sdl_backend* sdl_backend);
 
-void sdl_set_frequency(struct sdl_backend* sdl_backend, unsigned int frequency);
+/* Set the input rate to num/den Hz */
+void sdl_set_input_rate(struct sdl_backend* sdl_backend, unsigned int num, unsigned int den);
 
 void sdl_push_samples(struct sdl_backend* sdl_backend, const void* src, size_t size);
 
 void sdl_synchronize_audio(struct sdl_backend* sdl_backend);
 
+void sdl_save_checkpoint(struct sdl_backend* sdl_backend, struct audio_checkpoint* checkpoint);
+
+/* Take back the samples pushed since the checkpoint, unless played already, and end speculation */
+void sdl_restore_checkpoint(struct sdl_backend* sdl_backend, const struct audio_checkpoint* checkpoint);
+
+/* Stage pushed samples until sdl_end_speculation queues (commit) or drops them */
+void sdl_begin_speculation(struct sdl_backend* sdl_backend);
+
+void sdl_end_speculation(struct sdl_backend* sdl_backend, int commit);
+
+/* Apply the current config parameters to the running backend: synchronization, buffer sizes
+ * and targets, concealment and post-processing take effect at once (a new SECONDARY_BUFFER_SIZE
+ * reopens the device), and a new RESAMPLE is crossfaded to over the next audio callback.
+ * PRIMARY_BUFFER_LAYOUT and the low latency parameters wait for the next RomOpen. */
+void sdl_reload_config(struct sdl_backend* sdl_backend);
+
 void sdl_set_speed_factor(struct sdl_backend* sdl_backend, unsigned int speed_factor);
 
+/* sdl_volume is in the 0..SDL_MIX_MAXVOLUME range */
+void sdl_set_volume(struct sdl_backend* sdl_backend, int sdl_volume);
+
+void sdl_get_stats(struct sdl_backend* sdl_backend, struct audio_stats* stats);
+
+/* Lock free, may be called from any thread */
+void sdl_get_timing(struct sdl_backend* sdl_backend, struct audio_timing* timing);
+
+int sdl_start_capture(struct sdl_backend* sdl_backend, const char* output_file, const char* raw_file);
+
+void sdl_stop_capture(struct sdl_backend* sdl_backend);
+
 #endif
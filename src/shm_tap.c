@@ -0,0 +1,158 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - shm_tap.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "osal_shm.h"
+#include "shm_tap.h"
+
+#include "m64p_types.h"
+
+/* must be a power of two */
+enum { SHM_TAP_BLOCK_CAPACITY = 256 };
+/* 16-bit stereo */
+enum { SHM_TAP_CHANNELS = 2 };
+enum { SHM_TAP_FRAME_BYTES = 4 };
+/* larger than the largest SDL buffer, so that a callback always fits */
+enum { SHM_TAP_MIN_FRAMES = 16384 };
+
+struct shm_tap
+{
+    struct osal_shm* shm;
+
+    struct shm_tap_header* header;
+    struct shm_tap_block* blocks;
+    unsigned char* frames;
+
+    /* writer side copies of the published counters */
+    uint32_t write_frame;
+    uint32_t write_block;
+};
+
+static size_t align_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+struct shm_tap* start_shm_tap(const char* name, size_t frames)
+{
+    struct shm_tap* tap;
+    size_t frame_capacity = SHM_TAP_MIN_FRAMES;
+    size_t blocks_offset = align_up(sizeof(struct shm_tap_header), 64);
+    size_t frames_offset = align_up(blocks_offset + SHM_TAP_BLOCK_CAPACITY * sizeof(struct shm_tap_block), 64);
+    void* data;
+
+    while (frame_capacity < frames && frame_capacity < ((size_t)1 << 24)) {
+        frame_capacity <<= 1;
+    }
+
+    tap = malloc(sizeof(*tap));
+    if (tap == NULL) {
+        DebugMessage(M64MSG_ERROR, "Shared memory tap: failed to allocate memory");
+        return NULL;
+    }
+    memset(tap, 0, sizeof(*tap));
+
+    tap->shm = osal_shm_create(name, frames_offset + frame_capacity * SHM_TAP_FRAME_BYTES, &data);
+    if (tap->shm == NULL) {
+        DebugMessage(M64MSG_ERROR, "Shared memory tap: couldn't create %s", name);
+        free(tap);
+        return NULL;
+    }
+
+    tap->header = (struct shm_tap_header*)data;
+    tap->blocks = (struct shm_tap_block*)((unsigned char*)data + blocks_offset);
+    tap->frames = (unsigned char*)data + frames_offset;
+
+    tap->header->version = SHM_TAP_VERSION;
+    tap->header->blocks_offset = (uint32_t)blocks_offset;
+    tap->header->block_capacity = SHM_TAP_BLOCK_CAPACITY;
+    tap->header->frames_offset = (uint32_t)frames_offset;
+    tap->header->frame_capacity = (uint32_t)frame_capacity;
+    tap->header->channels = SHM_TAP_CHANNELS;
+    tap->header->frame_size = SHM_TAP_FRAME_BYTES;
+
+    /* readers check the magic last */
+    SDL_MemoryBarrierRelease();
+    tap->header->magic = SHM_TAP_MAGIC;
+
+    DebugMessage(M64MSG_INFO, "Shared memory tap: publishing output to %s (%u frames)",
+            name, (unsigned int)frame_capacity);
+
+    return tap;
+}
+
+void stop_shm_tap(struct shm_tap* tap)
+{
+    if (tap == NULL) {
+        return;
+    }
+
+    SDL_MemoryBarrierRelease();
+    tap->header->closed = 1;
+
+    DebugMessage(M64MSG_INFO, "Shared memory tap: %u frames in %u blocks published",
+            (unsigned int)tap->write_frame, (unsigned int)tap->write_block);
+
+    osal_shm_destroy(tap->shm);
+    free(tap);
+}
+
+void shm_tap_push(struct shm_tap* tap, const void* data, size_t size, unsigned int frequency)
+{
+    struct shm_tap_header* header = tap->header;
+    struct shm_tap_block* block = &tap->blocks[tap->write_block & (SHM_TAP_BLOCK_CAPACITY - 1)];
+    uint32_t capacity = header->frame_capacity;
+    uint32_t frames = (uint32_t)(size / SHM_TAP_FRAME_BYTES);
+    uint32_t pos;
+    uint32_t first;
+
+    if (frames > capacity) {
+        frames = capacity;
+    }
+
+    /* let readers know which frames are about to be overwritten */
+    header->reserve_frame = tap->write_frame + frames;
+    block->stamp = 0;
+    SDL_MemoryBarrierRelease();
+
+    /* copy in at most 2 parts, around the end of the ring */
+    pos = tap->write_frame & (capacity - 1);
+    first = (frames < capacity - pos) ? frames : capacity - pos;
+    memcpy(tap->frames + pos * SHM_TAP_FRAME_BYTES, data, first * SHM_TAP_FRAME_BYTES);
+    memcpy(tap->frames, (const unsigned char*)data + first * SHM_TAP_FRAME_BYTES, (frames - first) * SHM_TAP_FRAME_BYTES);
+
+    block->first_frame = tap->write_frame;
+    block->frames = frames;
+    block->frequency = frequency;
+    block->timestamp_ns = osal_shm_clock_ns();
+    SDL_MemoryBarrierRelease();
+    block->stamp = tap->write_block + 1;
+
+    tap->write_frame += frames;
+    tap->write_block += 1;
+    SDL_MemoryBarrierRelease();
+    header->write_frame = tap->write_frame;
+    header->write_block = tap->write_block;
+}
@@ -0,0 +1,108 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - shm_tap.h                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_SHM_TAP_H
+#define M64P_SHM_TAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Shared memory tap of the audio output.
+ *
+ * The final output frames (after resampling and volume) are published into a
+ * named shared memory ring, which other processes can map read-only.
+ * The plugin never waits for readers: a reader which falls more than the ring
+ * size behind loses frames, and detects it.
+ *
+ * The mapping starts with struct shm_tap_header, followed by the block table
+ * (block_capacity struct shm_tap_block, at blocks_offset) and by the frame ring
+ * (frame_capacity frames, at frames_offset). Frame n is at ring position
+ * n % frame_capacity. Counters are 32-bit and wrap around: compare them by
+ * unsigned difference.
+ *
+ * For each audio callback, the writer
+ *  1. advances reserve_frame past the frames it is about to write,
+ *  2. clears the stamp of the block entry, writes the frames and the entry,
+ *  3. sets the entry stamp to the block number + 1,
+ *  4. advances write_frame and write_block,
+ * with release barriers between steps. A reader loads write_frame (acquire),
+ * copies frames up to it, then loads reserve_frame: copied frames older than
+ * reserve_frame - frame_capacity may have been overwritten and must be dropped.
+ * Block entries are valid when their stamp is the expected one before and
+ * after copying them.
+ *
+ * This header is shared with readers, see tools/shm_reader.c.
+ */
+
+#define SHM_TAP_MAGIC   0x5041544d /* "MTAP" */
+#define SHM_TAP_VERSION 1
+
+struct shm_tap_header
+{
+    uint32_t magic;
+    uint32_t version;
+
+    /* layout of the mapping, offsets are from its start */
+    uint32_t blocks_offset;
+    uint32_t block_capacity;
+    uint32_t frames_offset;
+    uint32_t frame_capacity;
+
+    /* frames are interleaved signed 16-bit, in host byte order */
+    uint32_t channels;
+    uint32_t frame_size;
+
+    /* frames the writer has started to write */
+    volatile uint32_t reserve_frame;
+    /* frames and blocks completely written */
+    volatile uint32_t write_frame;
+    volatile uint32_t write_block;
+
+    /* set when the plugin stops the tap, readers should detach */
+    volatile uint32_t closed;
+};
+
+struct shm_tap_block
+{
+    /* block number + 1 when the entry is complete, 0 while it is written */
+    volatile uint32_t stamp;
+
+    /* frame number of the first frame of the block */
+    uint32_t first_frame;
+    uint32_t frames;
+    uint32_t frequency;
+
+    /* osal_shm_clock_ns() time of the audio callback which produced the block */
+    uint64_t timestamp_ns;
+};
+
+struct shm_tap;
+
+/* Creates the shared memory object name, with a ring of at least frames frames.
+ * Returns NULL on failure. */
+struct shm_tap* start_shm_tap(const char* name, size_t frames);
+
+void stop_shm_tap(struct shm_tap* tap);
+
+/* Can be called from the audio callback: no lock, no allocation, no I/O */
+void shm_tap_push(struct shm_tap* tap, const void* data, size_t size, unsigned int frequency);
+
+#endif
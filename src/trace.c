@@ -0,0 +1,239 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - trace.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "trace.h"
+
+#include "m64p_types.h"
+
+/* must be a power of two */
+enum { TRACE_RING_SIZE = 1 << 16 };
+enum { TRACE_MAX_THREADS = 8 };
+
+/* when a ring has wrapped, its oldest events may be overwritten while being dumped,
+ * so skip them */
+enum { TRACE_DUMP_MARGIN = 256 };
+
+struct trace_record
+{
+    uint64_t timestamp;
+    const char* name;
+    int64_t value;
+    int phase;
+};
+
+struct trace_ring
+{
+    /* total number of events written (only modified by the owner thread) */
+    SDL_atomic_t written;
+    const char* thread_name;
+    struct trace_record records[TRACE_RING_SIZE];
+};
+
+struct trace_thread_slot
+{
+    unsigned int generation;
+    struct trace_ring* ring;
+};
+
+volatile int g_trace_enabled = 0;
+
+static struct trace_ring* l_rings = NULL;
+static SDL_atomic_t l_claimed_rings;
+static SDL_atomic_t l_lost_events;
+static uint64_t l_start_time;
+/* incremented each time tracing is (re)started, invalidates per-thread ring assignments */
+static unsigned int l_generation = 0;
+
+static ATTR_THREAD_LOCAL struct trace_thread_slot l_thread_slot;
+
+
+static struct trace_ring* get_thread_ring(void)
+{
+    int index;
+
+    if (l_thread_slot.generation == l_generation) {
+        return l_thread_slot.ring;
+    }
+
+    /* first event of this thread in this session: claim a ring */
+    index = SDL_AtomicAdd(&l_claimed_rings, 1);
+
+    l_thread_slot.generation = l_generation;
+    l_thread_slot.ring = (index < TRACE_MAX_THREADS) ? &l_rings[index] : NULL;
+
+    return l_thread_slot.ring;
+}
+
+int trace_start(void)
+{
+    if (l_rings == NULL) {
+        l_rings = malloc(TRACE_MAX_THREADS * sizeof(*l_rings));
+        if (l_rings == NULL) {
+            DebugMessage(M64MSG_ERROR, "Failed to allocate memory for trace buffers");
+            return -1;
+        }
+    }
+
+    g_trace_enabled = 0;
+
+    memset(l_rings, 0, TRACE_MAX_THREADS * sizeof(*l_rings));
+    SDL_AtomicSet(&l_claimed_rings, 0);
+    SDL_AtomicSet(&l_lost_events, 0);
+    l_start_time = SDL_GetPerformanceCounter();
+    /* skip 0, which is the initial value of thread slots */
+    if (++l_generation == 0) {
+        ++l_generation;
+    }
+
+    SDL_MemoryBarrierRelease();
+    g_trace_enabled = 1;
+
+    return 0;
+}
+
+void trace_stop(void)
+{
+    g_trace_enabled = 0;
+}
+
+void trace_release(void)
+{
+    g_trace_enabled = 0;
+
+    free(l_rings);
+    l_rings = NULL;
+}
+
+void trace_event(enum trace_phase phase, const char* name, int64_t value)
+{
+    struct trace_ring* ring = get_thread_ring();
+    struct trace_record* record;
+    int written;
+
+    if (ring == NULL) {
+        SDL_AtomicAdd(&l_lost_events, 1);
+        return;
+    }
+
+    written = SDL_AtomicGet(&ring->written);
+    record = &ring->records[written & (TRACE_RING_SIZE - 1)];
+
+    record->timestamp = SDL_GetPerformanceCounter();
+    record->name = name;
+    record->value = value;
+    record->phase = phase;
+
+    /* publish the record */
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->written, written + 1);
+}
+
+void trace_thread_name(const char* name)
+{
+    struct trace_ring* ring = get_thread_ring();
+
+    if (ring != NULL && ring->thread_name == NULL) {
+        ring->thread_name = name;
+    }
+}
+
+int trace_dump(const char* filename)
+{
+    int i, n, rings;
+    const char* sep = "";
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    FILE* f;
+
+    if (l_rings == NULL) {
+        DebugMessage(M64MSG_WARNING, "Audio trace: nothing to dump");
+        return -1;
+    }
+
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        DebugMessage(M64MSG_ERROR, "Audio trace: couldn't open %s for writing", filename);
+        return -1;
+    }
+
+    rings = SDL_AtomicGet(&l_claimed_rings);
+    if (rings > TRACE_MAX_THREADS) {
+        rings = TRACE_MAX_THREADS;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (i = 0; i < rings; ++i) {
+        const struct trace_ring* ring = &l_rings[i];
+        int written = SDL_AtomicGet((SDL_atomic_t*)&ring->written);
+        int first = 0;
+
+        SDL_MemoryBarrierAcquire();
+
+        if (written > TRACE_RING_SIZE) {
+            first = written - TRACE_RING_SIZE + TRACE_DUMP_MARGIN;
+        }
+
+        if (ring->thread_name != NULL) {
+            fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    sep, i + 1, ring->thread_name);
+            sep = ",";
+        }
+
+        for (n = first; n < written; ++n) {
+            const struct trace_record* record = &ring->records[n & (TRACE_RING_SIZE - 1)];
+            double ts = (double)(int64_t)(record->timestamp - l_start_time) * 1000000.0 / frequency;
+
+            fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                    sep, record->name, record->phase, ts, i + 1);
+
+            switch (record->phase)
+            {
+            case TRACE_PHASE_COUNTER:
+                fprintf(f, ",\"args\":{\"value\":%lld}}", (long long)record->value);
+                break;
+            case TRACE_PHASE_INSTANT:
+                fprintf(f, ",\"s\":\"t\"}");
+                break;
+            default:
+                fprintf(f, "}");
+            }
+
+            sep = ",";
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    n = SDL_AtomicGet(&l_lost_events);
+    DebugMessage(M64MSG_INFO, "Audio trace written to %s", filename);
+    if (n != 0) {
+        DebugMessage(M64MSG_WARNING, "Audio trace: %d events lost (too many threads)", n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - trace.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_TRACE_H
+#define M64P_TRACE_H
+
+#include <stdint.h>
+
+#include "m64p_types.h"
+
+/* Lightweight event tracer.
+ *
+ * Events are recorded in per-thread ring buffers (no lock, no allocation once the thread
+ * has claimed its ring) and can be dumped as Chrome trace_event JSON, which can be opened
+ * with chrome://tracing or Perfetto.
+ *
+ * When tracing is disabled, each trace point costs a single load and branch.
+ */
+
+enum trace_phase
+{
+    TRACE_PHASE_BEGIN   = 'B',
+    TRACE_PHASE_END     = 'E',
+    TRACE_PHASE_INSTANT = 'i',
+    TRACE_PHASE_COUNTER = 'C'
+};
+
+extern volatile int g_trace_enabled;
+
+int trace_start(void);
+
+void trace_stop(void);
+
+int trace_dump(const char* filename);
+
+void trace_release(void);
+
+/* name is expected to be a string literal (only the pointer is stored) */
+void trace_event(enum trace_phase phase, const char* name, int64_t value);
+
+void trace_thread_name(const char* name);
+
+#define TRACE_ENABLED() (g_trace_enabled != 0)
+
+#define TRACE_BEGIN(name)          do { if (TRACE_ENABLED()) { trace_event(TRACE_PHASE_BEGIN,   (name), 0); } } while(0)
+#define TRACE_END(name)            do { if (TRACE_ENABLED()) { trace_event(TRACE_PHASE_END,     (name), 0); } } while(0)
+#define TRACE_INSTANT(name)        do { if (TRACE_ENABLED()) { trace_event(TRACE_PHASE_INSTANT, (name), 0); } } while(0)
+#define TRACE_COUNTER(name, value) do { if (TRACE_ENABLED()) { trace_event(TRACE_PHASE_COUNTER, (name), (int64_t)(value)); } } while(0)
+#define TRACE_THREAD_NAME(name)    do { if (TRACE_ENABLED()) { trace_thread_name(name); } } while(0)
+
+/* AudioTraceStart
+ *
+ * Starts recording events, discarding any recorded before.
+ * Returns M64ERR_NOT_INIT before PluginStartup, and M64ERR_NO_MEMORY if the
+ * trace buffers couldn't be allocated. */
+typedef m64p_error (*ptr_AudioTraceStart)(void);
+/* AudioTraceDump
+ *
+ * Writes the events recorded so far to filename, without stopping the recording.
+ * Returns M64ERR_NOT_INIT before PluginStartup, M64ERR_INPUT_ASSERT if filename
+ * is NULL, and M64ERR_FILES if nothing was ever recorded or the file couldn't be written. */
+typedef m64p_error (*ptr_AudioTraceDump)(const char* filename);
+
+#if defined(M64P_PLUGIN_PROTOTYPES)
+EXPORT m64p_error CALL AudioTraceStart(void);
+EXPORT m64p_error CALL AudioTraceDump(const char* filename);
+#endif
+
+#endif
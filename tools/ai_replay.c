@@ -0,0 +1,320 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - ai_replay.c                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Replay driver for AI input recordings (see src/ai_record.h).
+ *
+ * Loads the audio plugin and plays the role of the emulator core: it provides the
+ * config API, then feeds recorded AiDacrateChanged/AiLenChanged/SetSpeedFactor
+ * events to the plugin, either as fast as possible or with the recorded timing.
+ *
+ * Use SDL_AUDIODRIVER=dummy to run without audio hardware.
+ */
+
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ai_record.h"
+#include "audio_stats.h"
+#include "core_config.h"
+
+#define M64P_CORE_PROTOTYPES 1
+#include "m64p_common.h"
+#include "m64p_config.h"
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+/* 8MB of RDRAM, the biggest possible AI DMA */
+enum { RDRAM_SIZE = 0x800000 };
+
+static int l_verbose = 0;
+
+static void debug_callback(void* context, int level, const char* message)
+{
+    static const char* const levels[] = { "?", "Error", "Warning", "Info", "Status", "Verbose" };
+
+    if (level > M64MSG_INFO && !l_verbose) {
+        return;
+    }
+
+    fprintf(stderr, "Audio %s: %s\n", levels[(level >= 1 && level <= 5) ? level : 0], message);
+}
+
+/* ----------- replay ------------- */
+
+struct plugin
+{
+    void* handle;
+    ptr_PluginStartup PluginStartup;
+    ptr_PluginShutdown PluginShutdown;
+    int (*InitiateAudio)(AUDIO_INFO);
+    int (*RomOpen)(void);
+    void (*RomClosed)(void);
+    void (*AiDacrateChanged)(int);
+    void (*AiLenChanged)(void);
+    void (*SetSpeedFactor)(int);
+    m64p_error (*AudioGetStats)(struct audio_stats*);
+};
+
+static int load_plugin(struct plugin* plugin, const char* filename)
+{
+    plugin->handle = dlopen(filename, RTLD_NOW | RTLD_LOCAL);
+    if (plugin->handle == NULL) {
+        fprintf(stderr, "Couldn't load %s: %s\n", filename, dlerror());
+        return -1;
+    }
+
+#define GET_PROC(name) *(void**)&plugin->name = dlsym(plugin->handle, #name)
+    GET_PROC(PluginStartup);
+    GET_PROC(PluginShutdown);
+    GET_PROC(InitiateAudio);
+    GET_PROC(RomOpen);
+    GET_PROC(RomClosed);
+    GET_PROC(AiDacrateChanged);
+    GET_PROC(AiLenChanged);
+    GET_PROC(SetSpeedFactor);
+    GET_PROC(AudioGetStats);
+#undef GET_PROC
+
+    if (plugin->PluginStartup == NULL || plugin->PluginShutdown == NULL || plugin->InitiateAudio == NULL
+     || plugin->RomOpen == NULL || plugin->RomClosed == NULL || plugin->AiDacrateChanged == NULL
+     || plugin->AiLenChanged == NULL || plugin->SetSpeedFactor == NULL) {
+        fprintf(stderr, "%s is not an audio plugin\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int read_le32(FILE* f, uint32_t* v)
+{
+    unsigned char bytes[4];
+
+    if (fread(bytes, 1, 4, f) != 4) {
+        return -1;
+    }
+
+    *v = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return 0;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_until_us(uint64_t deadline)
+{
+    uint64_t now = now_us();
+
+    if (deadline > now) {
+        struct timespec ts;
+        ts.tv_sec = (deadline - now) / 1000000;
+        ts.tv_nsec = ((deadline - now) % 1000000) * 1000;
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options] <plugin> <recording>\n"
+        "Options:\n"
+        "  --realtime       replay with the recorded timing (default: as fast as possible)\n"
+        "  --set NAME=VALUE force an Audio-SDL config parameter (may be repeated)\n"
+        "  --verbose        show verbose plugin messages\n"
+        "As fast as possible replay disables AUDIO_SYNC unless it is forced.\n"
+        "Set SDL_AUDIODRIVER=dummy to run without audio hardware.\n",
+        argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    struct plugin plugin;
+    AUDIO_INFO info;
+    unsigned char* rdram;
+    unsigned char dmem[0x1000];
+    unsigned char imem[0x1000];
+    unsigned int mi_intr = 0, ai_dram_addr = 0, ai_len = 0, ai_control = 0, ai_status = 0, ai_dacrate = 0, ai_bitrate = 0;
+    const char* plugin_file = NULL;
+    const char* recording_file = NULL;
+    int realtime = 0;
+    char magic[8];
+    uint32_t version;
+    uint64_t start, timestamp = 0;
+    unsigned long events = 0;
+    unsigned long long bytes = 0;
+    int i, type;
+    FILE* f;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = 1;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0) {
+            l_verbose = 1;
+        }
+        else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+            if (core_config_force(argv[++i]) != 0) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (plugin_file == NULL) {
+            plugin_file = argv[i];
+        }
+        else if (recording_file == NULL) {
+            recording_file = argv[i];
+        }
+        else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (plugin_file == NULL || recording_file == NULL) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!realtime && !core_config_is_set("AUDIO_SYNC")) {
+        core_config_force("AUDIO_SYNC=0");
+    }
+
+    f = fopen(recording_file, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s\n", recording_file);
+        return EXIT_FAILURE;
+    }
+
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, AI_RECORD_MAGIC, 8) != 0
+     || read_le32(f, &version) != 0 || version != AI_RECORD_VERSION) {
+        fprintf(stderr, "%s is not a supported AI recording\n", recording_file);
+        return EXIT_FAILURE;
+    }
+
+    rdram = calloc(1, RDRAM_SIZE);
+    if (rdram == NULL || load_plugin(&plugin, plugin_file) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.RDRAM = rdram;
+    info.DMEM = dmem;
+    info.IMEM = imem;
+    info.MI_INTR_REG = &mi_intr;
+    info.AI_DRAM_ADDR_REG = &ai_dram_addr;
+    info.AI_LEN_REG = &ai_len;
+    info.AI_CONTROL_REG = &ai_control;
+    info.AI_STATUS_REG = &ai_status;
+    info.AI_DACRATE_REG = &ai_dacrate;
+    info.AI_BITRATE_REG = &ai_bitrate;
+
+    if (plugin.PluginStartup(dlopen(NULL, RTLD_NOW), NULL, debug_callback) != M64ERR_SUCCESS
+     || !plugin.InitiateAudio(info) || !plugin.RomOpen()) {
+        fprintf(stderr, "Couldn't start audio plugin\n");
+        return EXIT_FAILURE;
+    }
+
+    start = now_us();
+
+    while ((type = fgetc(f)) != EOF) {
+        uint32_t delta, a, b;
+
+        if (read_le32(f, &delta) != 0) {
+            break;
+        }
+
+        timestamp += delta;
+        if (realtime) {
+            sleep_until_us(start + timestamp);
+        }
+
+        switch (type)
+        {
+        case AI_RECORD_DACRATE:
+            if (read_le32(f, &a) != 0 || read_le32(f, &b) != 0) {
+                goto truncated;
+            }
+            ai_dacrate = b;
+            plugin.AiDacrateChanged((int)a);
+            break;
+
+        case AI_RECORD_LEN:
+            if (read_le32(f, &a) != 0 || a > RDRAM_SIZE || fread(rdram, 1, a, f) != a) {
+                goto truncated;
+            }
+            ai_dram_addr = 0;
+            ai_len = a;
+            plugin.AiLenChanged();
+            bytes += a;
+            break;
+
+        case AI_RECORD_SPEED:
+            if (read_le32(f, &a) != 0) {
+                goto truncated;
+            }
+            plugin.SetSpeedFactor((int)a);
+            break;
+
+        default:
+            fprintf(stderr, "Unknown event type %d\n", type);
+            goto truncated;
+        }
+
+        ++events;
+    }
+
+    if (0) {
+truncated:
+        fprintf(stderr, "Recording is truncated or corrupted after %lu events\n", events);
+    }
+
+    printf("Replayed %lu events (%llu sample bytes, %.3f s recorded) in %.3f s\n",
+            events, bytes, timestamp / 1e6, (now_us() - start) / 1e6);
+
+    if (plugin.AudioGetStats != NULL) {
+        struct audio_stats stats;
+        if (plugin.AudioGetStats(&stats) == M64ERR_SUCCESS) {
+            printf("Callbacks %llu, underruns %llu, overflows %llu, callback p50/p99/max %u/%u/%u us, resampling %llu us\n",
+                    (unsigned long long)stats.callbacks, (unsigned long long)stats.underruns,
+                    (unsigned long long)stats.overflows,
+                    stats.callback_us_p50, stats.callback_us_p99, stats.callback_us_max,
+                    (unsigned long long)stats.resample_us);
+            printf("Steady state callbacks %llu, resampling saved about %llu us\n",
+                    (unsigned long long)stats.steady_callbacks,
+                    (unsigned long long)stats.steady_saved_us);
+        }
+    }
+
+    plugin.RomClosed();
+    plugin.PluginShutdown();
+
+    fclose(f);
+    free(rdram);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1087 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - alist_test.c                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Differential test of the audio microcode HLE of ProcessAList (src/alist), against
+ * an RSP HLE plugin such as mupen64plus-rsp-hle (make alist-test).
+ *
+ * Each case is an audio task, run through alist_hle_process_task and through the
+ * reference: the RDRAM must be the same afterwards. Cases come from
+ *  - random command lists of each supported microcode (ABI1, GoldenEye, Blast Corps),
+ *    generated from --seed, when a reference plugin is given (--reference);
+ *  - a raw dump of a task (--dmem and --rdram, in N64 byte order, taken when the RSP
+ *    starts the task), also run through the reference;
+ *  - captures (.alist files), holding the inputs of a case and the RDRAM pages the
+ *    reference changed, written by --record and replayed without the reference.
+ *    Without a reference, --record writes the random lists as this build runs them:
+ *    such captures only guard against regressions (see tools/alist_captures/README).
+ *
+ * Every case starts with a task resetting the microcode state on both sides (data
+ * buffer, buffers, volumes, loop address and ADPCM table), so that its result only
+ * depends on its inputs. The random lists only use what RSP HLE plugins handle the
+ * same way as the microcode: buffers within the data buffer and ADPCM codebooks
+ * within the table they load. The words of an envelope mixer state that the mixers
+ * don't use are left out of the comparison, after an init.
+ *
+ * The kernels are those of this build: SSE2 when available, scalar with DSP_NO_SIMD.
+ */
+
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alist/alist.h"
+#include "alist/alist_kernels.h"
+#include "core_config.h"
+#include "dsp/dsp_simd.h"
+#include "hot_log.h"
+#include "main.h"
+
+#include "m64p_common.h"
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+#define CAPTURE_MAGIC "M64ALIST"
+#define CAPTURE_VERSION 1
+/* written in host byte order: captures hold host order memory */
+#define CAPTURE_BYTE_ORDER 0x01020304
+
+/* compared RDRAM, the reference gets 16MB as it masks addresses with 24 bits */
+enum { RDRAM_SIZE = ALIST_RDRAM_SIZE };
+enum { REFERENCE_RDRAM_SIZE = 0x1000000 };
+enum { DMEM_SIZE = 0x1000 };
+enum { PAGE_SIZE = 0x1000 };
+enum { MAX_IGNORES = 64 };
+
+/* OSTask header, at the end of DMEM */
+enum
+{
+    TASK_TYPE             = 0xfc0,
+    TASK_UCODE_BOOT_SIZE  = 0xfcc,
+    TASK_UCODE            = 0xfd0,
+    TASK_UCODE_SIZE       = 0xfd4,
+    TASK_UCODE_DATA       = 0xfd8,
+    TASK_UCODE_DATA_SIZE  = 0xfdc,
+    TASK_DATA_PTR         = 0xff0,
+    TASK_DATA_SIZE        = 0xff4
+};
+
+enum { M_AUDTASK = 2 };
+
+/* RDRAM layout of the generated cases */
+enum
+{
+    UCODE_TEXT   = 0x070000, /* one 0x1000 slot per microcode */
+    UCODE_DATA   = 0x080000, /* one 0x100 slot per microcode */
+    COMMAND_LIST = 0x090000,
+    SAMPLE_DATA  = 0x100000, /* random data, segment 1 */
+    SAMPLE_DATA_SIZE = 0x8000,
+    STATE_DATA   = 0x110000, /* command states */
+    STATE_SLOTS  = 16,
+    STATE_SLOT_SIZE = 0x80,
+    OUTPUT_DATA  = 0x120000, /* SAVEBUFF */
+    OUTPUT_DATA_SIZE = 0x4000,
+    GENERATED_END = 0x200000,
+
+    /* the reset list and the zero table it loads, restored after the reset */
+    RESET_PAGE   = RDRAM_SIZE - PAGE_SIZE,
+    RESET_ZERO_TABLE = RESET_PAGE + 0x800
+};
+
+/* SAMPLE_DATA offsets: crafted ADPCM frames, ADPCM tables and loop frames */
+enum
+{
+    ADPCM_FRAMES = 28,
+    ADPCM_SOURCE_SIZE = 0x100,
+    ADPCM_TABLE  = 0x7c00,
+    ADPCM_LOOP   = 0x7e00
+};
+
+/* data buffer (relative to its DMEM base): ADPCM frames first, never written by the lists */
+enum { BUFFER_END = 0xa40 };
+
+/* ABI1 commands and flags */
+enum
+{
+    A_SPNOOP = 0, A_ADPCM, A_CLEARBUFF, A_ENVMIXER, A_LOADBUFF, A_RESAMPLE, A_SAVEBUFF, A_SEGMENT,
+    A_SETBUFF, A_SETVOL, A_DMEMMOVE, A_LOADADPCM, A_MIXER, A_INTERLEAVE, A_POLEF, A_SETLOOP
+};
+
+enum { F_INIT = 0x01, F_LOOP = 0x02, F_LEFT = 0x02, F_VOL = 0x04, F_AUX = 0x08 };
+
+static const struct ucode
+{
+    const char* name;
+    /* word at ucode data + 0x28 */
+    uint32_t signature;
+    /* words of the envelope mixer state after an init that the mixer doesn't use */
+    const uint16_t* unused_state_words;
+} l_ucodes[] =
+{
+    { "abi1", 0x1e24138c, (const uint16_t[]) { 1, 1,  3, 1,  20, 20,  0 } },
+    { "ge",   0x1dc8138c, (const uint16_t[]) { 1, 1,  3, 1,  12, 4,  20, 20,  0 } },
+    { "bc",   0x1e3c1390, (const uint16_t[]) { 1, 1,  3, 1,  12, 4,  20, 20,  0 } },
+};
+
+#define UCODE_COUNT (sizeof(l_ucodes) / sizeof(l_ucodes[0]))
+
+/* RDRAM ranges left out of the comparison */
+struct ignore_range
+{
+    uint32_t address;
+    uint32_t size;
+};
+
+struct test_case
+{
+    char name[64];
+    unsigned char dmem[DMEM_SIZE];
+    struct ignore_range ignores[MAX_IGNORES];
+    size_t ignore_count;
+};
+
+struct rsp_plugin
+{
+    void* handle;
+    ptr_PluginStartup PluginStartup;
+    ptr_PluginShutdown PluginShutdown;
+    ptr_InitiateRSP InitiateRSP;
+    ptr_DoRspCycles DoRspCycles;
+
+    unsigned char* rdram;
+    unsigned char dmem[DMEM_SIZE];
+    unsigned char imem[DMEM_SIZE];
+    unsigned int regs[32];
+};
+
+static int l_verbose = 0;
+
+/* inputs of the current case, and the RDRAM of each side */
+static unsigned char* l_input;
+static unsigned char* l_ours;
+static unsigned char* l_expected;
+static struct alist_hle* l_hle;
+
+
+void DebugMessage(int level, const char *message, ...)
+{
+    va_list args;
+
+    if (level > M64MSG_WARNING && !l_verbose) {
+        return;
+    }
+
+    va_start(args, message);
+    fprintf(stderr, "alist: ");
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static void debug_callback(void* context, int level, const char* message)
+{
+    if (level > M64MSG_WARNING && !l_verbose) {
+        return;
+    }
+
+    fprintf(stderr, "reference: %s\n", message);
+}
+
+static void no_op(void)
+{
+}
+
+/* ----------- memory helpers ------------- */
+
+static void put_u32(unsigned char* memory, uint32_t address, uint32_t value)
+{
+    memcpy(memory + address, &value, sizeof(value));
+}
+
+static uint32_t get_u32(const unsigned char* memory, uint32_t address)
+{
+    uint32_t value;
+    memcpy(&value, memory + address, sizeof(value));
+    return value;
+}
+
+static void put_u8(unsigned char* memory, uint32_t address, uint8_t value)
+{
+    memory[address ^ ALIST_S8] = value;
+}
+
+/* N64 byte order to the host order words of RDRAM and DMEM */
+static void load_words(unsigned char* dst, const unsigned char* src, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i + 4 <= size; i += 4) {
+        put_u32(dst, (uint32_t)i, ((uint32_t)src[i] << 24) | ((uint32_t)src[i + 1] << 16)
+                | ((uint32_t)src[i + 2] << 8) | (uint32_t)src[i + 3]);
+    }
+}
+
+static uint32_t next_random(uint32_t* state)
+{
+    /* xorshift32 */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static uint32_t random_below(uint32_t* state, uint32_t n)
+{
+    return (n != 0) ? next_random(state) % n : 0;
+}
+
+static uint32_t align_up(uint32_t x, uint32_t n)
+{
+    return (x + n - 1) & ~(n - 1);
+}
+
+/* ----------- command lists ------------- */
+
+struct list_builder
+{
+    unsigned char* rdram;
+    uint32_t start;
+    uint32_t address;
+};
+
+static void emit(struct list_builder* list, unsigned int command, unsigned int flags, uint16_t lo, uint32_t w2)
+{
+    put_u32(list->rdram, list->address, ((uint32_t)command << 24) | ((uint32_t)flags << 16) | lo);
+    put_u32(list->rdram, list->address + 4, w2);
+    list->address += 8;
+}
+
+static void set_task_header(unsigned char* dmem, unsigned int ucode, uint32_t list, uint32_t size)
+{
+    memset(dmem, 0, DMEM_SIZE);
+    put_u32(dmem, TASK_TYPE, M_AUDTASK);
+    put_u32(dmem, TASK_UCODE_BOOT_SIZE, 0);
+    /* distinct microcode addresses, as plugins may cache the identification by address */
+    put_u32(dmem, TASK_UCODE, UCODE_TEXT + ucode * 0x1000);
+    put_u32(dmem, TASK_UCODE_SIZE, 0x1000);
+    put_u32(dmem, TASK_UCODE_DATA, UCODE_DATA + ucode * 0x100);
+    put_u32(dmem, TASK_UCODE_DATA_SIZE, 0x800);
+    put_u32(dmem, TASK_DATA_PTR, list);
+    put_u32(dmem, TASK_DATA_SIZE, size);
+}
+
+static void write_ucode_data(unsigned char* rdram)
+{
+    unsigned int i;
+
+    for (i = 0; i < UCODE_COUNT; ++i) {
+        uint32_t data = UCODE_DATA + i * 0x100;
+        put_u32(rdram, data, 0x00000001);
+        put_u32(rdram, data + 0x28, l_ucodes[i].signature);
+        put_u32(rdram, data + 0x30, 0xf0000f00);
+    }
+}
+
+/* writes the reset list in RESET_PAGE, returns its size */
+static uint32_t write_reset_list(unsigned char* rdram)
+{
+    struct list_builder list = { rdram, RESET_PAGE, RESET_PAGE };
+
+    memset(rdram + RESET_PAGE, 0, PAGE_SIZE);
+
+    emit(&list, A_SETBUFF, 0, 0, 0);
+    emit(&list, A_SETBUFF, F_AUX, 0, 0);
+    emit(&list, A_CLEARBUFF, 0, 0, BUFFER_END);
+    emit(&list, A_SETVOL, F_AUX, 0, 0);
+    emit(&list, A_SETVOL, F_VOL | F_LEFT, 0, 0);
+    emit(&list, A_SETVOL, F_VOL, 0, 0);
+    emit(&list, A_SETVOL, F_LEFT, 0, 0);
+    emit(&list, A_SETVOL, 0, 0, 0);
+    emit(&list, A_SETLOOP, 0, 0, 0);
+    /* 8 codebook entries, the size of the table of RSP HLE plugins */
+    emit(&list, A_LOADADPCM, 0, 0x100, RESET_ZERO_TABLE);
+
+    return list.address - list.start;
+}
+
+/* an even offset in the data buffer, for len bytes within [lo, BUFFER_END), mostly 16 bytes aligned */
+static uint16_t pick(uint32_t* seed, uint32_t lo, uint32_t len)
+{
+    static const uint32_t alignments[] = { 16, 16, 16, 16, 16, 16, 16, 8, 4, 2 };
+    uint32_t alignment = alignments[random_below(seed, sizeof(alignments) / sizeof(alignments[0]))];
+    uint32_t first = align_up(lo, alignment);
+    uint32_t last = (BUFFER_END - len) & ~(alignment - 1);
+
+    return (uint16_t)(first + random_below(seed, (last - first) / alignment + 1) * alignment);
+}
+
+static uint32_t pick_state(uint32_t* seed)
+{
+    return STATE_DATA + random_below(seed, STATE_SLOTS) * STATE_SLOT_SIZE;
+}
+
+static void add_ignore(struct test_case* c, uint32_t address, uint32_t size)
+{
+    if (c->ignore_count < MAX_IGNORES) {
+        c->ignores[c->ignore_count].address = address;
+        c->ignores[c->ignore_count].size = size;
+        ++c->ignore_count;
+    }
+}
+
+static void random_setvol(struct list_builder* list, uint32_t* seed, unsigned int ucode)
+{
+    /* exponential envelopes multiply vol by rate in 32 bits: keep rate below 1.0 there */
+    int32_t rate = (ucode == 0)
+        ? (int32_t)random_below(seed, 0x10000)
+        : (int32_t)random_below(seed, 0x80000) - 0x40000;
+
+    switch (random_below(seed, 5))
+    {
+    case 0: emit(list, A_SETVOL, F_AUX, (uint16_t)next_random(seed), (uint16_t)next_random(seed)); break;
+    case 1: emit(list, A_SETVOL, F_VOL | F_LEFT, (uint16_t)next_random(seed), 0); break;
+    case 2: emit(list, A_SETVOL, F_VOL, (uint16_t)next_random(seed), 0); break;
+    case 3: emit(list, A_SETVOL, F_LEFT, (uint16_t)next_random(seed), (uint32_t)rate); break;
+    default: emit(list, A_SETVOL, 0, (uint16_t)next_random(seed), (uint32_t)rate); break;
+    }
+}
+
+static void random_command(struct list_builder* list, struct test_case* c, uint32_t* seed, unsigned int ucode)
+{
+    uint32_t count, frames, state;
+    uint16_t in, out;
+    unsigned int flags;
+
+    switch (random_below(seed, 14))
+    {
+    case 0: {
+        /* whole frames of the crafted source, whose codebook indices stay within the table */
+        frames = 1 + random_below(seed, 8);
+        count = frames * 32;
+        in = (uint16_t)(random_below(seed, ADPCM_FRAMES - frames + 1) * 9);
+        out = pick(seed, ADPCM_SOURCE_SIZE, 32 + count);
+        flags = random_below(seed, 4) & (F_INIT | F_LOOP);
+        if (flags & F_LOOP) {
+            emit(list, A_SETLOOP, 0, 0, (1u << 24) | (ADPCM_LOOP + (random_below(seed, 0x100) & ~1u)));
+        }
+        emit(list, A_SETBUFF, 0, in, ((uint32_t)out << 16) | count);
+        emit(list, A_ADPCM, flags, 0, pick_state(seed));
+        break;
+    }
+
+    case 1:
+        count = random_below(seed, 0x200);
+        out = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16));
+        emit(list, A_CLEARBUFF, 0, out, count);
+        break;
+
+    case 2:
+    case 3: {
+        /* odd sample counts too, the linear mixers don't round them */
+        size_t i;
+        const uint16_t* unused = l_ucodes[ucode].unused_state_words;
+        uint16_t dr, wl, wr;
+
+        count = (random_below(seed, 2) == 0) ? 16 * (1 + random_below(seed, 24)) : 2 * (1 + random_below(seed, 192));
+        in = pick(seed, 0, align_up(count, 16) + 16);
+        out = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16) + 16);
+        dr = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16) + 16);
+        wl = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16) + 16);
+        wr = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16) + 16);
+        flags = random_below(seed, 2) * F_INIT | random_below(seed, 2) * F_AUX;
+        state = pick_state(seed);
+
+        for (i = random_below(seed, 4); i != 0; --i) {
+            random_setvol(list, seed, ucode);
+        }
+        emit(list, A_SETBUFF, 0, in, ((uint32_t)out << 16) | count);
+        emit(list, A_SETBUFF, F_AUX, dr, ((uint32_t)wl << 16) | wr);
+        emit(list, A_ENVMIXER, flags, 0, state);
+
+        if (flags & F_INIT) {
+            for (i = 0; unused[i] != 0; i += 2) {
+                add_ignore(c, state + 2 * unused[i], 2 * unused[i + 1]);
+            }
+        }
+        break;
+    }
+
+    case 4:
+        count = 8 * (1 + random_below(seed, 0x40));
+        in = pick(seed, ADPCM_SOURCE_SIZE, count);
+        emit(list, A_SETBUFF, 0, in, count);
+        emit(list, A_LOADBUFF, 0, 0, (1u << 24) | (random_below(seed, SAMPLE_DATA_SIZE - count) & ~7u));
+        break;
+
+    case 5:
+        /* reads up to twice count ahead of in, and writes the 4 samples before in */
+        count = 16 * (1 + random_below(seed, 16));
+        in = pick(seed, ADPCM_SOURCE_SIZE + 8, 2 * count + 16);
+        out = pick(seed, ADPCM_SOURCE_SIZE, count);
+        emit(list, A_SETBUFF, 0, in, ((uint32_t)out << 16) | count);
+        emit(list, A_RESAMPLE, random_below(seed, 2) * F_INIT, (uint16_t)next_random(seed), pick_state(seed));
+        break;
+
+    case 6:
+        count = 8 * (1 + random_below(seed, 0x40));
+        out = pick(seed, 0, count);
+        emit(list, A_SETBUFF, 0, 0, ((uint32_t)out << 16) | count);
+        emit(list, A_SAVEBUFF, 0, 0, OUTPUT_DATA + (random_below(seed, OUTPUT_DATA_SIZE - count) & ~7u));
+        break;
+
+    case 7:
+        random_setvol(list, seed, ucode);
+        break;
+
+    case 8:
+        count = 1 + random_below(seed, 0x200);
+        in = pick(seed, 0, align_up(count, 16));
+        out = pick(seed, ADPCM_SOURCE_SIZE, align_up(count, 16));
+        emit(list, A_DMEMMOVE, 0, in, ((uint32_t)out << 16) | count);
+        break;
+
+    case 9:
+        emit(list, A_LOADADPCM, 0, 0x100, (1u << 24) | ADPCM_TABLE);
+        break;
+
+    case 10:
+        count = 32 * (1 + random_below(seed, 12));
+        in = pick(seed, 0, count);
+        out = pick(seed, ADPCM_SOURCE_SIZE, count);
+        emit(list, A_SETBUFF, 0, 0, count);
+        emit(list, A_MIXER, 0, (uint16_t)next_random(seed), ((uint32_t)in << 16) | out);
+        break;
+
+    case 11: {
+        uint16_t left, right;
+
+        count = 16 * (1 + random_below(seed, 12));
+        out = pick(seed, ADPCM_SOURCE_SIZE, 2 * count);
+        left = pick(seed, 0, count);
+        right = pick(seed, 0, count);
+        emit(list, A_SETBUFF, 0, 0, ((uint32_t)out << 16) | count);
+        emit(list, A_INTERLEAVE, 0, 0, ((uint32_t)left << 16) | right);
+        break;
+    }
+
+    case 12:
+        count = 16 * (1 + random_below(seed, 16));
+        in = pick(seed, 0, count);
+        out = pick(seed, ADPCM_SOURCE_SIZE, count);
+        emit(list, A_SETBUFF, 0, in, ((uint32_t)out << 16) | count);
+        emit(list, A_POLEF, random_below(seed, 2) * F_INIT, (uint16_t)next_random(seed), pick_state(seed));
+        break;
+
+    default:
+        emit(list, A_SPNOOP, 0, 0, 0);
+        break;
+    }
+}
+
+/* a random list of the given microcode in l_input */
+static void generate_case(struct test_case* c, unsigned int ucode, uint32_t seed, unsigned int index)
+{
+    struct list_builder list = { l_input, COMMAND_LIST, COMMAND_LIST };
+    uint32_t state = (seed * 2654435761u) ^ ((ucode + 1) * 40503u) ^ (index * 2246822519u);
+    uint32_t i, commands;
+    uint32_t* rng = &state;
+
+    if (state == 0) {
+        state = 1;
+    }
+
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s-%u-%04u", l_ucodes[ucode].name, seed, index);
+
+    memset(l_input, 0, GENERATED_END);
+    write_ucode_data(l_input);
+
+    for (i = 0; i < SAMPLE_DATA_SIZE; i += 4) {
+        put_u32(l_input, SAMPLE_DATA + i, next_random(rng));
+    }
+
+    /* ADPCM frames: scale and codebook index (within the 8 entries loaded), then 8 bytes */
+    for (i = 0; i < ADPCM_FRAMES; ++i) {
+        put_u8(l_input, SAMPLE_DATA + i * 9, (uint8_t)(next_random(rng) & 0xf7));
+    }
+
+    emit(&list, A_SEGMENT, 0, 0, (1u << 24) | SAMPLE_DATA);
+    emit(&list, A_SETBUFF, 0, 0, BUFFER_END);
+    emit(&list, A_LOADBUFF, 0, 0, 1u << 24);
+    emit(&list, A_LOADADPCM, 0, 0x100, (1u << 24) | ADPCM_TABLE);
+    for (i = 0; i < 5; ++i) {
+        random_setvol(&list, rng, ucode);
+    }
+
+    commands = 4 + random_below(rng, 28);
+    for (i = 0; i < commands; ++i) {
+        random_command(&list, c, rng, ucode);
+    }
+
+    set_task_header(c->dmem, ucode, list.start, list.address - list.start);
+}
+
+/* ----------- running the cases ------------- */
+
+static int load_reference(struct rsp_plugin* plugin, const char* filename)
+{
+    RSP_INFO info;
+    unsigned int cycle_count = 0;
+    unsigned int* regs = plugin->regs;
+
+    plugin->handle = dlopen(filename, RTLD_NOW | RTLD_LOCAL);
+    if (plugin->handle == NULL) {
+        fprintf(stderr, "Couldn't load %s: %s\n", filename, dlerror());
+        return -1;
+    }
+
+#define GET_PROC(name) *(void**)&plugin->name = dlsym(plugin->handle, #name)
+    GET_PROC(PluginStartup);
+    GET_PROC(PluginShutdown);
+    GET_PROC(InitiateRSP);
+    GET_PROC(DoRspCycles);
+#undef GET_PROC
+
+    if (plugin->PluginStartup == NULL || plugin->PluginShutdown == NULL
+     || plugin->InitiateRSP == NULL || plugin->DoRspCycles == NULL) {
+        fprintf(stderr, "%s is not an RSP plugin\n", filename);
+        return -1;
+    }
+
+    plugin->rdram = calloc(1, REFERENCE_RDRAM_SIZE);
+    if (plugin->rdram == NULL) {
+        return -1;
+    }
+
+    /* the reference has to run the audio lists itself */
+    core_config_force("AudioListToAudioPlugin=0");
+
+    if (plugin->PluginStartup(dlopen(NULL, RTLD_NOW), NULL, debug_callback) != M64ERR_SUCCESS) {
+        fprintf(stderr, "Couldn't start %s\n", filename);
+        return -1;
+    }
+
+    memset(&info, 0, sizeof(info));
+    memset(plugin->regs, 0, sizeof(plugin->regs));
+    info.MemoryBswaped = 1;
+    info.RDRAM = plugin->rdram;
+    info.DMEM = plugin->dmem;
+    info.IMEM = plugin->imem;
+    info.MI_INTR_REG = &regs[0];
+    info.SP_MEM_ADDR_REG = &regs[1];
+    info.SP_DRAM_ADDR_REG = &regs[2];
+    info.SP_RD_LEN_REG = &regs[3];
+    info.SP_WR_LEN_REG = &regs[4];
+    info.SP_STATUS_REG = &regs[5];
+    info.SP_DMA_FULL_REG = &regs[6];
+    info.SP_DMA_BUSY_REG = &regs[7];
+    info.SP_PC_REG = &regs[8];
+    info.SP_SEMAPHORE_REG = &regs[9];
+    info.DPC_START_REG = &regs[10];
+    info.DPC_END_REG = &regs[11];
+    info.DPC_CURRENT_REG = &regs[12];
+    info.DPC_STATUS_REG = &regs[13];
+    info.DPC_CLOCK_REG = &regs[14];
+    info.DPC_BUFBUSY_REG = &regs[15];
+    info.DPC_PIPEBUSY_REG = &regs[16];
+    info.DPC_TMEM_REG = &regs[17];
+    info.CheckInterrupts = no_op;
+    info.ProcessDlistList = no_op;
+    info.ProcessAlistList = no_op;
+    info.ProcessRdpList = no_op;
+    info.ShowCFB = no_op;
+
+    plugin->InitiateRSP(info, &cycle_count);
+
+    return 0;
+}
+
+static void run_reference(unsigned char* rdram, const unsigned char* dmem, void* context)
+{
+    struct rsp_plugin* plugin = (struct rsp_plugin*)context;
+
+    (void)rdram;
+    memcpy(plugin->dmem, dmem, DMEM_SIZE);
+    plugin->regs[5] = 0;
+    plugin->DoRspCycles(0xffffffff);
+}
+
+static void run_ours(unsigned char* rdram, const unsigned char* dmem, void* context)
+{
+    int* status = (int*)context;
+
+    if (alist_hle_process_task(l_hle, rdram, dmem) != 0) {
+        *status = -1;
+    }
+}
+
+/* runs the reset task then the case */
+static void run_case(const struct test_case* c, unsigned char* rdram,
+                     void (*run)(unsigned char* rdram, const unsigned char* dmem, void* context), void* context)
+{
+    unsigned char saved[PAGE_SIZE];
+    unsigned char dmem[DMEM_SIZE];
+    uint32_t size;
+
+    memcpy(rdram, l_input, RDRAM_SIZE);
+
+    memcpy(saved, rdram + RESET_PAGE, PAGE_SIZE);
+    size = write_reset_list(rdram);
+    memcpy(dmem, c->dmem, DMEM_SIZE);
+    put_u32(dmem, TASK_DATA_PTR, RESET_PAGE);
+    put_u32(dmem, TASK_DATA_SIZE, size);
+    run(rdram, dmem, context);
+    memcpy(rdram + RESET_PAGE, saved, PAGE_SIZE);
+
+    run(rdram, c->dmem, context);
+}
+
+static void print_list(const struct test_case* c, const unsigned char* rdram)
+{
+    uint32_t address = get_u32(c->dmem, TASK_DATA_PTR);
+    uint32_t end = address + (get_u32(c->dmem, TASK_DATA_SIZE) & ~7u);
+
+    for (; address < end && address + 8 <= RDRAM_SIZE; address += 8) {
+        fprintf(stderr, "  %08x %08x\n", get_u32(rdram, address), get_u32(rdram, address + 4));
+    }
+}
+
+/* returns 0 if ours matches expected, out of the ignored ranges */
+static int compare_case(const struct test_case* c, unsigned char* ours, const unsigned char* expected, int status)
+{
+    size_t i;
+    uint32_t address;
+
+    if (status != 0) {
+        fprintf(stderr, "FAIL %s: microcode not supported\n", c->name);
+        return -1;
+    }
+
+    for (i = 0; i < c->ignore_count; ++i) {
+        uint32_t start = c->ignores[i].address;
+        uint32_t size = c->ignores[i].size;
+
+        if (start < RDRAM_SIZE) {
+            memcpy(ours + start, expected + start, (size < RDRAM_SIZE - start) ? size : RDRAM_SIZE - start);
+        }
+    }
+
+    if (memcmp(ours, expected, RDRAM_SIZE) == 0) {
+        return 0;
+    }
+
+    for (address = 0; get_u32(ours, address) == get_u32(expected, address); address += 4) {}
+
+    fprintf(stderr, "FAIL %s: RDRAM word 0x%06x is %08x, expected %08x\n",
+            c->name, address, get_u32(ours, address), get_u32(expected, address));
+    if (l_verbose) {
+        print_list(c, l_input);
+    }
+
+    return -1;
+}
+
+/* ----------- captures ------------- */
+
+static int write_le32(FILE* f, uint32_t v)
+{
+    unsigned char bytes[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+    return (fwrite(bytes, 1, 4, f) == 4) ? 0 : -1;
+}
+
+static int read_le32(FILE* f, uint32_t* v)
+{
+    unsigned char bytes[4];
+
+    if (fread(bytes, 1, 4, f) != 4) {
+        return -1;
+    }
+
+    *v = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return 0;
+}
+
+static int page_is_zero(const unsigned char* page)
+{
+    size_t i;
+
+    for (i = 0; i < PAGE_SIZE; ++i) {
+        if (page[i] != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* the non-zero pages of l_input, and the pages the reference changed */
+static int write_capture(const char* dir, const struct test_case* c, const unsigned char* expected)
+{
+    char filename[1024];
+    uint32_t in_pages = 0, out_pages = 0;
+    uint32_t address;
+    size_t i;
+    int error = 0;
+    FILE* f;
+
+    snprintf(filename, sizeof(filename), "%s/%s.alist", dir, c->name);
+    f = fopen(filename, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't create %s\n", filename);
+        return -1;
+    }
+
+    for (address = 0; address < RDRAM_SIZE; address += PAGE_SIZE) {
+        in_pages += !page_is_zero(l_input + address);
+        out_pages += (memcmp(l_input + address, expected + address, PAGE_SIZE) != 0);
+    }
+
+    error |= (fwrite(CAPTURE_MAGIC, 1, 8, f) != 8);
+    error |= write_le32(f, CAPTURE_VERSION);
+    error |= (fwrite(&(uint32_t){ CAPTURE_BYTE_ORDER }, 4, 1, f) != 1);
+    error |= write_le32(f, in_pages);
+    error |= write_le32(f, out_pages);
+    error |= write_le32(f, (uint32_t)c->ignore_count);
+    error |= (fwrite(c->dmem, 1, DMEM_SIZE, f) != DMEM_SIZE);
+
+    for (address = 0; address < RDRAM_SIZE; address += PAGE_SIZE) {
+        if (!page_is_zero(l_input + address)) {
+            error |= write_le32(f, address);
+            error |= (fwrite(l_input + address, 1, PAGE_SIZE, f) != PAGE_SIZE);
+        }
+    }
+    for (address = 0; address < RDRAM_SIZE; address += PAGE_SIZE) {
+        if (memcmp(l_input + address, expected + address, PAGE_SIZE) != 0) {
+            error |= write_le32(f, address);
+            error |= (fwrite(expected + address, 1, PAGE_SIZE, f) != PAGE_SIZE);
+        }
+    }
+    for (i = 0; i < c->ignore_count; ++i) {
+        error |= write_le32(f, c->ignores[i].address);
+        error |= write_le32(f, c->ignores[i].size);
+    }
+
+    if (fclose(f) != 0 || error) {
+        fprintf(stderr, "Couldn't write %s\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int read_pages(FILE* f, unsigned char* rdram, uint32_t count)
+{
+    uint32_t address;
+
+    while (count-- != 0) {
+        if (read_le32(f, &address) != 0 || (address % PAGE_SIZE) != 0 || address >= RDRAM_SIZE
+         || fread(rdram + address, 1, PAGE_SIZE, f) != PAGE_SIZE) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* loads a capture into c, l_input and l_expected */
+static int read_capture(const char* filename, struct test_case* c)
+{
+    char magic[8];
+    uint32_t version, byte_order, in_pages, out_pages, ignores, i;
+    const char* base = strrchr(filename, '/');
+    int status = -1;
+    FILE* f;
+
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", (base != NULL) ? base + 1 : filename);
+
+    f = fopen(filename, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s\n", filename);
+        return -1;
+    }
+
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, CAPTURE_MAGIC, 8) != 0
+     || read_le32(f, &version) != 0 || version != CAPTURE_VERSION
+     || fread(&byte_order, 4, 1, f) != 1) {
+        fprintf(stderr, "%s is not a supported capture\n", filename);
+        goto done;
+    }
+
+    if (byte_order != CAPTURE_BYTE_ORDER) {
+        fprintf(stderr, "%s was recorded on a host of the other byte order\n", filename);
+        goto done;
+    }
+
+    memset(l_input, 0, RDRAM_SIZE);
+    if (read_le32(f, &in_pages) != 0 || read_le32(f, &out_pages) != 0 || read_le32(f, &ignores) != 0
+     || ignores > MAX_IGNORES || fread(c->dmem, 1, DMEM_SIZE, f) != DMEM_SIZE
+     || read_pages(f, l_input, in_pages) != 0) {
+        goto truncated;
+    }
+
+    memcpy(l_expected, l_input, RDRAM_SIZE);
+    if (read_pages(f, l_expected, out_pages) != 0) {
+        goto truncated;
+    }
+
+    for (i = 0; i < ignores; ++i) {
+        uint32_t address, size;
+
+        if (read_le32(f, &address) != 0 || read_le32(f, &size) != 0) {
+            goto truncated;
+        }
+        add_ignore(c, address, size);
+    }
+
+    status = 0;
+    goto done;
+
+truncated:
+    fprintf(stderr, "%s is truncated or corrupted\n", filename);
+done:
+    fclose(f);
+    return status;
+}
+
+/* loads a raw task dump (N64 byte order) into c and l_input */
+static int read_dump(const char* dmem_file, const char* rdram_file, struct test_case* c)
+{
+    unsigned char* raw = calloc(1, RDRAM_SIZE);
+    const char* base = strrchr(dmem_file, '/');
+    size_t size = 0;
+    FILE* f;
+
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", (base != NULL) ? base + 1 : dmem_file);
+
+    if (raw == NULL) {
+        return -1;
+    }
+
+    f = fopen(dmem_file, "rb");
+    if (f != NULL) {
+        size = fread(raw, 1, DMEM_SIZE, f);
+        fclose(f);
+    }
+    if (size != DMEM_SIZE) {
+        fprintf(stderr, "Couldn't read %u bytes of DMEM from %s\n", DMEM_SIZE, dmem_file);
+        free(raw);
+        return -1;
+    }
+    load_words(c->dmem, raw, DMEM_SIZE);
+
+    memset(raw, 0, RDRAM_SIZE);
+    size = 0;
+    f = fopen(rdram_file, "rb");
+    if (f != NULL) {
+        size = fread(raw, 1, RDRAM_SIZE, f);
+        fclose(f);
+    }
+    if (size == 0) {
+        fprintf(stderr, "Couldn't read RDRAM from %s\n", rdram_file);
+        free(raw);
+        return -1;
+    }
+    load_words(l_input, raw, RDRAM_SIZE);
+
+    free(raw);
+    return 0;
+}
+
+/* ----------- main ------------- */
+
+struct test_stats
+{
+    unsigned int cases;
+    unsigned int failures;
+};
+
+/* runs the case in l_input against the reference, and records it */
+static void check_against_reference(struct rsp_plugin* reference, const struct test_case* c,
+                                    const char* record_dir, struct test_stats* stats)
+{
+    int status = 0;
+
+    run_case(c, reference->rdram, run_reference, reference);
+    run_case(c, l_ours, run_ours, &status);
+
+    /* recorded as the reference computed it */
+    if (record_dir != NULL) {
+        memcpy(l_expected, reference->rdram, RDRAM_SIZE);
+        if (write_capture(record_dir, c, l_expected) != 0) {
+            ++stats->failures;
+        }
+    }
+
+    ++stats->cases;
+    if (compare_case(c, l_ours, reference->rdram, status) != 0) {
+        ++stats->failures;
+    }
+}
+
+/* runs the case in l_input with this build's kernels, and records it */
+static void record_ours(const struct test_case* c, const char* record_dir, struct test_stats* stats)
+{
+    int status = 0;
+
+    run_case(c, l_ours, run_ours, &status);
+
+    ++stats->cases;
+    if (status != 0 || write_capture(record_dir, c, l_ours) != 0) {
+        ++stats->failures;
+    }
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options] [capture.alist...]\n"
+        "  --reference PLUGIN    RSP HLE plugin to compare with (e.g. mupen64plus-rsp-hle.so)\n"
+        "  --cases N             random lists per microcode, with a reference (default: 200)\n"
+        "  --seed S              seed of the random lists (default: 1)\n"
+        "  --dmem FILE --rdram FILE\n"
+        "                        raw dump of a task to run, with a reference\n"
+        "  --record DIR          write the cases run with the reference as captures in DIR,\n"
+        "                        or the random lists as this build runs them without one\n"
+        "  --verbose             show all messages, and the lists of failed cases\n"
+        "Captures are replayed without the reference. The test fails if there is nothing\n"
+        "to compare with.\n",
+        argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    struct rsp_plugin reference;
+    struct test_case c;
+    struct test_stats stats = { 0, 0 };
+    const char* reference_file = NULL;
+    const char* record_dir = NULL;
+    const char* dmem_file = NULL;
+    const char* rdram_file = NULL;
+    unsigned int cases = 200;
+    uint32_t seed = 1;
+    unsigned int ucode, i;
+    int first_capture = argc;
+
+    for (i = 1; i < (unsigned int)argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < (unsigned int)argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--verbose") == 0) { l_verbose = 1; continue; }
+        if (arg[0] != '-') { first_capture = (int)i; break; }
+        if (value == NULL) { print_usage(argv[0]); return EXIT_FAILURE; }
+        else if (strcmp(arg, "--reference") == 0) { reference_file = value; }
+        else if (strcmp(arg, "--cases") == 0) { cases = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--seed") == 0) { seed = (uint32_t)strtoul(value, NULL, 0); }
+        else if (strcmp(arg, "--dmem") == 0) { dmem_file = value; }
+        else if (strcmp(arg, "--rdram") == 0) { rdram_file = value; }
+        else if (strcmp(arg, "--record") == 0) { record_dir = value; }
+        else { print_usage(argv[0]); return EXIT_FAILURE; }
+        ++i;
+    }
+
+    if ((dmem_file == NULL) != (rdram_file == NULL)
+     || (dmem_file != NULL && reference_file == NULL)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    l_input = calloc(1, RDRAM_SIZE);
+    l_ours = calloc(1, RDRAM_SIZE);
+    l_expected = calloc(1, RDRAM_SIZE);
+    l_hle = init_alist_hle();
+    if (l_input == NULL || l_ours == NULL || l_expected == NULL || l_hle == NULL) {
+        fprintf(stderr, "Couldn't allocate memory\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(&reference, 0, sizeof(reference));
+    if (reference_file != NULL) {
+        if (load_reference(&reference, reference_file) != 0) {
+            return EXIT_FAILURE;
+        }
+
+        for (ucode = 0; ucode < UCODE_COUNT; ++ucode) {
+            for (i = 0; i < cases; ++i) {
+                generate_case(&c, ucode, seed, i);
+                check_against_reference(&reference, &c, record_dir, &stats);
+            }
+        }
+
+        if (dmem_file != NULL) {
+            if (read_dump(dmem_file, rdram_file, &c) != 0) {
+                return EXIT_FAILURE;
+            }
+            check_against_reference(&reference, &c, record_dir, &stats);
+        }
+    }
+    else if (record_dir != NULL) {
+        fprintf(stderr, "No reference: recording the results of this build's kernels\n");
+
+        for (ucode = 0; ucode < UCODE_COUNT; ++ucode) {
+            for (i = 0; i < cases; ++i) {
+                generate_case(&c, ucode, seed, i);
+                record_ours(&c, record_dir, &stats);
+            }
+        }
+    }
+
+    for (; first_capture < argc; ++first_capture) {
+        int status = 0;
+
+        ++stats.cases;
+        if (read_capture(argv[first_capture], &c) != 0) {
+            ++stats.failures;
+            continue;
+        }
+
+        run_case(&c, l_ours, run_ours, &status);
+        if (compare_case(&c, l_ours, l_expected, status) != 0) {
+            ++stats.failures;
+        }
+    }
+
+    hot_log_flush(1);
+
+    if (stats.cases == 0) {
+        fprintf(stderr, "Nothing to compare with: give a reference plugin (make alist-test RSP_HLE=...)\n"
+                        "or captures recorded from one (make alist-record RSP_HLE=...)\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("alist test (%s kernels): %u cases, %u failed\n",
+#if defined(DSP_SSE2)
+            "SSE2",
+#else
+            "scalar",
+#endif
+            stats.cases, stats.failures);
+
+    if (reference_file != NULL) {
+        reference.PluginShutdown();
+    }
+    release_alist_hle(l_hle);
+
+    return (stats.failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,562 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - bench.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Microbenchmarks of the audio hot path components, in isolation:
+ *  - produce_cbuff_data/consume_cbuff_data cycles on the primary buffer
+ *  - the N64 to SDL sample copy of sdl_push_samples (with and without channel swap),
+ *    and its split to planar int16 or float channels
+ *  - the steady block detection of sdl_push_samples, on silence (worst case),
+ *    and the steady state fast path of the audio callback on DC input, which
+ *    stands in for the ResampleAndMix cases below
+ *  - ResampleAndMix with each resampler configuration (32kHz to 48kHz),
+ *    from interleaved input and from each planar layout the resampler accepts
+ *  - the SDL_MixAudioFormat volume pass
+ *  - the DSP chain, with every stage kind enabled
+ *  - the primary buffer level estimation of sdl_synchronize_audio
+ *
+ * Each case runs for every secondary buffer size from 256 to 4096 samples,
+ * and reports time per output frame (or per call for the level estimation)
+ * as mean, standard deviation, minimum and median over several samples.
+ * Use --csv for machine-readable output.
+ * SDL uses its dummy audio driver, no audio device is needed.
+ */
+
+#include <SDL.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_sync.h"
+#include "circular_buffer.h"
+#include "dsp/dsp.h"
+#include "main.h"
+#include "resamplers/resamplers.h"
+#include "sample_format.h"
+
+enum { FRAME_BYTES = 4 };
+enum { INPUT_RATE = 32000 };
+enum { OUTPUT_RATE = 48000 };
+
+/* measurement samples per case, and target duration of each sample */
+enum { DEFAULT_SAMPLES = 15 };
+#define SAMPLE_SECONDS 0.005
+
+/* a DSP_CHAIN with every stage kind */
+#define BENCH_DSP_CHAIN "n64dac,peak:3000:3,limiter:-3,width:1.2"
+
+static const size_t l_secondary_sizes[] = { 256, 512, 1024, 2048, 4096 };
+
+#define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
+
+struct bench_case
+{
+    /* run iterations of the case, return the number of processed units (frames or calls) */
+    size_t (*run)(struct bench_case* bc, size_t iterations);
+    size_t secondary_size;
+    const char* resampler_id;
+
+    const struct resampler_interface* iresampler;
+    void* resampler;
+    unsigned int layout;
+
+    struct dsp_chain* dsp_chain;
+
+    struct circular_buffer cbuff;
+    unsigned char* input;
+    size_t input_size;
+    size_t input_pos;
+    /* bench input, split in planes of each layout */
+    unsigned char* input_planes[2][2];
+    unsigned char* planes[2];
+    unsigned char* output;
+    unsigned char* mix_buffer;
+    int swap_channels;
+    size_t sink;
+};
+
+static int l_csv = 0;
+
+/* ----------- cases ------------- */
+
+static size_t run_cbuff(struct bench_case* bc, size_t iterations)
+{
+    size_t i, available;
+    size_t produced = bc->secondary_size * INPUT_RATE / OUTPUT_RATE * FRAME_BYTES;
+
+    for (i = 0; i < iterations; ++i) {
+        /* one push from the core, then one callback worth of consumption */
+        cbuff_head(&bc->cbuff, &available);
+        produce_cbuff_data(&bc->cbuff, (produced <= available) ? produced : available);
+        cbuff_tail(&bc->cbuff, &available);
+        consume_cbuff_data(&bc->cbuff, (produced <= available) ? produced : available);
+    }
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_copy(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+
+    for (i = 0; i < iterations; ++i) {
+        copy_n64_samples(bc->output, bc->input, bc->secondary_size * FRAME_BYTES, bc->swap_channels);
+    }
+    bc->sink += bc->output[0];
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_split(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+
+    for (i = 0; i < iterations; ++i) {
+        split_n64_samples(bc->planes[0], bc->planes[1], bc->layout == RESAMPLER_LAYOUT_F32_PLANAR,
+                bc->input, bc->secondary_size * FRAME_BYTES, 0);
+    }
+    bc->sink += bc->planes[0][0];
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_steady(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+    uint32_t frame = 0;
+
+    for (i = 0; i < iterations; ++i) {
+        bc->sink += (size_t)is_steady_block(bc->output, bc->secondary_size * FRAME_BYTES, &frame);
+    }
+    bc->sink += frame;
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_steady_render(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+    uint32_t frame;
+
+    /* DC frame, so that the volume scaling runs */
+    memcpy(&frame, bc->mix_buffer, sizeof(frame));
+    frame |= 1;
+
+    for (i = 0; i < iterations; ++i) {
+        fill_steady_block(bc->output, bc->secondary_size * FRAME_BYTES, frame, SDL_MIX_MAXVOLUME * 80 / 100);
+    }
+    bc->sink += bc->output[0];
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_resample(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+    size_t needed = bc->secondary_size * INPUT_RATE / OUTPUT_RATE * FRAME_BYTES;
+
+    for (i = 0; i < iterations; ++i) {
+        /* same input window as a callback with a well filled primary buffer */
+        size_t available = 2 * needed;
+        size_t consumed;
+
+        if (bc->input_pos + available > bc->input_size) {
+            bc->input_pos = 0;
+        }
+
+        consumed = ResampleAndMix(bc->resampler, bc->iresampler, bc->mix_buffer,
+                bc->input + bc->input_pos, available, INPUT_RATE,
+                bc->output, bc->secondary_size * FRAME_BYTES, OUTPUT_RATE,
+                SDL_MIX_MAXVOLUME);
+
+        bc->input_pos += consumed;
+    }
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_resample_planar(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+    size_t frame_bytes = get_resampler_frame_bytes(bc->layout);
+    size_t needed = bc->secondary_size * INPUT_RATE / OUTPUT_RATE * frame_bytes;
+    size_t input_size = bc->input_size / FRAME_BYTES * frame_bytes;
+    unsigned char* const* input_planes = bc->input_planes[bc->layout == RESAMPLER_LAYOUT_F32_PLANAR];
+
+    for (i = 0; i < iterations; ++i) {
+        /* same input window as a callback with a well filled primary buffer */
+        size_t available = 2 * needed;
+        const void* planes[2];
+        size_t consumed;
+
+        if (bc->input_pos + available > input_size) {
+            bc->input_pos = 0;
+        }
+
+        planes[0] = input_planes[0] + bc->input_pos / 2;
+        planes[1] = input_planes[1] + bc->input_pos / 2;
+
+        consumed = ResampleAndMixPlanar(bc->resampler, bc->iresampler, bc->layout, bc->mix_buffer,
+                planes, available, INPUT_RATE,
+                bc->output, bc->secondary_size * FRAME_BYTES, OUTPUT_RATE,
+                SDL_MIX_MAXVOLUME);
+
+        bc->input_pos += consumed;
+    }
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_volume(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+
+    for (i = 0; i < iterations; ++i) {
+        memset(bc->output, 0, bc->secondary_size * FRAME_BYTES);
+        SDL_MixAudioFormat(bc->output, bc->mix_buffer, AUDIO_S16SYS, (Uint32)(bc->secondary_size * FRAME_BYTES), SDL_MIX_MAXVOLUME * 80 / 100);
+    }
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_dsp(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+
+    for (i = 0; i < iterations; ++i) {
+        dsp_chain_process(bc->dsp_chain, bc->output, bc->secondary_size);
+    }
+    bc->sink += bc->output[0];
+
+    return iterations * bc->secondary_size;
+}
+
+static size_t run_estimate(struct bench_case* bc, size_t iterations)
+{
+    size_t i;
+    unsigned int last_cb_time = SDL_GetTicks();
+
+    for (i = 0; i < iterations; ++i) {
+        bc->sink += estimate_audio_level((i * 64) & 0xffff,
+                INPUT_RATE, 1, OUTPUT_RATE, 100,
+                bc->secondary_size, last_cb_time, SDL_GetTicks());
+    }
+
+    return iterations;
+}
+
+/* ----------- measurement ------------- */
+
+static double elapsed_ns(Uint64 start, Uint64 end)
+{
+    return (double)(end - start) * 1e9 / (double)SDL_GetPerformanceFrequency();
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void bench(struct bench_case* bc, const char* name, const char* unit, unsigned int samples)
+{
+    double results[64];
+    double mean = 0.0, variance = 0.0;
+    size_t iterations = 1;
+    unsigned int s;
+
+    if (samples > ARRAY_SIZE(results)) {
+        samples = ARRAY_SIZE(results);
+    }
+
+    /* warm up and calibrate the number of iterations per sample */
+    for (;;) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        bc->run(bc, iterations);
+        if (elapsed_ns(start, SDL_GetPerformanceCounter()) >= SAMPLE_SECONDS * 1e9 || iterations >= (1 << 24)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    for (s = 0; s < samples; ++s) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        size_t units = bc->run(bc, iterations);
+        results[s] = elapsed_ns(start, SDL_GetPerformanceCounter()) / (double)units;
+        mean += results[s];
+    }
+    mean /= samples;
+
+    for (s = 0; s < samples; ++s) {
+        variance += (results[s] - mean) * (results[s] - mean);
+    }
+    variance /= (samples > 1) ? samples - 1 : 1;
+
+    qsort(results, samples, sizeof(results[0]), compare_doubles);
+
+    if (l_csv) {
+        printf("%s,%s,%u,%s,%.3f,%.3f,%.3f,%.3f,%u\n",
+               name, (bc->resampler_id != NULL) ? bc->resampler_id : "",
+               (unsigned int)bc->secondary_size, unit,
+               mean, sqrt(variance), results[0], results[samples / 2], samples);
+    }
+    else {
+        char label[96];
+        snprintf(label, sizeof(label), "%s%s%s", name,
+                 (bc->resampler_id != NULL) ? " " : "", (bc->resampler_id != NULL) ? bc->resampler_id : "");
+        printf("%-44s %5u %10.3f %9.3f %10.3f %10.3f  ns/%s\n",
+               label, (unsigned int)bc->secondary_size,
+               mean, sqrt(variance), results[0], results[samples / 2], unit);
+    }
+    fflush(stdout);
+}
+
+static int selected(const char* filter, const char* name, const char* resampler_id)
+{
+    return filter == NULL || strstr(name, filter) != NULL
+        || (resampler_id != NULL && strstr(resampler_id, filter) != NULL);
+}
+
+static void* alloc_buffer(size_t size)
+{
+    void* buffer = calloc(1, size);
+
+    if (buffer == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return buffer;
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "Options:\n"
+        "  --filter TEXT  only run cases whose name or resampler contains TEXT\n"
+        "  --samples N    measurement samples per case (default: %d)\n"
+        "  --csv          machine-readable output\n",
+        argv0, DEFAULT_SAMPLES);
+}
+
+int main(int argc, char* argv[])
+{
+    struct bench_case bc;
+    SDL_AudioSpec desired;
+    const char* filter = NULL;
+    unsigned int samples = DEFAULT_SAMPLES;
+    size_t input_size = 1 << 20;
+    size_t sizes, i;
+    const char* id;
+    int a;
+
+    for (a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) {
+            filter = argv[++a];
+        }
+        else if (strcmp(argv[a], "--samples") == 0 && a + 1 < argc) {
+            samples = (unsigned int)atoi(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--csv") == 0) {
+            l_csv = 1;
+        }
+        else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (samples < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* SDL_MixAudio needs an opened audio device, the dummy one is enough */
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+        fprintf(stderr, "Couldn't init SDL audio: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    memset(&desired, 0, sizeof(desired));
+    desired.freq = OUTPUT_RATE;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = 2;
+    desired.samples = 1024;
+    if (SDL_OpenAudio(&desired, NULL) < 0) {
+        fprintf(stderr, "Couldn't open dummy audio device: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    memset(&bc, 0, sizeof(bc));
+    bc.input_size = input_size;
+    bc.input = alloc_buffer(input_size);
+    bc.output = alloc_buffer(4096 * FRAME_BYTES);
+    bc.mix_buffer = alloc_buffer(4096 * FRAME_BYTES);
+
+    /* quiet noise, so that mixing and resampling work on non trivial data */
+    srand(64);
+    for (i = 0; i < input_size / 2; ++i) {
+        ((int16_t*)bc.input)[i] = (int16_t)((rand() & 0x3fff) - 0x2000);
+    }
+    memcpy(bc.mix_buffer, bc.input, 4096 * FRAME_BYTES);
+
+    /* planar copies of the input: int16 planes, then float planes */
+    for (i = 0; i < 2; ++i) {
+        bc.input_planes[0][i] = alloc_buffer(input_size / 2);
+        bc.input_planes[1][i] = alloc_buffer(input_size);
+        bc.planes[i] = alloc_buffer(4096 * sizeof(float));
+    }
+    split_n64_samples(bc.input_planes[0][0], bc.input_planes[0][1], 0, bc.input, input_size, 0);
+    split_n64_samples(bc.input_planes[1][0], bc.input_planes[1][1], 1, bc.input, input_size, 0);
+
+    if (l_csv) {
+        printf("case,resampler,secondary_size,unit,mean_ns,stddev_ns,min_ns,median_ns,samples\n");
+    }
+    else {
+        printf("%-44s %5s %10s %9s %10s %10s\n", "# case", "size", "mean", "stddev", "min", "median");
+    }
+
+    for (sizes = 0; sizes < ARRAY_SIZE(l_secondary_sizes); ++sizes) {
+        bc.secondary_size = l_secondary_sizes[sizes];
+        bc.resampler_id = NULL;
+
+        if (selected(filter, "cbuff_produce_consume", NULL)) {
+            /* default PRIMARY_BUFFER_SIZE, kept at the default PRIMARY_BUFFER_TARGET level
+             * so that consumption moves as much data as in the plugin */
+            if (init_cbuff(&bc.cbuff, 16384 * FRAME_BYTES) != 0) {
+                fprintf(stderr, "Out of memory\n");
+                return EXIT_FAILURE;
+            }
+            memset(bc.cbuff.data, 0, bc.cbuff.size);
+            produce_cbuff_data(&bc.cbuff, 10240 * INPUT_RATE / OUTPUT_RATE * FRAME_BYTES);
+            bc.run = run_cbuff;
+            bench(&bc, "cbuff_produce_consume", "frame", samples);
+            release_cbuff(&bc.cbuff);
+        }
+
+        if (selected(filter, "push_samples_swap", NULL)) {
+            bc.run = run_copy;
+            bc.swap_channels = 0;
+            bench(&bc, "push_samples_swap", "frame", samples);
+        }
+
+        if (selected(filter, "push_samples_memcpy", NULL)) {
+            bc.run = run_copy;
+            bc.swap_channels = 1;
+            bench(&bc, "push_samples_memcpy", "frame", samples);
+        }
+
+        if (selected(filter, "push_samples_planar_s16", NULL)) {
+            bc.run = run_split;
+            bc.layout = RESAMPLER_LAYOUT_S16_PLANAR;
+            bench(&bc, "push_samples_planar_s16", "frame", samples);
+        }
+
+        if (selected(filter, "push_samples_planar_f32", NULL)) {
+            bc.run = run_split;
+            bc.layout = RESAMPLER_LAYOUT_F32_PLANAR;
+            bench(&bc, "push_samples_planar_f32", "frame", samples);
+        }
+
+        if (selected(filter, "steady_detect", NULL)) {
+            memset(bc.output, 0, bc.secondary_size * FRAME_BYTES);
+            bc.run = run_steady;
+            bench(&bc, "steady_detect", "frame", samples);
+        }
+
+        if (selected(filter, "steady_render", NULL)) {
+            bc.run = run_steady_render;
+            bench(&bc, "steady_render", "frame", samples);
+        }
+
+        if (selected(filter, "volume_mix", NULL)) {
+            bc.run = run_volume;
+            bench(&bc, "volume_mix", "frame", samples);
+        }
+
+        if (selected(filter, "dsp_chain", NULL)) {
+            bc.dsp_chain = init_dsp_chain(BENCH_DSP_CHAIN);
+            if (bc.dsp_chain != NULL) {
+                dsp_chain_set_frequency(bc.dsp_chain, OUTPUT_RATE);
+                memcpy(bc.output, bc.mix_buffer, bc.secondary_size * FRAME_BYTES);
+                bc.run = run_dsp;
+                bench(&bc, "dsp_chain", "frame", samples);
+                release_dsp_chain(bc.dsp_chain);
+            }
+        }
+
+        if (selected(filter, "estimate_level", NULL)) {
+            bc.run = run_estimate;
+            bench(&bc, "estimate_level", "call", samples);
+        }
+
+        for (i = 0; (id = get_resampler_id(i)) != NULL; ++i) {
+            static const struct {
+                unsigned int layout;
+                const char* name;
+            } layouts[] = {
+                { RESAMPLER_LAYOUT_S16_INTERLEAVED, "resample_and_mix" },
+                { RESAMPLER_LAYOUT_S16_PLANAR, "resample_and_mix_planar_s16" },
+                { RESAMPLER_LAYOUT_F32_PLANAR, "resample_and_mix_planar_f32" }
+            };
+            size_t l;
+
+            for (l = 0; l < ARRAY_SIZE(layouts); ++l) {
+                if (!selected(filter, layouts[l].name, id)) {
+                    continue;
+                }
+
+                bc.resampler_id = id;
+                bc.iresampler = get_iresampler(id, &bc.resampler);
+                if ((bc.iresampler->layouts & layouts[l].layout) == 0) {
+                    bc.iresampler->release(bc.resampler);
+                    continue;
+                }
+
+                bc.layout = layouts[l].layout;
+                bc.iresampler->reserve(bc.resampler, bc.layout,
+                        16384 * get_resampler_frame_bytes(bc.layout), 4096 * FRAME_BYTES, 0);
+                bc.input_pos = 0;
+                bc.run = (bc.layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) ? run_resample : run_resample_planar;
+                bench(&bc, layouts[l].name, "frame", samples);
+                bc.iresampler->release(bc.resampler);
+            }
+        }
+    }
+
+    SDL_CloseAudio();
+    SDL_Quit();
+
+    free(bc.input);
+    free(bc.output);
+    free(bc.mix_buffer);
+    for (i = 0; i < 2; ++i) {
+        free(bc.input_planes[0][i]);
+        free(bc.input_planes[1][i]);
+        free(bc.planes[i]);
+    }
+
+    /* keep results of the computations alive */
+    return (bc.sink == (size_t)-1) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
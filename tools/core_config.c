@@ -0,0 +1,236 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - core_config.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Core config API for the tools which load plugins (see core_config.h) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core_config.h"
+
+#define M64P_CORE_PROTOTYPES 1
+#include "m64p_common.h"
+#include "m64p_config.h"
+#include "m64p_frontend.h"
+#include "m64p_types.h"
+
+#define CONFIG_API_VERSION 0x020100
+
+enum { MAX_PARAMS = 64 };
+
+struct config_param
+{
+    char name[64];
+    m64p_type type;
+    int ival;
+    float fval;
+    char sval[1024];
+};
+
+static struct config_param l_params[MAX_PARAMS];
+static size_t l_param_count = 0;
+static int l_section = 0;
+
+static struct config_param* find_param(const char* name)
+{
+    size_t i;
+
+    for (i = 0; i < l_param_count; ++i) {
+        if (strcmp(l_params[i].name, name) == 0) {
+            return &l_params[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct config_param* add_param(const char* name, m64p_type type)
+{
+    struct config_param* param = find_param(name);
+
+    if (param != NULL) {
+        return param;
+    }
+
+    if (l_param_count >= MAX_PARAMS) {
+        fprintf(stderr, "Too many config parameters\n");
+        exit(EXIT_FAILURE);
+    }
+
+    param = &l_params[l_param_count++];
+    memset(param, 0, sizeof(*param));
+    strncpy(param->name, name, sizeof(param->name) - 1);
+    param->type = type;
+
+    return param;
+}
+
+EXPORT m64p_error CALL CoreGetAPIVersions(int* ConfigVersion, int* DebugVersion, int* VidextVersion, int* ExtraVersion)
+{
+    if (ConfigVersion != NULL) { *ConfigVersion = CONFIG_API_VERSION; }
+    if (DebugVersion != NULL)  { *DebugVersion = 0x020000; }
+    if (VidextVersion != NULL) { *VidextVersion = 0x030000; }
+    if (ExtraVersion != NULL)  { *ExtraVersion = 0; }
+
+    return M64ERR_SUCCESS;
+}
+
+/* only for the plugins which insist on finding it */
+EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void* ParamPtr)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+EXPORT m64p_error CALL ConfigOpenSection(const char* SectionName, m64p_handle* ConfigSectionHandle)
+{
+    *ConfigSectionHandle = &l_section;
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigDeleteSection(const char* SectionName)
+{
+    /* keep parameters forced from the command line */
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSaveSection(const char* SectionName)
+{
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSetParameter(m64p_handle ConfigSectionHandle, const char* ParamName, m64p_type ParamType, const void* ParamValue)
+{
+    struct config_param* param = add_param(ParamName, ParamType);
+
+    switch (ParamType)
+    {
+    case M64TYPE_INT:
+    case M64TYPE_BOOL:   param->ival = *(const int*)ParamValue; break;
+    case M64TYPE_FLOAT:  param->fval = *(const float*)ParamValue; break;
+    case M64TYPE_STRING: strncpy(param->sval, (const char*)ParamValue, sizeof(param->sval) - 1); break;
+    }
+
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigGetParameter(m64p_handle ConfigSectionHandle, const char* ParamName, m64p_type ParamType, void* ParamValue, int MaxSize)
+{
+    const struct config_param* param = find_param(ParamName);
+
+    if (param == NULL) {
+        return M64ERR_INPUT_NOT_FOUND;
+    }
+
+    switch (ParamType)
+    {
+    case M64TYPE_INT:
+    case M64TYPE_BOOL:   *(int*)ParamValue = param->ival; break;
+    case M64TYPE_FLOAT:  *(float*)ParamValue = param->fval; break;
+    case M64TYPE_STRING: strncpy((char*)ParamValue, param->sval, MaxSize); break;
+    }
+
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSetDefaultInt(m64p_handle ConfigSectionHandle, const char* ParamName, int ParamValue, const char* ParamHelp)
+{
+    if (find_param(ParamName) == NULL) {
+        add_param(ParamName, M64TYPE_INT)->ival = ParamValue;
+    }
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSetDefaultFloat(m64p_handle ConfigSectionHandle, const char* ParamName, float ParamValue, const char* ParamHelp)
+{
+    if (find_param(ParamName) == NULL) {
+        add_param(ParamName, M64TYPE_FLOAT)->fval = ParamValue;
+    }
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSetDefaultBool(m64p_handle ConfigSectionHandle, const char* ParamName, int ParamValue, const char* ParamHelp)
+{
+    if (find_param(ParamName) == NULL) {
+        add_param(ParamName, M64TYPE_BOOL)->ival = ParamValue;
+    }
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigSetDefaultString(m64p_handle ConfigSectionHandle, const char* ParamName, const char* ParamValue, const char* ParamHelp)
+{
+    if (find_param(ParamName) == NULL) {
+        strncpy(add_param(ParamName, M64TYPE_STRING)->sval, ParamValue, sizeof(l_params[0].sval) - 1);
+    }
+    return M64ERR_SUCCESS;
+}
+
+EXPORT int CALL ConfigGetParamInt(m64p_handle ConfigSectionHandle, const char* ParamName)
+{
+    const struct config_param* param = find_param(ParamName);
+    return (param != NULL) ? param->ival : 0;
+}
+
+EXPORT float CALL ConfigGetParamFloat(m64p_handle ConfigSectionHandle, const char* ParamName)
+{
+    const struct config_param* param = find_param(ParamName);
+    return (param != NULL) ? param->fval : 0.0f;
+}
+
+EXPORT int CALL ConfigGetParamBool(m64p_handle ConfigSectionHandle, const char* ParamName)
+{
+    const struct config_param* param = find_param(ParamName);
+    return (param != NULL) ? param->ival : 0;
+}
+
+EXPORT const char* CALL ConfigGetParamString(m64p_handle ConfigSectionHandle, const char* ParamName)
+{
+    const struct config_param* param = find_param(ParamName);
+    return (param != NULL) ? param->sval : "";
+}
+
+int core_config_force(const char* arg)
+{
+    char name[64];
+    const char* value = strchr(arg, '=');
+    struct config_param* param;
+
+    if (value == NULL || (size_t)(value - arg) >= sizeof(name)) {
+        return -1;
+    }
+
+    memcpy(name, arg, value - arg);
+    name[value - arg] = '\0';
+    ++value;
+
+    /* type is fixed later by the plugin defaults, keep every representation */
+    param = add_param(name, M64TYPE_STRING);
+    param->ival = atoi(value);
+    param->fval = (float)atof(value);
+    strncpy(param->sval, value, sizeof(param->sval) - 1);
+
+    return 0;
+}
+
+int core_config_is_set(const char* name)
+{
+    return find_param(name) != NULL;
+}
@@ -0,0 +1,39 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - core_config.h                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_TOOLS_CORE_CONFIG_H
+#define M64P_TOOLS_CORE_CONFIG_H
+
+/* Core config API for the tools which load plugins in place of the core.
+ *
+ * Parameters live in memory: plugins set their defaults, unless the parameter was
+ * forced from the command line first. All sections share the same parameters.
+ * The tools must export their symbols (-rdynamic) for the plugins to find the API,
+ * and pass their own handle (dlopen(NULL)) to PluginStartup.
+ */
+
+/* Force a parameter from a NAME=VALUE argument, return -1 if it isn't one */
+int core_config_force(const char* arg);
+
+/* Return non-zero if the parameter was forced or has a default */
+int core_config_is_set(const char* name);
+
+#endif
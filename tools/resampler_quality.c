@@ -0,0 +1,805 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - resampler_quality.c                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Resampler quality and throughput check.
+ *
+ * Runs every resampler configuration of this build over synthetic tones, impulses
+ * and sweeps at N64 rates and speed factors, driving them like the audio callback does.
+ * For each case it measures:
+ *  - snr:    1kHz tone at -6dBFS, fundamental vs everything but its harmonics (dB, higher is better)
+ *  - thdn:   same tone, everything but the fundamental vs the fundamental (dB, lower is better)
+ *  - ripple: gain spread of tones across the passband (dB, lower is better)
+ *  - alias:  level of the alias (downsampling) or image (upsampling) of a tone
+ *            outside of the shared band, relative to the tone (dB, lower is better)
+ *  - delay:  position of the impulse response peak relative to the impulse (output frames)
+ *  - fps:    output frames per second resampling a log sweep (higher is better)
+ *
+ * Results can be saved as a baseline and later compared against it;
+ * the exit status is non zero if any case regressed, or has no baseline
+ * (so that a resampler can't be added or enabled without its baseline rows).
+ * The baseline of the quality metrics is tools/resampler_quality.baseline, checked by `make quality`.
+ * Throughput depends on the machine: it is only compared when asked for (QUALITY_FPS=1).
+ * Writing a baseline keeps the rows of the cases this build doesn't measure (e.g. resamplers
+ * of libraries it was built without).
+ * No audio device is needed.
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "resamplers/resamplers.h"
+
+#include "m64p_types.h"
+
+#include "rt_check.h"
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+enum { CHANNELS = 2 };
+enum { FRAME_BYTES = 4 };
+
+/* output frames produced per resample call, like a 1024 samples SDL callback */
+enum { CHUNK_FRAMES = 1024 };
+
+/* output frames skipped before analysis, to let the filters settle */
+enum { WARMUP_FRAMES = 4096 };
+
+/* output frames analysed */
+enum { ANALYSIS_FRAMES = 16384 };
+
+/* number of passband tones */
+enum { RIPPLE_TONES = 12 };
+
+/* max number of sinusoids in a fit (fundamental + harmonics) */
+enum { MAX_FIT_TONES = 5 };
+
+static const unsigned int l_input_rates[] = { 22050, 32000, 44100 };
+static const unsigned int l_speed_factors[] = { 100, 50, 200 };
+
+#define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
+
+struct metrics
+{
+    double snr;
+    double thdn;
+    double ripple;
+    double alias;
+    double delay;
+    double fps;
+};
+
+struct result
+{
+    char id[64];
+    unsigned int input_rate;
+    unsigned int output_rate;
+    unsigned int speed_factor;
+    struct metrics metrics;
+};
+
+static int l_verbose = 0;
+
+void DebugMessage(int level, const char *message, ...)
+{
+    va_list args;
+
+    if (level > M64MSG_WARNING && !l_verbose) {
+        return;
+    }
+
+    va_start(args, message);
+    fprintf(stderr, "Resampler: ");
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double to_db(double power_ratio)
+{
+    return 10.0 * log10(power_ratio + 1e-30);
+}
+
+/* ----------- signal generation ------------- */
+
+static int16_t* alloc_frames(size_t frames)
+{
+    int16_t* samples = calloc(frames * CHANNELS, sizeof(int16_t));
+
+    if (samples == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return samples;
+}
+
+static void gen_tone(int16_t* samples, size_t frames, double frequency, unsigned int rate, double amplitude)
+{
+    size_t i;
+
+    for (i = 0; i < frames; ++i) {
+        int16_t s = (int16_t)lrint(32767.0 * amplitude * sin(2.0 * M_PI * frequency * i / rate));
+        samples[CHANNELS * i + 0] = s;
+        samples[CHANNELS * i + 1] = s;
+    }
+}
+
+static void gen_sweep(int16_t* samples, size_t frames, double f0, double f1, unsigned int rate, double amplitude)
+{
+    size_t i;
+    double duration = (double)frames / rate;
+    double k = log(f1 / f0);
+
+    for (i = 0; i < frames; ++i) {
+        double t = (double)i / rate;
+        double phase = 2.0 * M_PI * f0 * duration / k * (exp(t * k / duration) - 1.0);
+        int16_t s = (int16_t)lrint(32767.0 * amplitude * sin(phase));
+        samples[CHANNELS * i + 0] = s;
+        samples[CHANNELS * i + 1] = s;
+    }
+}
+
+/* ----------- resampling driver ------------- */
+
+/* Resample in CHUNK_FRAMES output blocks, feeding at most what a well filled primary buffer would hold.
+ * Returns the number of output frames produced. */
+static size_t run_resampler(const struct resampler_interface* iresampler, void* resampler,
+                            const int16_t* input, size_t input_frames, unsigned int input_rate,
+                            int16_t* output, size_t output_frames, unsigned int dst_freq)
+{
+    size_t pos = 0;
+    size_t produced = 0;
+
+    while (produced + CHUNK_FRAMES <= output_frames) {
+        size_t needed = (size_t)((uint64_t)CHUNK_FRAMES * input_rate / dst_freq);
+        size_t available = input_frames - pos;
+        size_t consumed;
+
+        if (available < needed) {
+            break;
+        }
+        if (available > 2 * needed + 256) {
+            available = 2 * needed + 256;
+        }
+
+        RT_CHECK_ENTER_CALLBACK();
+        consumed = iresampler->resample(resampler,
+                input + CHANNELS * pos, available * FRAME_BYTES, input_rate,
+                output + CHANNELS * produced, CHUNK_FRAMES * FRAME_BYTES, dst_freq);
+        RT_CHECK_LEAVE_CALLBACK();
+
+        pos += consumed / FRAME_BYTES;
+        produced += CHUNK_FRAMES;
+    }
+
+    return produced;
+}
+
+static const struct resampler_interface* new_resampler(const char* id, void** resampler)
+{
+    const struct resampler_interface* iresampler = get_iresampler(id, resampler);
+
+    /* same reservation as the backend with a default configuration */
+    iresampler->reserve(*resampler, RESAMPLER_LAYOUT_S16_INTERLEAVED, 16384 * FRAME_BYTES, CHUNK_FRAMES * FRAME_BYTES, 0);
+
+    return iresampler;
+}
+
+/* Resample input with a fresh resampler instance */
+static size_t resample(const char* id,
+                       const int16_t* input, size_t input_frames, unsigned int input_rate,
+                       int16_t* output, size_t output_frames, unsigned int dst_freq)
+{
+    void* resampler;
+    const struct resampler_interface* iresampler = new_resampler(id, &resampler);
+
+    size_t produced = run_resampler(iresampler, resampler,
+            input, input_frames, input_rate,
+            output, output_frames, dst_freq);
+
+    iresampler->release(resampler);
+    return produced;
+}
+
+/* ----------- analysis ------------- */
+
+/* Solve the n x n linear system a.x = b (in place, partial pivoting) */
+static void solve(double* a, double* b, size_t n)
+{
+    size_t i, j, k;
+
+    for (i = 0; i < n; ++i) {
+        size_t pivot = i;
+        for (j = i + 1; j < n; ++j) {
+            if (fabs(a[j * n + i]) > fabs(a[pivot * n + i])) {
+                pivot = j;
+            }
+        }
+        if (pivot != i) {
+            for (k = 0; k < n; ++k) {
+                double t = a[i * n + k]; a[i * n + k] = a[pivot * n + k]; a[pivot * n + k] = t;
+            }
+            { double t = b[i]; b[i] = b[pivot]; b[pivot] = t; }
+        }
+        if (fabs(a[i * n + i]) < 1e-12) {
+            continue;
+        }
+        for (j = i + 1; j < n; ++j) {
+            double f = a[j * n + i] / a[i * n + i];
+            for (k = i; k < n; ++k) {
+                a[j * n + k] -= f * a[i * n + k];
+            }
+            b[j] -= f * b[i];
+        }
+    }
+
+    for (i = n; i-- > 0;) {
+        double s = b[i];
+        for (k = i + 1; k < n; ++k) {
+            s -= a[i * n + k] * b[k];
+        }
+        b[i] = (fabs(a[i * n + i]) < 1e-12) ? 0.0 : s / a[i * n + i];
+    }
+}
+
+/* Least squares fit of DC + sinusoids at the given normalized angular frequencies
+ * on one channel of samples. Stores the power of each sinusoid in powers
+ * and returns the residual power. */
+static double fit_tones(const int16_t* samples, size_t frames, unsigned int channel,
+                        const double* omegas, size_t count, double* powers)
+{
+    enum { MAX_N = 1 + 2 * MAX_FIT_TONES };
+    double ata[MAX_N * MAX_N];
+    double atb[MAX_N];
+    double basis[MAX_N];
+    double residual = 0.0;
+    size_t n = 1 + 2 * count;
+    size_t i, j, k;
+
+    memset(ata, 0, sizeof(ata));
+    memset(atb, 0, sizeof(atb));
+
+    for (i = 0; i < frames; ++i) {
+        double y = samples[CHANNELS * i + channel] / 32768.0;
+
+        basis[0] = 1.0;
+        for (k = 0; k < count; ++k) {
+            basis[1 + 2 * k] = cos(omegas[k] * i);
+            basis[2 + 2 * k] = sin(omegas[k] * i);
+        }
+        for (j = 0; j < n; ++j) {
+            for (k = 0; k < n; ++k) {
+                ata[j * n + k] += basis[j] * basis[k];
+            }
+            atb[j] += basis[j] * y;
+        }
+    }
+
+    solve(ata, atb, n);
+
+    for (k = 0; k < count; ++k) {
+        powers[k] = 0.5 * (atb[1 + 2 * k] * atb[1 + 2 * k] + atb[2 + 2 * k] * atb[2 + 2 * k]);
+    }
+
+    for (i = 0; i < frames; ++i) {
+        double y = samples[CHANNELS * i + channel] / 32768.0 - atb[0];
+        for (k = 0; k < count; ++k) {
+            y -= atb[1 + 2 * k] * cos(omegas[k] * i) + atb[2 + 2 * k] * sin(omegas[k] * i);
+        }
+        residual += y * y;
+    }
+
+    return residual / frames;
+}
+
+/* Resample a tone and fit its fundamental (and optionally harmonics) on the output.
+ * Worst channel is reported. Returns the fundamental power and residual powers. */
+static void measure_tone(const char* id, unsigned int input_rate, unsigned int dst_freq,
+                         double frequency, double amplitude, size_t harmonics,
+                         double* fundamental_power, double* residual_power)
+{
+    size_t output_frames = WARMUP_FRAMES + ANALYSIS_FRAMES + CHUNK_FRAMES;
+    size_t input_frames = (size_t)((uint64_t)output_frames * input_rate / dst_freq) + 4 * CHUNK_FRAMES;
+    int16_t* input = alloc_frames(input_frames);
+    int16_t* output = alloc_frames(output_frames);
+    double omegas[MAX_FIT_TONES];
+    double powers[MAX_FIT_TONES];
+    size_t count = 0;
+    unsigned int channel;
+
+    gen_tone(input, input_frames, frequency, input_rate, amplitude);
+    resample(id, input, input_frames, input_rate, output, output_frames, dst_freq);
+
+    /* fundamental and harmonics below the output nyquist frequency */
+    while (count < 1 + harmonics && count < MAX_FIT_TONES && (count + 1) * frequency < 0.5 * dst_freq) {
+        omegas[count] = 2.0 * M_PI * (count + 1) * frequency / dst_freq;
+        ++count;
+    }
+
+    *fundamental_power = INFINITY;
+    *residual_power = 0.0;
+
+    for (channel = 0; channel < CHANNELS; ++channel) {
+        double residual = fit_tones(output + CHANNELS * WARMUP_FRAMES, ANALYSIS_FRAMES, channel, omegas, count, powers);
+        if (powers[0] < *fundamental_power) {
+            *fundamental_power = powers[0];
+        }
+        if (residual > *residual_power) {
+            *residual_power = residual;
+        }
+    }
+
+    free(input);
+    free(output);
+}
+
+/* Level of the component at target_frequency in the output, for a tone of the given frequency at the input */
+static double measure_spur(const char* id, unsigned int input_rate, unsigned int dst_freq,
+                           double frequency, double target_frequency)
+{
+    size_t output_frames = WARMUP_FRAMES + ANALYSIS_FRAMES + CHUNK_FRAMES;
+    size_t input_frames = (size_t)((uint64_t)output_frames * input_rate / dst_freq) + 4 * CHUNK_FRAMES;
+    int16_t* input = alloc_frames(input_frames);
+    int16_t* output = alloc_frames(output_frames);
+    double omega = 2.0 * M_PI * target_frequency / dst_freq;
+    double power, worst = 0.0;
+    unsigned int channel;
+
+    gen_tone(input, input_frames, frequency, input_rate, 0.5);
+    resample(id, input, input_frames, input_rate, output, output_frames, dst_freq);
+
+    for (channel = 0; channel < CHANNELS; ++channel) {
+        fit_tones(output + CHANNELS * WARMUP_FRAMES, ANALYSIS_FRAMES, channel, &omega, 1, &power);
+        if (power > worst) {
+            worst = power;
+        }
+    }
+
+    free(input);
+    free(output);
+
+    /* relative to the input tone power */
+    return to_db(worst / (0.5 * 0.5 * 0.5));
+}
+
+static double measure_alias(const char* id, unsigned int input_rate, unsigned int dst_freq)
+{
+    double input_nyquist = 0.5 * input_rate;
+    double output_nyquist = 0.5 * dst_freq;
+
+    if (input_rate > dst_freq * 21 / 20) {
+        /* downsampling: tone above the output nyquist folds back into the output band */
+        double frequency = 0.5 * (input_nyquist + output_nyquist);
+        return measure_spur(id, input_rate, dst_freq, frequency, dst_freq - frequency);
+    }
+    else if (0.6 * input_rate < 0.95 * output_nyquist) {
+        /* upsampling: image of a high tone mirrored around the input nyquist */
+        double frequency = 0.4 * input_rate;
+        return measure_spur(id, input_rate, dst_freq, frequency, input_rate - frequency);
+    }
+
+    /* rates too close for a meaningful measurement */
+    return NAN;
+}
+
+static double measure_ripple(const char* id, unsigned int input_rate, unsigned int dst_freq)
+{
+    double f0 = 50.0;
+    double f1 = 0.4 * ((input_rate < dst_freq) ? input_rate : dst_freq);
+    double gain_min = INFINITY, gain_max = -INFINITY;
+    size_t i;
+
+    for (i = 0; i < RIPPLE_TONES; ++i) {
+        double fundamental, residual;
+        double frequency = f0 * pow(f1 / f0, (double)i / (RIPPLE_TONES - 1));
+        double gain;
+
+        measure_tone(id, input_rate, dst_freq, frequency, 0.5, 0, &fundamental, &residual);
+        gain = to_db(fundamental / (0.5 * 0.5 * 0.5));
+
+        if (gain < gain_min) { gain_min = gain; }
+        if (gain > gain_max) { gain_max = gain; }
+    }
+
+    return gain_max - gain_min;
+}
+
+static double measure_delay(const char* id, unsigned int input_rate, unsigned int dst_freq)
+{
+    size_t output_frames = 2 * WARMUP_FRAMES + CHUNK_FRAMES;
+    size_t input_frames = (size_t)((uint64_t)output_frames * input_rate / dst_freq) + 4 * CHUNK_FRAMES;
+    size_t impulse_frame = (size_t)((uint64_t)WARMUP_FRAMES * input_rate / dst_freq);
+    int16_t* input = alloc_frames(input_frames);
+    int16_t* output = alloc_frames(output_frames);
+    size_t produced, i, peak = 0;
+
+    input[CHANNELS * impulse_frame + 0] = 16384;
+    input[CHANNELS * impulse_frame + 1] = 16384;
+
+    produced = resample(id, input, input_frames, input_rate, output, output_frames, dst_freq);
+
+    for (i = 0; i < produced; ++i) {
+        if (abs(output[CHANNELS * i]) > abs(output[CHANNELS * peak])) {
+            peak = i;
+        }
+    }
+
+    free(input);
+    free(output);
+
+    return (double)peak - (double)impulse_frame * dst_freq / input_rate;
+}
+
+static double measure_fps(const char* id, unsigned int input_rate, unsigned int dst_freq, double seconds)
+{
+    size_t output_frames = (size_t)(seconds * dst_freq) / CHUNK_FRAMES * CHUNK_FRAMES;
+    size_t input_frames = (size_t)((uint64_t)output_frames * input_rate / dst_freq) + 4 * CHUNK_FRAMES;
+    int16_t* input = alloc_frames(input_frames);
+    int16_t* output = alloc_frames(output_frames);
+    const struct resampler_interface* iresampler;
+    void* resampler;
+    double best = 0.0;
+    int run;
+
+    gen_sweep(input, input_frames, 20.0, 0.45 * input_rate, input_rate, 0.5);
+
+    /* best of 3 runs, on a warm instance */
+    iresampler = new_resampler(id, &resampler);
+    run_resampler(iresampler, resampler, input, input_frames / 8, input_rate, output, output_frames / 8, dst_freq);
+
+    for (run = 0; run < 3; ++run) {
+        double start = now_seconds();
+        size_t produced = run_resampler(iresampler, resampler,
+                input, input_frames, input_rate,
+                output, output_frames, dst_freq);
+        double elapsed = now_seconds() - start;
+
+        if (elapsed > 0.0 && produced / elapsed > best) {
+            best = produced / elapsed;
+        }
+    }
+
+    iresampler->release(resampler);
+    free(input);
+    free(output);
+
+    return best;
+}
+
+static void measure(const char* id, unsigned int input_rate, unsigned int output_rate, unsigned int speed_factor,
+                    double fps_seconds, struct metrics* metrics)
+{
+    /* same output frequency as in the audio callback */
+    unsigned int dst_freq = output_rate * 100 / speed_factor;
+    double fundamental, residual_harmonics, residual;
+
+    measure_tone(id, input_rate, dst_freq, 1000.0, 0.5, MAX_FIT_TONES - 1, &fundamental, &residual_harmonics);
+    metrics->snr = to_db(fundamental / residual_harmonics);
+
+    measure_tone(id, input_rate, dst_freq, 1000.0, 0.5, 0, &fundamental, &residual);
+    metrics->thdn = to_db(residual / fundamental);
+
+    metrics->ripple = measure_ripple(id, input_rate, dst_freq);
+    metrics->alias = measure_alias(id, input_rate, dst_freq);
+    metrics->delay = measure_delay(id, input_rate, dst_freq);
+    metrics->fps = measure_fps(id, input_rate, dst_freq, fps_seconds);
+}
+
+/* ----------- baselines ------------- */
+
+static void print_result(FILE* f, const struct result* result)
+{
+    fprintf(f, "%-24s %6u %6u %4u %8.2f %8.2f %7.3f %8.2f %7.1f %12.0f\n",
+            result->id, result->input_rate, result->output_rate, result->speed_factor,
+            result->metrics.snr, result->metrics.thdn, result->metrics.ripple,
+            result->metrics.alias, result->metrics.delay, result->metrics.fps);
+}
+
+static void print_header(FILE* f)
+{
+    fprintf(f, "# %-22s %6s %6s %4s %8s %8s %7s %8s %7s %12s\n",
+            "resampler", "in", "out", "spd", "snr", "thdn", "ripple", "alias", "delay", "fps");
+}
+
+static void append_result(struct result** results, size_t* count, size_t* capacity, const struct result* r)
+{
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? 64 : 2 * *capacity;
+        *results = realloc(*results, *capacity * sizeof(**results));
+        if (*results == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    (*results)[(*count)++] = *r;
+}
+
+/* Load the results of a baseline file. A missing file is an error unless optional is set. */
+static struct result* load_baseline(const char* filename, size_t* count, int optional)
+{
+    FILE* f = fopen(filename, "r");
+    struct result* results = NULL;
+    size_t capacity = 0;
+    char line[512];
+
+    *count = 0;
+
+    if (f == NULL) {
+        if (optional) {
+            return NULL;
+        }
+        fprintf(stderr, "Couldn't open baseline %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        struct result r;
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        if (sscanf(line, "%63s %u %u %u %lf %lf %lf %lf %lf %lf",
+                   r.id, &r.input_rate, &r.output_rate, &r.speed_factor,
+                   &r.metrics.snr, &r.metrics.thdn, &r.metrics.ripple,
+                   &r.metrics.alias, &r.metrics.delay, &r.metrics.fps) != 10) {
+            continue;
+        }
+
+        append_result(&results, count, &capacity, &r);
+    }
+
+    fclose(f);
+    return results;
+}
+
+static const struct result* find_result(const struct result* results, size_t count, const struct result* key)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        if (strcmp(results[i].id, key->id) == 0
+         && results[i].input_rate == key->input_rate
+         && results[i].output_rate == key->output_rate
+         && results[i].speed_factor == key->speed_factor) {
+            return &results[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Save results, followed by the rows of previous that weren't measured again */
+static void write_baseline(const char* filename, const struct result* results, size_t count,
+                           const struct result* previous, size_t previous_count)
+{
+    FILE* f = fopen(filename, "w");
+    size_t i;
+
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't create %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    print_header(f);
+
+    for (i = 0; i < count; ++i) {
+        print_result(f, &results[i]);
+    }
+
+    for (i = 0; i < previous_count; ++i) {
+        if (find_result(results, count, &previous[i]) == NULL) {
+            print_result(f, &previous[i]);
+        }
+    }
+
+    fclose(f);
+}
+
+/* Print and count regressions of result against its baseline */
+static int compare_result(const struct result* result, const struct result* base, double tolerance, double fps_tolerance)
+{
+    const struct metrics* m = &result->metrics;
+    const struct metrics* b = &base->metrics;
+    int regressions = 0;
+
+#define REGRESSION(cond, name, value, base_value) \
+    if (cond) { \
+        printf("REGRESSION %s %u->%u @%u%%: %s %.3f (baseline %.3f)\n", \
+               result->id, result->input_rate, result->output_rate, result->speed_factor, \
+               name, value, base_value); \
+        ++regressions; \
+    }
+
+    REGRESSION(m->snr < b->snr - tolerance, "snr", m->snr, b->snr);
+    REGRESSION(m->thdn > b->thdn + tolerance, "thdn", m->thdn, b->thdn);
+    REGRESSION(m->ripple > b->ripple + 0.1 * tolerance, "ripple", m->ripple, b->ripple);
+    REGRESSION(!isnan(b->alias) && m->alias > b->alias + tolerance, "alias", m->alias, b->alias);
+    REGRESSION(fabs(m->delay - b->delay) > 1.0, "delay", m->delay, b->delay);
+    REGRESSION(fps_tolerance >= 0.0 && m->fps < b->fps * (1.0 - fps_tolerance / 100.0), "fps", m->fps, b->fps);
+
+#undef REGRESSION
+
+    return regressions;
+}
+
+/* ----------- main ------------- */
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "Options:\n"
+        "  --resampler ID        only check this resampler (may be repeated, default: all)\n"
+        "  --output-rate RATE    output frequency (default: 48000)\n"
+        "  --quick               only check the nominal speed factor, with a shorter throughput run\n"
+        "  --write-baseline FILE save results as a baseline\n"
+        "  --baseline FILE       compare results against a baseline, fail on regressions\n"
+        "                        and on cases without baseline\n"
+        "  --tolerance DB        allowed quality loss (default: 0.5 dB, ripple: a tenth of it)\n"
+        "  --fps-tolerance PCT   allowed throughput loss (default: 25, negative to disable)\n"
+        "  --verbose             show resampler messages\n",
+        argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* selected[64];
+    size_t selected_count = 0;
+    const char* baseline_file = NULL;
+    const char* write_file = NULL;
+    unsigned int output_rate = 48000;
+    double tolerance = 0.5;
+    double fps_tolerance = 25.0;
+    double fps_seconds = 5.0;
+    size_t speed_count = ARRAY_SIZE(l_speed_factors);
+    struct result* baseline = NULL;
+    size_t baseline_count = 0;
+    struct result* results = NULL;
+    size_t result_count = 0;
+    size_t result_capacity = 0;
+    int regressions = 0;
+    int missing = 0;
+    const char* id;
+    size_t i, r, s;
+    int a;
+
+    for (a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--resampler") == 0 && a + 1 < argc && selected_count < ARRAY_SIZE(selected)) {
+            selected[selected_count++] = argv[++a];
+        }
+        else if (strcmp(argv[a], "--output-rate") == 0 && a + 1 < argc) {
+            output_rate = (unsigned int)atoi(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--quick") == 0) {
+            speed_count = 1;
+            fps_seconds = 1.0;
+        }
+        else if (strcmp(argv[a], "--baseline") == 0 && a + 1 < argc) {
+            baseline_file = argv[++a];
+        }
+        else if (strcmp(argv[a], "--write-baseline") == 0 && a + 1 < argc) {
+            write_file = argv[++a];
+        }
+        else if (strcmp(argv[a], "--tolerance") == 0 && a + 1 < argc) {
+            tolerance = atof(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--fps-tolerance") == 0 && a + 1 < argc) {
+            fps_tolerance = atof(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--verbose") == 0) {
+            l_verbose = 1;
+        }
+        else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (output_rate == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (baseline_file != NULL) {
+        baseline = load_baseline(baseline_file, &baseline_count, 0);
+    }
+
+    RT_CHECK_RESET();
+    print_header(stdout);
+
+    for (i = 0; (id = get_resampler_id(i)) != NULL; ++i) {
+        if (selected_count > 0) {
+            size_t j;
+            for (j = 0; j < selected_count && strcmp(selected[j], id) != 0; ++j) {}
+            if (j == selected_count) {
+                continue;
+            }
+        }
+
+        for (r = 0; r < ARRAY_SIZE(l_input_rates); ++r) {
+            for (s = 0; s < speed_count; ++s) {
+                struct result result;
+
+                memset(&result, 0, sizeof(result));
+                strncpy(result.id, id, sizeof(result.id) - 1);
+                result.input_rate = l_input_rates[r];
+                result.output_rate = output_rate;
+                result.speed_factor = l_speed_factors[s];
+
+                measure(id, result.input_rate, output_rate, result.speed_factor, fps_seconds, &result.metrics);
+
+                print_result(stdout, &result);
+                fflush(stdout);
+                append_result(&results, &result_count, &result_capacity, &result);
+
+                /* an empty baseline has no results at all */
+                if (baseline_file != NULL) {
+                    const struct result* base = find_result(baseline, baseline_count, &result);
+                    if (base != NULL) {
+                        regressions += compare_result(&result, base, tolerance, fps_tolerance);
+                    }
+                    else {
+                        printf("MISSING %s %u->%u @%u%%: no baseline\n",
+                               result.id, result.input_rate, result.output_rate, result.speed_factor);
+                        ++missing;
+                    }
+                }
+            }
+        }
+    }
+
+    RT_CHECK_REPORT();
+
+    if (write_file != NULL) {
+        size_t previous_count;
+        struct result* previous = load_baseline(write_file, &previous_count, 1);
+
+        write_baseline(write_file, results, result_count, previous, previous_count);
+        free(previous);
+    }
+    free(results);
+    free(baseline);
+
+    if (baseline_file != NULL) {
+        printf("%d regression(s), %d case(s) without baseline\n", regressions, missing);
+        if (missing != 0) {
+            printf("Record the missing cases with --write-baseline (make quality-baseline)\n");
+        }
+    }
+
+    return (regressions == 0 && missing == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,329 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - rt_check_resamplers.c                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Real-time safety test of the resamplers, for RT_CHECK=1 builds (make rt-check).
+ *
+ * Drives every resampler configuration of this build from each input layout it accepts,
+ * the way the backend does:
+ *  - buffers are reserved outside of the audio callback, for the primary buffer and mix
+ *    buffer sizes, on every reconfiguration (secondary buffer size changes up and down)
+ *  - resample/resample_planar then run under the callback mark, with input sizes from empty
+ *    to a full primary buffer, partial outputs, and input rate and speed factor changes
+ *  - deferred messages are flushed outside of the callback, like the emulation thread does
+ *
+ * Any allocation, lock or logging counted by the checker fails the test, and the cases
+ * where it happened are listed. No audio device is needed.
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hot_log.h"
+#include "main.h"
+#include "resamplers/resamplers.h"
+#include "sample_format.h"
+
+#include "m64p_types.h"
+
+#include "rt_check.h"
+
+#if !defined(RT_CHECK)
+#error "the real-time safety test must be built with RT_CHECK=1 (make rt-check)"
+#endif
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+enum { FRAME_BYTES = 4 };
+enum { OUTPUT_RATE = 48000 };
+
+/* callbacks run per configuration */
+enum { CALLBACKS = 96 };
+
+/* in this order, so that reservations both grow and shrink */
+static const size_t l_secondary_sizes[] = { 1024, 256, 4096, 512, 2048 };
+static const unsigned int l_input_rates[] = { 32000, 22050, 44100, 48000 };
+static const unsigned int l_speed_factors[] = { 100, 50, 200, 10, 300 };
+static const unsigned int l_layouts[] = {
+    RESAMPLER_LAYOUT_S16_INTERLEAVED,
+    RESAMPLER_LAYOUT_S16_PLANAR,
+    RESAMPLER_LAYOUT_F32_PLANAR
+};
+
+#define ARRAY_SIZE(x) sizeof((x)) / sizeof((x)[0])
+
+static int l_verbose = 0;
+
+void DebugMessage(int level, const char *message, ...)
+{
+    va_list args;
+
+    /* same check as the plugin's DebugMessage */
+    RT_CHECK_POINT(RT_CHECK_LOG);
+
+    if (level > M64MSG_WARNING && !l_verbose) {
+        return;
+    }
+
+    va_start(args, message);
+    fprintf(stderr, "RT check test: ");
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static void* alloc_or_die(size_t size)
+{
+    void* p = calloc(1, size);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return p;
+}
+
+static const char* layout_name(unsigned int layout)
+{
+    switch (layout)
+    {
+    case RESAMPLER_LAYOUT_S16_INTERLEAVED: return "s16";
+    case RESAMPLER_LAYOUT_S16_PLANAR: return "s16-planar";
+    case RESAMPLER_LAYOUT_F32_PLANAR: return "f32-planar";
+    default: return "?";
+    }
+}
+
+/* Primary buffer size (in frames) of a secondary buffer size, like the backend's default configuration */
+static size_t primary_frames(size_t secondary_size)
+{
+    size_t frames = 16384;
+
+    while (frames < 4 * secondary_size) {
+        frames *= 2;
+    }
+
+    return frames;
+}
+
+/* Input bytes available at the n-th callback: empty, starved, nominal, backlogged and full buffers */
+static size_t available_frames(unsigned int n, size_t needed, size_t primary)
+{
+    size_t frames;
+
+    switch (n % 6)
+    {
+    case 0: frames = 0; break;
+    case 1: frames = needed / 3 + 1; break;
+    case 2: frames = needed; break;
+    case 3: frames = needed + 7; break;
+    case 4: frames = 3 * needed + 13; break;
+    default: frames = primary; break;
+    }
+
+    return (frames < primary) ? frames : primary;
+}
+
+struct test_input
+{
+    /* interleaved frames, and the same frames split in the planes of each layout */
+    int16_t* interleaved;
+    int16_t* s16_planes[2];
+    float* f32_planes[2];
+    size_t frames;
+};
+
+static void init_input(struct test_input* input, size_t frames)
+{
+    size_t i;
+
+    input->frames = frames;
+    input->interleaved = alloc_or_die(frames * FRAME_BYTES);
+    input->s16_planes[0] = alloc_or_die(frames * sizeof(int16_t));
+    input->s16_planes[1] = alloc_or_die(frames * sizeof(int16_t));
+    input->f32_planes[0] = alloc_or_die(frames * sizeof(float));
+    input->f32_planes[1] = alloc_or_die(frames * sizeof(float));
+
+    for (i = 0; i < frames; ++i) {
+        input->interleaved[2 * i + 0] = (int16_t)lrint(16384.0 * sin(2.0 * M_PI * 440.0 * i / 32000.0));
+        input->interleaved[2 * i + 1] = (int16_t)lrint(16384.0 * sin(2.0 * M_PI * 660.0 * i / 32000.0));
+    }
+
+    deinterleave_s16(input->s16_planes[0], input->s16_planes[1], input->interleaved, frames * FRAME_BYTES);
+    deinterleave_s16_to_f32(input->f32_planes[0], input->f32_planes[1], input->interleaved, frames * FRAME_BYTES);
+}
+
+static void release_input(struct test_input* input)
+{
+    free(input->interleaved);
+    free(input->s16_planes[0]);
+    free(input->s16_planes[1]);
+    free(input->f32_planes[0]);
+    free(input->f32_planes[1]);
+}
+
+/* Run one resampler instance through every size configuration in the given layout.
+ * Return the number of violations counted. */
+static int test_layout(const char* id, unsigned int layout, const struct test_input* input, unsigned char* output)
+{
+    const struct resampler_interface* iresampler;
+    void* resampler;
+    size_t frame_bytes = get_resampler_frame_bytes(layout);
+    int failed = 0;
+    size_t s;
+
+    /* like the backend, the resampler is created once and reserved on every reconfiguration */
+    iresampler = get_iresampler(id, &resampler);
+    hot_log_flush(1);
+
+    for (s = 0; s < ARRAY_SIZE(l_secondary_sizes); ++s) {
+        size_t secondary = l_secondary_sizes[s];
+        size_t primary = primary_frames(secondary);
+        int before;
+        unsigned int n;
+
+        iresampler->reserve(resampler, layout, primary * frame_bytes, secondary * FRAME_BYTES, 0);
+
+        before = RT_CHECK_VIOLATIONS();
+
+        for (n = 0; n < CALLBACKS; ++n) {
+            unsigned int input_rate = l_input_rates[(n / 12) % ARRAY_SIZE(l_input_rates)];
+            unsigned int speed_factor = l_speed_factors[(n / 5) % ARRAY_SIZE(l_speed_factors)];
+            uint64_t dst_rate = (uint64_t)OUTPUT_RATE * 100 / speed_factor;
+            /* partial callbacks, as when the device asks for less than a secondary buffer */
+            size_t dst_frames = (n % 7 == 3) ? secondary / 2 + 1 : secondary;
+            size_t needed = (size_t)(dst_frames * input_rate / dst_rate) + 1;
+            size_t frames = available_frames(n, needed, primary);
+            size_t offset = (n * 131) % (input->frames - frames + 1);
+
+            RT_CHECK_ENTER_CALLBACK();
+            if (layout == RESAMPLER_LAYOUT_S16_INTERLEAVED) {
+                iresampler->resample(resampler,
+                        input->interleaved + 2 * offset, frames * frame_bytes, input_rate,
+                        output, dst_frames * FRAME_BYTES, dst_rate);
+            }
+            else {
+                const void* planes[2];
+
+                if (layout == RESAMPLER_LAYOUT_S16_PLANAR) {
+                    planes[0] = input->s16_planes[0] + offset;
+                    planes[1] = input->s16_planes[1] + offset;
+                }
+                else {
+                    planes[0] = input->f32_planes[0] + offset;
+                    planes[1] = input->f32_planes[1] + offset;
+                }
+
+                iresampler->resample_planar(resampler, layout,
+                        planes, frames * frame_bytes, input_rate,
+                        output, dst_frames * FRAME_BYTES, dst_rate);
+            }
+            RT_CHECK_LEAVE_CALLBACK();
+
+            if (n % 16 == 15) {
+                hot_log_flush(1);
+            }
+        }
+
+        hot_log_flush(1);
+
+        if (RT_CHECK_VIOLATIONS() != before) {
+            printf("FAIL %s %s secondary %u primary %u: %d violation(s)\n",
+                    id, layout_name(layout), (unsigned int)secondary, (unsigned int)primary,
+                    RT_CHECK_VIOLATIONS() - before);
+            failed = 1;
+        }
+        else if (l_verbose) {
+            printf("ok   %s %s secondary %u primary %u\n",
+                    id, layout_name(layout), (unsigned int)secondary, (unsigned int)primary);
+        }
+    }
+
+    iresampler->release(resampler);
+
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    struct test_input input;
+    unsigned char* output;
+    size_t max_secondary = 0;
+    size_t i, l;
+    const char* id;
+    int failures = 0;
+    int cases = 0;
+    int a;
+
+    for (a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--verbose") == 0) {
+            l_verbose = 1;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--verbose]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(l_secondary_sizes); ++i) {
+        if (l_secondary_sizes[i] > max_secondary) {
+            max_secondary = l_secondary_sizes[i];
+        }
+    }
+
+    init_input(&input, primary_frames(max_secondary) + 4096);
+    output = alloc_or_die(max_secondary * FRAME_BYTES);
+
+    RT_CHECK_RESET();
+
+    for (i = 0; (id = get_resampler_id(i)) != NULL; ++i) {
+        void* probe;
+        const struct resampler_interface* iresampler = get_iresampler(id, &probe);
+        unsigned int layouts = iresampler->layouts;
+
+        iresampler->release(probe);
+
+        for (l = 0; l < ARRAY_SIZE(l_layouts); ++l) {
+            if (!(layouts & l_layouts[l])
+             || (l_layouts[l] != RESAMPLER_LAYOUT_S16_INTERLEAVED && iresampler->resample_planar == NULL)) {
+                continue;
+            }
+
+            failures += test_layout(id, l_layouts[l], &input, output);
+            ++cases;
+        }
+    }
+
+    RT_CHECK_REPORT();
+
+    free(output);
+    release_input(&input);
+
+    printf("%d resampler/layout case(s), %d failed\n", cases, failures);
+
+    return (failures == 0 && RT_CHECK_VIOLATIONS() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,489 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - shm_reader.c                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Example reader of the shared memory output tap (SHM_TAP_NAME).
+ *
+ * Attaches read-only to the ring published by the plugin, follows it in real time
+ * and optionally writes the frames to a WAV file. While reading it checks that
+ * the stream goes through intact:
+ *  - frames lost because the reader fell more than the ring size behind, or
+ *    overwritten while being copied, are counted and never output;
+ *  - every block must start where the previous one ended;
+ *  - the delay between the audio callback and the reader is measured.
+ *
+ * The exit status is non-zero if the stream was inconsistent, or with --strict
+ * if any frame was lost, so it can be used to check a tap under load.
+ * With --counter, the frames must hold the pattern of tools/shm_writer.c (frame n
+ * holds n), and any other output frame is counted as corrupted and fails the run:
+ * this is how make shm-test checks that no torn frame goes undetected.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shm_tap.h"
+
+/* frames copied per read */
+enum { READ_CHUNK_FRAMES = 4096 };
+
+#define LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+
+struct tap_mapping
+{
+    const unsigned char* data;
+    size_t size;
+    const struct shm_tap_header* header;
+    const struct shm_tap_block* blocks;
+    const unsigned char* frames;
+};
+
+struct reader_stats
+{
+    uint64_t frames;
+    uint64_t blocks;
+    uint64_t lost_frames;
+    uint64_t torn_frames;
+    uint64_t skipped_blocks;
+    uint64_t discontinuities;
+    uint64_t corrupted_frames;
+    uint64_t delay_ns_sum;
+    uint64_t delay_ns_max;
+    /* since the last periodic report */
+    uint64_t interval_delay_ns_max;
+};
+
+struct wav_output
+{
+    FILE* file;
+    unsigned int frequency;
+    uint32_t data_size;
+};
+
+static uint64_t clock_ns(void)
+{
+    struct timespec ts;
+
+    /* same clock as osal_shm_clock_ns */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    nanosleep(&ts, NULL);
+}
+
+static int attach_tap(const char* name, struct tap_mapping* map)
+{
+    char shm_name[256];
+    struct stat st;
+    const struct shm_tap_header* header;
+    int fd;
+
+    snprintf(shm_name, sizeof(shm_name), "%s%s", (name[0] == '/') ? "" : "/", name);
+
+    fd = shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct shm_tap_header)) {
+        close(fd);
+        return -1;
+    }
+
+    map->size = (size_t)st.st_size;
+    map->data = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map->data == MAP_FAILED) {
+        return -1;
+    }
+
+    header = (const struct shm_tap_header*)map->data;
+    if (LOAD_ACQUIRE(header->magic) != SHM_TAP_MAGIC || header->version != SHM_TAP_VERSION
+     || header->frame_size != 4 || header->channels != 2
+     || (header->frame_capacity & (header->frame_capacity - 1)) != 0
+     || (header->block_capacity & (header->block_capacity - 1)) != 0
+     || (size_t)header->blocks_offset + (size_t)header->block_capacity * sizeof(struct shm_tap_block) > map->size
+     || (size_t)header->frames_offset + (size_t)header->frame_capacity * header->frame_size > map->size) {
+        munmap((void*)map->data, map->size);
+        return -2;
+    }
+
+    map->header = header;
+    map->blocks = (const struct shm_tap_block*)(map->data + header->blocks_offset);
+    map->frames = map->data + header->frames_offset;
+
+    return 0;
+}
+
+static void write_le32(unsigned char* dst, uint32_t value)
+{
+    dst[0] = (unsigned char)value;
+    dst[1] = (unsigned char)(value >> 8);
+    dst[2] = (unsigned char)(value >> 16);
+    dst[3] = (unsigned char)(value >> 24);
+}
+
+static void write_wav_header(struct wav_output* wav)
+{
+    unsigned char h[44];
+
+    memcpy(h, "RIFF", 4);
+    write_le32(h + 4, 36 + wav->data_size);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    write_le32(h + 16, 16);
+    /* PCM, 2 channels */
+    write_le32(h + 20, 1 | (2 << 16));
+    write_le32(h + 24, wav->frequency);
+    write_le32(h + 28, wav->frequency * 4);
+    /* block align 4, 16 bits per sample */
+    write_le32(h + 32, 4 | (16 << 16));
+    memcpy(h + 36, "data", 4);
+    write_le32(h + 40, wav->data_size);
+
+    fseek(wav->file, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), wav->file);
+    fseek(wav->file, 0, SEEK_END);
+}
+
+static void wav_write(struct wav_output* wav, const unsigned char* frames, size_t count)
+{
+    size_t i;
+
+    if (wav->file == NULL) {
+        return;
+    }
+
+    /* WAV is little endian, the tap is in host byte order */
+    for (i = 0; i < count * 2; ++i) {
+        uint16_t sample;
+        unsigned char le[2];
+        memcpy(&sample, frames + i * 2, 2);
+        le[0] = (unsigned char)sample;
+        le[1] = (unsigned char)(sample >> 8);
+        fwrite(le, 1, 2, wav->file);
+    }
+
+    wav->data_size += (uint32_t)(count * 4);
+}
+
+/* Reads the block entries published since *next_block */
+static void read_blocks(const struct tap_mapping* map, uint32_t* next_block, uint32_t* expected_frame,
+                        int* have_expected, struct reader_stats* stats, struct wav_output* wav)
+{
+    const struct shm_tap_header* header = map->header;
+    uint32_t write_block = LOAD_ACQUIRE(header->write_block);
+    uint64_t now = clock_ns();
+
+    if (write_block - *next_block > header->block_capacity) {
+        stats->skipped_blocks += write_block - *next_block - header->block_capacity;
+        *next_block = write_block - header->block_capacity;
+        *have_expected = 0;
+    }
+
+    while (*next_block != write_block) {
+        const struct shm_tap_block* entry = &map->blocks[*next_block & (header->block_capacity - 1)];
+        uint32_t stamp = *next_block + 1;
+        struct shm_tap_block block;
+
+        if (LOAD_ACQUIRE(entry->stamp) != stamp) {
+            ++stats->skipped_blocks;
+            *have_expected = 0;
+            ++*next_block;
+            continue;
+        }
+        memcpy(&block, (const void*)entry, sizeof(block));
+        if (LOAD_ACQUIRE(entry->stamp) != stamp) {
+            ++stats->skipped_blocks;
+            *have_expected = 0;
+            ++*next_block;
+            continue;
+        }
+
+        if (*have_expected && block.first_frame != *expected_frame) {
+            fprintf(stderr, "Block %u starts at frame %u, expected %u\n",
+                    (unsigned int)*next_block, (unsigned int)block.first_frame, (unsigned int)*expected_frame);
+            ++stats->discontinuities;
+        }
+        *expected_frame = block.first_frame + block.frames;
+        *have_expected = 1;
+
+        if (block.frequency != wav->frequency) {
+            if (wav->frequency != 0) {
+                fprintf(stderr, "Output frequency changed from %u to %u Hz\n", wav->frequency, (unsigned int)block.frequency);
+            }
+            if (wav->data_size == 0) {
+                wav->frequency = block.frequency;
+            }
+        }
+
+        if (now > block.timestamp_ns) {
+            uint64_t delay = now - block.timestamp_ns;
+            stats->delay_ns_sum += delay;
+            if (delay > stats->delay_ns_max) {
+                stats->delay_ns_max = delay;
+            }
+            if (delay > stats->interval_delay_ns_max) {
+                stats->interval_delay_ns_max = delay;
+            }
+        }
+
+        ++stats->blocks;
+        ++*next_block;
+    }
+}
+
+/* Checks the counter pattern of shm_writer, frames holds count frames starting at frame */
+static void check_counter(const unsigned char* frames, uint32_t frame, uint32_t count,
+                          struct reader_stats* stats)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        uint16_t sample[2];
+        uint32_t n = frame + i;
+
+        memcpy(sample, frames + (size_t)i * 4, 4);
+        if (sample[0] != (uint16_t)n || sample[1] != (uint16_t)(n >> 16)) {
+            if (stats->corrupted_frames == 0) {
+                fprintf(stderr, "Frame %u holds %u\n", (unsigned int)n,
+                        (unsigned int)sample[0] | ((unsigned int)sample[1] << 16));
+            }
+            ++stats->corrupted_frames;
+        }
+    }
+}
+
+/* Reads the frames published since *next_frame, returns 0 if there were none */
+static int read_frames(const struct tap_mapping* map, uint32_t* next_frame, int counter,
+                       struct reader_stats* stats, struct wav_output* wav)
+{
+    static unsigned char chunk[READ_CHUNK_FRAMES * 4];
+    const struct shm_tap_header* header = map->header;
+    uint32_t capacity = header->frame_capacity;
+    uint32_t write_frame = LOAD_ACQUIRE(header->write_frame);
+    uint32_t count, pos, first, overwritten;
+
+    if (write_frame == *next_frame) {
+        return 0;
+    }
+
+    if (write_frame - *next_frame > capacity) {
+        stats->lost_frames += write_frame - *next_frame - capacity;
+        *next_frame = write_frame - capacity;
+    }
+
+    count = write_frame - *next_frame;
+    if (count > READ_CHUNK_FRAMES) {
+        count = READ_CHUNK_FRAMES;
+    }
+
+    pos = *next_frame & (capacity - 1);
+    first = (count < capacity - pos) ? count : capacity - pos;
+    memcpy(chunk, map->frames + (size_t)pos * 4, (size_t)first * 4);
+    memcpy(chunk + (size_t)first * 4, map->frames, (size_t)(count - first) * 4);
+
+    /* frames the writer may have overwritten while they were copied */
+    overwritten = LOAD_ACQUIRE(header->reserve_frame) - *next_frame;
+    overwritten = (overwritten > capacity) ? overwritten - capacity : 0;
+    if (overwritten > count) {
+        overwritten = count;
+    }
+
+    stats->torn_frames += overwritten;
+    stats->frames += count - overwritten;
+    if (counter) {
+        check_counter(chunk + (size_t)overwritten * 4, *next_frame + overwritten, count - overwritten, stats);
+    }
+    wav_write(wav, chunk + (size_t)overwritten * 4, count - overwritten);
+
+    *next_frame += count;
+    return 1;
+}
+
+static void print_stats(const char* label, const struct reader_stats* stats)
+{
+    fprintf(stderr, "%s: %llu frames, %llu blocks, lost %llu, torn %llu, skipped blocks %llu, "
+            "discontinuities %llu, corrupted %llu, delay avg %.2f ms max %.2f ms\n",
+            label,
+            (unsigned long long)stats->frames, (unsigned long long)stats->blocks,
+            (unsigned long long)stats->lost_frames, (unsigned long long)stats->torn_frames,
+            (unsigned long long)stats->skipped_blocks, (unsigned long long)stats->discontinuities,
+            (unsigned long long)stats->corrupted_frames,
+            (stats->blocks != 0) ? (double)stats->delay_ns_sum / stats->blocks / 1e6 : 0.0,
+            (double)stats->delay_ns_max / 1e6);
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options] NAME\n"
+        "  NAME                  shared memory object name (SHM_TAP_NAME)\n"
+        "  --output FILE         write the frames to this WAV file\n"
+        "  --duration S          stop after S seconds (default: until the plugin stops the tap)\n"
+        "  --wait                wait for the tap to be created\n"
+        "  --strict              fail if any frame was lost\n"
+        "  --counter             check the counter pattern of shm_writer\n"
+        "  --quiet               only print the final summary\n",
+        argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* name = NULL;
+    const char* output = NULL;
+    double duration_s = 0.0;
+    int wait = 0;
+    int strict = 0;
+    int counter = 0;
+    int quiet = 0;
+    struct tap_mapping map;
+    struct reader_stats stats, last_stats;
+    struct wav_output wav;
+    uint32_t next_frame, next_block, expected_frame = 0;
+    int have_expected = 0;
+    uint64_t start, last_report;
+    int status;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--wait") == 0) { wait = 1; continue; }
+        if (strcmp(arg, "--strict") == 0) { strict = 1; continue; }
+        if (strcmp(arg, "--counter") == 0) { counter = 1; continue; }
+        if (strcmp(arg, "--quiet") == 0) { quiet = 1; continue; }
+        if (arg[0] != '-' && name == NULL) { name = arg; continue; }
+        if (value == NULL) { print_usage(argv[0]); return EXIT_FAILURE; }
+        else if (strcmp(arg, "--output") == 0) { output = value; }
+        else if (strcmp(arg, "--duration") == 0) { duration_s = atof(value); }
+        else { print_usage(argv[0]); return EXIT_FAILURE; }
+        ++i;
+    }
+
+    if (name == NULL) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    while ((status = attach_tap(name, &map)) != 0) {
+        if (status == -2) {
+            fprintf(stderr, "%s is not a compatible audio tap\n", name);
+            return EXIT_FAILURE;
+        }
+        if (!wait) {
+            fprintf(stderr, "Couldn't open %s\n", name);
+            return EXIT_FAILURE;
+        }
+        sleep_ms(100);
+    }
+
+    memset(&wav, 0, sizeof(wav));
+    if (output != NULL) {
+        wav.file = fopen(output, "wb");
+        if (wav.file == NULL) {
+            fprintf(stderr, "Couldn't create %s\n", output);
+            return EXIT_FAILURE;
+        }
+        write_wav_header(&wav);
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    last_stats = stats;
+
+    /* start from the live position */
+    next_frame = LOAD_ACQUIRE(map.header->write_frame);
+    next_block = LOAD_ACQUIRE(map.header->write_block);
+
+    fprintf(stderr, "Attached to %s: %u frames ring, %u blocks\n", name,
+            (unsigned int)map.header->frame_capacity, (unsigned int)map.header->block_capacity);
+
+    start = last_report = clock_ns();
+    for (;;) {
+        uint64_t now = clock_ns();
+        int closed = LOAD_ACQUIRE(map.header->closed);
+
+        read_blocks(&map, &next_block, &expected_frame, &have_expected, &stats, &wav);
+        while (read_frames(&map, &next_frame, counter, &stats, &wav)) {}
+
+        if (closed || (duration_s > 0.0 && (double)(now - start) / 1e9 >= duration_s)) {
+            break;
+        }
+
+        if (!quiet && now - last_report >= 1000000000) {
+            struct reader_stats delta = stats;
+            delta.frames -= last_stats.frames;
+            delta.blocks -= last_stats.blocks;
+            delta.lost_frames -= last_stats.lost_frames;
+            delta.torn_frames -= last_stats.torn_frames;
+            delta.skipped_blocks -= last_stats.skipped_blocks;
+            delta.discontinuities -= last_stats.discontinuities;
+            delta.corrupted_frames -= last_stats.corrupted_frames;
+            delta.delay_ns_sum -= last_stats.delay_ns_sum;
+            delta.delay_ns_max = stats.interval_delay_ns_max;
+            print_stats("last second", &delta);
+            stats.interval_delay_ns_max = 0;
+            last_stats = stats;
+            last_report = now;
+        }
+
+        sleep_ms(2);
+    }
+
+    if (wav.file != NULL) {
+        write_wav_header(&wav);
+        fclose(wav.file);
+    }
+
+    print_stats("total", &stats);
+    munmap((void*)map.data, map.size);
+
+    if (stats.discontinuities != 0 || stats.corrupted_frames != 0) {
+        return EXIT_FAILURE;
+    }
+    if (counter && stats.frames == 0) {
+        fprintf(stderr, "No frame to check\n");
+        return EXIT_FAILURE;
+    }
+    if (strict && (stats.lost_frames != 0 || stats.torn_frames != 0 || stats.skipped_blocks != 0)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
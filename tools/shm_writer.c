@@ -0,0 +1,190 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - shm_writer.c                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Load test writer of the shared memory output tap (make shm-test).
+ *
+ * Publishes a counter pattern through the plugin's shm_tap writer, faster than real time:
+ * frame n holds n itself (left channel the low 16 bits, right channel the high 16 bits),
+ * so that a reader run with --counter can check that every frame it outputs is the one
+ * it claims to be. Block sizes vary like SDL callbacks do, and the tap is closed at the
+ * end so that the reader stops.
+ *
+ * The tap is created first, then the writer waits --delay ms for the reader to attach,
+ * as the reader starts from the live position.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "shm_tap.h"
+
+#include "m64p_types.h"
+
+/* largest block pushed, like a large SDL buffer */
+enum { MAX_BLOCK_FRAMES = 8192 };
+
+static int l_verbose = 0;
+
+void DebugMessage(int level, const char *message, ...)
+{
+    va_list args;
+
+    if (level > M64MSG_WARNING && !l_verbose) {
+        return;
+    }
+
+    va_start(args, message);
+    fprintf(stderr, "shm writer: ");
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static uint64_t clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(deadline / 1000000000);
+    ts.tv_nsec = (long)(deadline % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {}
+}
+
+static void fill_counter(int16_t* frames, uint32_t first_frame, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        uint32_t n = first_frame + i;
+        frames[2 * i + 0] = (int16_t)(uint16_t)n;
+        frames[2 * i + 1] = (int16_t)(uint16_t)(n >> 16);
+    }
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options] NAME\n"
+        "  NAME                  shared memory object name\n"
+        "  --duration S          push for S seconds (default: 3)\n"
+        "  --speed X             push X times faster than real time (default: 20)\n"
+        "  --frequency HZ        output frequency published in the blocks (default: 48000)\n"
+        "  --block N             average frames per block, 1 to %d (default: 1024)\n"
+        "  --ring N              ring size in frames (default: 65536)\n"
+        "  --delay MS            wait for the reader before pushing (default: 500)\n"
+        "  --verbose             show the tap messages\n",
+        argv0, MAX_BLOCK_FRAMES / 2);
+}
+
+int main(int argc, char* argv[])
+{
+    static int16_t frames[MAX_BLOCK_FRAMES * 2];
+    const char* name = NULL;
+    double duration_s = 3.0;
+    double speed = 20.0;
+    unsigned int frequency = 48000;
+    unsigned int block_frames = 1024;
+    unsigned int ring_frames = 65536;
+    unsigned int delay_ms = 500;
+    struct shm_tap* tap;
+    uint64_t start, end, deadline;
+    uint32_t frame = 0;
+    uint32_t blocks = 0;
+    uint32_t rng = 1;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--verbose") == 0) { l_verbose = 1; continue; }
+        if (arg[0] != '-' && name == NULL) { name = arg; continue; }
+        if (value == NULL) { print_usage(argv[0]); return EXIT_FAILURE; }
+        else if (strcmp(arg, "--duration") == 0) { duration_s = atof(value); }
+        else if (strcmp(arg, "--speed") == 0) { speed = atof(value); }
+        else if (strcmp(arg, "--frequency") == 0) { frequency = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--block") == 0) { block_frames = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--ring") == 0) { ring_frames = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--delay") == 0) { delay_ms = (unsigned int)atoi(value); }
+        else { print_usage(argv[0]); return EXIT_FAILURE; }
+        ++i;
+    }
+
+    if (name == NULL || speed <= 0.0 || frequency == 0
+     || block_frames == 0 || block_frames > MAX_BLOCK_FRAMES / 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    tap = start_shm_tap(name, ring_frames);
+    if (tap == NULL) {
+        fprintf(stderr, "Couldn't create %s\n", name);
+        return EXIT_FAILURE;
+    }
+
+    sleep_until_ns(clock_ns() + (uint64_t)delay_ms * 1000000);
+
+    start = deadline = clock_ns();
+    end = start + (uint64_t)(duration_s * 1e9);
+    while (deadline < end) {
+        /* block sizes from half to 1.5x the average, like callbacks of a varying buffer size */
+        uint32_t count;
+
+        rng = rng * 1664525 + 1013904223;
+        count = block_frames / 2 + (rng >> 8) % (block_frames + 1);
+        if (count == 0) {
+            count = 1;
+        }
+
+        fill_counter(frames, frame, count);
+        shm_tap_push(tap, frames, (size_t)count * 4, frequency);
+        frame += count;
+        ++blocks;
+
+        deadline += (uint64_t)(count * 1e9 / (frequency * speed));
+        sleep_until_ns(deadline);
+    }
+
+    fprintf(stderr, "shm writer: %u frames in %u blocks, %.1fx real time\n",
+            (unsigned int)frame, (unsigned int)blocks,
+            (double)frame / frequency / ((double)(clock_ns() - start) / 1e9));
+
+    stop_shm_tap(tap);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,682 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-audio-sdl - sync_sim.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64Plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Offline simulator of the emulation/audio synchronization.
+ *
+ * Runs the plugin synchronization logic (estimate_audio_level and audio_sync_decide)
+ * against a virtual clock instead of SDL_GetTicks/SDL_Delay and the SDL audio thread:
+ *  - the emulator renders frames with a configurable work time, jitter and occasional spikes,
+ *    pushes one frame worth of samples, synchronizes, then waits for its speed limiter;
+ *  - the audio device consumes a secondary buffer per period, with period jitter and
+ *    clock drift relative to the emulator.
+ *
+ * For every combination of sync policy and buffer configuration it reports underruns,
+ * pauses, output latency distribution and the time emulation was stalled by synchronization.
+ *
+ * The game plays a 1kHz tone, rendered with the plugin underrun concealment (CONCEAL_MS):
+ * the output steps larger than the tone's are counted as clicks.
+ *
+ * Resampling is modeled as a cost per output frame for each level of a RESAMPLE=auto ladder,
+ * multiplied during periodic episodes of CPU contention. With a RESAMPLE_BUDGET, the plugin
+ * quality governor picks the level, with the same handover as the backend (requested by the
+ * callback, prepared at the next push, crossfaded by the following callback); without, the
+ * first level is used throughout. Callbacks whose resampling doesn't fit in their period are
+ * counted as overruns.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_sync.h"
+#include "concealment.h"
+#include "resample_governor.h"
+
+#if !defined(M_PI)
+#define M_PI 3.14159265358979323846
+#endif
+
+/* number of bytes per sample */
+#define N64_SAMPLE_BYTES 4
+#define SDL_SAMPLE_BYTES 4
+
+/* tone played by the game, and the output step counted as a click (twice the tone's largest) */
+#define TONE_FREQUENCY 1000.0
+#define TONE_AMPLITUDE 16384.0
+
+enum { MAX_VALUES = 16 };
+
+struct value_list
+{
+    unsigned int values[MAX_VALUES];
+    size_t count;
+};
+
+struct sim_params
+{
+    /* input rate is input_rate_num/input_rate_den Hz */
+    unsigned int input_rate_num;
+    unsigned int input_rate_den;
+    unsigned int output_frequency;
+    unsigned int speed_factor;
+    double vi_rate;
+    int limiter;
+
+    size_t primary_buffer_size;
+    size_t target;
+    size_t secondary_buffer_size;
+    struct audio_sync_policy policy;
+    unsigned int conceal_ms;
+
+    /* resampling cost of each level (ns per output frame), and RESAMPLE_BUDGET (0 for a fixed level) */
+    struct value_list level_costs;
+    unsigned int budget;
+
+    /* resampling costs are multiplied by contention during the first contention_s of every contention_period_s */
+    double contention;
+    double contention_s;
+    double contention_period_s;
+
+    /* emulator frame work time, its standard deviation, and rare long frames (ms) */
+    double frame_work_ms;
+    double frame_jitter_ms;
+    double spike_probability;
+    double spike_ms;
+
+    /* device period jitter standard deviation (us) and clock drift (ppm, positive = device is faster) */
+    double period_jitter_us;
+    double drift_ppm;
+
+    /* SDL_Delay oversleeps by up to this much (ms) */
+    double sleep_overshoot_ms;
+
+    double duration_s;
+    uint64_t seed;
+};
+
+struct sim_results
+{
+    uint64_t callbacks;
+    uint64_t underruns;
+    uint64_t overflows;
+    uint64_t pauses;
+    double paused_ms;
+    double stall_ms;
+    uint64_t frames;
+    double expected_frames;
+    uint64_t clicks;
+    uint64_t switches;
+    uint64_t level_sum;
+    uint64_t overruns;
+
+    double* latencies_ms;
+    size_t latency_count;
+    size_t latency_capacity;
+};
+
+/* ----------- random numbers ------------- */
+
+static uint64_t l_rng_state;
+
+static double rand_uniform(void)
+{
+    /* xorshift64* */
+    l_rng_state ^= l_rng_state >> 12;
+    l_rng_state ^= l_rng_state << 25;
+    l_rng_state ^= l_rng_state >> 27;
+    return (double)((l_rng_state * UINT64_C(2685821657736338717)) >> 11) / 9007199254740992.0;
+}
+
+static double rand_gauss(void)
+{
+    double u1 = rand_uniform();
+    double u2 = rand_uniform();
+    return sqrt(-2.0 * log(u1 + 1e-300)) * cos(2.0 * M_PI * u2);
+}
+
+/* ----------- simulation ------------- */
+
+static void add_latency(struct sim_results* results, double latency_ms)
+{
+    if (results->latency_count == results->latency_capacity) {
+        results->latency_capacity = (results->latency_capacity == 0) ? 4096 : 2 * results->latency_capacity;
+        results->latencies_ms = realloc(results->latencies_ms, results->latency_capacity * sizeof(double));
+        if (results->latencies_ms == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    results->latencies_ms[results->latency_count++] = latency_ms;
+}
+
+static double frame_work_us(const struct sim_params* p)
+{
+    double work = p->frame_work_ms + p->frame_jitter_ms * rand_gauss();
+
+    if (rand_uniform() < p->spike_probability) {
+        work += p->spike_ms;
+    }
+
+    return 1000.0 * ((work > 0.1) ? work : 0.1);
+}
+
+/* the tone from phase, for frames output frames, returns the phase after them */
+static double render_tone(int16_t* samples, size_t frames, double phase, unsigned int output_frequency)
+{
+    size_t i;
+
+    for (i = 0; i < frames; ++i) {
+        int16_t sample = (int16_t)lrint(TONE_AMPLITUDE * sin(phase));
+
+        samples[2 * i] = sample;
+        samples[2 * i + 1] = sample;
+        phase += 2.0 * M_PI * TONE_FREQUENCY / output_frequency;
+    }
+
+    return fmod(phase, 2.0 * M_PI);
+}
+
+static uint64_t count_clicks(const int16_t* samples, size_t frames, int16_t* last, double threshold)
+{
+    uint64_t clicks = 0;
+    size_t i;
+
+    for (i = 0; i < frames; ++i) {
+        clicks += (fabs((double)samples[2 * i] - *last) > threshold);
+        *last = samples[2 * i];
+    }
+
+    return clicks;
+}
+
+/* time (in us) spent resampling frames output frames at a level, at time now */
+static double resample_us(const struct sim_params* p, size_t level, size_t frames, double now)
+{
+    double cost = p->level_costs.values[level] * 1e-3 * frames;
+
+    if (p->contention_period_s > 0.0 && fmod(now * 1e-6, p->contention_period_s) < p->contention_s) {
+        cost *= p->contention;
+    }
+
+    return cost;
+}
+
+static void simulate(const struct sim_params* p, struct sim_results* r)
+{
+    /* same sizes and rates as the backend */
+    uint64_t src_rate = (uint64_t)p->input_rate_num * p->speed_factor;
+    uint64_t dst_rate = (uint64_t)p->input_rate_den * p->output_frequency * 100;
+    size_t needed = (size_t)(((uint64_t)p->secondary_buffer_size * SDL_SAMPLE_BYTES * src_rate) / dst_rate);
+    size_t capacity = N64_SAMPLE_BYTES * (size_t)(((uint64_t)p->primary_buffer_size * src_rate) / dst_rate);
+    /* fractional input sample consumed by the resampler, in 1/dst_rate units */
+    uint64_t resample_phase = 0;
+    double end_us = p->duration_s * 1e6;
+
+    /* device */
+    double period_us = 1e6 * p->secondary_buffer_size / p->output_frequency / (1.0 + p->drift_ppm * 1e-6);
+    uint64_t cb_index = 1;
+    double cb_time = period_us;
+    double last_cb_us = 0.0;
+    unsigned int last_cb_time = 0;
+
+    /* emulator */
+    double frame_period_us = 1e6 / (p->vi_rate * p->speed_factor / 100.0);
+    double samples_per_frame = (double)p->input_rate_num / p->input_rate_den / p->vi_rate;
+    double sample_debt = 0.0;
+    double frame_start = 0.0;
+    double frame_end;
+
+    /* shared state */
+    size_t available = 0;
+    int paused = 1;
+
+    /* output signal */
+    int16_t* stream = malloc(p->secondary_buffer_size * SDL_SAMPLE_BYTES);
+    struct concealment concealment;
+    double tone_phase = 0.0;
+    double click_threshold = 2.0 * 2.0 * M_PI * TONE_FREQUENCY / p->output_frequency * TONE_AMPLITUDE;
+    int16_t last_sample = 0;
+
+    /* resampler quality, and the pending handover: 0 idle, 1 requested, 2 ready */
+    struct resample_governor governor;
+    size_t next_level = 0;
+    int handover = 0;
+
+    if (stream == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&concealment, 0, sizeof(concealment));
+    init_concealment(&concealment, (size_t)p->conceal_ms * p->output_frequency / 1000);
+
+    init_resample_governor(&governor, p->level_costs.count, p->budget, 0);
+
+    memset(r, 0, sizeof(*r));
+    l_rng_state = p->seed * UINT64_C(0x9E3779B97F4A7C15) + 1;
+    frame_end = frame_work_us(p);
+
+    while (cb_time < end_us || frame_end < end_us) {
+        if (cb_time <= frame_end) {
+            /* audio callback, not called at all while paused */
+            if (paused) {
+                r->paused_ms += (cb_time - last_cb_us) / 1000.0;
+            }
+            else {
+                ++r->callbacks;
+                last_cb_time = (unsigned int)(cb_time / 1000.0);
+
+                /* same decisions as the backend callback */
+                if ((available < needed) && (concealment.frames != 0)) {
+                    size_t frames = (size_t)((uint64_t)(available / N64_SAMPLE_BYTES) * dst_rate / src_rate);
+                    size_t consumed;
+
+                    ++r->underruns;
+
+                    if (frames > p->secondary_buffer_size) {
+                        frames = p->secondary_buffer_size;
+                    }
+                    if (frames > 0) {
+                        resample_phase += (uint64_t)frames * src_rate;
+                        consumed = N64_SAMPLE_BYTES * (size_t)(resample_phase / dst_rate);
+                        available -= (consumed < available) ? consumed : available;
+                        resample_phase %= dst_rate;
+
+                        tone_phase = render_tone(stream, frames, tone_phase, p->output_frequency);
+                        concealment_render(&concealment, stream, frames);
+                    }
+                    concealment_conceal(&concealment, stream + 2 * frames, p->secondary_buffer_size - frames);
+                }
+                else if ((available > 0) && (available >= needed)) {
+                    double busy_us = resample_us(p, governor.level, p->secondary_buffer_size, cb_time);
+
+                    if (handover == 2) {
+                        /* a crossfade resamples twice, and says nothing about the load of either level */
+                        busy_us += resample_us(p, next_level, p->secondary_buffer_size, cb_time);
+                        resample_governor_switched(&governor, next_level, last_cb_time);
+                        handover = 0;
+                        ++r->switches;
+                    }
+                    else if (p->budget != 0 && handover == 0) {
+                        next_level = resample_governor_update(&governor, busy_us / period_us, last_cb_time);
+                        handover = (next_level != governor.level);
+                    }
+
+                    r->overruns += (busy_us >= period_us);
+
+                    resample_phase += (uint64_t)p->secondary_buffer_size * src_rate;
+                    available -= N64_SAMPLE_BYTES * (size_t)(resample_phase / dst_rate);
+                    resample_phase %= dst_rate;
+
+                    tone_phase = render_tone(stream, p->secondary_buffer_size, tone_phase, p->output_frequency);
+                    concealment_render(&concealment, stream, p->secondary_buffer_size);
+                }
+                else {
+                    ++r->underruns;
+                    memset(stream, 0, p->secondary_buffer_size * SDL_SAMPLE_BYTES);
+                }
+
+                r->clicks += count_clicks(stream, p->secondary_buffer_size, &last_sample, click_threshold);
+                r->level_sum += governor.level;
+
+                /* output latency of the last sample pushed: primary buffer content plus SDL's buffer */
+                add_latency(r, 1000.0 * ((double)(available / N64_SAMPLE_BYTES) * dst_rate / src_rate
+                        + p->secondary_buffer_size) / p->output_frequency);
+            }
+
+            last_cb_us = cb_time;
+            ++cb_index;
+            cb_time = cb_index * period_us + p->period_jitter_us * rand_gauss();
+            if (cb_time <= last_cb_us) {
+                cb_time = last_cb_us + 1.0;
+            }
+        }
+        else {
+            /* end of an emulated frame: push its samples, then synchronize */
+            double now = frame_end;
+            size_t frames, size, expected_level;
+            unsigned int wait_time = 0;
+
+            sample_debt += samples_per_frame;
+            frames = (size_t)sample_debt;
+            sample_debt -= frames;
+            size = frames * N64_SAMPLE_BYTES;
+
+            if (available + size <= capacity) {
+                available += size;
+            }
+            else {
+                ++r->overflows;
+            }
+
+            ++r->frames;
+
+            /* the emulation thread prepares the level requested by the callback */
+            if (handover == 1) {
+                handover = 2;
+            }
+
+            expected_level = estimate_audio_level(available,
+                    p->input_rate_num, p->input_rate_den, p->output_frequency, p->speed_factor,
+                    p->secondary_buffer_size, last_cb_time, (unsigned int)(now / 1000.0));
+
+            switch (audio_sync_decide(&p->policy, expected_level, p->target, p->secondary_buffer_size,
+                        p->output_frequency, paused, &wait_time))
+            {
+            case AUDIO_SYNC_DELAY: {
+                double sleep = 1000.0 * (wait_time + p->sleep_overshoot_ms * rand_uniform());
+                r->stall_ms += sleep / 1000.0;
+                now += sleep;
+                paused = 0;
+                break;
+            }
+            case AUDIO_SYNC_PAUSE:
+                if (!paused) {
+                    ++r->pauses;
+                }
+                paused = 1;
+                break;
+            case AUDIO_SYNC_RUN:
+                paused = 0;
+                break;
+            }
+
+            /* core speed limiter */
+            if (p->limiter && now < frame_start + frame_period_us) {
+                now = frame_start + frame_period_us;
+            }
+
+            frame_start = now;
+            frame_end = now + frame_work_us(p);
+        }
+    }
+
+    r->expected_frames = end_us / frame_period_us;
+
+    release_concealment(&concealment);
+    free(stream);
+}
+
+/* ----------- reporting ------------- */
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, size_t count, double p)
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    return sorted[(size_t)(p * (count - 1))];
+}
+
+static void print_header(int csv)
+{
+    if (csv) {
+        printf("audio_sync,tolerance_ms,resume_ms,secondary,target,primary,conceal_ms,budget,callbacks,underruns,overflows,pauses,"
+               "paused_ms,clicks,switches,mean_level,overruns,latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms,stall_pct,speed_pct\n");
+    }
+    else {
+        printf("%4s %4s %4s %5s %6s %4s %4s | %8s %7s %7s %6s %9s %6s | %5s %5s %6s | %6s %6s %6s %6s | %6s %6s\n",
+               "sync", "tol", "res", "sec", "target", "conc", "bud",
+               "cbs", "under", "over", "pause", "paused_ms", "clicks",
+               "sw", "level", "ovrun",
+               "p50", "p90", "p99", "max", "stall%", "speed%");
+    }
+}
+
+static void print_results(const struct sim_params* p, struct sim_results* r, int csv)
+{
+    double duration_ms = p->duration_s * 1000.0;
+    double p50, p90, p99, max;
+    double mean_level = (r->callbacks != 0) ? (double)r->level_sum / r->callbacks : 0.0;
+
+    qsort(r->latencies_ms, r->latency_count, sizeof(double), compare_doubles);
+    p50 = percentile(r->latencies_ms, r->latency_count, 0.50);
+    p90 = percentile(r->latencies_ms, r->latency_count, 0.90);
+    p99 = percentile(r->latencies_ms, r->latency_count, 0.99);
+    max = percentile(r->latencies_ms, r->latency_count, 1.0);
+
+    if (csv) {
+        printf("%d,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%.1f,%llu,%llu,%.3f,%llu,%.2f,%.2f,%.2f,%.2f,%.3f,%.2f\n",
+               p->policy.audio_sync, p->policy.tolerance_ms, p->policy.resume_ms,
+               (unsigned int)p->secondary_buffer_size, (unsigned int)p->target, (unsigned int)p->primary_buffer_size,
+               p->conceal_ms, p->budget,
+               (unsigned long long)r->callbacks, (unsigned long long)r->underruns,
+               (unsigned long long)r->overflows, (unsigned long long)r->pauses,
+               r->paused_ms, (unsigned long long)r->clicks,
+               (unsigned long long)r->switches, mean_level, (unsigned long long)r->overruns, p50, p90, p99, max,
+               100.0 * r->stall_ms / duration_ms, 100.0 * r->frames / r->expected_frames);
+    }
+    else {
+        printf("%4d %4u %4u %5u %6u %4u %4u | %8llu %7llu %7llu %6llu %9.0f %6llu | %5llu %5.2f %6llu | %6.1f %6.1f %6.1f %6.1f | %6.2f %6.1f\n",
+               p->policy.audio_sync, p->policy.tolerance_ms, p->policy.resume_ms,
+               (unsigned int)p->secondary_buffer_size, (unsigned int)p->target, p->conceal_ms, p->budget,
+               (unsigned long long)r->callbacks, (unsigned long long)r->underruns,
+               (unsigned long long)r->overflows, (unsigned long long)r->pauses,
+               r->paused_ms, (unsigned long long)r->clicks,
+               (unsigned long long)r->switches, mean_level, (unsigned long long)r->overruns, p50, p90, p99, max,
+               100.0 * r->stall_ms / duration_ms, 100.0 * r->frames / r->expected_frames);
+    }
+    fflush(stdout);
+}
+
+/* ----------- main ------------- */
+
+static int parse_list(const char* arg, struct value_list* list)
+{
+    char* end;
+
+    list->count = 0;
+    do {
+        unsigned long value = strtoul(arg, &end, 10);
+        if (end == arg || list->count >= MAX_VALUES) {
+            return -1;
+        }
+        list->values[list->count++] = (unsigned int)value;
+        arg = end + 1;
+    } while (*end == ',');
+
+    return (*end == '\0') ? 0 : -1;
+}
+
+/* HZ or NUM/DEN, num and den are set to 0 on error */
+static void parse_rate(const char* arg, unsigned int* num, unsigned int* den)
+{
+    char* end;
+
+    *num = (unsigned int)strtoul(arg, &end, 10);
+    *den = 1;
+
+    if (*end == '/') {
+        *den = (unsigned int)strtoul(end + 1, &end, 10);
+    }
+
+    if (end == arg || *end != '\0') {
+        *num = 0;
+        *den = 0;
+    }
+}
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "Configurations (comma separated lists, every combination is simulated):\n"
+        "  --sync LIST           AUDIO_SYNC values (default: 1)\n"
+        "  --tolerance LIST      SYNC_TOLERANCE_MS values (default: 10)\n"
+        "  --resume LIST         SYNC_RESUME_MS values (default: 0)\n"
+        "  --secondary LIST      SECONDARY_BUFFER_SIZE values (default: 256,512,1024,2048)\n"
+        "  --target LIST         PRIMARY_BUFFER_TARGET values (default: 2048)\n"
+        "  --primary N           PRIMARY_BUFFER_SIZE (default: 16384)\n"
+        "  --conceal LIST        CONCEAL_MS values (default: 5)\n"
+        "  --budget LIST         RESAMPLE_BUDGET values, 0 for a fixed resampler (default: 0,30)\n"
+        "Model:\n"
+        "  --input-rate HZ[/DEN] N64 sample rate, exact fraction of Hz with DEN (e.g. 48681812/1521) (default: 32000)\n"
+        "  --output-rate HZ      device sample rate (default: 48000)\n"
+        "  --speed PCT           speed factor (default: 100)\n"
+        "  --vi-rate HZ          emulated frames per second (default: 60)\n"
+        "  --no-limiter          disable the core speed limiter\n"
+        "  --frame-work MS       emulation work per frame (default: 8)\n"
+        "  --frame-jitter MS     standard deviation of the frame work (default: 2)\n"
+        "  --spike-prob P        probability of a long frame (default: 0.005)\n"
+        "  --spike-ms MS         extra work of a long frame (default: 40)\n"
+        "  --period-jitter US    standard deviation of the device period (default: 500)\n"
+        "  --drift PPM           device clock drift, positive when faster (default: 50)\n"
+        "  --sleep-overshoot MS  SDL_Delay oversleeps by up to this (default: 1)\n"
+        "  --level-cost LIST     resampling cost of each RESAMPLE=auto level, best first (ns per frame)\n"
+        "                        (default: 2500,1200,500,200,50)\n"
+        "  --contention X        resampling cost factor during CPU contention (default: 4)\n"
+        "  --contention-s S      contention at the start of every period, for this long (default: 10)\n"
+        "  --contention-period S period of the contention episodes, 0 for none (default: 30)\n"
+        "  --duration S          simulated time (default: 120)\n"
+        "  --seed N              random seed (default: 1)\n"
+        "Output:\n"
+        "  --csv                 machine-readable output\n",
+        argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    struct sim_params p;
+    struct sim_results r;
+    struct value_list syncs = { { 1 }, 1 };
+    struct value_list tolerances = { { 10 }, 1 };
+    struct value_list resumes = { { 0 }, 1 };
+    struct value_list secondaries = { { 256, 512, 1024, 2048 }, 4 };
+    struct value_list targets = { { 2048 }, 1 };
+    struct value_list conceals = { { 5 }, 1 };
+    struct value_list budgets = { { 0, 30 }, 2 };
+    struct value_list level_costs = { { 2500, 1200, 500, 200, 50 }, 5 };
+    size_t primary_buffer_size = 16384;
+    size_t a, b, c, d, e, f, g;
+    int csv = 0;
+    int i;
+
+    memset(&p, 0, sizeof(p));
+    p.input_rate_num = 32000;
+    p.input_rate_den = 1;
+    p.output_frequency = 48000;
+    p.speed_factor = 100;
+    p.vi_rate = 60.0;
+    p.limiter = 1;
+    p.frame_work_ms = 8.0;
+    p.frame_jitter_ms = 2.0;
+    p.spike_probability = 0.005;
+    p.spike_ms = 40.0;
+    p.period_jitter_us = 500.0;
+    p.drift_ppm = 50.0;
+    p.sleep_overshoot_ms = 1.0;
+    p.duration_s = 120.0;
+    p.seed = 1;
+    p.contention = 4.0;
+    p.contention_s = 10.0;
+    p.contention_period_s = 30.0;
+
+    for (i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(arg, "--csv") == 0) { csv = 1; continue; }
+        if (strcmp(arg, "--no-limiter") == 0) { p.limiter = 0; continue; }
+        if (value == NULL) { ok = 0; }
+        else if (strcmp(arg, "--sync") == 0) { ok = parse_list(value, &syncs) == 0; }
+        else if (strcmp(arg, "--tolerance") == 0) { ok = parse_list(value, &tolerances) == 0; }
+        else if (strcmp(arg, "--resume") == 0) { ok = parse_list(value, &resumes) == 0; }
+        else if (strcmp(arg, "--secondary") == 0) { ok = parse_list(value, &secondaries) == 0; }
+        else if (strcmp(arg, "--target") == 0) { ok = parse_list(value, &targets) == 0; }
+        else if (strcmp(arg, "--conceal") == 0) { ok = parse_list(value, &conceals) == 0; }
+        else if (strcmp(arg, "--budget") == 0) { ok = parse_list(value, &budgets) == 0; }
+        else if (strcmp(arg, "--level-cost") == 0) { ok = parse_list(value, &level_costs) == 0; }
+        else if (strcmp(arg, "--contention") == 0) { p.contention = atof(value); }
+        else if (strcmp(arg, "--contention-s") == 0) { p.contention_s = atof(value); }
+        else if (strcmp(arg, "--contention-period") == 0) { p.contention_period_s = atof(value); }
+        else if (strcmp(arg, "--primary") == 0) { primary_buffer_size = strtoul(value, NULL, 10); }
+        else if (strcmp(arg, "--input-rate") == 0) { parse_rate(value, &p.input_rate_num, &p.input_rate_den); }
+        else if (strcmp(arg, "--output-rate") == 0) { p.output_frequency = (unsigned int)strtoul(value, NULL, 10); }
+        else if (strcmp(arg, "--speed") == 0) { p.speed_factor = (unsigned int)strtoul(value, NULL, 10); }
+        else if (strcmp(arg, "--vi-rate") == 0) { p.vi_rate = atof(value); }
+        else if (strcmp(arg, "--frame-work") == 0) { p.frame_work_ms = atof(value); }
+        else if (strcmp(arg, "--frame-jitter") == 0) { p.frame_jitter_ms = atof(value); }
+        else if (strcmp(arg, "--spike-prob") == 0) { p.spike_probability = atof(value); }
+        else if (strcmp(arg, "--spike-ms") == 0) { p.spike_ms = atof(value); }
+        else if (strcmp(arg, "--period-jitter") == 0) { p.period_jitter_us = atof(value); }
+        else if (strcmp(arg, "--drift") == 0) { p.drift_ppm = atof(value); }
+        else if (strcmp(arg, "--sleep-overshoot") == 0) { p.sleep_overshoot_ms = atof(value); }
+        else if (strcmp(arg, "--duration") == 0) { p.duration_s = atof(value); }
+        else if (strcmp(arg, "--seed") == 0) { p.seed = strtoull(value, NULL, 10); }
+        else { ok = 0; }
+
+        if (!ok) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        ++i;
+    }
+
+    if (p.input_rate_num == 0 || p.input_rate_den == 0 || p.output_frequency == 0 || p.vi_rate <= 0.0
+     || p.speed_factor < 10 || p.speed_factor > 300 || p.duration_s <= 0.0 || p.contention <= 0.0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    p.level_costs = level_costs;
+
+    print_header(csv);
+
+    for (a = 0; a < syncs.count; ++a)
+    for (b = 0; b < tolerances.count; ++b)
+    for (c = 0; c < resumes.count; ++c)
+    for (d = 0; d < secondaries.count; ++d)
+    for (e = 0; e < targets.count; ++e)
+    for (f = 0; f < conceals.count; ++f)
+    for (g = 0; g < budgets.count; ++g) {
+        p.conceal_ms = conceals.values[f];
+        p.budget = budgets.values[g];
+        p.policy.audio_sync = syncs.values[a];
+        p.policy.tolerance_ms = tolerances.values[b];
+        p.policy.resume_ms = resumes.values[c];
+        p.secondary_buffer_size = secondaries.values[d];
+
+        /* same clamping as the backend */
+        p.target = targets.values[e];
+        if (p.target < p.secondary_buffer_size) {
+            p.target = p.secondary_buffer_size;
+        }
+        p.primary_buffer_size = primary_buffer_size;
+        if (p.primary_buffer_size < p.target) {
+            p.primary_buffer_size = p.target;
+        }
+
+        simulate(&p, &r);
+        print_results(&p, &r, csv);
+        free(r.latencies_ms);
+    }
+
+    return EXIT_SUCCESS;
+}